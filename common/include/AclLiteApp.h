@@ -11,6 +11,7 @@
 #pragma once
 
 #include "AclLiteThreadMgr.h"
+#include "ObjectPool.h"
 #include "acl/acl.h"
 
 namespace
@@ -55,13 +56,53 @@ class AclLiteApp
                                      const std::string &instName,
                                      aclrtContext       context,
                                      aclrtRunMode       runMode,
-                                     const uint32_t     msgQueueSize);
+                                     const uint32_t     msgQueueSize,
+                                     AclLiteQueueType   queueType =
+                                         ACLLITE_QUEUE_MUTEX);
+    /**
+     * @brief Create the worker pool which runs the instances configured with
+     *        ACLLITE_EXEC_POOL, must be called before Start
+     * @param [in] workerNum: worker thread number, 0 means cpu core number
+     * @param [in] cpus: cpus the workers are pinned to one by one, empty
+     *             means the cpus of the process
+     */
+    AclLiteError InitWorkerPool(uint32_t                workerNum,
+                                const std::vector<int> &cpus =
+                                    std::vector<int>());
     int          Start(std::vector<AclLiteThreadParam> &threadParamTbl);
     void         Wait();
     void         Wait(AclLiteMsgProcess msgProcess, void *param);
     int          GetAclLiteThreadIdByName(const std::string &threadName);
     AclLiteError SendMessage(int dest, int msgId, std::shared_ptr<void> data);
-    void         WaitEnd() { waitEnd_ = true; }
+    /**
+     * @brief Send message with the given overload policy
+     * @param [in] policy: what to do if the queue of dest is full
+     * @param [in] timeoutUs: max block time of ACLLITE_SEND_BLOCK
+     * @return ACLLITE_OK, ACLLITE_ERROR_MSG_DROPPED if the message is
+     *         discarded by the policy, or other error
+     */
+    AclLiteError SendMessage(int                   dest,
+                             int                   msgId,
+                             std::shared_ptr<void> data,
+                             AclLiteSendPolicy     policy,
+                             uint32_t timeoutUs = ACLLITE_WAIT_FOREVER);
+    /**
+     * @brief Send message to the lane of dest selected by priority, control
+     *        lane messages are processed before the queued data messages
+     * @param [in] priority: ACLLITE_PRIO_NORMAL is the same as the send
+     *        without priority
+     */
+    AclLiteError SendMessage(int                   dest,
+                             int                   msgId,
+                             std::shared_ptr<void> data,
+                             AclLiteMsgPriority    priority);
+    /**
+     * @brief Send message with the policy configured on dest thread by
+     *        AclLiteThreadParam::sendPolicy
+     */
+    AclLiteError
+    SendMessageByPolicy(int dest, int msgId, std::shared_ptr<void> data);
+    void         WaitEnd();
     void         Exit();
     void         PrintQueueStatus();
     void         ClearThreadQueue(int threadId);
@@ -73,8 +114,11 @@ class AclLiteApp
                                         const std::string &instName,
                                         aclrtContext       context,
                                         aclrtRunMode       runMode,
-                                        const uint32_t     msgQueueSize);
+                                        const uint32_t     msgQueueSize,
+                                        AclLiteQueueType   queueType);
     bool         CheckThreadAbnormal();
+    std::shared_ptr<AclLiteMessage>
+    MakeMessage(int dest, int msgId, std::shared_ptr<void> &data);
     bool         CheckThreadNameUnique(const std::string &threadName);
     void         ReleaseThreads();
 
@@ -82,10 +126,24 @@ class AclLiteApp
     bool                            isReleased_;
     bool                            waitEnd_;
     std::vector<AclLiteThreadMgr *> threadList_;
+    AclLiteWorkerPool              *workerPool_;
+    // free list of the message envelopes
+    ObjectPool<AclLiteMessage>      msgPool_;
 };
 
 AclLiteApp  &CreateAclLiteAppInstance();
 AclLiteApp  &GetAclLiteAppInstance();
 AclLiteError SendMessage(int dest, int msgId, std::shared_ptr<void> data);
-int          GetAclLiteThreadIdByName(const std::string &threadName);
+AclLiteError SendMessage(int                   dest,
+                         int                   msgId,
+                         std::shared_ptr<void> data,
+                         AclLiteSendPolicy     policy,
+                         uint32_t              timeoutUs = ACLLITE_WAIT_FOREVER);
+AclLiteError SendMessage(int                   dest,
+                         int                   msgId,
+                         std::shared_ptr<void> data,
+                         AclLiteMsgPriority    priority);
+AclLiteError
+SendMessageByPolicy(int dest, int msgId, std::shared_ptr<void> data);
+int GetAclLiteThreadIdByName(const std::string &threadName);
 #endif
\ No newline at end of file
@@ -0,0 +1,65 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File AclLiteConfigWatcher.h
+* Description: watches the config file and calls back when it is rewritten
+*              or SIGHUP is received
+*/
+#ifndef ACLLITE_CONFIG_WATCHER_H
+#define ACLLITE_CONFIG_WATCHER_H
+#pragma once
+#include "AclLiteError.h"
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+
+/**
+ * One background thread waits on inotify for the directory of the file, so
+ * editors that save by rename are seen as well, and on the flag set by
+ * RequestReload. Bursts of events are merged: the callback runs once the
+ * file has been quiet for a short while. The callback runs on the watcher
+ * thread and must not block the pipeline.
+ */
+class AclLiteConfigWatcher
+{
+  public:
+    typedef std::function<void()> ReloadCallback;
+
+    static AclLiteConfigWatcher &GetInstance();
+    ~AclLiteConfigWatcher();
+
+    AclLiteError Start(const std::string &path, const ReloadCallback &callback);
+    void         Stop();
+    // async-signal-safe, used by the SIGHUP handler
+    void RequestReload() { pending_ = true; }
+
+  private:
+    AclLiteConfigWatcher();
+    AclLiteConfigWatcher(const AclLiteConfigWatcher &) = delete;
+    AclLiteConfigWatcher &operator=(const AclLiteConfigWatcher &) = delete;
+    void WatcherEntry();
+    bool ReadEvents();
+
+  private:
+    int               inotifyFd_;
+    std::string       fileName_;
+    ReloadCallback    callback_;
+    std::atomic<bool> pending_;
+    std::atomic<bool> running_;
+    std::thread       watcher_;
+};
+
+#endif
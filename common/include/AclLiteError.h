@@ -40,6 +40,10 @@ const int ACLLITE_ERROR_WRITE_FILE = 13;
 const int ACLLITE_ERROR_THREAD_ABNORMAL = 14;
 const int ACLLITE_ERROR_START_THREAD = 15;
 const int ACLLITE_ERROR_ADD_THREAD = 16;
+// message discarded by the send policy of the destination queue
+const int ACLLITE_ERROR_MSG_DROPPED = 17;
+// set thread affinity, nice value or scheduling policy failed
+const int ACLLITE_ERROR_SET_THREAD_SCHED = 18;
 
 // malloc or new memory failed
 const int ACLLITE_ERROR_MALLOC = 101;
@@ -0,0 +1,217 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File AclLiteMetrics.h
+* Description: per thread instance counters, latency histograms and queue
+*              depth gauges with a periodic reporter
+*/
+#ifndef ACLLITE_METRICS_H
+#define ACLLITE_METRICS_H
+#pragma once
+#include "AclLiteError.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// monotonic clock in microseconds, used for all metrics timestamps
+inline int64_t AclLiteNowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+class AclLiteCounter
+{
+  public:
+    AclLiteCounter() : value_(0) {}
+    void     Add(uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t Get() const { return value_.load(std::memory_order_relaxed); }
+
+  private:
+    std::atomic<uint64_t> value_;
+};
+
+class AclLiteGauge
+{
+  public:
+    AclLiteGauge() : value_(0) {}
+    void    Set(int64_t value) { value_.store(value, std::memory_order_relaxed); }
+    int64_t Get() const { return value_.load(std::memory_order_relaxed); }
+
+  private:
+    std::atomic<int64_t> value_;
+};
+
+struct AclLiteHistogramSnapshot
+{
+    std::vector<uint64_t> buckets;
+    uint64_t              count = 0;
+    uint64_t              sum = 0;
+    uint64_t              max = 0;
+
+    // value at percent (0-100], the upper bound of the bucket, 0 if empty
+    uint64_t Percentile(double percent) const;
+    // samples recorded after older was taken; max becomes the upper bound
+    // of the highest bucket that changed
+    AclLiteHistogramSnapshot Delta(const AclLiteHistogramSnapshot &older) const;
+};
+
+/**
+ * Log-linear histogram of microsecond values in the HDR style: every power
+ * of two range is split into 16 buckets, so the relative error of a
+ * percentile is below 1/16. Record only does relaxed atomic adds and can be
+ * called from any thread.
+ */
+class AclLiteHistogram
+{
+  public:
+    static const uint32_t kSubBucketBits = 4;
+    static const uint32_t kSubBucketNum = 1U << kSubBucketBits;
+    // values up to 2^32 us (about 71 minutes), larger ones go to the last
+    static const uint32_t kMaxValueBits = 32;
+    static const uint32_t kBucketNum =
+        (kMaxValueBits - kSubBucketBits + 1) * kSubBucketNum;
+
+    AclLiteHistogram();
+    AclLiteHistogram(const AclLiteHistogram &) = delete;
+    AclLiteHistogram &operator=(const AclLiteHistogram &) = delete;
+
+    void Record(int64_t valueUs);
+    void GetSnapshot(AclLiteHistogramSnapshot &snapshot) const;
+
+    static uint32_t BucketIndex(uint64_t value);
+    static uint64_t BucketUpperBound(uint32_t index);
+
+  private:
+    std::atomic<uint64_t> buckets_[kBucketNum];
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> max_;
+};
+
+// metrics of one thread instance, recorded by AclLiteThreadMgr
+struct AclLiteStageMetrics
+{
+    std::string      name;
+    AclLiteCounter   processNum;    // messages processed
+    AclLiteCounter   droppedNum;    // messages dropped by the send policy
+    AclLiteHistogram processTime;   // Process call time
+    AclLiteHistogram queueWaitTime; // time from enqueue to dequeue
+    AclLiteGauge     queueDepth;    // pending messages after the last pop
+};
+
+// records the lifetime of the scope to a histogram, no-op if it is null
+class AclLiteScopeTimer
+{
+  public:
+    explicit AclLiteScopeTimer(AclLiteHistogram *histogram)
+        : histogram_(histogram), startUs_(histogram ? AclLiteNowUs() : 0)
+    {
+    }
+    ~AclLiteScopeTimer()
+    {
+        if (histogram_ != nullptr)
+        {
+            histogram_->Record(AclLiteNowUs() - startUs_);
+        }
+    }
+    AclLiteScopeTimer(const AclLiteScopeTimer &) = delete;
+    AclLiteScopeTimer &operator=(const AclLiteScopeTimer &) = delete;
+
+  private:
+    AclLiteHistogram *histogram_;
+    int64_t           startUs_;
+};
+
+class AclLiteMetrics
+{
+  public:
+    static AclLiteMetrics &GetInstance();
+    ~AclLiteMetrics();
+
+    // Get or create the metrics of a thread instance. The pointer stays
+    // valid for the process lifetime, cache it instead of looking up per
+    // message
+    AclLiteStageMetrics *GetStageMetrics(const std::string &name);
+    // Get or create a named histogram, e.g. "<instance>.execute"
+    AclLiteHistogram    *GetHistogram(const std::string &name);
+    // Get or create a named counter or gauge for events outside the thread
+    // managers, e.g. "<instance>.lost". Same lifetime rule as above
+    AclLiteCounter      *GetCounter(const std::string &name);
+    AclLiteGauge        *GetGauge(const std::string &name);
+
+    // Log one summary line per active stage and histogram, percentiles are
+    // computed over the samples since the previous report
+    void        Report();
+    // Cumulative values of all metrics as a JSON object
+    std::string DumpJson();
+    // Cumulative values of all metrics in the Prometheus text format. A
+    // name "<instance>.<metric>" becomes acllite_<metric>{instance="..."}
+    std::string DumpPrometheus();
+    // Write DumpJson to path through a temporary file and rename
+    AclLiteError WriteDump(const std::string &path);
+
+    // Report every intervalMs in a background thread and rewrite dumpPath
+    // (if not empty) at the same time
+    AclLiteError StartReporter(uint32_t intervalMs, const std::string &dumpPath);
+    // Stop the reporter, then report and dump once more
+    void         StopReporter();
+
+  private:
+    AclLiteMetrics();
+    AclLiteMetrics(const AclLiteMetrics &) = delete;
+    AclLiteMetrics &operator=(const AclLiteMetrics &) = delete;
+    void ReporterEntry();
+
+  private:
+    struct ReportState
+    {
+        AclLiteHistogramSnapshot processTime;
+        AclLiteHistogramSnapshot queueWaitTime;
+        uint64_t                 processNum = 0;
+        uint64_t                 droppedNum = 0;
+    };
+
+    std::mutex mutex_;
+    // registration order is kept for stable report output
+    std::vector<std::unique_ptr<AclLiteStageMetrics>>         stages_;
+    std::vector<std::pair<std::string, std::unique_ptr<AclLiteHistogram>>>
+                                                              histograms_;
+    std::vector<std::pair<std::string, std::unique_ptr<AclLiteCounter>>>
+                                                              counters_;
+    std::vector<std::pair<std::string, std::unique_ptr<AclLiteGauge>>>
+                                                              gauges_;
+    std::map<const AclLiteStageMetrics *, ReportState>       stageStates_;
+    std::map<const AclLiteHistogram *, AclLiteHistogramSnapshot> histStates_;
+    std::map<const AclLiteCounter *, uint64_t>                 counterStates_;
+    int64_t                                                   lastReportUs_;
+
+    std::mutex              reporterMutex_;
+    std::condition_variable reporterCond_;
+    std::thread             reporter_;
+    bool                    reporterRunning_;
+    uint32_t                intervalMs_;
+    std::string             dumpPath_;
+};
+
+#endif
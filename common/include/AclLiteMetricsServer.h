@@ -0,0 +1,56 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File AclLiteMetricsServer.h
+* Description: minimal HTTP listener serving AclLiteMetrics in the
+*              Prometheus text format on GET /metrics
+*/
+#ifndef ACLLITE_METRICS_SERVER_H
+#define ACLLITE_METRICS_SERVER_H
+#pragma once
+#include "AclLiteError.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+/**
+ * One background thread accepts and answers connections one at a time, a
+ * scrape only reads the metric atomics so pipeline threads never wait for
+ * it. Bind to 127.0.0.1 unless the box is scraped from outside.
+ */
+class AclLiteMetricsServer
+{
+  public:
+    static AclLiteMetricsServer &GetInstance();
+    ~AclLiteMetricsServer();
+
+    AclLiteError Start(const std::string &bindAddr, uint16_t port);
+    void         Stop();
+
+  private:
+    AclLiteMetricsServer();
+    AclLiteMetricsServer(const AclLiteMetricsServer &) = delete;
+    AclLiteMetricsServer &operator=(const AclLiteMetricsServer &) = delete;
+    void ServerEntry();
+    void HandleConnection(int fd);
+
+  private:
+    int               listenFd_;
+    std::atomic<bool> running_;
+    std::thread       server_;
+};
+
+#endif
@@ -0,0 +1,54 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File AclLiteSnapshot.h
+* Description: immutable value published by one thread and read by others
+*/
+#ifndef ACLLITE_SNAPSHOT_H
+#define ACLLITE_SNAPSHOT_H
+#pragma once
+#include <atomic>
+#include <memory>
+
+/**
+ * Holds a shared_ptr to an immutable T that is replaced as a whole. The
+ * writer builds a new value and stores it, a reader loads the pointer once
+ * per frame and keeps using that value even if a newer one is stored in
+ * between, so a reader never sees a half updated value. Comparing the loaded
+ * pointer with the last one applied tells the reader whether anything
+ * changed. Load returns nullptr until the first Store.
+ */
+template <typename T>
+class AclLiteSnapshot
+{
+  public:
+    AclLiteSnapshot() {}
+
+    std::shared_ptr<const T> Load() const { return std::atomic_load(&value_); }
+
+    void Store(std::shared_ptr<const T> value)
+    {
+        std::atomic_store(&value_, std::move(value));
+    }
+
+  private:
+    AclLiteSnapshot(const AclLiteSnapshot &) = delete;
+    AclLiteSnapshot &operator=(const AclLiteSnapshot &) = delete;
+
+  private:
+    std::shared_ptr<const T> value_;
+};
+
+#endif
@@ -20,14 +20,61 @@
 #define ACLLITE_THREAD_H
 #pragma once
 #include "AclLiteError.h"
+#include "AclLiteType.h"
 #include "ThreadSafeQueue.h"
 #include "acl/acl.h"
 #include <iostream>
 #include <memory>
 #include <thread>
 #include <unistd.h>
+#include <vector>
 
 #define INVALID_INSTANCE_ID (-1)
+// send timeout value: block until the message is queued
+#define ACLLITE_WAIT_FOREVER (0U)
+
+// Message queue implementation of the thread
+enum AclLiteQueueType
+{
+    ACLLITE_QUEUE_MUTEX = 0, // std::queue + mutex
+    ACLLITE_QUEUE_SPSC,      // lock free ring, only one sender thread
+    ACLLITE_QUEUE_MPSC,      // lock free ring, multiple sender threads
+};
+
+// What the sender does when the destination message queue is full
+enum AclLiteSendPolicy
+{
+    ACLLITE_SEND_BLOCK = 0,   // wait for the consumer to pop, up to timeout
+    ACLLITE_SEND_DROP_OLDEST, // evict the oldest droppable queued message
+    ACLLITE_SEND_DROP_NEWEST, // discard the message being sent
+    ACLLITE_SEND_FAIL_FAST,   // return ACLLITE_ERROR_ENQUEUE at once
+};
+
+// Which lane of the destination thread a message goes to. Control lane
+// messages are popped before any data message; a fenced one additionally
+// waits until the data messages queued before it have been popped, for
+// end-of-stream markers which must stay behind the last frames
+enum AclLiteMsgPriority
+{
+    ACLLITE_PRIO_NORMAL = 0,    // data lane
+    ACLLITE_PRIO_HIGH,          // control lane, overtakes queued data
+    ACLLITE_PRIO_HIGH_FENCED,   // control lane, after earlier data
+};
+
+// How the thread instance is executed
+enum AclLiteExecMode
+{
+    ACLLITE_EXEC_THREAD = 0, // dedicated thread blocking on its queue
+    ACLLITE_EXEC_POOL,       // actor run by the shared worker pool
+};
+
+// One message of a batch handed to AclLiteThread::ProcessBatch
+struct AclLiteThreadMsg
+{
+    int                   msgId;
+    std::shared_ptr<void> data;
+};
+
 class AclLiteThread
 {
   public:
@@ -35,6 +82,27 @@ class AclLiteThread
     virtual ~AclLiteThread(){};
     virtual int  Init() { return ACLLITE_OK; };
     virtual int  Process(int msgId, std::shared_ptr<void> msgData) = 0;
+    // Called instead of Process when the max batch size is above 1, with up
+    // to that many data messages popped from the queue at once, in queue
+    // order. The default calls Process for each of them; an override may
+    // coalesce, e.g. skip frames superseded by a newer one in the batch
+    virtual int  ProcessBatch(std::vector<AclLiteThreadMsg> &msgs);
+    // Max number of messages taken from the queue per wakeup, 1 (default)
+    // keeps the one message per Process call path
+    void         SetMaxBatchSize(uint32_t size)
+    {
+        maxBatchSize_ = size > 0 ? size : 1;
+    }
+    uint32_t     GetMaxBatchSize() { return maxBatchSize_; }
+    // A dedicated thread holding fewer than the max batch size waits up to
+    // this long after the first of them was queued for more to arrive, so
+    // that batches fill up under light load. 0 (default) processes what is
+    // queued at once; a pool actor never waits
+    void         SetBatchDeadline(uint32_t deadlineUs)
+    {
+        batchDeadlineUs_ = deadlineUs;
+    }
+    uint32_t     GetBatchDeadline() { return batchDeadlineUs_; }
     int          SelfInstanceId() { return instanceId_; }
     std::string &SelfInstanceName() { return instanceName_; }
     aclrtContext GetContext() { return context_; }
@@ -51,15 +119,28 @@ class AclLiteThread
     std::string  instanceName_;
     bool         baseConfiged_;
     bool         isExit_;
+    uint32_t     maxBatchSize_;
+    uint32_t     batchDeadlineUs_;
 };
 
 struct AclLiteThreadParam
 {
-    AclLiteThread *threadInst = nullptr;
-    std::string    threadInstName = "";
-    aclrtContext   context = nullptr;
-    aclrtRunMode   runMode = ACL_HOST;
-    int            threadInstId = INVALID_INSTANCE_ID;
-    uint32_t       queueSize = 256;
+    AclLiteThread   *threadInst = nullptr;
+    std::string      threadInstName = "";
+    aclrtContext     context = nullptr;
+    aclrtRunMode     runMode = ACL_HOST;
+    int              threadInstId = INVALID_INSTANCE_ID;
+    uint32_t         queueSize = 256;
+    AclLiteQueueType queueType = ACLLITE_QUEUE_MUTEX;
+    // overload policy of the messages sent to this thread by
+    // SendMessageByPolicy, i.e. the policy of the edge into this thread
+    AclLiteSendPolicy sendPolicy = ACLLITE_SEND_BLOCK;
+    uint32_t          sendTimeoutUs = ACLLITE_WAIT_FOREVER;
+    // instances which block inside Process (device sync, socket, decoder)
+    // should keep a dedicated thread
+    AclLiteExecMode   execMode = ACLLITE_EXEC_THREAD;
+    // cpu affinity, nice value and SCHED_FIFO priority of the dedicated
+    // thread, inherited by the helper threads it creates
+    AclLiteThreadSched sched;
 };
 #endif
\ No newline at end of file
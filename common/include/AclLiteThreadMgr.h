@@ -19,13 +19,19 @@
 #ifndef ACLLITE_THREADMGR_H
 #define ACLLITE_THREADMGR_H
 #pragma once
+#include "AclLiteMetrics.h"
 #include "AclLiteThread.h"
 #include "AclLiteUtils.h"
+#include "RingBufferQueue.h"
 #include "ThreadSafeQueue.h"
+#include <atomic>
+#include <deque>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <thread>
 #include <unistd.h>
+#include <vector>
 
 enum AclLiteThreadStatus
 {
@@ -36,29 +42,84 @@ enum AclLiteThreadStatus
     THREAD_ERROR = 4,
 };
 
+class AclLiteWorkerPool;
+
 class AclLiteThreadMgr
 {
   public:
     AclLiteThreadMgr(AclLiteThread     *userThreadInstance,
                      const std::string &threadName,
-                     const uint32_t     msgQueueSize);
+                     const uint32_t     msgQueueSize,
+                     AclLiteQueueType   queueType = ACLLITE_QUEUE_MUTEX);
     ~AclLiteThreadMgr();
     // Thread function
     static void        ThreadEntry(void *data);
     AclLiteThread     *GetUserInstance() { return this->userInstance_; }
     const std::string &GetThreadName() { return name_; }
-    // Send AclLiteMessage data to the queue
+    // Send AclLiteMessage data to the queue, fail at once if queue is full
     AclLiteError PushMsgToQueue(std::shared_ptr<AclLiteMessage> &pMessage);
-    // Get AclLiteMessage data from the queue
-    std::shared_ptr<AclLiteMessage> PopMsgFromQueue()
+    // Send AclLiteMessage data to the queue with the overload policy
+    AclLiteError PushMsgToQueue(std::shared_ptr<AclLiteMessage> &pMessage,
+                                AclLiteSendPolicy                policy,
+                                uint32_t                         timeoutUs);
+    // Send AclLiteMessage to the control lane, fail if the lane is full
+    AclLiteError PushMsgToQueue(std::shared_ptr<AclLiteMessage> &pMessage,
+                                AclLiteMsgPriority               priority);
+    // Get AclLiteMessage data from the queue, control lane first
+    std::shared_ptr<AclLiteMessage> PopMsgFromQueue();
+    // Get AclLiteMessage data from the queue, block until a message arrives,
+    // timeout or WakeUp
+    std::shared_ptr<AclLiteMessage> PopMsgFromQueue(uint32_t timeoutUs);
+    // Get up to maxNum data messages with one queue operation; a control
+    // message that is ready is returned alone. Returns the number popped
+    uint32_t PopMsgBatch(std::vector<std::shared_ptr<AclLiteMessage>> &msgs,
+                         uint32_t                                      maxNum);
+    // Same as above, block until a message arrives, timeout or WakeUp
+    uint32_t PopMsgBatch(std::vector<std::shared_ptr<AclLiteMessage>> &msgs,
+                         uint32_t                                      maxNum,
+                         uint32_t timeoutUs);
+    // Pop more data messages into a batch which does not start with a
+    // control message, until it holds maxNum, deadlineUs has passed since
+    // its first message was queued or a control message is waiting
+    void FillBatch(std::vector<std::shared_ptr<AclLiteMessage>> &msgs,
+                   uint32_t                                      maxNum,
+                   uint32_t                                      deadlineUs);
+    // Wake up the thread blocked on the empty queue
+    void WakeUp()
+    {
+        ringQueue_ ? ringQueue_->WakeUp() : msgQueue_.WakeUp();
+    }
+    // Drop all pending data messages, the control lane is kept
+    void ClearQueue()
     {
-        return this->msgQueue_.Pop();
+        while (PopDataMsg() != nullptr)
+        {
+        }
     }
     void CreateThread();
     void SetStatus(AclLiteThreadStatus status) { status_ = status; }
     AclLiteThreadStatus GetStatus() { return status_; }
     AclLiteError        WaitThreadInitEnd();
-    uint32_t GetQueueSize() { return msgQueue_.Size(); }
+    uint32_t GetQueueSize() { return GetDataQueueSize() + ctrlNum_.load(); }
+    AclLiteQueueType GetQueueType() { return queueType_; }
+    void SetSendPolicy(AclLiteSendPolicy policy, uint32_t timeoutUs)
+    {
+        sendPolicy_ = policy;
+        sendTimeoutUs_ = timeoutUs;
+    }
+    AclLiteSendPolicy GetSendPolicy() { return sendPolicy_; }
+    uint32_t          GetSendTimeout() { return sendTimeoutUs_; }
+    uint64_t          GetDroppedMsgNum() { return metrics_->droppedNum.Get(); }
+    AclLiteStageMetrics *GetMetrics() { return metrics_; }
+    // Run the instance as an actor of the worker pool instead of a dedicated
+    // thread, must be called before CreateThread
+    void SetWorkerPool(AclLiteWorkerPool *pool) { pool_ = pool; }
+    bool IsPoolActor() { return pool_ != nullptr; }
+    // Scheduling settings applied by the thread itself before Init
+    void SetThreadSched(const AclLiteThreadSched &sched) { sched_ = sched; }
+    // Called by the worker pool: init the instance on the first run, then
+    // process at most budget messages
+    void RunActor(uint32_t budget);
 
   public:
     bool                                             isExit_;
@@ -66,5 +127,102 @@ class AclLiteThreadMgr
     AclLiteThread                                   *userInstance_;
     std::string                                      name_;
     ThreadSafeQueue<std::shared_ptr<AclLiteMessage>> msgQueue_;
+    // lock free queue, used instead of msgQueue_ if queueType_ is not
+    // ACLLITE_QUEUE_MUTEX
+    AclLiteQueueType                                 queueType_;
+    RingBufferQueue<std::shared_ptr<AclLiteMessage>> *ringQueue_;
+
+  private:
+    bool QueuePush(std::shared_ptr<AclLiteMessage> &pMessage)
+    {
+        pMessage->enqueueUs = AclLiteNowUs();
+        bool ret = ringQueue_
+                       ? ringQueue_->Push(pMessage, pMessage->droppable)
+                       : msgQueue_.Push(pMessage);
+        if (ret)
+        {
+            dataPushNum_++;
+        }
+        if (ret && pool_ != nullptr)
+        {
+            TrySchedule();
+        }
+        return ret;
+    }
+    bool QueuePushWait(std::shared_ptr<AclLiteMessage> &pMessage,
+                       uint32_t                         timeoutUs)
+    {
+        pMessage->enqueueUs = AclLiteNowUs();
+        bool ret = ringQueue_ ? ringQueue_->PushWait(pMessage, timeoutUs)
+                              : msgQueue_.PushWait(pMessage, timeoutUs);
+        if (ret)
+        {
+            dataPushNum_++;
+        }
+        if (ret && pool_ != nullptr)
+        {
+            TrySchedule();
+        }
+        return ret;
+    }
+    std::shared_ptr<AclLiteMessage> PopDataMsg()
+    {
+        std::shared_ptr<AclLiteMessage> msg =
+            ringQueue_ ? ringQueue_->Pop() : msgQueue_.Pop();
+        if (msg != nullptr)
+        {
+            dataPopNum_++;
+        }
+        return msg;
+    }
+    uint32_t PopDataBatch(std::vector<std::shared_ptr<AclLiteMessage>> &msgs,
+                          uint32_t                                      maxNum)
+    {
+        uint32_t num = ringQueue_ ? ringQueue_->PopBatch(msgs, maxNum)
+                                  : msgQueue_.PopBatch(msgs, maxNum);
+        dataPopNum_ += num;
+        return num;
+    }
+    uint32_t GetDataQueueSize()
+    {
+        return ringQueue_ ? ringQueue_->Size() : msgQueue_.Size();
+    }
+    // Call Process of the user instance and record the metrics
+    int ProcessMsg(std::shared_ptr<AclLiteMessage> &msg);
+    // Call ProcessBatch of the user instance and record the metrics, the
+    // messages are released and msgs is cleared
+    int ProcessBatch(std::vector<std::shared_ptr<AclLiteMessage>> &msgs);
+    // First control message whose fence is passed, nullptr if none
+    std::shared_ptr<AclLiteMessage> PopCtrlMsg();
+    // Submit the actor to the pool unless it is already queued or running
+    void         TrySchedule();
+    AclLiteError PushBlock(std::shared_ptr<AclLiteMessage> &pMessage,
+                           uint32_t                         timeoutUs);
+    // Evict the oldest droppable data message in place to make room, the
+    // lock free queues only check the head. If nothing can be evicted the
+    // message being sent is dropped, the sender never waits
+    AclLiteError PushDropOldest(std::shared_ptr<AclLiteMessage> &pMessage);
+
+  private:
+    AclLiteSendPolicy     sendPolicy_;
+    uint32_t              sendTimeoutUs_;
+    // counters and histograms of this instance, owned by AclLiteMetrics
+    AclLiteStageMetrics  *metrics_;
+    AclLiteWorkerPool    *pool_;
+    // true while the actor is in a run queue or being run by a worker
+    std::atomic<bool>     scheduled_;
+    AclLiteThreadSched    sched_;
+    // control lane, small and rarely used, so a locked deque is enough;
+    // ctrlNum_ lets the pop path skip the lock when the lane is empty
+    std::mutex                                  ctrlMutex_;
+    std::deque<std::shared_ptr<AclLiteMessage>> ctrlQueue_;
+    std::atomic<uint32_t>                       ctrlNum_;
+    // data lane counters for the fence of the control messages
+    std::atomic<uint64_t>                       dataPushNum_;
+    std::atomic<uint64_t>                       dataPopNum_;
+    // reused by the batch path, only touched by the consuming thread
+    std::vector<std::shared_ptr<AclLiteMessage>> batchMsgs_;
+    std::vector<AclLiteThreadMsg>                batchArgs_;
+    bool                                         batchIsCtrl_;
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,177 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File AclLiteTrace.h
+* Description: per frame stage spans and a Chrome trace event JSON sink
+*/
+#ifndef ACLLITE_TRACE_H
+#define ACLLITE_TRACE_H
+#pragma once
+#include "AclLiteError.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// one stage interval of a frame, name must be a string literal
+struct AclLiteSpan
+{
+    const char *name;
+    int64_t     beginUs;
+    int64_t     endUs;
+    int32_t     tid;
+};
+
+/**
+ * Fixed size span array carried inside a frame message. Stages append spans
+ * one after another as the frame is handed down the pipeline, so no locking
+ * is needed. Everything is a no-op unless the frame was sampled.
+ */
+struct AclLiteFrameTrace
+{
+    static const uint32_t kMaxSpans = 16;
+
+    bool        sampled = false;
+    uint32_t    spanNum = 0;
+    AclLiteSpan spans[kMaxSpans];
+
+    // open a span, returns its index or -1 if not sampled or full
+    int Begin(const char *name)
+    {
+        return sampled ? BeginSpan(name) : -1;
+    }
+    // close a span opened by Begin
+    void End(int index)
+    {
+        if (index >= 0)
+        {
+            EndSpan(index);
+        }
+    }
+    // add a span measured by the caller, times from AclLiteNowUs
+    void Add(const char *name, int64_t beginUs, int64_t endUs);
+
+  private:
+    int  BeginSpan(const char *name);
+    void EndSpan(int index);
+};
+
+// span of the enclosing scope
+class AclLiteTraceScope
+{
+  public:
+    AclLiteTraceScope(AclLiteFrameTrace &trace, const char *name)
+        : trace_(trace), index_(trace.Begin(name))
+    {
+    }
+    ~AclLiteTraceScope() { trace_.End(index_); }
+    AclLiteTraceScope(const AclLiteTraceScope &) = delete;
+    AclLiteTraceScope &operator=(const AclLiteTraceScope &) = delete;
+
+  private:
+    AclLiteFrameTrace &trace_;
+    int                index_;
+};
+
+/**
+ * Writes finished frame traces as Chrome trace event JSON, which can be
+ * loaded by chrome://tracing or ui.perfetto.dev. One process row per
+ * channel, one thread row per OS thread. Submit copies the spans into a
+ * ring allocated by Start and a background thread formats them, full ring
+ * drops the frame.
+ */
+class AclLiteTracer
+{
+  public:
+    static AclLiteTracer &GetInstance();
+    ~AclLiteTracer();
+
+    // open path and start the writer, sampling is off until SetEnable
+    AclLiteError Start(const std::string &path, uint32_t ringSize);
+    // write out pending frames and close the file
+    void         Stop();
+
+    // switch sampling at runtime, safe to call from a signal handler
+    void SetEnable(bool enable) { enable_.store(enable, std::memory_order_relaxed); }
+    bool IsEnabled() const { return enable_.load(std::memory_order_relaxed); }
+    // trace one frame in every interval frames of a channel
+    void SetSampleInterval(uint32_t interval)
+    {
+        sampleInterval_.store(interval > 0 ? interval : 1,
+                              std::memory_order_relaxed);
+    }
+
+    // whether frame frameNum of a channel should be traced
+    bool ShouldSample(uint32_t frameNum) const
+    {
+        return enable_.load(std::memory_order_relaxed) &&
+               frameNum % sampleInterval_.load(std::memory_order_relaxed) == 0;
+    }
+
+    // queue a finished frame for writing
+    void Submit(uint32_t channelId, int frameNum, const AclLiteFrameTrace &trace);
+
+    // OS thread id of the caller, the thread is named in the trace by its
+    // pthread name at the first call
+    static int32_t CurrentThreadId();
+
+  private:
+    AclLiteTracer();
+    AclLiteTracer(const AclLiteTracer &) = delete;
+    AclLiteTracer &operator=(const AclLiteTracer &) = delete;
+    void WriterEntry();
+    void WriteRecords();
+    void WriteMetadata(const char        *name,
+                       uint32_t           pid,
+                       int32_t            tid,
+                       const std::string &value);
+    void RegisterThread(int32_t tid);
+
+  private:
+    struct Record
+    {
+        uint32_t          channelId;
+        int               frameNum;
+        AclLiteFrameTrace trace;
+    };
+
+    std::atomic<bool>     enable_;
+    std::atomic<uint32_t> sampleInterval_;
+
+    std::mutex              mutex_;
+    std::condition_variable cond_;
+    std::vector<Record>     ring_;
+    uint32_t                head_;
+    uint32_t                pendingNum_;
+    uint64_t                droppedNum_;
+    bool                    running_;
+    std::thread             writer_;
+    // pthread names of the threads seen by CurrentThreadId
+    std::map<int32_t, std::string> threadNames_;
+
+    // writer thread only
+    FILE                                 *file_;
+    bool                                  firstEvent_;
+    std::set<uint32_t>                    namedChannels_;
+    std::set<std::pair<uint32_t, int32_t>> namedThreads_;
+};
+
+#endif
@@ -25,6 +25,7 @@
 #include <memory>
 #include <string>
 #include <unistd.h>
+#include <vector>
 
 enum MemoryType
 {
@@ -58,8 +59,9 @@ enum VencStatus
     STATUS_VENC_ERROR
 };
 
-// 编码数据回调函数类型
-typedef void (*VencDataCallback)(void* data, uint32_t size, void* userData);
+// 编码数据回调函数类型, ptsUs 为输入帧 ImageData::ptsUs 原样带出, -1 为未知
+typedef void (*VencDataCallback)(void* data, uint32_t size, int64_t ptsUs,
+                                 void* userData);
 
 struct VencConfig
 {
@@ -85,6 +87,7 @@ struct VencConfig
     std::string         rtspTransport = "tcp";  // RTSP传输协议("tcp"或"udp"),默认"tcp"
     uint32_t            rtspBufferSize = 1024000;  // RTSP缓冲区大小(字节),默认1024000 (1MB)
     uint32_t            rtspMaxDelay = 500000;  // RTSP最大延迟(微秒),默认500000 (0.5s)
+    uint32_t            channelId = 0;          // 所属通道, 编码/推流辅助线程和指标按通道命名
 };
 
 struct ImageData
@@ -96,6 +99,10 @@ struct ImageData
     uint32_t                 alignHeight = 0;
     uint32_t                 size = 0;
     std::shared_ptr<uint8_t> data = nullptr;
+    int64_t                  ptsUs = -1;   // source pts in us, -1 if unknown
+    int64_t                  captureUs = 0; // packet received, monotonic
+    int64_t                  decodeUs = 0; // decoder output time, monotonic
+    bool                     streamGap = false; // first frame after reconnect
 };
 
 struct FrameData
@@ -132,6 +139,27 @@ struct AclLiteMessage
     int                   dest;
     int                   msgId;
     std::shared_ptr<void> data = nullptr;
+    bool                  droppable = false; // may be evicted by drop-oldest
+    // control lane only: data messages pushed to dest before this one, the
+    // message is not delivered until they are all popped
+    uint64_t              fence = 0;
+    int64_t               enqueueUs = 0; // AclLiteNowUs when queued
+};
+
+// nice value which keeps the inherited one
+#define ACLLITE_NICE_KEEP (100)
+
+// Cpu affinity and scheduling of a thread, default values keep the settings
+// inherited from the creating thread
+struct AclLiteThreadSched
+{
+    std::vector<int> cpus;                     // allowed cpus, empty: not bound
+    int              nice = ACLLITE_NICE_KEEP; // -20..19
+    int              fifoPriority = 0;         // 1..99 uses SCHED_FIFO
+    bool IsDefault() const
+    {
+        return cpus.empty() && nice == ACLLITE_NICE_KEEP && fifoPriority == 0;
+    }
 };
 
 struct DataInfo
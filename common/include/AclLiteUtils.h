@@ -532,4 +532,42 @@ bool ReadConfig(std::map<std::string, std::string> &config,
  * @return None
  */
 void PrintConfig(const std::map<std::string, std::string> &m);
+
+/**
+ * @brief strip the leading and trailing blanks, tabs and line breaks of a
+ *        config value
+ * @param [in]: value: string to trim
+ * @return trimmed copy, empty if value is all whitespace
+ */
+std::string TrimString(const std::string &value);
+
+/**
+ * @brief name the calling thread and apply the cpu affinity, nice value and
+ *        SCHED_FIFO priority, failures are logged and the thread goes on
+ * @param [in]: name: thread name, truncated to 15 characters
+ * @param [in]: sched: scheduling settings
+ * @return ACLLITE_OK or ACLLITE_ERROR_SET_THREAD_SCHED
+ */
+AclLiteError SetCurrentThreadSched(const std::string        &name,
+                                   const AclLiteThreadSched &sched);
+
+/**
+ * @brief register the scheduling settings of a kind of helper thread, such
+ *        as "decode", "encode" or "rtsp_push"
+ * @param [in]: role: helper thread kind
+ * @param [in]: sched: scheduling settings
+ * @return None
+ */
+void SetHelperThreadSched(const std::string        &role,
+                          const AclLiteThreadSched &sched);
+
+/**
+ * @brief called at the start of a helper thread: name it and apply the
+ *        settings registered for role. A helper without settings keeps the
+ *        ones inherited from the stage thread which created it
+ * @param [in]: role: helper thread kind
+ * @param [in]: name: thread name
+ * @return None
+ */
+void ApplyHelperThreadSched(const std::string &role, const std::string &name);
 #endif
\ No newline at end of file
@@ -26,6 +26,22 @@
 #define RTSP_TRANS_UDP ((uint32_t)0)
 #define RTSP_TRANS_TCP ((uint32_t)1)
 
+#define LATENCY_MODE_ACCURATE ((uint32_t)0) // every decoded frame is read
+#define LATENCY_MODE_LIVE ((uint32_t)1)     // newest frame wins
+
+#define DECODE_BACKEND_AUTO ((uint32_t)0) // vdec, software if vdec can not
+#define DECODE_BACKEND_VDEC ((uint32_t)1) // dvpp vdec only
+#define DECODE_BACKEND_SOFT ((uint32_t)2) // libavcodec on the cpu
+
+// Decoder choice of a video/rtsp input, fixed when the input is opened
+struct VideoDecodeConfig
+{
+    uint32_t backend = DECODE_BACKEND_AUTO;
+    uint32_t softThreads = 0; // software decoder threads, 0 = per cpu core
+    // backoff cap of reconnecting a dropped rtsp input, 0 = end the stream
+    uint32_t reconnectMaxMs = 10000;
+};
+
 enum StreamProperty
 {
     FRAME_WIDTH = 1,
@@ -33,7 +49,10 @@ enum StreamProperty
     VIDEO_FPS = 3,
     OUTPUT_IMAGE_FORMAT = 4,
     RTSP_TRANSPORT = 5,
-    STREAM_FORMAT = 6
+    STREAM_FORMAT = 6,
+    TARGET_FPS = 7, // decode pacing by stream pts, 0 = decode every frame
+    LATENCY_MODE = 8, // LATENCY_MODE_ACCURATE or LATENCY_MODE_LIVE
+    LOOP_PLAYBACK = 9, // 1 = restart at the end of a file input
 };
 
 class AclLiteVideoCapBase
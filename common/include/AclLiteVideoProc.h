@@ -32,9 +32,10 @@ class AclLiteVideoProc
                      uint32_t width = 1280,
                      uint32_t height = 720,
                      uint32_t fps = 15);
-    AclLiteVideoProc(const std::string &videoPath,
-                     int32_t            deviceId = 0,
-                     aclrtContext       context = nullptr);
+    AclLiteVideoProc(const std::string       &videoPath,
+                     int32_t                  deviceId = 0,
+                     aclrtContext             context = nullptr,
+                     const VideoDecodeConfig &decodeConfig = VideoDecodeConfig());
     AclLiteVideoProc(VencConfig &vencConfig, aclrtContext context = nullptr);
     ~AclLiteVideoProc();
 
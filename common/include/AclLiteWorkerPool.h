@@ -0,0 +1,91 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File AclLiteWorkerPool.h
+* Description: fixed size work stealing pool which runs AclLiteThread
+*              instances as actors
+*/
+#ifndef ACLLITE_WORKER_POOL_H
+#define ACLLITE_WORKER_POOL_H
+#pragma once
+#include "acl/acl.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class AclLiteThreadMgr;
+
+/**
+ * Each worker owns a run queue of actors (AclLiteThreadMgr in pool mode).
+ * An actor is in at most one run queue at a time and is run by one worker
+ * at a time, so the messages of one instance are processed in order.
+ * Idle workers steal actors from the tail of the other run queues.
+ * Worker i is pinned to the i-th cpu of the configured set, or of the cpus
+ * the process may run on, wrapping around when there are more workers.
+ */
+class AclLiteWorkerPool
+{
+  public:
+    /**
+     * @param [in]: workerNum: worker thread number, 0 means cpu core number
+     * @param [in]: cpus: cpus the workers are pinned to, empty means all the
+     *              cpus of the process
+     */
+    AclLiteWorkerPool(uint32_t                workerNum,
+                      const std::vector<int> &cpus = std::vector<int>());
+    ~AclLiteWorkerPool();
+    AclLiteWorkerPool(const AclLiteWorkerPool &) = delete;
+    AclLiteWorkerPool &operator=(const AclLiteWorkerPool &) = delete;
+
+    void     Start();
+    void     Stop();
+    uint32_t GetWorkerNum() { return workerNum_; }
+    // Put a runnable actor to a run queue, caller owns the scheduled flag
+    void Submit(AclLiteThreadMgr *actor);
+    // Run one runnable actor on the calling worker, used by a worker which
+    // would otherwise block on a full queue. Return false if nothing to run
+    bool RunOneTask();
+    // Whether the calling thread is a worker of any pool
+    static bool InWorker();
+    // RunOneTask on the pool of the calling worker
+    static bool HelpOnce();
+
+  private:
+    struct Worker
+    {
+        std::deque<AclLiteThreadMgr *> runQueue;
+        std::mutex                     mutex;
+        std::thread                    thread;
+    };
+    void              WorkerEntry(uint32_t index);
+    AclLiteThreadMgr *TakeTask(uint32_t index);
+    void              RunTask(AclLiteThreadMgr *actor);
+
+  private:
+    uint32_t                workerNum_;
+    std::vector<int>        cpus_;
+    std::vector<Worker *>   workers_;
+    std::atomic<bool>       running_;
+    std::atomic<uint32_t>   nextWorker_;
+    std::atomic<int>        pendingNum_;
+    std::atomic<int>        idleNum_;
+    std::mutex              idleMutex_;
+    std::condition_variable idleCond_;
+};
+
+#endif
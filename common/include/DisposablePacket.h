@@ -0,0 +1,57 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File DisposablePacket.h
+* Description: finds the annexb packets which can be dropped before decoding
+*/
+#ifndef DISPOSABLE_PACKET_H
+#define DISPOSABLE_PACKET_H
+#pragma once
+
+#include <cstdint>
+
+/**
+ * A packet is disposable if no other picture references it. For h264 that
+ * is a slice with nal_ref_idc 0. For h265 a sub-layer non-reference picture
+ * (TRAIL_N, TSA_N, STSA_N, RADL_N, RASL_N and reserved _N) is only skipped
+ * by pictures of its own sub-layer, higher sub-layers may still reference
+ * it, so it is disposable only on the highest sub-layer of the stream. The
+ * number of sub-layers comes from the last SPS, or while no SPS was seen
+ * from the highest TemporalId seen so far. All slices of a picture share
+ * the NAL type and TemporalId, so only the first one is looked at.
+ */
+class DisposablePacketFilter
+{
+  public:
+    DisposablePacketFilter();
+
+    /**
+     * @brief Whether the packet can be dropped before decoding. Every packet
+     *        of the stream should go through here, so the SPS are seen
+     * @param [in]: data: one annexb access unit
+     * @param [in]: size: data size in bytes
+     * @param [in]: videoType: AV_CODEC_ID_H264 or AV_CODEC_ID_HEVC, other
+     *              codecs are never disposable
+     * @return true if nothing references the picture
+     */
+    bool IsDisposable(const uint8_t *data, int size, int videoType);
+    void Reset();
+
+  private:
+    int spsMaxTemporalId_;  // from sps_max_sub_layers_minus1, -1 if no SPS
+    int seenMaxTemporalId_; // highest TemporalId of a slice so far
+};
+
+#endif
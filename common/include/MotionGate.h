@@ -0,0 +1,87 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File MotionGate.h
+* Description: frame difference against a running background of a
+*              downscaled luma plane
+*/
+#ifndef MOTION_GATE_H
+#define MOTION_GATE_H
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct MotionGateConfig
+{
+    bool     enable = false;
+    uint32_t gridWidth = 160;        // cells per row of the downscaled plane
+    uint32_t pixelThreshold = 12;    // luma change of an active cell
+    float    activityThreshold = 0;  // active cell ratio of motion, 0 = any
+    float    learningRate = 0.05f;   // background update weight per frame
+    uint32_t maxSkipFrames = 25;     // quiet frames before a forced pass
+};
+
+/**
+ * The luma plane is split into square cells of about width / gridWidth
+ * pixels, each reduced to the mean of a 2x sampled subset of its pixels.
+ * A cell is active when its mean differs from the running background by
+ * more than pixelThreshold, after the mean difference of all cells (auto
+ * exposure, passing clouds) is taken off. Cell averaging keeps a target a
+ * few pixels wide visible, which point sampling at the same grid would miss.
+ *
+ * Update returns false only for a quiet frame. The first frame, a changed
+ * frame size and the frame after maxSkipFrames quiet ones in a row count as
+ * motion, so the caller still runs detection on them; 0 never forces.
+ */
+class MotionGate
+{
+  public:
+    explicit MotionGate(const MotionGateConfig &config);
+
+    /**
+     * @brief Compare a frame with the background, then update the background
+     * @param [in]: luma: Y plane, stride bytes per row
+     * @return true if the frame has motion or is forced
+     */
+    bool     Update(const uint8_t *luma,
+                    uint32_t       width,
+                    uint32_t       height,
+                    uint32_t       stride);
+    // drop the background, the next frame starts over
+    void     Reset();
+    // active cell ratio of the last frame, 0 on a first frame
+    float    Activity() const { return activity_; }
+    // whether the last true from Update came from the skip limit
+    bool     Forced() const { return forced_; }
+
+  private:
+    void Downscale(const uint8_t *luma, uint32_t stride);
+
+  private:
+    MotionGateConfig     config_;
+    uint32_t             width_;
+    uint32_t             height_;
+    uint32_t             cellSize_;
+    uint32_t             cols_;
+    uint32_t             rows_;
+    std::vector<uint8_t> cells_;      // cell means of the current frame
+    std::vector<float>   background_;
+    uint32_t             quietNum_;   // quiet frames since the last motion
+    float                activity_;
+    bool                 forced_;
+};
+
+#endif
@@ -0,0 +1,231 @@
+#ifndef OBJECT_POOL_H
+#define OBJECT_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+/**
+ * 线程安全的对象池, Acquire 返回带自定义 deleter 的 shared_ptr.
+ *
+ * 最后一个持有者释放时, 对象先经 reset 回调复位(可保留 vector 容量),
+ * 再放回空闲链表; shared_ptr 的控制块也从池内的空闲块分配, 因此稳定
+ * 状态下 Acquire/释放 不产生堆分配. 空闲对象超过 capacity 时直接释放.
+ * 池本身先于在途对象析构是安全的: 在途对象释放时直接 delete.
+ */
+template <typename T> class ObjectPool
+{
+  public:
+    typedef std::function<void(T &)> ResetFunc;
+
+    /**
+     * @brief ObjectPool constructor
+     * @param [in] capacity: max idle objects kept by the pool
+     * @param [in] reset: called on an object before it goes back to the pool
+     */
+    explicit ObjectPool(uint32_t capacity, ResetFunc reset = nullptr)
+        : core_(std::make_shared<Core>(capacity, reset))
+    {
+    }
+
+    ObjectPool(const ObjectPool &) = delete;
+    ObjectPool &operator=(const ObjectPool &) = delete;
+
+    /**
+     * @brief ObjectPool destructor, objects still in use are deleted when
+     *        their last owner releases them
+     */
+    ~ObjectPool()
+    {
+        std::lock_guard<std::mutex> lock(core_->mutex);
+        core_->closed = true;
+    }
+
+    /**
+     * @brief get an object from the pool, create one if the pool is empty
+     * @return shared pointer which gives the object back on release
+     */
+    std::shared_ptr<T> Acquire()
+    {
+        T *obj = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(core_->mutex);
+            if (!core_->objects.empty())
+            {
+                obj = core_->objects.back();
+                core_->objects.pop_back();
+            }
+        }
+        if (obj != nullptr)
+        {
+            core_->hitNum++;
+        }
+        else
+        {
+            core_->missNum++;
+            obj = new T();
+        }
+        return std::shared_ptr<T>(
+            obj, Deleter(core_), BlockAllocator<T>(core_));
+    }
+
+    /**
+     * @brief create num idle objects in advance
+     */
+    void Reserve(uint32_t num)
+    {
+        std::lock_guard<std::mutex> lock(core_->mutex);
+        for (uint32_t i = 0; i < num && core_->objects.size() < core_->capacity;
+             i++)
+        {
+            core_->objects.push_back(new T());
+        }
+    }
+
+    /**
+     * @brief number of Acquire served from the pool
+     */
+    uint64_t GetHitNum() { return core_->hitNum.load(); }
+
+    /**
+     * @brief number of Acquire which created a new object
+     */
+    uint64_t GetMissNum() { return core_->missNum.load(); }
+
+    /**
+     * @brief number of idle objects in the pool
+     */
+    uint32_t GetIdleNum()
+    {
+        std::lock_guard<std::mutex> lock(core_->mutex);
+        return core_->objects.size();
+    }
+
+  private:
+    struct Core
+    {
+        Core(uint32_t cap, ResetFunc resetFunc)
+            : capacity(cap), reset(resetFunc), hitNum(0), missNum(0)
+        {
+            objects.reserve(capacity);
+            blocks.reserve(capacity);
+        }
+        ~Core()
+        {
+            for (size_t i = 0; i < objects.size(); i++)
+            {
+                delete objects[i];
+            }
+            for (size_t i = 0; i < blocks.size(); i++)
+            {
+                ::operator delete(blocks[i]);
+            }
+        }
+
+        std::mutex            mutex;
+        std::vector<T *>      objects;       // idle objects
+        std::vector<void *>   blocks;        // idle shared_ptr control blocks
+        size_t                blockSize = 0; // control block size of T
+        uint32_t              capacity;
+        ResetFunc             reset;
+        bool                  closed = false;
+        std::atomic<uint64_t> hitNum;
+        std::atomic<uint64_t> missNum;
+    };
+
+    struct Deleter
+    {
+        explicit Deleter(const std::shared_ptr<Core> &core) : core_(core) {}
+        void operator()(T *obj) const
+        {
+            if (core_->reset)
+            {
+                core_->reset(*obj);
+            }
+            {
+                std::lock_guard<std::mutex> lock(core_->mutex);
+                if (!core_->closed &&
+                    core_->objects.size() < core_->capacity)
+                {
+                    core_->objects.push_back(obj);
+                    return;
+                }
+            }
+            delete obj;
+        }
+        std::shared_ptr<Core> core_;
+    };
+
+    // allocates the shared_ptr control blocks from Core::blocks
+    template <typename U> struct BlockAllocator
+    {
+        typedef U value_type;
+        template <typename V> struct rebind
+        {
+            typedef BlockAllocator<V> other;
+        };
+
+        explicit BlockAllocator(const std::shared_ptr<Core> &core)
+            : core_(core)
+        {
+        }
+        template <typename V>
+        BlockAllocator(const BlockAllocator<V> &other) : core_(other.core_)
+        {
+        }
+
+        U *allocate(size_t n)
+        {
+            size_t size = sizeof(U) * n;
+            {
+                std::lock_guard<std::mutex> lock(core_->mutex);
+                if (core_->blockSize == 0)
+                {
+                    core_->blockSize = size;
+                }
+                if (size == core_->blockSize && !core_->blocks.empty())
+                {
+                    void *block = core_->blocks.back();
+                    core_->blocks.pop_back();
+                    return static_cast<U *>(block);
+                }
+            }
+            return static_cast<U *>(::operator new(size));
+        }
+
+        void deallocate(U *p, size_t n)
+        {
+            size_t size = sizeof(U) * n;
+            {
+                std::lock_guard<std::mutex> lock(core_->mutex);
+                if (!core_->closed && size == core_->blockSize &&
+                    core_->blocks.size() < core_->capacity)
+                {
+                    core_->blocks.push_back(p);
+                    return;
+                }
+            }
+            ::operator delete(p);
+        }
+
+        template <typename V> bool operator==(const BlockAllocator<V> &other) const
+        {
+            return core_ == other.core_;
+        }
+        template <typename V> bool operator!=(const BlockAllocator<V> &other) const
+        {
+            return core_ != other.core_;
+        }
+
+        std::shared_ptr<Core> core_;
+    };
+
+    std::shared_ptr<Core> core_;
+};
+
+#endif /* OBJECT_POOL_H */
@@ -0,0 +1,112 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File PicDirReader.h
+* Description: reads a list of jpeg files ahead on a pool of jpegd workers
+*/
+#ifndef PIC_DIR_READER_H
+#define PIC_DIR_READER_H
+#pragma once
+
+#include "AclLiteError.h"
+#include "AclLiteImageProc.h"
+#include "AclLiteMetrics.h"
+#include "AclLiteType.h"
+#include "acl/acl.h"
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Each file is read and decoded once, by the dvpp jpegd of one worker; every
+ * worker owns its jpegd channel and stream. The workers run at most prefetch
+ * files ahead of Read, which returns the pictures in file order. A file that
+ * can not be read or decoded is skipped with a warning.
+ *
+ * Besides the jpegd output in dvpp memory, Read gives the same picture in
+ * host memory with the rows packed (stride = width), so a BGR image can be
+ * derived from it when one is needed instead of decoding the file again.
+ */
+class PicDirReader
+{
+  public:
+    /**
+     * @param [in]: name: prefix of the metrics, e.g. picdec0
+     * @param [in]: files: jpeg files in the order they are read
+     * @param [in]: workerNum: decode threads, at least 1
+     * @param [in]: prefetch: decoded pictures waiting at most, >= workerNum
+     */
+    PicDirReader(const std::string              &name,
+                 const std::vector<std::string> &files,
+                 uint32_t                        workerNum,
+                 uint32_t                        prefetch,
+                 aclrtRunMode                    runMode);
+    ~PicDirReader();
+
+    // Start the workers on the acl context of the calling thread
+    AclLiteError Open();
+    /**
+     * @brief Next picture in file order, blocks until it is decoded
+     * @param [out]: dvppImg: decoded NV12 in dvpp memory, jpegd alignment
+     * @param [out]: hostImg: the same NV12 in host memory, stride = width
+     * @return ACLLITE_ERROR_DECODE_FINISH after the last file
+     */
+    AclLiteError Read(ImageData &dvppImg, ImageData &hostImg);
+    void         Close();
+    size_t       FileNum() const { return files_.size(); }
+
+  private:
+    struct Slot
+    {
+        bool         ready = false;
+        AclLiteError ret = ACLLITE_OK;
+        ImageData    dvppImg;
+        ImageData    hostImg;
+    };
+
+    static void  WorkerEntry(PicDirReader *self, uint32_t index);
+    void         WorkerLoop(AclLiteImageProc &jpegd);
+    AclLiteError DecodeFile(AclLiteImageProc  &jpegd,
+                            const std::string &file,
+                            Slot              &slot);
+    AclLiteError PackToHost(ImageData &hostImg, ImageData &dvppImg);
+
+  private:
+    std::string              name_;
+    std::vector<std::string> files_;
+    uint32_t                 workerNum_;
+    uint32_t                 prefetch_;
+    aclrtRunMode             runMode_;
+    aclrtContext             context_;
+
+    std::mutex               mutex_;
+    std::condition_variable  decoded_;  // a slot became ready
+    std::condition_variable  consumed_; // a slot was read, or stop
+    std::vector<Slot>        slots_;    // file i is kept in slot i % prefetch
+    size_t                   nextDecode_;
+    size_t                   nextRead_;
+    uint32_t                 startedNum_;
+    uint32_t                 failedNum_; // workers whose jpegd init failed
+    bool                     stop_;
+    std::vector<std::thread> workers_;
+
+    AclLiteHistogram *decodeTime_; // read + jpegd + host copy of a file
+    AclLiteHistogram *readWait_;   // Read blocked on a picture not yet done
+    AclLiteCounter   *skippedNum_; // files which failed to read or decode
+};
+
+#endif
@@ -0,0 +1,79 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File RawVideoReader.h
+* Description: reads uncompressed Y4M or headerless NV12 files through mmap
+*/
+#ifndef RAW_VIDEO_READER_H
+#define RAW_VIDEO_READER_H
+#pragma once
+#include "AclLiteVideoCapBase.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Frames are handed out as host NV12 ImageData. A headerless NV12 file is
+ * served zero copy: the frame data points into the read only mapping, which
+ * stays alive as long as any frame does. Y4M stores planar 4:2:0, its
+ * chroma is interleaved into a new buffer per frame. Nothing here depends
+ * on the decoder or the device, so the reader also runs on a dev box.
+ *
+ * TARGET_FPS paces Read on a steady clock grid, 0 (default) returns frames
+ * as fast as they are read. LOOP_PLAYBACK 1 restarts at the first frame
+ * instead of returning ACLLITE_ERROR_DECODE_FINISH.
+ */
+class RawVideoReader : public AclLiteVideoCapBase
+{
+  public:
+    // width and height are required for a headerless NV12 file and
+    // ignored for Y4M, which carries them in its header
+    RawVideoReader(const std::string &path,
+                   uint32_t           width = 0,
+                   uint32_t           height = 0);
+    ~RawVideoReader();
+
+    static bool IsY4mFile(const std::string &path);
+
+    bool         IsOpened() { return mapping_ != nullptr; }
+    AclLiteError Set(StreamProperty key, uint32_t value);
+    uint32_t     Get(StreamProperty key);
+    AclLiteError Read(ImageData &frame);
+    AclLiteError Close();
+    AclLiteError Open();
+
+  private:
+    AclLiteError ParseY4mHeader();
+    AclLiteError IndexFrames();
+    void         WaitFrameDue();
+    void         InterleaveChroma(const uint8_t *planar, uint8_t *nv12);
+
+  private:
+    std::string              path_;
+    bool                     isY4m_;
+    uint32_t                 width_;
+    uint32_t                 height_;
+    uint32_t                 fileFps_;   // Y4M header rate, 0 if unknown
+    std::shared_ptr<uint8_t> mapping_;   // whole file, unmapped with the
+    size_t                   mapSize_;   // last frame referring to it
+    std::vector<size_t>      frameOffsets_; // start of each frame's pixels
+    size_t                   frameIndex_;
+    uint64_t                 readNum_;    // frames read, loops included
+    bool                     loop_;
+    int64_t                  intervalUs_; // 0 = as fast as possible
+    int64_t                  nextDueUs_;
+};
+
+#endif
@@ -0,0 +1,415 @@
+#ifndef RING_BUFFER_QUEUE_H
+#define RING_BUFFER_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/**
+ * 固定容量无锁环形队列, 与 ThreadSafeQueue 保持相同的
+ * Push/PushWait/Pop/PopBatch/PopWait/WaitNotEmpty/WakeUp/Size/Empty/Clear 接口.
+ *
+ * 基于每槽位序号的有界队列: 生产者在入队位置上竞争(单生产者模式下直接写),
+ * 出队一侧使用 CAS, 因此 Clear 可以在非消费线程中调用(如 ClearThreadQueue).
+ * 读写位置和每个槽位都按 cache line 填充, 避免生产者/消费者伪共享.
+ * 只有消费者(队列空)或生产者(队列满)需要睡眠时才会用到
+ * mutex/condition_variable.
+ */
+template <typename T> class RingBufferQueue
+{
+  public:
+    /**
+     * @brief RingBufferQueue constructor
+     * @param [in] capacity: the queue capacity
+     * @param [in] multiProducer: false only if exactly one thread pushes
+     */
+    RingBufferQueue(uint32_t capacity, bool multiProducer = true)
+        : multiProducer_(multiProducer), enqueuePos_(0), dequeuePos_(0),
+          waiters_(0), pushWaiters_(0)
+    {
+        if (capacity >= kMinQueueCapacity && capacity <= kMaxQueueCapacity)
+        {
+            queueCapacity_ = capacity;
+        }
+        else
+        {
+            queueCapacity_ = kDefaultQueueCapacity;
+        }
+        cells_ = new Cell[queueCapacity_];
+        for (size_t i = 0; i < queueCapacity_; i++)
+        {
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+            cells_[i].evictable.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    RingBufferQueue(const RingBufferQueue &) = delete;
+    RingBufferQueue &operator=(const RingBufferQueue &) = delete;
+
+    /**
+     * @brief RingBufferQueue destructor
+     */
+    ~RingBufferQueue() { delete[] cells_; }
+
+    /**
+     * @brief push data to queue
+     * @param [in] input_value: the value will push to the queue
+     * @param [in] evictable: the element may be removed by PushEvict
+     * @return true: success to push data; false: the queue is full
+     */
+    bool Push(T input_value, bool evictable = false)
+    {
+        Cell  *cell;
+        size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        while (true)
+        {
+            cell = &cells_[pos % queueCapacity_];
+            size_t   seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0)
+            {
+                if (!multiProducer_)
+                {
+                    enqueuePos_.store(pos + 1, std::memory_order_relaxed);
+                    break;
+                }
+                if (enqueuePos_.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false; // full
+            }
+            else
+            {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = std::move(input_value);
+        cell->evictable.store(evictable, std::memory_order_relaxed);
+        cell->seq.store(pos + 1, std::memory_order_release);
+
+        // only take the lock when a consumer is sleeping in PopWait
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_relaxed) > 0)
+        {
+            std::lock_guard<std::mutex> lock(waitMutex_);
+            notEmpty_.notify_one();
+        }
+        return true;
+    }
+
+    /**
+     * @brief push data to queue, if the queue is full and its head was
+     *        pushed evictable, remove the head to make room. Only the head
+     *        can be taken without a lock, an evictable element behind a non
+     *        evictable one is left in place; nothing is moved to the tail
+     * @param [in] input_value: the value will push to the queue
+     * @param [in] evictable: the element may be removed by a later PushEvict
+     * @param [out] evicted: the removed element, nullptr if none
+     * @return true: success to push data; false: the queue is still full,
+     *         evicted may be set if another producer took the slot
+     */
+    bool PushEvict(T input_value, bool evictable, T &evicted)
+    {
+        evicted = nullptr;
+        if (Push(input_value, evictable))
+        {
+            return true;
+        }
+        // fails if the head is not evictable or the consumer emptied the
+        // queue meanwhile, push again in both cases
+        PopOne(evicted, true);
+        return Push(input_value, evictable);
+    }
+
+    /**
+     * @brief push data to queue, block until there is free space, the
+     *        timeout expires or WakeUp is called
+     * @param [in] input_value: the value will push to the queue
+     * @param [in] timeoutUs: max time to wait in microseconds
+     * @return true: success to push data; false: the queue is still full
+     */
+    bool PushWait(T input_value, uint32_t timeoutUs)
+    {
+        if (Push(input_value))
+        {
+            return true;
+        }
+
+        auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::microseconds(timeoutUs);
+        std::unique_lock<std::mutex> lock(waitMutex_);
+        uint64_t wakeupSeq = wakeupSeq_;
+        while (true)
+        {
+            pushWaiters_.fetch_add(1, std::memory_order_seq_cst);
+            bool ready = notFull_.wait_until(
+                lock, deadline, [this, wakeupSeq] {
+                    return Size() < queueCapacity_ ||
+                           wakeupSeq != wakeupSeq_;
+                });
+            pushWaiters_.fetch_sub(1, std::memory_order_relaxed);
+            if (!ready || wakeupSeq != wakeupSeq_)
+            {
+                break;
+            }
+            // Push notifies the consumer under waitMutex_
+            lock.unlock();
+            if (Push(input_value))
+            {
+                return true;
+            }
+            lock.lock();
+        }
+        lock.unlock();
+        return Push(input_value);
+    }
+
+    /**
+     * @brief pop data from queue
+     * @return the data; nullptr if the queue is empty
+     */
+    T Pop()
+    {
+        T tmp_ptr = nullptr;
+        if (!PopOne(tmp_ptr))
+        {
+            return nullptr;
+        }
+        NotifyNotFull();
+        return tmp_ptr;
+    }
+
+    /**
+     * @brief pop up to maxNum elements, sleeping producers are notified once
+     * @param [out] output: the popped elements are appended in queue order
+     * @param [in] maxNum: max number of elements to pop
+     * @return number of elements popped
+     */
+    uint32_t PopBatch(std::vector<T> &output, uint32_t maxNum)
+    {
+        uint32_t num = 0;
+        T        tmp_ptr = nullptr;
+        while (num < maxNum && PopOne(tmp_ptr))
+        {
+            output.push_back(std::move(tmp_ptr));
+            tmp_ptr = nullptr;
+            num++;
+        }
+        if (num > 0)
+        {
+            NotifyNotFull();
+        }
+        return num;
+    }
+
+    /**
+     * @brief pop data from queue, block until data arrives, the timeout
+     *        expires or WakeUp is called
+     * @param [in] timeoutUs: max time to wait in microseconds
+     * @return the data; nullptr if no data is available when woken up
+     */
+    T PopWait(uint32_t timeoutUs)
+    {
+        T tmp_ptr = Pop();
+        if (tmp_ptr != nullptr)
+        {
+            return tmp_ptr;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(waitMutex_);
+            uint64_t wakeupSeq = wakeupSeq_;
+            waiters_.fetch_add(1, std::memory_order_seq_cst);
+            notEmpty_.wait_for(lock,
+                               std::chrono::microseconds(timeoutUs),
+                               [this, wakeupSeq] {
+                                   return !Empty() ||
+                                          wakeupSeq != wakeupSeq_;
+                               });
+            waiters_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return Pop();
+    }
+
+    /**
+     * @brief get the current WakeUp sequence, pass it to WaitNotEmpty so
+     *        that a WakeUp called after this point is not missed
+     */
+    uint64_t GetWakeupSeq()
+    {
+        std::lock_guard<std::mutex> lock(waitMutex_);
+        return wakeupSeq_;
+    }
+
+    /**
+     * @brief block until the queue is not empty, the timeout expires or
+     *        WakeUp is called after wakeupSeq was read
+     * @param [in] timeoutUs: max time to wait in microseconds
+     * @param [in] wakeupSeq: value returned by GetWakeupSeq
+     * @return true: the queue is not empty; false: the queue is empty
+     */
+    bool WaitNotEmpty(uint32_t timeoutUs, uint64_t wakeupSeq)
+    {
+        {
+            std::unique_lock<std::mutex> lock(waitMutex_);
+            waiters_.fetch_add(1, std::memory_order_seq_cst);
+            notEmpty_.wait_for(lock,
+                               std::chrono::microseconds(timeoutUs),
+                               [this, wakeupSeq] {
+                                   return !Empty() ||
+                                          wakeupSeq != wakeupSeq_;
+                               });
+            waiters_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return !Empty();
+    }
+
+    /**
+     * @brief wake up all threads blocked in PopWait or PushWait
+     */
+    void WakeUp()
+    {
+        {
+            std::lock_guard<std::mutex> lock(waitMutex_);
+            wakeupSeq_++;
+        }
+        notEmpty_.notify_all();
+        notFull_.notify_all();
+    }
+
+    /**
+     * @brief check the queue is empty, lock free
+     * @return true: the queue is empty; false: the queue is not empty
+     */
+    bool Empty() { return Size() == 0; }
+
+    /**
+     * @brief get the queue size, lock free. The value is a snapshot and may
+     *        include an element that is being written by a producer
+     * @return the queue size
+     */
+    uint32_t Size()
+    {
+        size_t deq = dequeuePos_.load(std::memory_order_seq_cst);
+        size_t enq = enqueuePos_.load(std::memory_order_seq_cst);
+        if (enq <= deq)
+        {
+            return 0;
+        }
+        size_t size = enq - deq;
+        return size > queueCapacity_ ? queueCapacity_ : (uint32_t)size;
+    }
+
+    /**
+     * @brief get the queue capacity
+     */
+    uint32_t Capacity() { return queueCapacity_; }
+
+    /**
+     * @brief clear all data in queue, safe to call concurrently with Pop
+     */
+    void Clear()
+    {
+        while (Pop() != nullptr)
+        {
+        }
+    }
+
+  private:
+    static const size_t kCacheLineSize = 64;
+
+    // take the element at the dequeue position, false if the queue is empty
+    // or onlyEvictable is set and the element was not pushed evictable
+    bool PopOne(T &output, bool onlyEvictable = false)
+    {
+        Cell  *cell;
+        size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        while (true)
+        {
+            cell = &cells_[pos % queueCapacity_];
+            size_t   seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0)
+            {
+                // a consumer taking the cell meanwhile fails the CAS below
+                if (onlyEvictable &&
+                    !cell->evictable.load(std::memory_order_relaxed))
+                {
+                    return false;
+                }
+                if (dequeuePos_.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false; // empty
+            }
+            else
+            {
+                pos = dequeuePos_.load(std::memory_order_relaxed);
+            }
+        }
+        output = std::move(cell->data);
+        cell->data = nullptr;
+        cell->seq.store(pos + queueCapacity_, std::memory_order_release);
+        return true;
+    }
+
+    // only take the lock when a producer is sleeping in PushWait
+    void NotifyNotFull()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (pushWaiters_.load(std::memory_order_relaxed) > 0)
+        {
+            std::lock_guard<std::mutex> lock(waitMutex_);
+            notFull_.notify_all();
+        }
+    }
+
+    struct CellBody
+    {
+        std::atomic<size_t> seq;
+        std::atomic<bool>   evictable;
+        T                   data;
+    };
+    struct Cell : CellBody
+    {
+        char pad[kCacheLineSize - sizeof(CellBody) % kCacheLineSize];
+    };
+
+    const uint32_t kMinQueueCapacity = 1;
+    const uint32_t kMaxQueueCapacity = 10000;
+    const uint32_t kDefaultQueueCapacity = 10;
+
+    uint32_t queueCapacity_;
+    bool     multiProducer_;
+    Cell    *cells_;
+
+    char                pad0_[kCacheLineSize];
+    std::atomic<size_t> enqueuePos_; // written by producers
+    char                pad1_[kCacheLineSize - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> dequeuePos_; // written by consumer
+    char                pad2_[kCacheLineSize - sizeof(std::atomic<size_t>)];
+
+    std::atomic<int>        waiters_;     // consumers sleeping in PopWait
+    std::atomic<int>        pushWaiters_; // producers sleeping in PushWait
+    std::mutex              waitMutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+    uint64_t                wakeupSeq_ = 0;
+};
+
+#endif /* RING_BUFFER_QUEUE_H */
@@ -0,0 +1,84 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File SoftDecodeBackend.h
+* Description: video decode backend on the libavcodec software decoder
+*/
+#ifndef SOFT_DECODE_BACKEND_H
+#define SOFT_DECODE_BACKEND_H
+#pragma once
+
+#include "VideoDecodeBackend.h"
+#include "acl/acl.h"
+#include <vector>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libswscale/swscale.h>
+}
+
+// Decodes on the cpu in the demux thread and delivers the frames
+// synchronously, in the same layout as vdec: NV12 in dvpp memory with the
+// width stride aligned to 16 and the height stride to 2. Needs no vdec
+// channel, any pixel format libavcodec outputs (10 bit, 4:2:2 ...) is
+// converted to 8 bit NV12. A frame decoded with keep false is delivered as
+// nullptr without the conversion and the copy to dvpp
+class SoftDecodeBackend : public VideoDecodeBackend
+{
+  public:
+    /**
+     * @param [in]: codecId: AVCodecID of the stream
+     * @param [in]: threadNum: decoder threads, 0 = one per cpu core
+     */
+    SoftDecodeBackend(int                  codecId,
+                      uint32_t             width,
+                      uint32_t             height,
+                      uint32_t             threadNum,
+                      aclrtRunMode         runMode,
+                      DecodedFrameCallBack callback,
+                      void                *userData);
+    ~SoftDecodeBackend();
+
+    AclLiteError Init();
+    AclLiteError Decode(const void *data, int size, uint32_t frameId,
+                        bool keep);
+    AclLiteError Flush();
+    AclLiteError SetFormat(uint32_t format);
+    bool         IsAsync() const { return false; }
+    const char  *Name() const { return "soft"; }
+
+  private:
+    AclLiteError SendPacket(AVPacket *packet);
+    AclLiteError ReceiveFrames();
+    AclLiteError DeliverFrame(AVFrame *frame);
+
+  private:
+    int                  codecId_;
+    uint32_t             width_;
+    uint32_t             height_;
+    uint32_t             threadNum_;
+    uint32_t             format_;
+    aclrtRunMode         runMode_;
+    DecodedFrameCallBack callback_;
+    void                *userData_;
+    AVCodecContext      *codecCtx_;
+    AVPacket            *packet_;
+    AVFrame             *frame_;
+    SwsContext          *swsCtx_;
+    std::vector<uint8_t> hostBuf_; // NV12 staging, reused by every frame
+};
+
+#endif
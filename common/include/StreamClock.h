@@ -0,0 +1,60 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File StreamClock.h
+* Description: maps source frame timestamps to the timeline of an output
+*              stream
+*/
+#ifndef STREAM_CLOCK_H
+#define STREAM_CLOCK_H
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Output timestamps start at 0 and only go forward. The step between two
+ * frames is the step of their source pts, or of their receive time when the
+ * source has no pts, so a recording keeps the camera timing whatever the
+ * pipeline did to the frame rate on the way. Where the source time can not
+ * be followed (no time at all, going back, a jump of more than kMaxStepUs,
+ * the first frame after a reconnect) the frame is placed one frame interval
+ * after the previous one and the source is followed again from there.
+ */
+class StreamClock
+{
+  public:
+    // @param [in]: fps: output frame rate, gives the fallback frame interval
+    explicit StreamClock(uint32_t fps);
+
+    /**
+     * @brief Output time of the next frame of the stream
+     * @param [in]: ptsUs: source pts, -1 if unknown
+     * @param [in]: captureUs: monotonic receive time, 0 if unknown
+     * @param [in]: gap: the source was interrupted before this frame
+     * @return output timestamp in microseconds
+     */
+    int64_t Map(int64_t ptsUs, int64_t captureUs, bool gap);
+    void    Reset();
+    int64_t FrameIntervalUs() const { return frameIntervalUs_; }
+
+  private:
+    int64_t frameIntervalUs_;
+    bool    started_;
+    bool    lastFromPts_; // the last source time was a pts
+    int64_t lastSrcUs_;   // -1 if the last frame had no source time
+    int64_t lastOutUs_;
+};
+
+#endif
@@ -34,8 +34,12 @@
 #ifndef THREAD_SAFE_QUEUE_H
 #define THREAD_SAFE_QUEUE_H
 
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <mutex>
-#include <queue>
+#include <vector>
 
 template <typename T> class ThreadSafeQueue
 {
@@ -74,16 +78,85 @@ template <typename T> class ThreadSafeQueue
      */
     bool Push(T input_value)
     {
-        std::lock_guard<std::mutex> lock(mutex_);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            // check current size is less than capacity
+            if (queue_.size() >= queueCapacity)
+            {
+                return false;
+            }
+            queue_.push_back(input_value);
+        }
+        // wake up one consumer blocked in PopWait
+        notEmpty_.notify_one();
+        return true;
+    }
 
-        // check current size is less than capacity
-        if (queue_.size() < queueCapacity)
+    /**
+     * @brief push data to queue, block until there is free space, the
+     *        timeout expires or WakeUp is called
+     * @param [in] input_value: the value will push to the queue
+     * @param [in] timeoutUs: max time to wait in microseconds
+     * @return true: success to push data; false: the queue is still full
+     */
+    bool PushWait(T input_value, uint32_t timeoutUs)
+    {
         {
-            queue_.push(input_value);
-            return true;
+            std::unique_lock<std::mutex> lock(mutex_);
+            uint64_t wakeupSeq = wakeupSeq_;
+            pushWaiters_++;
+            notFull_.wait_for(lock,
+                              std::chrono::microseconds(timeoutUs),
+                              [this, wakeupSeq] {
+                                  return queue_.size() < queueCapacity ||
+                                         wakeupSeq != wakeupSeq_;
+                              });
+            pushWaiters_--;
+            if (queue_.size() >= queueCapacity)
+            {
+                return false;
+            }
+            queue_.push_back(input_value);
         }
+        notEmpty_.notify_one();
+        return true;
+    }
 
-        return false;
+    /**
+     * @brief push data to queue, if the queue is full remove the oldest
+     *        element accepted by canEvict to make room. The other elements
+     *        keep their order, nothing is moved to the tail
+     * @param [in] input_value: the value will push to the queue
+     * @param [in] canEvict: predicate called on the queued elements
+     * @param [out] evicted: the removed element, nullptr if none
+     * @return true: success to push data; false: the queue is full and no
+     *         element can be evicted
+     */
+    template <typename Pred>
+    bool PushEvict(T input_value, Pred canEvict, T &evicted)
+    {
+        evicted = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (queue_.size() >= queueCapacity)
+            {
+                auto it = queue_.begin();
+                while (it != queue_.end() && !canEvict(*it))
+                {
+                    ++it;
+                }
+                if (it == queue_.end())
+                {
+                    return false;
+                }
+                evicted = std::move(*it);
+                queue_.erase(it);
+            }
+            queue_.push_back(input_value);
+        }
+        notEmpty_.notify_one();
+        return true;
     }
 
     /**
@@ -99,10 +172,105 @@ template <typename T> class ThreadSafeQueue
         }
 
         T tmp_ptr = queue_.front();
-        queue_.pop();
+        queue_.pop_front();
+        NotifyNotFull();
         return tmp_ptr;
     }
 
+    /**
+     * @brief pop up to maxNum elements under one lock
+     * @param [out] output: the popped elements are appended in queue order
+     * @param [in] maxNum: max number of elements to pop
+     * @return number of elements popped
+     */
+    uint32_t PopBatch(std::vector<T> &output, uint32_t maxNum)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint32_t num = 0;
+        while (num < maxNum && !queue_.empty())
+        {
+            output.push_back(std::move(queue_.front()));
+            queue_.pop_front();
+            num++;
+        }
+        // several slots may be free, let every waiting producer recheck
+        if (num > 0 && pushWaiters_ > 0)
+        {
+            notFull_.notify_all();
+        }
+        return num;
+    }
+
+    /**
+     * @brief pop data from queue, block until data arrives, the timeout
+     *        expires or WakeUp is called
+     * @param [in] timeoutUs: max time to wait in microseconds
+     * @return the data; nullptr if no data is available when woken up
+     */
+    T PopWait(uint32_t timeoutUs)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        uint64_t wakeupSeq = wakeupSeq_;
+        notEmpty_.wait_for(lock,
+                           std::chrono::microseconds(timeoutUs),
+                           [this, wakeupSeq] {
+                               return !queue_.empty() ||
+                                      wakeupSeq != wakeupSeq_;
+                           });
+        if (queue_.empty())
+        {
+            return nullptr;
+        }
+
+        T tmp_ptr = queue_.front();
+        queue_.pop_front();
+        NotifyNotFull();
+        return tmp_ptr;
+    }
+
+    /**
+     * @brief get the current WakeUp sequence, pass it to WaitNotEmpty so
+     *        that a WakeUp called after this point is not missed
+     */
+    uint64_t GetWakeupSeq()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return wakeupSeq_;
+    }
+
+    /**
+     * @brief block until the queue is not empty, the timeout expires or
+     *        WakeUp is called after wakeupSeq was read
+     * @param [in] timeoutUs: max time to wait in microseconds
+     * @param [in] wakeupSeq: value returned by GetWakeupSeq
+     * @return true: the queue is not empty; false: the queue is empty
+     */
+    bool WaitNotEmpty(uint32_t timeoutUs, uint64_t wakeupSeq)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        notEmpty_.wait_for(lock,
+                           std::chrono::microseconds(timeoutUs),
+                           [this, wakeupSeq] {
+                               return !queue_.empty() ||
+                                      wakeupSeq != wakeupSeq_;
+                           });
+        return !queue_.empty();
+    }
+
+    /**
+     * @brief wake up all threads blocked in PopWait or PushWait, used on
+     *        shutdown so that they can recheck the running status at once
+     */
+    void WakeUp()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            wakeupSeq_++;
+        }
+        notEmpty_.notify_all();
+        notFull_.notify_all();
+    }
+
     /**
      * @brief check the queue is empty
      * @return true: the queue is empty; false: the queue is not empty
@@ -138,14 +306,31 @@ template <typename T> class ThreadSafeQueue
         std::lock_guard<std::mutex> lock(mutex_);
         while (!queue_.empty())
         {
-            queue_.pop();
+            queue_.pop_front();
+        }
+        if (pushWaiters_ > 0)
+        {
+            notFull_.notify_all();
         }
     }
 
   private:
-    std::queue<T>      queue_;                     // the queue
+    // called with mutex_ held after one element is removed
+    void NotifyNotFull()
+    {
+        if (pushWaiters_ > 0)
+        {
+            notFull_.notify_one();
+        }
+    }
+
+    std::deque<T>      queue_;                     // the queue
     uint32_t           queueCapacity;              // queue capacity
     mutable std::mutex mutex_;                     // the mutex value
+    std::condition_variable notEmpty_;             // signaled on push
+    std::condition_variable notFull_;              // signaled on pop
+    uint32_t           pushWaiters_ = 0;           // producers in PushWait
+    uint64_t           wakeupSeq_ = 0;             // bumped by WakeUp
     const uint32_t     kMinQueueCapacity = 1;      // the minimum queue capacity
     const uint32_t     kMaxQueueCapacity = 10000;  // the maximum queue capacity
     const uint32_t     kDefaultQueueCapacity = 10; // default queue capacity
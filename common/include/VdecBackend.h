@@ -0,0 +1,63 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File VdecBackend.h
+* Description: video decode backend on the dvpp vdec hardware decoder
+*/
+#ifndef VDEC_BACKEND_H
+#define VDEC_BACKEND_H
+#pragma once
+
+#include "VdecHelper.h"
+#include "VideoDecodeBackend.h"
+#include "acl/acl.h"
+
+class VdecBackend : public VideoDecodeBackend
+{
+  public:
+    /**
+     * @param [in]: channelId: vdec channel, taken from ChannelIdGenerator
+     * @param [in]: streamFormat: H265_MAIN_LEVEL, H264_xxx_LEVEL
+     */
+    VdecBackend(int                  channelId,
+                uint32_t             width,
+                uint32_t             height,
+                int                  streamFormat,
+                aclrtRunMode         runMode,
+                DecodedFrameCallBack callback,
+                void                *userData);
+    ~VdecBackend() {}
+
+    AclLiteError Init();
+    AclLiteError Decode(const void *data, int size, uint32_t frameId,
+                        bool keep);
+    AclLiteError Flush();
+    AclLiteError SetFormat(uint32_t format);
+    bool         IsAsync() const { return true; }
+    const char  *Name() const { return "vdec"; }
+
+  private:
+    static void VdecCallback(acldvppStreamDesc *input,
+                             acldvppPicDesc    *output,
+                             void              *userData);
+
+  private:
+    VdecHelper           vdec_;
+    aclrtRunMode         runMode_;
+    DecodedFrameCallBack callback_;
+    void                *userData_;
+};
+
+#endif
@@ -12,7 +12,8 @@
 // 编码数据回调函数类型
 // 参数: data - 编码后的H264数据指针
 //       size - 数据大小
+//       ptsUs - 对应输入帧的时间戳(微秒), -1 为未知
 //       userData - 用户自定义数据
-typedef std::function<void(void* data, uint32_t size, void* userData)> VencDataCallback;
+typedef std::function<void(void* data, uint32_t size, int64_t ptsUs, void* userData)> VencDataCallback;
 
 #endif // VENC_CALLBACK_H
@@ -36,12 +36,16 @@
 #ifndef VIDEO_FRAME_DECODE_H
 #define VIDEO_FRAME_DECODE_H
 
+#include "AclLiteMetrics.h"
 #include "AclLiteVideoProc.h"
+#include "DisposablePacket.h"
 #include "ThreadSafeQueue.h"
-#include "VdecHelper.h"
+#include "VideoDecodeBackend.h"
+#include <atomic>
 #include <dirent.h>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <stdint.h>
 #include <string>
 #include <thread>
@@ -60,9 +64,13 @@ extern "C"
 #define RTSP_TRANSPORT_UDP "udp"
 #define RTSP_TRANSPORT_TCP "tcp"
 
-typedef int (*FrameProcessCallBack)(void *callback_param,
-                                    void *frame_data,
-                                    int   frame_size);
+// pts_us: presentation time of the packet in microseconds, -1 if unknown
+// recv_us: monotonic time the demuxer got the packet, see AclLiteNowUs
+typedef int (*FrameProcessCallBack)(void   *callback_param,
+                                    void   *frame_data,
+                                    int     frame_size,
+                                    int64_t pts_us,
+                                    int64_t recv_us);
 
 enum StreamType
 {
@@ -127,7 +135,16 @@ class FFmpegDecoder
   public:
     FFmpegDecoder(const std::string &name);
     ~FFmpegDecoder() {}
-    void Decode(FrameProcessCallBack callback_func, void *callback_param);
+    /**
+     * @brief Demux until the input ends or drops, the stop request or a
+     * callback error
+     * @param [in]: waitKeyFrame: drop the packets before the first key frame
+     * @return AclLiteError: error of the callback or of opening the input,
+     * ACLLITE_OK otherwise
+     */
+    AclLiteError Decode(FrameProcessCallBack callback_func,
+                        void                *callback_param,
+                        bool                 waitKeyFrame = false);
     int  GetFrameWidth() { return frameWidth_; }
     int  GetFrameHeight() { return frameHeight_; }
     int  GetVideoType() { return videoType_; }
@@ -136,9 +153,16 @@ class FFmpegDecoder
     int  GetProfile() { return profile_; }
     void SetTransport(const std::string &transportType);
     void StopDecode() { isStop_ = true; }
+    // packets passed to the callback by the last Decode
+    int64_t GetPacketNum() { return packetNum_; }
+    // whether the codec, profile or size differs since the last call, found
+    // when Decode reopens the input
+    bool TakeStreamChanged();
 
   private:
+    static int IsInterrupted(void *decoder);
     int  GetVideoIndex(AVFormatContext *av_format_context);
+    void CheckStreamChanged(const AVCodecParameters *codecpar);
     void GetVideoInfo();
     void InitVideoStreamFilter(const AVBitStreamFilter *&video_filter);
     bool OpenVideo(AVFormatContext *&av_format_context);
@@ -150,6 +174,8 @@ class FFmpegDecoder
   private:
     bool        isFinished_;
     bool        isStop_;
+    bool        streamChanged_;
+    int64_t     packetNum_;
     int         frameWidth_;
     int         frameHeight_;
     int         videoType_;
@@ -165,9 +191,10 @@ class VideoCapture : public AclLiteVideoCapBase
     /**
      * @brief VideoCapture constructor
      */
-    VideoCapture(const std::string &videoName,
-                 int32_t            deviceId = 0,
-                 aclrtContext       context = nullptr);
+    VideoCapture(const std::string       &videoName,
+                 int32_t                  deviceId = 0,
+                 aclrtContext             context = nullptr,
+                 const VideoDecodeConfig &decodeConfig = VideoDecodeConfig());
 
     /**
      * @brief VideoCapture destructor
@@ -175,21 +202,23 @@ class VideoCapture : public AclLiteVideoCapBase
     ~VideoCapture();
 
     static void FrameDecodeThreadFunction(void *decoderSelf);
-    static AclLiteError
-    FrameDecodeCallback(void *context, void *frameData, int frameSize);
-    static void DvppVdecCallback(acldvppStreamDesc *input,
-                                 acldvppPicDesc    *output,
-                                 void              *userdata);
+    static AclLiteError FrameDecodeCallback(void   *context,
+                                            void   *frameData,
+                                            int     frameSize,
+                                            int64_t ptsUs,
+                                            int64_t recvUs);
+    static void DecodedFrameCallback(void                      *userData,
+                                     std::shared_ptr<ImageData> frame,
+                                     uint32_t                   frameId);
 
     AclLiteError DecodeH26xFrame();
-    void         ProcessDecodedImage(std::shared_ptr<ImageData> frameData);
+    void         ProcessDecodedImage(std::shared_ptr<ImageData> frameData,
+                                     bool                       keep = true);
     AclLiteError Read(ImageData &image);
 
-    void FFmpegDecode()
-    {
-        ffmpegDecoder_->Decode(&VideoCapture::FrameDecodeCallback,
-                               (void *)this);
-    }
+    // demux until the input ends, a dropped rtsp input is reopened with
+    // backoff and the decoder kept when the stream did not change
+    void FFmpegDecode();
 
     bool         IsOpened();
     AclLiteError Open();
@@ -201,7 +230,7 @@ class VideoCapture : public AclLiteVideoCapBase
     void         SetStatus(DecodeStatus status) { status_ = status; }
     DecodeStatus GetStatus() { return status_; }
 
-    AclLiteError Set(StreamProperty key, int value);
+    AclLiteError Set(StreamProperty key, uint32_t value);
     uint32_t     Get(StreamProperty key);
 
     void         SleeptoNextFrameTime();
@@ -214,13 +243,27 @@ class VideoCapture : public AclLiteVideoCapBase
 
   private:
     AclLiteError InitResource();
+    AclLiteError InitDecoder();
     AclLiteError InitVdecDecoder();
+    AclLiteError InitSoftDecoder();
+    bool         IsVdecSupported();
+    void         InitMetrics();
     AclLiteError InitFFmpegDecoder();
     void         StartFrameDecoder();
     int          GetVdecType();
     AclLiteError FrameImageEnQueue(std::shared_ptr<ImageData> frameData);
     std::shared_ptr<ImageData> FrameImageOutQueue(bool noWait = false);
     AclLiteError               SetRtspTransType(uint32_t transCode);
+    // decide by pts whether the packet is due for the target fps
+    bool                       PaceFrame(int64_t ptsUs);
+    struct FrameTag;
+    void                       TagFrame(const FrameTag &tag);
+    // the tag of a decoded frame, false if it was overwritten already
+    bool                       TakeFrameTag(uint32_t frameId, FrameTag *tag);
+    int64_t                    ReconnectWaitUs(uint32_t attempt);
+    bool                       WaitUnlessStop(int64_t waitUs);
+    AclLiteError               OnReconnected();
+    AclLiteError               ResetDecoder();
 
   private:
     bool                                        isStop_;
@@ -241,9 +284,46 @@ class VideoCapture : public AclLiteVideoCapBase
     std::string                                 streamName_;
     std::thread                                 decodeThread_;
     FFmpegDecoder                              *ffmpegDecoder_;
-    VdecHelper                                 *dvppVdec_;
+    VideoDecodeConfig                           decodeConfig_;
+    VideoDecodeBackend                         *decoder_;
+    std::string                                 decoderName_; // vdec<n>, swdec<n>
     ThreadSafeQueue<std::shared_ptr<ImageData>> frameImageQueue_;
     int                                         videoChannelMax_;
+    AclLiteCounter                             *decodedNum_; // frames queued
+    AclLiteCounter                             *lostNum_;    // lost, queue full
+    // pts pacing, only the demux thread touches these
+    int64_t                                     paceIntervalUs_; // 0 = off
+    int64_t                                     nextDuePtsUs_;
+    int64_t                                     packetNum_; // packets demuxed
+    // keep flag and times of the packets in the decoder, looked up by frame
+    // id when the frame comes out
+    struct FrameTag
+    {
+        uint32_t frameId = 0;
+        bool     keep = true;
+        bool     gap = false;    // first packet after a reconnect
+        int64_t  ptsUs = -1;     // source pts, -1 if the stream has none
+        int64_t  captureUs = 0;  // packet received from the source
+    };
+    std::mutex                                  frameTagMutex_;
+    std::vector<FrameTag>                       frameTags_;
+    DisposablePacketFilter                      disposableFilter_; // demux thread
+    AclLiteCounter                             *skippedNum_; // dropped before vdec
+    AclLiteCounter                             *pacedNum_;   // decoded, not due
+    // live mode: the queue is a single slot mailbox, a new frame replaces
+    // the one not read yet so Read always returns the newest
+    bool                                        liveMode_;
+    AclLiteCounter                             *supersededNum_; // replaced unread
+    AclLiteHistogram                           *frameAge_; // decode to Read, us
+    // rtsp reconnect. gapPending_ and gapStartUs_ belong to the demux
+    // thread, frameGapPending_ to the thread delivering decoded frames
+    int64_t                                     reconnectMaxWaitUs_; // 0 = off
+    std::atomic<bool>                           reconnecting_;
+    bool                                        gapPending_;
+    int64_t                                     gapStartUs_;
+    bool                                        frameGapPending_;
+    AclLiteCounter                             *reconnectNum_;
+    AclLiteHistogram                           *streamGap_; // drop to data, us
 };
 
 #endif /* VIDEO_FRAME_DECODE_H_ */
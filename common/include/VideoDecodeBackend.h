@@ -0,0 +1,65 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File VideoDecodeBackend.h
+* Description: decoder of the h26x packets demuxed by VideoCapture
+*/
+#ifndef VIDEO_DECODE_BACKEND_H
+#define VIDEO_DECODE_BACKEND_H
+#pragma once
+
+#include "AclLiteError.h"
+#include "AclLiteType.h"
+#include <cstdint>
+#include <memory>
+
+// Receives a decoded NV12 frame in dvpp memory. frameId is the id passed to
+// Decode for the packet of the frame, frames may come out of decode order.
+// frame is nullptr if the packet was decoded with keep false and the backend
+// did not produce the picture
+typedef void (*DecodedFrameCallBack)(void                      *userData,
+                                     std::shared_ptr<ImageData> frame,
+                                     uint32_t                   frameId);
+
+class VideoDecodeBackend
+{
+  public:
+    VideoDecodeBackend() {}
+    virtual ~VideoDecodeBackend() {}
+
+    virtual AclLiteError Init() = 0;
+    /**
+     * @brief Decode one annexb access unit
+     * @param [in]: data: packet in host memory, still owned by the caller
+     * @param [in]: frameId: id given back with the decoded frame
+     * @param [in]: keep: false if the frame is not due and will be released
+     *              unread, it only has to be decoded for the following ones
+     */
+    virtual AclLiteError Decode(const void *data,
+                                int         size,
+                                uint32_t    frameId,
+                                bool        keep) = 0;
+    /**
+     * @brief Send end of stream, the buffered frames are delivered
+     */
+    virtual AclLiteError Flush() = 0;
+    virtual AclLiteError SetFormat(uint32_t format) = 0;
+    // true if frames are delivered from another thread after Decode returns,
+    // otherwise all frames are delivered when Flush returns
+    virtual bool         IsAsync() const = 0;
+    virtual const char  *Name() const = 0;
+};
+
+#endif
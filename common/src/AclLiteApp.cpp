@@ -9,17 +9,30 @@
  */
 #include "AclLiteApp.h"
 #include "AclLiteThreadMgr.h"
+#include "AclLiteWorkerPool.h"
 #include "acl/acl.h"
-#include <cctype>
 
 using namespace std;
 namespace
 {
 const uint32_t kWaitInterval = 10000;
-const uint32_t kThreadExitRetry = 3;
+const uint32_t kMainMsgWaitTimeout = 100000;
+const uint32_t kThreadExitCheckInterval = 10000;
+const uint32_t kThreadExitRetry = 300;
+const uint32_t kMsgPoolSize = 4096;
 } // namespace
 
-AclLiteApp::AclLiteApp() : isReleased_(false), waitEnd_(false) { Init(); }
+AclLiteApp::AclLiteApp()
+    : isReleased_(false), waitEnd_(false), workerPool_(nullptr),
+      msgPool_(kMsgPoolSize, [](AclLiteMessage &msg) {
+          msg.data = nullptr;
+          msg.droppable = false;
+          msg.fence = 0;
+          msg.enqueueUs = 0;
+      })
+{
+    Init();
+}
 
 AclLiteApp::~AclLiteApp() { ReleaseThreads(); }
 
@@ -37,10 +50,11 @@ int AclLiteApp::CreateAclLiteThread(AclLiteThread *thInst,
                                     const string  &instName,
                                     aclrtContext   context,
                                     aclrtRunMode   runMode,
-                                    const uint32_t msgQueueSize)
+                                    const uint32_t msgQueueSize,
+                                    AclLiteQueueType queueType)
 {
     int instId = CreateAclLiteThreadMgr(
-        thInst, instName, context, runMode, msgQueueSize);
+        thInst, instName, context, runMode, msgQueueSize, queueType);
     if (instId == INVALID_INSTANCE_ID)
     {
         ACLLITE_LOG_ERROR("Add thread instance %s failed", instName.c_str());
@@ -62,7 +76,8 @@ int AclLiteApp::CreateAclLiteThreadMgr(AclLiteThread *thInst,
                                        const string  &instName,
                                        aclrtContext   context,
                                        aclrtRunMode   runMode,
-                                       const uint32_t msgQueueSize)
+                                       const uint32_t msgQueueSize,
+                                       AclLiteQueueType queueType)
 {
     if (!CheckThreadNameUnique(instName))
     {
@@ -79,7 +94,7 @@ int AclLiteApp::CreateAclLiteThreadMgr(AclLiteThread *thInst,
     }
 
     AclLiteThreadMgr *thMgr =
-        new AclLiteThreadMgr(thInst, instName, msgQueueSize);
+        new AclLiteThreadMgr(thInst, instName, msgQueueSize, queueType);
     threadList_.push_back(thMgr);
 
     return instId;
@@ -103,6 +118,18 @@ bool AclLiteApp::CheckThreadNameUnique(const string &threadName)
     return true;
 }
 
+AclLiteError AclLiteApp::InitWorkerPool(uint32_t           workerNum,
+                                        const vector<int> &cpus)
+{
+    if (workerPool_ != nullptr)
+    {
+        ACLLITE_LOG_ERROR("Worker pool is already created");
+        return ACLLITE_ERROR;
+    }
+    workerPool_ = new AclLiteWorkerPool(workerNum, cpus);
+    return ACLLITE_OK;
+}
+
 int AclLiteApp::Start(vector<AclLiteThreadParam> &threadParamTbl)
 {
     for (size_t i = 0; i < threadParamTbl.size(); i++)
@@ -111,13 +138,35 @@ int AclLiteApp::Start(vector<AclLiteThreadParam> &threadParamTbl)
                                             threadParamTbl[i].threadInstName,
                                             threadParamTbl[i].context,
                                             threadParamTbl[i].runMode,
-                                            threadParamTbl[i].queueSize);
+                                            threadParamTbl[i].queueSize,
+                                            threadParamTbl[i].queueType);
         if (instId == INVALID_INSTANCE_ID)
         {
             ACLLITE_LOG_ERROR("Create thread instance failed");
             return ACLLITE_ERROR;
         }
         threadParamTbl[i].threadInstId = instId;
+        threadList_[instId]->SetSendPolicy(threadParamTbl[i].sendPolicy,
+                                           threadParamTbl[i].sendTimeoutUs);
+        threadList_[instId]->SetThreadSched(threadParamTbl[i].sched);
+        if (threadParamTbl[i].execMode == ACLLITE_EXEC_POOL)
+        {
+            if (!threadParamTbl[i].sched.IsDefault())
+            {
+                ACLLITE_LOG_WARNING("Thread %s runs in worker pool, ignore "
+                                    "its sched settings",
+                                    threadParamTbl[i].threadInstName.c_str());
+            }
+            if (workerPool_ == nullptr)
+            {
+                InitWorkerPool(0);
+            }
+            threadList_[instId]->SetWorkerPool(workerPool_);
+        }
+    }
+    if (workerPool_ != nullptr)
+    {
+        workerPool_->Start();
     }
     // Note:The instance id must generate first, then create thread,
     // for the user thread get other thread instance id in Init function
@@ -160,23 +209,77 @@ int AclLiteApp::GetAclLiteThreadIdByName(const string &threadName)
     return INVALID_INSTANCE_ID;
 }
 
-AclLiteError AclLiteApp::SendMessage(int dest, int msgId, shared_ptr<void> data)
+shared_ptr<AclLiteMessage>
+AclLiteApp::MakeMessage(int dest, int msgId, shared_ptr<void> &data)
 {
-    if ((uint32_t)dest > threadList_.size())
+    if ((uint32_t)dest >= threadList_.size() || threadList_[dest] == nullptr)
     {
         ACLLITE_LOG_ERROR("Send message to %d failed for thread not exist",
                           dest);
-        return ACLLITE_ERROR_DEST_INVALID;
+        return nullptr;
     }
 
-    shared_ptr<AclLiteMessage> pMessage = make_shared<AclLiteMessage>();
+    shared_ptr<AclLiteMessage> pMessage = msgPool_.Acquire();
     pMessage->dest = dest;
     pMessage->msgId = msgId;
     pMessage->data = data;
+    return pMessage;
+}
+
+AclLiteError AclLiteApp::SendMessage(int dest, int msgId, shared_ptr<void> data)
+{
+    shared_ptr<AclLiteMessage> pMessage = MakeMessage(dest, msgId, data);
+    if (pMessage == nullptr)
+    {
+        return ACLLITE_ERROR_DEST_INVALID;
+    }
 
     return threadList_[dest]->PushMsgToQueue(pMessage);
 }
 
+AclLiteError AclLiteApp::SendMessage(int               dest,
+                                     int               msgId,
+                                     shared_ptr<void>  data,
+                                     AclLiteSendPolicy policy,
+                                     uint32_t          timeoutUs)
+{
+    shared_ptr<AclLiteMessage> pMessage = MakeMessage(dest, msgId, data);
+    if (pMessage == nullptr)
+    {
+        return ACLLITE_ERROR_DEST_INVALID;
+    }
+
+    return threadList_[dest]->PushMsgToQueue(pMessage, policy, timeoutUs);
+}
+
+AclLiteError AclLiteApp::SendMessage(int                dest,
+                                     int                msgId,
+                                     shared_ptr<void>   data,
+                                     AclLiteMsgPriority priority)
+{
+    shared_ptr<AclLiteMessage> pMessage = MakeMessage(dest, msgId, data);
+    if (pMessage == nullptr)
+    {
+        return ACLLITE_ERROR_DEST_INVALID;
+    }
+
+    return threadList_[dest]->PushMsgToQueue(pMessage, priority);
+}
+
+AclLiteError
+AclLiteApp::SendMessageByPolicy(int dest, int msgId, shared_ptr<void> data)
+{
+    shared_ptr<AclLiteMessage> pMessage = MakeMessage(dest, msgId, data);
+    if (pMessage == nullptr)
+    {
+        return ACLLITE_ERROR_DEST_INVALID;
+    }
+
+    AclLiteThreadMgr *thMgr = threadList_[dest];
+    return thMgr->PushMsgToQueue(
+        pMessage, thMgr->GetSendPolicy(), thMgr->GetSendTimeout());
+}
+
 void AclLiteApp::Wait()
 {
     while (true)
@@ -217,10 +320,10 @@ void AclLiteApp::Wait(AclLiteMsgProcess msgProcess, void *param)
         if (waitEnd_)
             break;
 
-        shared_ptr<AclLiteMessage> msg = mainMgr->PopMsgFromQueue();
+        shared_ptr<AclLiteMessage> msg =
+            mainMgr->PopMsgFromQueue(kMainMsgWaitTimeout);
         if (msg == nullptr)
         {
-            usleep(kWaitInterval);
             continue;
         }
         int ret = msgProcess(msg->msgId, msg->data, param);
@@ -236,6 +339,13 @@ void AclLiteApp::Wait(AclLiteMsgProcess msgProcess, void *param)
     threadList_[g_MainThreadId]->SetStatus(THREAD_EXITED);
 }
 
+void AclLiteApp::WaitEnd()
+{
+    waitEnd_ = true;
+    // main thread may be blocked on the empty main queue
+    threadList_[g_MainThreadId]->WakeUp();
+}
+
 void AclLiteApp::Exit() { ReleaseThreads(); }
 
 void AclLiteApp::ReleaseThreads()
@@ -250,6 +360,24 @@ void AclLiteApp::ReleaseThreads()
             (threadList_[i]->GetStatus() == THREAD_RUNNING))
             threadList_[i]->SetStatus(THREAD_EXITING);
     }
+    // threads blocked on empty queue check the exiting status immediately
+    for (uint32_t i = 1; i < threadList_.size(); i++)
+    {
+        if (threadList_[i] != nullptr)
+            threadList_[i]->WakeUp();
+    }
+    // actors exit when the workers stop, a worker blocked in a sender
+    // returns once the receiver is not running
+    if (workerPool_ != nullptr)
+    {
+        workerPool_->Stop();
+        for (uint32_t i = 1; i < threadList_.size(); i++)
+        {
+            if ((threadList_[i] != nullptr) && threadList_[i]->IsPoolActor() &&
+                (threadList_[i]->GetStatus() <= THREAD_EXITING))
+                threadList_[i]->SetStatus(THREAD_EXITED);
+        }
+    }
 
     int retry = kThreadExitRetry;
     while (retry >= 0)
@@ -274,9 +402,14 @@ void AclLiteApp::ReleaseThreads()
         if (exitFinish)
             break;
 
-        sleep(1);
+        usleep(kThreadExitCheckInterval);
         retry--;
     }
+    if (workerPool_ != nullptr)
+    {
+        delete workerPool_;
+        workerPool_ = nullptr;
+    }
     isReleased_ = true;
 }
 
@@ -290,6 +423,31 @@ AclLiteError SendMessage(int dest, int msgId, shared_ptr<void> data)
     return app.SendMessage(dest, msgId, data);
 }
 
+AclLiteError SendMessage(int               dest,
+                         int               msgId,
+                         shared_ptr<void>  data,
+                         AclLiteSendPolicy policy,
+                         uint32_t          timeoutUs)
+{
+    AclLiteApp &app = AclLiteApp::GetInstance();
+    return app.SendMessage(dest, msgId, data, policy, timeoutUs);
+}
+
+AclLiteError SendMessage(int                dest,
+                         int                msgId,
+                         shared_ptr<void>   data,
+                         AclLiteMsgPriority priority)
+{
+    AclLiteApp &app = AclLiteApp::GetInstance();
+    return app.SendMessage(dest, msgId, data, priority);
+}
+
+AclLiteError SendMessageByPolicy(int dest, int msgId, shared_ptr<void> data)
+{
+    AclLiteApp &app = AclLiteApp::GetInstance();
+    return app.SendMessageByPolicy(dest, msgId, data);
+}
+
 int GetAclLiteThreadIdByName(const string &threadName)
 {
     AclLiteApp &app = AclLiteApp::GetInstance();
@@ -299,38 +457,21 @@ int GetAclLiteThreadIdByName(const string &threadName)
 void AclLiteApp::PrintQueueStatus()
 {
     ACLLITE_LOG_INFO("========== Thread Queue Status ==========");
-    for (size_t i = 0; i < threadList_.size(); i++)
+    // main thread (index 0) only receives the exit message
+    for (size_t i = 1; i < threadList_.size(); i++)
     {
-        const std::string &name = threadList_[i]->GetThreadName();
-        uint32_t queueSize = threadList_[i]->GetQueueSize();
-        // case-insensitive name matching; ensure inference and rtsp threads are
-        // printed even when their queue size is 0
-        auto ToLower = [](const std::string &s) {
-            std::string out;
-            out.reserve(s.size());
-            for (unsigned char c : s) {
-                out.push_back(std::tolower(c));
-            }
-            return out;
-        };
-        std::string nameLower = ToLower(name);
-        if (queueSize > 0 ||
-            nameLower.find("datainput") != std::string::npos ||
-            nameLower.find("detectpre") != std::string::npos ||
-            nameLower.find("preprocess") != std::string::npos ||
-            nameLower.find("infer") != std::string::npos ||
-            nameLower.find("detectinfer") != std::string::npos ||
-            nameLower.find("postprocess") != std::string::npos ||
-            nameLower.find("detectpost") != std::string::npos ||
-            // show track queue lengths when tracking is enabled
-            nameLower.find("track") != std::string::npos ||
-            nameLower.find("dataoutput") != std::string::npos ||
-            nameLower.find("output") != std::string::npos ||
-            nameLower.find("rtsp") != std::string::npos)
+        if (threadList_[i] == nullptr)
         {
-            ACLLITE_LOG_INFO("  [%s] Queue: %u", name.c_str(), queueSize);
+            continue;
         }
+        ACLLITE_LOG_INFO("  [%s] Queue: %u, dropped: %lu",
+                         threadList_[i]->GetThreadName().c_str(),
+                         threadList_[i]->GetQueueSize(),
+                         (unsigned long)threadList_[i]->GetDroppedMsgNum());
     }
+    ACLLITE_LOG_INFO("  [message pool] hit: %lu, miss: %lu",
+                     (unsigned long)msgPool_.GetHitNum(),
+                     (unsigned long)msgPool_.GetMissNum());
     ACLLITE_LOG_INFO("=========================================");
 }
 
@@ -341,6 +482,6 @@ void AclLiteApp::ClearThreadQueue(int threadId)
         ACLLITE_LOG_ERROR("Clear queue failed for thread id %d invalid", threadId);
         return;
     }
-    threadList_[threadId]->msgQueue_.Clear();
+    threadList_[threadId]->ClearQueue();
 }
 
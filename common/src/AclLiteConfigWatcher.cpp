@@ -0,0 +1,161 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File AclLiteConfigWatcher.cpp
+* Description: watches the config file and calls back when it is rewritten
+*              or SIGHUP is received
+*/
+#include "AclLiteConfigWatcher.h"
+#include "AclLiteUtils.h"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+using namespace std;
+namespace
+{
+const int kWatchPollMs = 200;    // how often Stop and SIGHUP are noticed
+const int kReloadQuietMs = 300;  // wait for the writer to finish the file
+const uint32_t kWatchMask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+
+int64_t NowMs()
+{
+    return chrono::duration_cast<chrono::milliseconds>(
+               chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+} // namespace
+
+AclLiteConfigWatcher::AclLiteConfigWatcher()
+    : inotifyFd_(-1), pending_(false), running_(false)
+{
+}
+
+AclLiteConfigWatcher::~AclLiteConfigWatcher() { Stop(); }
+
+AclLiteConfigWatcher &AclLiteConfigWatcher::GetInstance()
+{
+    static AclLiteConfigWatcher instance;
+    return instance;
+}
+
+AclLiteError AclLiteConfigWatcher::Start(const string         &path,
+                                         const ReloadCallback &callback)
+{
+    if (running_)
+    {
+        return ACLLITE_OK;
+    }
+    size_t slash = path.find_last_of('/');
+    string dir = slash == string::npos ? "." : path.substr(0, slash + 1);
+    fileName_ = slash == string::npos ? path : path.substr(slash + 1);
+    callback_ = callback;
+    inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd_ < 0 ||
+        inotify_add_watch(inotifyFd_, dir.c_str(), kWatchMask) < 0)
+    {
+        // SIGHUP still works without inotify
+        ACLLITE_LOG_WARNING("Watch config dir %s failed, errno %d, reload on "
+                            "SIGHUP only",
+                            dir.c_str(),
+                            errno);
+        if (inotifyFd_ >= 0)
+        {
+            close(inotifyFd_);
+            inotifyFd_ = -1;
+        }
+    }
+    running_ = true;
+    watcher_ = thread(&AclLiteConfigWatcher::WatcherEntry, this);
+    ACLLITE_LOG_INFO("Watching config %s for runtime parameter changes",
+                     path.c_str());
+    return ACLLITE_OK;
+}
+
+void AclLiteConfigWatcher::Stop()
+{
+    if (!running_.exchange(false))
+    {
+        return;
+    }
+    if (watcher_.joinable())
+    {
+        watcher_.join();
+    }
+    if (inotifyFd_ >= 0)
+    {
+        close(inotifyFd_);
+        inotifyFd_ = -1;
+    }
+}
+
+bool AclLiteConfigWatcher::ReadEvents()
+{
+    // events of other files in the same directory are skipped
+    bool changed = false;
+    char buf[4096] __attribute__((aligned(__alignof__(inotify_event))));
+    while (true)
+    {
+        ssize_t len = read(inotifyFd_, buf, sizeof(buf));
+        if (len <= 0)
+        {
+            break;
+        }
+        for (char *ptr = buf; ptr < buf + len;)
+        {
+            const inotify_event *event = (const inotify_event *)ptr;
+            if (event->len > 0 && fileName_ == event->name)
+            {
+                changed = true;
+            }
+            ptr += sizeof(inotify_event) + event->len;
+        }
+    }
+    return changed;
+}
+
+void AclLiteConfigWatcher::WatcherEntry()
+{
+    SetCurrentThreadSched("acllite_config", AclLiteThreadSched());
+    pollfd pfd;
+    pfd.fd = inotifyFd_; // poll ignores a negative fd
+    pfd.events = POLLIN;
+    bool    dirty = false;
+    int64_t lastChangeMs = 0;
+    while (running_)
+    {
+        pfd.revents = 0;
+        int ret = poll(&pfd, 1, kWatchPollMs);
+        if (ret > 0 && (pfd.revents & POLLIN) && ReadEvents())
+        {
+            dirty = true;
+            lastChangeMs = NowMs();
+        }
+        if (pending_.exchange(false))
+        {
+            // an explicit request does not wait for the file to settle
+            dirty = true;
+            lastChangeMs = NowMs() - kReloadQuietMs;
+        }
+        if (dirty && NowMs() - lastChangeMs >= kReloadQuietMs)
+        {
+            dirty = false;
+            callback_();
+        }
+    }
+}
@@ -0,0 +1,635 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File AclLiteMetrics.cpp
+* Description: per thread instance counters, latency histograms and queue
+*              depth gauges with a periodic reporter
+*/
+#include "AclLiteMetrics.h"
+#include "AclLiteUtils.h"
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+using namespace std;
+namespace
+{
+const uint32_t kMinReportInterval = 100;
+const char    *kPromPrefix = "acllite_";
+// Prometheus histogram bucket bounds in microseconds, the log-linear buckets
+// are folded into these
+const uint64_t kPromBucketsUs[] = {100,    250,    500,     1000,    2500,
+                                   5000,   10000,  25000,   50000,   100000,
+                                   250000, 500000, 1000000, 2500000};
+
+// highest set bit, value must not be 0
+inline uint32_t HighestBit(uint64_t value)
+{
+    return 63 - __builtin_clzll(value);
+}
+
+void AppendHistogramJson(ostringstream &os, const AclLiteHistogramSnapshot &s)
+{
+    os << "{\"count\":" << s.count << ",\"mean\":"
+       << (s.count > 0 ? s.sum / s.count : 0) << ",\"p50\":"
+       << s.Percentile(50) << ",\"p95\":" << s.Percentile(95)
+       << ",\"p99\":" << s.Percentile(99) << ",\"max\":" << s.max << "}";
+}
+
+// names come from the config, escape the characters JSON does not allow
+string JsonEscape(const string &str)
+{
+    string out;
+    out.reserve(str.size());
+    for (char c : str)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out.push_back('\\');
+            out.push_back(c);
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        }
+        else
+        {
+            out.push_back(c);
+        }
+    }
+    return out;
+}
+template <typename T>
+T *FindOrAdd(vector<pair<string, unique_ptr<T>>> &list, const string &name)
+{
+    for (size_t i = 0; i < list.size(); i++)
+    {
+        if (list[i].first == name)
+        {
+            return list[i].second.get();
+        }
+    }
+    list.emplace_back(name, unique_ptr<T>(new T()));
+    return list.back().second.get();
+}
+
+// metric names only allow [a-zA-Z0-9_:]
+string PromName(const string &str)
+{
+    string out(str);
+    for (size_t i = 0; i < out.size(); i++)
+    {
+        char c = out[i];
+        if (!isalnum(static_cast<unsigned char>(c)) && c != '_' && c != ':')
+        {
+            out[i] = '_';
+        }
+    }
+    return out;
+}
+
+string PromLabel(const string &key, const string &value)
+{
+    string out = key + "=\"";
+    for (char c : value)
+    {
+        if (c == '\\' || c == '"')
+        {
+            out.push_back('\\');
+            out.push_back(c);
+        }
+        else if (c == '\n')
+        {
+            out += "\\n";
+        }
+        else
+        {
+            out.push_back(c);
+        }
+    }
+    return out + "\"";
+}
+
+// "<instance>.<metric>" to the family name and the instance label
+void SplitMetricName(const string &name, string &family, string &labels)
+{
+    size_t pos = name.rfind('.');
+    if (pos == string::npos)
+    {
+        family = kPromPrefix + PromName(name);
+        labels.clear();
+        return;
+    }
+    family = kPromPrefix + PromName(name.substr(pos + 1));
+    labels = PromLabel("instance", name.substr(0, pos));
+}
+
+// samples of one family must be written together after its TYPE line
+struct PromFamily
+{
+    string        type;
+    ostringstream samples;
+};
+
+template <typename T>
+void AppendPromSample(ostringstream &os, const string &name,
+                      const string &labels, T value)
+{
+    os << name;
+    if (!labels.empty())
+    {
+        os << "{" << labels << "}";
+    }
+    os << " " << value << "\n";
+}
+
+void AppendPromHistogram(map<string, PromFamily> &families,
+                         const string &family, const string &labels,
+                         const AclLiteHistogramSnapshot &s)
+{
+    PromFamily &f = families[family];
+    f.type = "histogram";
+    string   prefix = labels.empty() ? "" : labels + ",";
+    uint64_t cumulative = 0;
+    size_t   index = 0;
+    size_t   boundNum = sizeof(kPromBucketsUs) / sizeof(kPromBucketsUs[0]);
+    for (size_t b = 0; b < boundNum; b++)
+    {
+        while (index < s.buckets.size() &&
+               AclLiteHistogram::BucketUpperBound(index) <= kPromBucketsUs[b])
+        {
+            cumulative += s.buckets[index++];
+        }
+        ostringstream le;
+        le << kPromBucketsUs[b] / 1000000.0;
+        AppendPromSample(f.samples, family + "_bucket",
+                         prefix + PromLabel("le", le.str()), cumulative);
+    }
+    AppendPromSample(f.samples, family + "_bucket",
+                     prefix + PromLabel("le", "+Inf"), s.count);
+    // microseconds printed as seconds without losing digits
+    char sum[32];
+    snprintf(sum, sizeof(sum), "%lu.%06lu",
+             (unsigned long)(s.sum / 1000000), (unsigned long)(s.sum % 1000000));
+    AppendPromSample(f.samples, family + "_sum", labels, sum);
+    AppendPromSample(f.samples, family + "_count", labels, s.count);
+}
+} // namespace
+
+uint64_t AclLiteHistogramSnapshot::Percentile(double percent) const
+{
+    if (count == 0 || buckets.empty())
+    {
+        return 0;
+    }
+    // rank of the sample, 1 based
+    uint64_t rank = static_cast<uint64_t>(count * percent / 100.0 + 0.5);
+    if (rank == 0)
+    {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < buckets.size(); i++)
+    {
+        seen += buckets[i];
+        if (seen >= rank)
+        {
+            uint64_t bound = AclLiteHistogram::BucketUpperBound(i);
+            return (max > 0 && bound > max) ? max : bound;
+        }
+    }
+    return max;
+}
+
+AclLiteHistogramSnapshot
+AclLiteHistogramSnapshot::Delta(const AclLiteHistogramSnapshot &older) const
+{
+    AclLiteHistogramSnapshot delta;
+    delta.buckets.assign(buckets.size(), 0);
+    bool sameLayout = older.buckets.size() == buckets.size();
+    for (uint32_t i = 0; i < buckets.size(); i++)
+    {
+        uint64_t prev = sameLayout ? older.buckets[i] : 0;
+        delta.buckets[i] = buckets[i] > prev ? buckets[i] - prev : 0;
+        if (delta.buckets[i] > 0)
+        {
+            delta.max = AclLiteHistogram::BucketUpperBound(i);
+        }
+    }
+    if (delta.max > max)
+    {
+        delta.max = max;
+    }
+    delta.count = count > older.count ? count - older.count : 0;
+    delta.sum = sum > older.sum ? sum - older.sum : 0;
+    return delta;
+}
+
+AclLiteHistogram::AclLiteHistogram() : count_(0), sum_(0), max_(0)
+{
+    for (uint32_t i = 0; i < kBucketNum; i++)
+    {
+        buckets_[i].store(0, memory_order_relaxed);
+    }
+}
+
+uint32_t AclLiteHistogram::BucketIndex(uint64_t value)
+{
+    if (value < kSubBucketNum)
+    {
+        return static_cast<uint32_t>(value);
+    }
+    uint32_t shift = HighestBit(value) - kSubBucketBits;
+    uint32_t index = (shift + 1) * kSubBucketNum +
+                     static_cast<uint32_t>(value >> shift) - kSubBucketNum;
+    return index < kBucketNum ? index : kBucketNum - 1;
+}
+
+uint64_t AclLiteHistogram::BucketUpperBound(uint32_t index)
+{
+    if (index < kSubBucketNum)
+    {
+        return index;
+    }
+    uint32_t shift = index / kSubBucketNum - 1;
+    uint64_t sub = index % kSubBucketNum + kSubBucketNum;
+    return ((sub + 1) << shift) - 1;
+}
+
+void AclLiteHistogram::Record(int64_t valueUs)
+{
+    uint64_t value = valueUs > 0 ? static_cast<uint64_t>(valueUs) : 0;
+    buckets_[BucketIndex(value)].fetch_add(1, memory_order_relaxed);
+    count_.fetch_add(1, memory_order_relaxed);
+    sum_.fetch_add(value, memory_order_relaxed);
+    uint64_t curMax = max_.load(memory_order_relaxed);
+    while (value > curMax &&
+           !max_.compare_exchange_weak(curMax, value, memory_order_relaxed))
+    {
+    }
+}
+
+void AclLiteHistogram::GetSnapshot(AclLiteHistogramSnapshot &snapshot) const
+{
+    snapshot.buckets.resize(kBucketNum);
+    uint64_t count = 0;
+    for (uint32_t i = 0; i < kBucketNum; i++)
+    {
+        snapshot.buckets[i] = buckets_[i].load(memory_order_relaxed);
+        count += snapshot.buckets[i];
+    }
+    // count from the buckets, so that percentiles stay consistent while
+    // writers are recording
+    snapshot.count = count;
+    snapshot.sum = sum_.load(memory_order_relaxed);
+    snapshot.max = max_.load(memory_order_relaxed);
+}
+
+AclLiteMetrics &AclLiteMetrics::GetInstance()
+{
+    static AclLiteMetrics instance;
+    return instance;
+}
+
+AclLiteMetrics::AclLiteMetrics()
+    : lastReportUs_(AclLiteNowUs()), reporterRunning_(false), intervalMs_(0)
+{
+}
+
+AclLiteMetrics::~AclLiteMetrics() { StopReporter(); }
+
+AclLiteStageMetrics *AclLiteMetrics::GetStageMetrics(const string &name)
+{
+    lock_guard<mutex> lock(mutex_);
+    for (size_t i = 0; i < stages_.size(); i++)
+    {
+        if (stages_[i]->name == name)
+        {
+            return stages_[i].get();
+        }
+    }
+    stages_.emplace_back(new AclLiteStageMetrics());
+    stages_.back()->name = name;
+    return stages_.back().get();
+}
+
+AclLiteHistogram *AclLiteMetrics::GetHistogram(const string &name)
+{
+    lock_guard<mutex> lock(mutex_);
+    return FindOrAdd(histograms_, name);
+}
+
+AclLiteCounter *AclLiteMetrics::GetCounter(const string &name)
+{
+    lock_guard<mutex> lock(mutex_);
+    return FindOrAdd(counters_, name);
+}
+
+AclLiteGauge *AclLiteMetrics::GetGauge(const string &name)
+{
+    lock_guard<mutex> lock(mutex_);
+    return FindOrAdd(gauges_, name);
+}
+
+void AclLiteMetrics::Report()
+{
+    lock_guard<mutex> lock(mutex_);
+    int64_t nowUs = AclLiteNowUs();
+    double  seconds = (nowUs - lastReportUs_) / 1000000.0;
+    lastReportUs_ = nowUs;
+    if (seconds <= 0)
+    {
+        seconds = 1;
+    }
+
+    AclLiteHistogramSnapshot snapshot;
+    for (size_t i = 0; i < stages_.size(); i++)
+    {
+        AclLiteStageMetrics *stage = stages_[i].get();
+        ReportState         &state = stageStates_[stage];
+        uint64_t             processNum = stage->processNum.Get();
+        uint64_t             droppedNum = stage->droppedNum.Get();
+        int64_t              depth = stage->queueDepth.Get();
+        uint64_t             processDelta = processNum - state.processNum;
+        uint64_t             droppedDelta = droppedNum - state.droppedNum;
+        state.processNum = processNum;
+        state.droppedNum = droppedNum;
+
+        stage->processTime.GetSnapshot(snapshot);
+        AclLiteHistogramSnapshot proc = snapshot.Delta(state.processTime);
+        state.processTime = snapshot;
+        stage->queueWaitTime.GetSnapshot(snapshot);
+        AclLiteHistogramSnapshot wait = snapshot.Delta(state.queueWaitTime);
+        state.queueWaitTime = snapshot;
+
+        // idle instances are left out to keep the summary short
+        if (processDelta == 0 && droppedDelta == 0 && depth == 0)
+        {
+            continue;
+        }
+        ACLLITE_LOG_INFO("[metrics] %s %.1f/s proc us p50/p95/p99/max "
+                         "%lu/%lu/%lu/%lu wait us p50/p99 %lu/%lu queue %ld "
+                         "dropped %lu",
+                         stage->name.c_str(),
+                         processDelta / seconds,
+                         (unsigned long)proc.Percentile(50),
+                         (unsigned long)proc.Percentile(95),
+                         (unsigned long)proc.Percentile(99),
+                         (unsigned long)proc.max,
+                         (unsigned long)wait.Percentile(50),
+                         (unsigned long)wait.Percentile(99),
+                         (long)depth,
+                         (unsigned long)droppedDelta);
+    }
+    for (size_t i = 0; i < histograms_.size(); i++)
+    {
+        const AclLiteHistogram   *hist = histograms_[i].second.get();
+        AclLiteHistogramSnapshot &prev = histStates_[hist];
+        hist->GetSnapshot(snapshot);
+        AclLiteHistogramSnapshot delta = snapshot.Delta(prev);
+        prev = snapshot;
+        if (delta.count == 0)
+        {
+            continue;
+        }
+        ACLLITE_LOG_INFO("[metrics] %s n %lu us p50/p95/p99/max "
+                         "%lu/%lu/%lu/%lu",
+                         histograms_[i].first.c_str(),
+                         (unsigned long)delta.count,
+                         (unsigned long)delta.Percentile(50),
+                         (unsigned long)delta.Percentile(95),
+                         (unsigned long)delta.Percentile(99),
+                         (unsigned long)delta.max);
+    }
+    for (size_t i = 0; i < counters_.size(); i++)
+    {
+        const AclLiteCounter *counter = counters_[i].second.get();
+        uint64_t             &prev = counterStates_[counter];
+        uint64_t              value = counter->Get();
+        if (value == prev)
+        {
+            continue;
+        }
+        ACLLITE_LOG_INFO("[metrics] %s +%lu (total %lu)",
+                         counters_[i].first.c_str(),
+                         (unsigned long)(value - prev),
+                         (unsigned long)value);
+        prev = value;
+    }
+}
+
+string AclLiteMetrics::DumpJson()
+{
+    lock_guard<mutex> lock(mutex_);
+    ostringstream     os;
+    AclLiteHistogramSnapshot snapshot;
+    os << "{\"timestamp_us\":" << AclLiteNowUs() << ",\"stages\":[";
+    for (size_t i = 0; i < stages_.size(); i++)
+    {
+        AclLiteStageMetrics *stage = stages_[i].get();
+        os << (i > 0 ? "," : "") << "{\"name\":\""
+           << JsonEscape(stage->name) << "\",\"processed\":"
+           << stage->processNum.Get() << ",\"dropped\":"
+           << stage->droppedNum.Get() << ",\"queue_depth\":"
+           << stage->queueDepth.Get() << ",\"process_us\":";
+        stage->processTime.GetSnapshot(snapshot);
+        AppendHistogramJson(os, snapshot);
+        os << ",\"queue_wait_us\":";
+        stage->queueWaitTime.GetSnapshot(snapshot);
+        AppendHistogramJson(os, snapshot);
+        os << "}";
+    }
+    os << "],\"histograms\":[";
+    for (size_t i = 0; i < histograms_.size(); i++)
+    {
+        os << (i > 0 ? "," : "") << "{\"name\":\""
+           << JsonEscape(histograms_[i].first) << "\",\"us\":";
+        histograms_[i].second->GetSnapshot(snapshot);
+        AppendHistogramJson(os, snapshot);
+        os << "}";
+    }
+    os << "],\"counters\":{";
+    for (size_t i = 0; i < counters_.size(); i++)
+    {
+        os << (i > 0 ? "," : "") << "\"" << JsonEscape(counters_[i].first)
+           << "\":" << counters_[i].second->Get();
+    }
+    os << "},\"gauges\":{";
+    for (size_t i = 0; i < gauges_.size(); i++)
+    {
+        os << (i > 0 ? "," : "") << "\"" << JsonEscape(gauges_[i].first)
+           << "\":" << gauges_[i].second->Get();
+    }
+    os << "}}";
+    return os.str();
+}
+
+string AclLiteMetrics::DumpPrometheus()
+{
+    map<string, PromFamily>  families;
+    AclLiteHistogramSnapshot snapshot;
+    string                   family;
+    string                   labels;
+    {
+        lock_guard<mutex> lock(mutex_);
+        for (size_t i = 0; i < stages_.size(); i++)
+        {
+            AclLiteStageMetrics *stage = stages_[i].get();
+            labels = PromLabel("instance", stage->name);
+            PromFamily &processed = families["acllite_stage_processed_total"];
+            processed.type = "counter";
+            AppendPromSample(processed.samples,
+                             "acllite_stage_processed_total",
+                             labels,
+                             stage->processNum.Get());
+            PromFamily &dropped = families["acllite_stage_dropped_total"];
+            dropped.type = "counter";
+            AppendPromSample(dropped.samples,
+                             "acllite_stage_dropped_total",
+                             labels,
+                             stage->droppedNum.Get());
+            PromFamily &depth = families["acllite_stage_queue_depth"];
+            depth.type = "gauge";
+            AppendPromSample(depth.samples,
+                             "acllite_stage_queue_depth",
+                             labels,
+                             stage->queueDepth.Get());
+            stage->processTime.GetSnapshot(snapshot);
+            AppendPromHistogram(
+                families, "acllite_stage_process_seconds", labels, snapshot);
+            stage->queueWaitTime.GetSnapshot(snapshot);
+            AppendPromHistogram(
+                families, "acllite_stage_queue_wait_seconds", labels, snapshot);
+        }
+        for (size_t i = 0; i < histograms_.size(); i++)
+        {
+            SplitMetricName(histograms_[i].first, family, labels);
+            histograms_[i].second->GetSnapshot(snapshot);
+            AppendPromHistogram(families, family + "_seconds", labels, snapshot);
+        }
+        for (size_t i = 0; i < counters_.size(); i++)
+        {
+            SplitMetricName(counters_[i].first, family, labels);
+            PromFamily &f = families[family + "_total"];
+            f.type = "counter";
+            AppendPromSample(
+                f.samples, family + "_total", labels, counters_[i].second->Get());
+        }
+        for (size_t i = 0; i < gauges_.size(); i++)
+        {
+            SplitMetricName(gauges_[i].first, family, labels);
+            PromFamily &f = families[family];
+            f.type = "gauge";
+            AppendPromSample(f.samples, family, labels, gauges_[i].second->Get());
+        }
+    }
+    ostringstream os;
+    for (auto &f : families)
+    {
+        os << "# TYPE " << f.first << " " << f.second.type << "\n"
+           << f.second.samples.str();
+    }
+    return os.str();
+}
+
+AclLiteError AclLiteMetrics::WriteDump(const string &path)
+{
+    string   tmpPath = path + ".tmp";
+    ofstream file(tmpPath.c_str(), ios::out | ios::trunc);
+    if (!file.is_open())
+    {
+        ACLLITE_LOG_ERROR("Open metrics dump file %s failed", tmpPath.c_str());
+        return ACLLITE_ERROR_OPEN_FILE;
+    }
+    file << DumpJson() << "\n";
+    file.close();
+    // readers never see a half written file
+    if (rename(tmpPath.c_str(), path.c_str()) != 0)
+    {
+        ACLLITE_LOG_ERROR("Rename metrics dump file to %s failed",
+                          path.c_str());
+        return ACLLITE_ERROR_WRITE_FILE;
+    }
+    return ACLLITE_OK;
+}
+
+AclLiteError AclLiteMetrics::StartReporter(uint32_t      intervalMs,
+                                           const string &dumpPath)
+{
+    lock_guard<mutex> lock(reporterMutex_);
+    if (reporterRunning_)
+    {
+        return ACLLITE_OK;
+    }
+    intervalMs_ = intervalMs < kMinReportInterval ? kMinReportInterval
+                                                  : intervalMs;
+    dumpPath_ = dumpPath;
+    reporterRunning_ = true;
+    reporter_ = thread(&AclLiteMetrics::ReporterEntry, this);
+    ACLLITE_LOG_INFO("Metrics reporter started, interval %u ms, dump %s",
+                     intervalMs_,
+                     dumpPath_.empty() ? "none" : dumpPath_.c_str());
+    return ACLLITE_OK;
+}
+
+void AclLiteMetrics::StopReporter()
+{
+    {
+        lock_guard<mutex> lock(reporterMutex_);
+        if (!reporterRunning_)
+        {
+            return;
+        }
+        reporterRunning_ = false;
+    }
+    reporterCond_.notify_all();
+    if (reporter_.joinable())
+    {
+        reporter_.join();
+    }
+    Report();
+    if (!dumpPath_.empty())
+    {
+        WriteDump(dumpPath_);
+    }
+}
+
+void AclLiteMetrics::ReporterEntry()
+{
+    SetCurrentThreadSched("acllite_metric", AclLiteThreadSched());
+    unique_lock<mutex> lock(reporterMutex_);
+    while (reporterRunning_)
+    {
+        reporterCond_.wait_for(
+            lock, chrono::milliseconds(intervalMs_), [this] {
+                return !reporterRunning_;
+            });
+        if (!reporterRunning_)
+        {
+            break;
+        }
+        lock.unlock();
+        Report();
+        if (!dumpPath_.empty())
+        {
+            WriteDump(dumpPath_);
+        }
+        lock.lock();
+    }
+}
@@ -0,0 +1,222 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File AclLiteMetricsServer.cpp
+* Description: minimal HTTP listener serving AclLiteMetrics in the
+*              Prometheus text format on GET /metrics
+*/
+#include "AclLiteMetricsServer.h"
+#include "AclLiteMetrics.h"
+#include "AclLiteUtils.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+namespace
+{
+const int    kListenBacklog = 8;
+const int    kAcceptPollMs = 200;   // how often Stop is noticed
+const int    kSocketTimeoutMs = 1000;
+const size_t kRequestMaxLen = 4096;
+const char  *kContentType = "text/plain; version=0.0.4; charset=utf-8";
+
+bool SendAll(int fd, const char *data, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return false;
+        }
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+void SendResponse(int fd, const char *status, const string &body)
+{
+    string head = string("HTTP/1.1 ") + status +
+                  "\r\nContent-Type: " + kContentType +
+                  "\r\nContent-Length: " + to_string(body.size()) +
+                  "\r\nConnection: close\r\n\r\n";
+    if (SendAll(fd, head.data(), head.size()))
+    {
+        SendAll(fd, body.data(), body.size());
+    }
+}
+} // namespace
+
+AclLiteMetricsServer::AclLiteMetricsServer() : listenFd_(-1), running_(false)
+{
+}
+
+AclLiteMetricsServer::~AclLiteMetricsServer() { Stop(); }
+
+AclLiteMetricsServer &AclLiteMetricsServer::GetInstance()
+{
+    static AclLiteMetricsServer instance;
+    return instance;
+}
+
+AclLiteError AclLiteMetricsServer::Start(const string &bindAddr, uint16_t port)
+{
+    if (running_)
+    {
+        return ACLLITE_OK;
+    }
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, bindAddr.c_str(), &addr.sin_addr) != 1)
+    {
+        ACLLITE_LOG_ERROR("Metrics http bind address %s is invalid",
+                          bindAddr.c_str());
+        return ACLLITE_ERROR;
+    }
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        ACLLITE_LOG_ERROR("Create metrics http socket failed, errno %d", errno);
+        return ACLLITE_ERROR;
+    }
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (bind(fd, (sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(fd, kListenBacklog) != 0)
+    {
+        ACLLITE_LOG_ERROR("Metrics http listen on %s:%u failed, errno %d",
+                          bindAddr.c_str(),
+                          port,
+                          errno);
+        close(fd);
+        return ACLLITE_ERROR;
+    }
+    listenFd_ = fd;
+    running_ = true;
+    server_ = thread(&AclLiteMetricsServer::ServerEntry, this);
+    ACLLITE_LOG_INFO("Metrics http listening on %s:%u/metrics",
+                     bindAddr.c_str(),
+                     port);
+    return ACLLITE_OK;
+}
+
+void AclLiteMetricsServer::Stop()
+{
+    if (!running_.exchange(false))
+    {
+        return;
+    }
+    if (server_.joinable())
+    {
+        server_.join();
+    }
+    close(listenFd_);
+    listenFd_ = -1;
+}
+
+void AclLiteMetricsServer::ServerEntry()
+{
+    SetCurrentThreadSched("acllite_http", AclLiteThreadSched());
+    pollfd pfd;
+    pfd.fd = listenFd_;
+    pfd.events = POLLIN;
+    while (running_)
+    {
+        pfd.revents = 0;
+        int ret = poll(&pfd, 1, kAcceptPollMs);
+        if (ret <= 0 || !(pfd.revents & POLLIN))
+        {
+            continue;
+        }
+        int fd = accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            continue;
+        }
+        // a stalled client must not keep the listener forever
+        timeval tv;
+        tv.tv_sec = kSocketTimeoutMs / 1000;
+        tv.tv_usec = (kSocketTimeoutMs % 1000) * 1000;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        HandleConnection(fd);
+        close(fd);
+    }
+}
+
+void AclLiteMetricsServer::HandleConnection(int fd)
+{
+    // only the request line is used, read until the end of the headers
+    string request;
+    char   buf[1024];
+    while (request.find("\r\n\r\n") == string::npos &&
+           request.size() < kRequestMaxLen)
+    {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            break;
+        }
+        request.append(buf, n);
+    }
+    size_t lineEnd = request.find("\r\n");
+    if (lineEnd == string::npos)
+    {
+        return;
+    }
+    string line = request.substr(0, lineEnd);
+    size_t methodEnd = line.find(' ');
+    size_t pathEnd = line.find(' ', methodEnd + 1);
+    if (methodEnd == string::npos || pathEnd == string::npos)
+    {
+        SendResponse(fd, "400 Bad Request", "bad request\n");
+        return;
+    }
+    string method = line.substr(0, methodEnd);
+    string path = line.substr(methodEnd + 1, pathEnd - methodEnd - 1);
+    size_t query = path.find('?');
+    if (query != string::npos)
+    {
+        path.resize(query);
+    }
+    if (method != "GET")
+    {
+        SendResponse(fd, "405 Method Not Allowed", "only GET\n");
+    }
+    else if (path == "/metrics")
+    {
+        SendResponse(fd, "200 OK", AclLiteMetrics::GetInstance().DumpPrometheus());
+    }
+    else
+    {
+        SendResponse(fd, "404 Not Found", "see /metrics\n");
+    }
+}
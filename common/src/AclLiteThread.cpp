@@ -20,10 +20,25 @@
 using namespace std;
 AclLiteThread::AclLiteThread()
     : context_(nullptr), runMode_(ACL_HOST), instanceId_(INVALID_INSTANCE_ID),
-      instanceName_(""), baseConfiged_(false)
+      instanceName_(""), baseConfiged_(false), maxBatchSize_(1),
+      batchDeadlineUs_(0)
 {
 }
 
+int AclLiteThread::ProcessBatch(vector<AclLiteThreadMsg> &msgs)
+{
+    for (size_t i = 0; i < msgs.size(); i++)
+    {
+        int ret = Process(msgs[i].msgId, msgs[i].data);
+        msgs[i].data = nullptr;
+        if (ret)
+        {
+            return ret;
+        }
+    }
+    return ACLLITE_OK;
+}
+
 AclLiteError AclLiteThread::BaseConfig(int           instanceId,
                                        const string &threadName,
                                        aclrtContext  context,
@@ -18,19 +18,38 @@
 */
 #include "AclLiteThreadMgr.h"
 #include "AclLiteUtils.h"
+#include "AclLiteWorkerPool.h"
+#include <algorithm>
 using namespace std;
 namespace
 {
-const uint32_t kWait10Milliseconds = 10000;
+const uint32_t kMsgWaitTimeout = 100000;
 const uint32_t kWaitThreadStart = 1000;
+// blocked sender rechecks the receiver status at this interval
+const uint32_t kSendWaitSlice = 100000;
+// blocked pool worker waits this long when there is no other actor to run
+const uint32_t kHelpWaitSlice = 1000;
+// max pending messages of the control lane
+const size_t kCtrlQueueSize = 64;
 } // namespace
 
 AclLiteThreadMgr::AclLiteThreadMgr(AclLiteThread *userThreadInstance,
                                    const string  &threadName,
-                                   const uint32_t msgQueueSize)
+                                   const uint32_t msgQueueSize,
+                                   AclLiteQueueType queueType)
     : isExit_(false), status_(THREAD_READY), userInstance_(userThreadInstance),
-      name_(threadName), msgQueue_(msgQueueSize)
+      name_(threadName), msgQueue_(msgQueueSize), queueType_(queueType),
+      ringQueue_(nullptr), sendPolicy_(ACLLITE_SEND_BLOCK),
+      sendTimeoutUs_(ACLLITE_WAIT_FOREVER), pool_(nullptr),
+      scheduled_(false), ctrlNum_(0), dataPushNum_(0), dataPopNum_(0),
+      batchIsCtrl_(false)
 {
+    metrics_ = AclLiteMetrics::GetInstance().GetStageMetrics(threadName);
+    if (queueType_ != ACLLITE_QUEUE_MUTEX)
+    {
+        ringQueue_ = new RingBufferQueue<shared_ptr<AclLiteMessage>>(
+            msgQueueSize, queueType_ == ACLLITE_QUEUE_MPSC);
+    }
 }
 
 AclLiteThreadMgr::~AclLiteThreadMgr()
@@ -40,10 +59,21 @@ AclLiteThreadMgr::~AclLiteThreadMgr()
     {
         msgQueue_.Pop();
     }
+    if (ringQueue_ != nullptr)
+    {
+        delete ringQueue_;
+        ringQueue_ = nullptr;
+    }
 }
 
 void AclLiteThreadMgr::CreateThread()
 {
+    if (pool_ != nullptr)
+    {
+        // the first run on a worker calls Init
+        TrySchedule();
+        return;
+    }
     thread engine(&AclLiteThreadMgr::ThreadEntry, (void *)this);
     engine.detach();
 }
@@ -59,7 +89,11 @@ void AclLiteThreadMgr::ThreadEntry(void *arg)
         return;
     }
 
-    string      &instName = userInstance->SelfInstanceName();
+    string &instName = userInstance->SelfInstanceName();
+    // named after the instance so that perf/top attribute time to the stage,
+    // helper threads created in Init/Process inherit the affinity
+    SetCurrentThreadSched(instName, thMgr->sched_);
+
     aclrtContext context = userInstance->GetContext();
     aclError     aclRet = aclrtSetCurrentContext(context);
     if (aclRet != ACL_SUCCESS)
@@ -82,16 +116,34 @@ void AclLiteThreadMgr::ThreadEntry(void *arg)
     thMgr->SetStatus(THREAD_RUNNING);
     while (THREAD_RUNNING == thMgr->GetStatus())
     {
-        // get data from queue
-        shared_ptr<AclLiteMessage> msg = thMgr->PopMsgFromQueue();
-        if (msg == nullptr)
+        uint32_t maxBatch = userInstance->GetMaxBatchSize();
+        if (maxBatch > 1)
         {
-            usleep(kWait10Milliseconds);
-            continue;
+            // drain what is queued with one lock and one wakeup
+            if (thMgr->PopMsgBatch(
+                    thMgr->batchMsgs_, maxBatch, kMsgWaitTimeout) == 0)
+            {
+                continue;
+            }
+            uint32_t deadlineUs = userInstance->GetBatchDeadline();
+            if (deadlineUs > 0)
+            {
+                thMgr->FillBatch(thMgr->batchMsgs_, maxBatch, deadlineUs);
+            }
+            ret = thMgr->ProcessBatch(thMgr->batchMsgs_);
+        }
+        else
+        {
+            // get data from queue, sleep until message arrives or woken up
+            shared_ptr<AclLiteMessage> msg =
+                thMgr->PopMsgFromQueue(kMsgWaitTimeout);
+            if (msg == nullptr)
+            {
+                continue;
+            }
+            // call function to process thread msg
+            ret = thMgr->ProcessMsg(msg);
         }
-        // call function to process thread msg
-        ret = userInstance->Process(msg->msgId, msg->data);
-        msg->data = nullptr;
         if (ret)
         {
             ACLLITE_LOG_ERROR("Thread %s process function return "
@@ -108,6 +160,225 @@ void AclLiteThreadMgr::ThreadEntry(void *arg)
     return;
 }
 
+int AclLiteThreadMgr::ProcessMsg(shared_ptr<AclLiteMessage> &msg)
+{
+    int64_t startUs = AclLiteNowUs();
+    metrics_->queueWaitTime.Record(startUs - msg->enqueueUs);
+    metrics_->queueDepth.Set(GetQueueSize());
+    int ret = userInstance_->Process(msg->msgId, msg->data);
+    msg->data = nullptr;
+    metrics_->processTime.Record(AclLiteNowUs() - startUs);
+    metrics_->processNum.Add();
+    return ret;
+}
+
+int AclLiteThreadMgr::ProcessBatch(vector<shared_ptr<AclLiteMessage>> &msgs)
+{
+    if (msgs.size() == 1)
+    {
+        int ret = ProcessMsg(msgs[0]);
+        msgs.clear();
+        return ret;
+    }
+    int64_t startUs = AclLiteNowUs();
+    size_t  batchNum = msgs.size();
+    metrics_->queueDepth.Set(GetQueueSize());
+    batchArgs_.clear();
+    for (size_t i = 0; i < msgs.size(); i++)
+    {
+        metrics_->queueWaitTime.Record(startUs - msgs[i]->enqueueUs);
+        AclLiteThreadMsg arg;
+        arg.msgId = msgs[i]->msgId;
+        arg.data = std::move(msgs[i]->data);
+        batchArgs_.push_back(std::move(arg));
+    }
+    msgs.clear();
+    int ret = userInstance_->ProcessBatch(batchArgs_);
+    batchArgs_.clear();
+    // the histogram stays per message, the batch time is split evenly
+    int64_t perMsgUs = (AclLiteNowUs() - startUs) / (int64_t)batchNum;
+    for (size_t i = 0; i < batchNum; i++)
+    {
+        metrics_->processTime.Record(perMsgUs);
+    }
+    metrics_->processNum.Add(batchNum);
+    return ret;
+}
+
+void AclLiteThreadMgr::TrySchedule()
+{
+    bool expected = false;
+    if (scheduled_.compare_exchange_strong(expected, true))
+    {
+        pool_->Submit(this);
+    }
+}
+
+void AclLiteThreadMgr::RunActor(uint32_t budget)
+{
+    if (status_ == THREAD_READY)
+    {
+        int ret = userInstance_->Init();
+        if (ret)
+        {
+            ACLLITE_LOG_ERROR("Thread %s init error %d, actor exit",
+                              userInstance_->SelfInstanceName().c_str(),
+                              ret);
+            SetStatus(THREAD_ERROR);
+            return;
+        }
+        SetStatus(THREAD_RUNNING);
+    }
+
+    uint32_t maxBatch = userInstance_->GetMaxBatchSize();
+    for (uint32_t i = 0; i < budget && THREAD_RUNNING == status_;)
+    {
+        int ret;
+        if (maxBatch > 1)
+        {
+            uint32_t num = PopMsgBatch(batchMsgs_, min(maxBatch, budget - i));
+            if (num == 0)
+            {
+                break;
+            }
+            i += num;
+            ret = ProcessBatch(batchMsgs_);
+        }
+        else
+        {
+            shared_ptr<AclLiteMessage> msg = PopMsgFromQueue();
+            if (msg == nullptr)
+            {
+                break;
+            }
+            i++;
+            ret = ProcessMsg(msg);
+        }
+        if (ret)
+        {
+            ACLLITE_LOG_ERROR("Thread %s process function return "
+                              "error %d, actor exit",
+                              userInstance_->SelfInstanceName().c_str(),
+                              ret);
+            SetStatus(THREAD_ERROR);
+            return;
+        }
+    }
+
+    scheduled_.store(false);
+    // a sender which pushed while the actor was running saw scheduled_ set
+    // and did not submit it, so check the queue again after clearing it
+    if (THREAD_RUNNING == status_ && GetQueueSize() > 0)
+    {
+        TrySchedule();
+    }
+}
+
+shared_ptr<AclLiteMessage> AclLiteThreadMgr::PopCtrlMsg()
+{
+    if (ctrlNum_.load() == 0)
+    {
+        return nullptr;
+    }
+    lock_guard<mutex> lock(ctrlMutex_);
+    for (auto it = ctrlQueue_.begin(); it != ctrlQueue_.end(); ++it)
+    {
+        // the data lane may also be emptied by ClearQueue, do not wait for
+        // the popped count in that case
+        if (dataPopNum_.load() >= (*it)->fence || GetDataQueueSize() == 0)
+        {
+            shared_ptr<AclLiteMessage> msg = *it;
+            ctrlQueue_.erase(it);
+            ctrlNum_--;
+            return msg;
+        }
+    }
+    return nullptr;
+}
+
+shared_ptr<AclLiteMessage> AclLiteThreadMgr::PopMsgFromQueue()
+{
+    shared_ptr<AclLiteMessage> msg = PopCtrlMsg();
+    return (msg != nullptr) ? msg : PopDataMsg();
+}
+
+shared_ptr<AclLiteMessage> AclLiteThreadMgr::PopMsgFromQueue(uint32_t timeoutUs)
+{
+    // read the sequence before checking the lanes, a control message pushed
+    // after this point wakes up the wait below
+    uint64_t wakeupSeq =
+        ringQueue_ ? ringQueue_->GetWakeupSeq() : msgQueue_.GetWakeupSeq();
+    shared_ptr<AclLiteMessage> msg = PopMsgFromQueue();
+    if (msg != nullptr)
+    {
+        return msg;
+    }
+    ringQueue_ ? ringQueue_->WaitNotEmpty(timeoutUs, wakeupSeq)
+               : msgQueue_.WaitNotEmpty(timeoutUs, wakeupSeq);
+    return PopMsgFromQueue();
+}
+
+uint32_t AclLiteThreadMgr::PopMsgBatch(vector<shared_ptr<AclLiteMessage>> &msgs,
+                                      uint32_t                            maxNum)
+{
+    // a control message is never batched with data, ProcessBatch of the
+    // user instance only sees the data lane
+    shared_ptr<AclLiteMessage> msg = PopCtrlMsg();
+    batchIsCtrl_ = (msg != nullptr);
+    if (msg != nullptr)
+    {
+        msgs.push_back(msg);
+        return 1;
+    }
+    return PopDataBatch(msgs, maxNum);
+}
+
+void AclLiteThreadMgr::FillBatch(vector<shared_ptr<AclLiteMessage>> &msgs,
+                                 uint32_t                            maxNum,
+                                 uint32_t deadlineUs)
+{
+    if (msgs.empty() || batchIsCtrl_)
+    {
+        return;
+    }
+    // counted from the first message, a batch which waited in the queue
+    // long enough is processed at once
+    int64_t dueUs = msgs[0]->enqueueUs + deadlineUs;
+    while (msgs.size() < maxNum && THREAD_RUNNING == status_)
+    {
+        uint64_t wakeupSeq =
+            ringQueue_ ? ringQueue_->GetWakeupSeq() : msgQueue_.GetWakeupSeq();
+        if (PopDataBatch(msgs, maxNum - msgs.size()) > 0)
+        {
+            continue;
+        }
+        int64_t waitUs = dueUs - AclLiteNowUs();
+        if (waitUs <= 0 || ctrlNum_.load() > 0)
+        {
+            break;
+        }
+        // a control message wakes us up as well
+        ringQueue_ ? ringQueue_->WaitNotEmpty((uint32_t)waitUs, wakeupSeq)
+                   : msgQueue_.WaitNotEmpty((uint32_t)waitUs, wakeupSeq);
+    }
+}
+
+uint32_t AclLiteThreadMgr::PopMsgBatch(vector<shared_ptr<AclLiteMessage>> &msgs,
+                                      uint32_t                            maxNum,
+                                      uint32_t timeoutUs)
+{
+    uint64_t wakeupSeq =
+        ringQueue_ ? ringQueue_->GetWakeupSeq() : msgQueue_.GetWakeupSeq();
+    uint32_t num = PopMsgBatch(msgs, maxNum);
+    if (num > 0)
+    {
+        return num;
+    }
+    ringQueue_ ? ringQueue_->WaitNotEmpty(timeoutUs, wakeupSeq)
+               : msgQueue_.WaitNotEmpty(timeoutUs, wakeupSeq);
+    return PopMsgBatch(msgs, maxNum);
+}
+
 AclLiteError AclLiteThreadMgr::WaitThreadInitEnd()
 {
     while (true)
@@ -145,5 +416,177 @@ AclLiteThreadMgr::PushMsgToQueue(shared_ptr<AclLiteMessage> &pMessage)
                           status_);
         return ACLLITE_ERROR_THREAD_ABNORMAL;
     }
-    return msgQueue_.Push(pMessage) ? ACLLITE_OK : ACLLITE_ERROR_ENQUEUE;
+    return QueuePush(pMessage) ? ACLLITE_OK : ACLLITE_ERROR_ENQUEUE;
+}
+
+AclLiteError
+AclLiteThreadMgr::PushMsgToQueue(shared_ptr<AclLiteMessage> &pMessage,
+                                 AclLiteSendPolicy           policy,
+                                 uint32_t                    timeoutUs)
+{
+    if (status_ != THREAD_RUNNING)
+    {
+        ACLLITE_LOG_ERROR("Thread instance %s status(%d) is invalid, "
+                          "can not reveive message",
+                          name_.c_str(),
+                          status_);
+        return ACLLITE_ERROR_THREAD_ABNORMAL;
+    }
+
+    switch (policy)
+    {
+    case ACLLITE_SEND_BLOCK:
+        return PushBlock(pMessage, timeoutUs);
+    case ACLLITE_SEND_DROP_OLDEST:
+        pMessage->droppable = true;
+        return PushDropOldest(pMessage);
+    case ACLLITE_SEND_DROP_NEWEST:
+        if (QueuePush(pMessage))
+        {
+            return ACLLITE_OK;
+        }
+        metrics_->droppedNum.Add();
+        return ACLLITE_ERROR_MSG_DROPPED;
+    case ACLLITE_SEND_FAIL_FAST:
+    default:
+        return QueuePush(pMessage) ? ACLLITE_OK : ACLLITE_ERROR_ENQUEUE;
+    }
+}
+
+AclLiteError
+AclLiteThreadMgr::PushMsgToQueue(shared_ptr<AclLiteMessage> &pMessage,
+                                 AclLiteMsgPriority          priority)
+{
+    if (priority == ACLLITE_PRIO_NORMAL)
+    {
+        return PushMsgToQueue(pMessage);
+    }
+    if (status_ != THREAD_RUNNING)
+    {
+        ACLLITE_LOG_ERROR("Thread instance %s status(%d) is invalid, "
+                          "can not reveive message",
+                          name_.c_str(),
+                          status_);
+        return ACLLITE_ERROR_THREAD_ABNORMAL;
+    }
+
+    {
+        lock_guard<mutex> lock(ctrlMutex_);
+        if (ctrlQueue_.size() >= kCtrlQueueSize)
+        {
+            ACLLITE_LOG_ERROR("Thread instance %s control lane is full, "
+                              "message %d is not sent",
+                              name_.c_str(),
+                              pMessage->msgId);
+            return ACLLITE_ERROR_ENQUEUE;
+        }
+        pMessage->fence =
+            (priority == ACLLITE_PRIO_HIGH_FENCED) ? dataPushNum_.load() : 0;
+        pMessage->enqueueUs = AclLiteNowUs();
+        ctrlQueue_.push_back(pMessage);
+        ctrlNum_++;
+    }
+    // the consumer may sleep on the empty data lane
+    WakeUp();
+    if (pool_ != nullptr)
+    {
+        TrySchedule();
+    }
+    return ACLLITE_OK;
+}
+
+AclLiteError AclLiteThreadMgr::PushBlock(shared_ptr<AclLiteMessage> &pMessage,
+                                         uint32_t timeoutUs)
+{
+    if (QueuePush(pMessage))
+    {
+        return ACLLITE_OK;
+    }
+
+    // wait in slices, so that the sender does not hang on a receiver which
+    // is exiting; the receiver's pop wakes the sender immediately
+    auto start = chrono::steady_clock::now();
+    while (true)
+    {
+        uint32_t waitUs = kSendWaitSlice;
+        if (timeoutUs != ACLLITE_WAIT_FOREVER)
+        {
+            int64_t elapsedUs = chrono::duration_cast<chrono::microseconds>(
+                                    chrono::steady_clock::now() - start)
+                                    .count();
+            if (elapsedUs >= timeoutUs)
+            {
+                metrics_->droppedNum.Add();
+                return ACLLITE_ERROR_MSG_DROPPED;
+            }
+            if (timeoutUs - elapsedUs < waitUs)
+            {
+                waitUs = timeoutUs - elapsedUs;
+            }
+        }
+        bool pushed;
+        if (AclLiteWorkerPool::InWorker())
+        {
+            // a pool worker must not sleep on a full queue, the receiver may
+            // be an actor which only this worker can run now
+            if (AclLiteWorkerPool::HelpOnce())
+            {
+                pushed = QueuePush(pMessage);
+            }
+            else
+            {
+                pushed = QueuePushWait(pMessage, min(waitUs, kHelpWaitSlice));
+            }
+        }
+        else
+        {
+            pushed = QueuePushWait(pMessage, waitUs);
+        }
+        if (pushed)
+        {
+            return ACLLITE_OK;
+        }
+        if (status_ != THREAD_RUNNING)
+        {
+            ACLLITE_LOG_ERROR("Thread instance %s exit while sender blocked",
+                              name_.c_str());
+            return ACLLITE_ERROR_THREAD_ABNORMAL;
+        }
+    }
+}
+
+AclLiteError
+AclLiteThreadMgr::PushDropOldest(shared_ptr<AclLiteMessage> &pMessage)
+{
+    // evict in place, the lane keeps its FIFO order and the popped count
+    // used by the fences only grows by the evicted message
+    shared_ptr<AclLiteMessage> evicted = nullptr;
+    pMessage->enqueueUs = AclLiteNowUs();
+    bool pushed =
+        ringQueue_
+            ? ringQueue_->PushEvict(pMessage, true, evicted)
+            : msgQueue_.PushEvict(
+                  pMessage,
+                  [](const shared_ptr<AclLiteMessage> &msg) {
+                      return msg->droppable;
+                  },
+                  evicted);
+    if (evicted != nullptr)
+    {
+        dataPopNum_++;
+        metrics_->droppedNum.Add();
+    }
+    if (!pushed)
+    {
+        // nothing droppable ahead of it, drop the new message instead of
+        // waiting: a drop policy never blocks the sender
+        metrics_->droppedNum.Add();
+        return ACLLITE_ERROR_MSG_DROPPED;
+    }
+    dataPushNum_++;
+    if (pool_ != nullptr)
+    {
+        TrySchedule();
+    }
+    return ACLLITE_OK;
 }
\ No newline at end of file
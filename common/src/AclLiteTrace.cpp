@@ -0,0 +1,265 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File AclLiteTrace.cpp
+* Description: per frame stage spans and a Chrome trace event JSON sink
+*/
+#include "AclLiteTrace.h"
+#include "AclLiteMetrics.h"
+#include "AclLiteUtils.h"
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+namespace
+{
+const uint32_t kMinRingSize = 16;
+const uint32_t kWriterWaitMs = 200;
+const size_t   kThreadNameLen = 16;
+}
+
+void AclLiteFrameTrace::Add(const char *name, int64_t beginUs, int64_t endUs)
+{
+    if (!sampled || spanNum >= kMaxSpans)
+    {
+        return;
+    }
+    AclLiteSpan &span = spans[spanNum++];
+    span.name = name;
+    span.beginUs = beginUs;
+    span.endUs = endUs;
+    span.tid = AclLiteTracer::CurrentThreadId();
+}
+
+int AclLiteFrameTrace::BeginSpan(const char *name)
+{
+    if (spanNum >= kMaxSpans)
+    {
+        return -1;
+    }
+    AclLiteSpan &span = spans[spanNum];
+    span.name = name;
+    span.beginUs = AclLiteNowUs();
+    span.endUs = span.beginUs;
+    span.tid = AclLiteTracer::CurrentThreadId();
+    return spanNum++;
+}
+
+void AclLiteFrameTrace::EndSpan(int index)
+{
+    spans[index].endUs = AclLiteNowUs();
+}
+
+AclLiteTracer::AclLiteTracer()
+    : enable_(false), sampleInterval_(1), head_(0), pendingNum_(0),
+      droppedNum_(0), running_(false), file_(nullptr), firstEvent_(true)
+{
+}
+
+AclLiteTracer::~AclLiteTracer()
+{
+    Stop();
+}
+
+AclLiteTracer &AclLiteTracer::GetInstance()
+{
+    static AclLiteTracer instance;
+    return instance;
+}
+
+int32_t AclLiteTracer::CurrentThreadId()
+{
+    static thread_local int32_t tid = 0;
+    if (tid == 0)
+    {
+        tid = (int32_t)syscall(SYS_gettid);
+        GetInstance().RegisterThread(tid);
+    }
+    return tid;
+}
+
+void AclLiteTracer::RegisterThread(int32_t tid)
+{
+    char name[kThreadNameLen] = {0};
+    pthread_getname_np(pthread_self(), name, sizeof(name));
+    lock_guard<mutex> lock(mutex_);
+    threadNames_[tid] = name;
+}
+
+AclLiteError AclLiteTracer::Start(const string &path, uint32_t ringSize)
+{
+    lock_guard<mutex> lock(mutex_);
+    if (running_)
+    {
+        return ACLLITE_OK;
+    }
+    file_ = fopen(path.c_str(), "w");
+    if (file_ == nullptr)
+    {
+        ACLLITE_LOG_ERROR("Open trace file %s failed", path.c_str());
+        return ACLLITE_ERROR_OPEN_FILE;
+    }
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file_);
+    firstEvent_ = true;
+    ring_.resize(ringSize < kMinRingSize ? kMinRingSize : ringSize);
+    head_ = 0;
+    pendingNum_ = 0;
+    droppedNum_ = 0;
+    running_ = true;
+    writer_ = thread(&AclLiteTracer::WriterEntry, this);
+    ACLLITE_LOG_INFO("Frame trace writes to %s, ring %zu frames",
+                     path.c_str(),
+                     ring_.size());
+    return ACLLITE_OK;
+}
+
+void AclLiteTracer::Stop()
+{
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (!running_)
+        {
+            return;
+        }
+        running_ = false;
+        enable_.store(false, memory_order_relaxed);
+    }
+    cond_.notify_all();
+    if (writer_.joinable())
+    {
+        writer_.join();
+    }
+    // frames released after the writer exited
+    WriteRecords();
+    fputs("\n]}\n", file_);
+    fclose(file_);
+    file_ = nullptr;
+    if (droppedNum_ > 0)
+    {
+        ACLLITE_LOG_WARNING("Frame trace dropped %lu frames, ring full",
+                            (unsigned long)droppedNum_);
+    }
+}
+
+void AclLiteTracer::Submit(uint32_t                 channelId,
+                           int                      frameNum,
+                           const AclLiteFrameTrace &trace)
+{
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (!running_ || ring_.empty())
+        {
+            return;
+        }
+        if (pendingNum_ == ring_.size())
+        {
+            droppedNum_++;
+            return;
+        }
+        Record &record = ring_[(head_ + pendingNum_) % ring_.size()];
+        record.channelId = channelId;
+        record.frameNum = frameNum;
+        record.trace = trace;
+        pendingNum_++;
+    }
+    cond_.notify_one();
+}
+
+void AclLiteTracer::WriterEntry()
+{
+    SetCurrentThreadSched("acllite_trace", AclLiteThreadSched());
+    unique_lock<mutex> lock(mutex_);
+    while (running_)
+    {
+        cond_.wait_for(lock, chrono::milliseconds(kWriterWaitMs));
+        lock.unlock();
+        WriteRecords();
+        lock.lock();
+    }
+}
+
+void AclLiteTracer::WriteMetadata(const char *name, uint32_t pid,
+                                  int32_t tid, const string &value)
+{
+    fprintf(file_,
+            "%s{\"name\":\"%s\",\"ph\":\"M\",\"pid\":%u,\"tid\":%d,"
+            "\"args\":{\"name\":\"%s\"}}",
+            firstEvent_ ? "" : ",\n",
+            name,
+            pid,
+            tid,
+            value.c_str());
+    firstEvent_ = false;
+}
+
+void AclLiteTracer::WriteRecords()
+{
+    char   line[512];
+    Record record;
+    while (true)
+    {
+        {
+            lock_guard<mutex> lock(mutex_);
+            if (pendingNum_ == 0)
+            {
+                break;
+            }
+            record = ring_[head_];
+            head_ = (head_ + 1) % ring_.size();
+            pendingNum_--;
+        }
+        // channel c is shown as process c + 1, pid 0 looks invalid to viewers
+        uint32_t pid = record.channelId + 1;
+        if (namedChannels_.insert(pid).second)
+        {
+            WriteMetadata("process_name", pid, 0,
+                          "channel " + to_string(record.channelId));
+        }
+        for (uint32_t i = 0; i < record.trace.spanNum; i++)
+        {
+            const AclLiteSpan &span = record.trace.spans[i];
+            // thread names are per process in the trace format
+            if (namedThreads_.insert(make_pair(pid, span.tid)).second)
+            {
+                string threadName;
+                {
+                    lock_guard<mutex> lock(mutex_);
+                    threadName = threadNames_[span.tid];
+                }
+                WriteMetadata("thread_name", pid, span.tid, threadName);
+            }
+            int len = snprintf(line,
+                               sizeof(line),
+                               "%s{\"name\":\"%s\",\"cat\":\"frame\","
+                               "\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,"
+                               "\"pid\":%u,\"tid\":%d,"
+                               "\"args\":{\"frame\":%d}}",
+                               firstEvent_ ? "" : ",\n",
+                               span.name,
+                               (long long)span.beginUs,
+                               (long long)(span.endUs - span.beginUs),
+                               pid,
+                               span.tid,
+                               record.frameNum);
+            if (len > 0 && len < (int)sizeof(line))
+            {
+                fwrite(line, 1, len, file_);
+                firstEvent_ = false;
+            }
+        }
+    }
+    fflush(file_);
+}
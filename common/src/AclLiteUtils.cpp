@@ -19,14 +19,19 @@
 #include "AclLiteUtils.h"
 #include "acl/acl.h"
 #include "acl/ops/acl_dvpp.h"
+#include <cerrno>
 #include <cstring>
 #include <dirent.h>
 #include <fstream>
 #include <iostream>
 #include <map>
+#include <pthread.h>
 #include <regex>
+#include <sched.h>
 #include <string.h>
+#include <sys/resource.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <unistd.h>
 #include <vector>
@@ -60,6 +65,13 @@ const string kRegexVideoFile = "^.+\\.(mp4|h264|h265)$";
 
 // regex for verify RTSP rtsp://ip:port/channelname
 const string kRegexRtsp = "^rtsp://.*";
+
+// pthread name is limited to 16 bytes including the terminator
+const size_t kThreadNameMaxLen = 15;
+
+// helper thread role => scheduling settings
+mutex                           g_helperSchedMutex;
+map<string, AclLiteThreadSched> g_helperSched;
 } // namespace
 
 bool IsDigitStr(const string &str)
@@ -487,13 +499,18 @@ AclLiteError ReadJpeg(ImageData &image, const std::string &fileName)
     uint32_t size = 0;
     void    *buf = nullptr;
 
-    ReadBinFile(fileName, buf, size);
+    AclLiteError ret = ReadBinFile(fileName, buf, size);
+    if (ret != ACLLITE_OK)
+    {
+        return ret;
+    }
 
     int32_t ch = 0;
     acldvppJpegGetImageInfo(buf, size, &(image.width), &(image.height), &ch);
     if (image.width == 0 || image.height == 0)
     {
         ACLLITE_LOG_ERROR("unsupported format, only Baseline JPEG");
+        delete[] (uint8_t *)buf;
         return ACLLITE_ERROR;
     }
     image.data.reset((uint8_t *)buf, [](uint8_t *p) { delete[] (p); });
@@ -572,6 +589,18 @@ void Trim(string &str)
     str = str.substr(startPos, endPos - startPos + 1);
 }
 
+string TrimString(const string &value)
+{
+    const string whitespace = " \t\n\r";
+    size_t       start = value.find_first_not_of(whitespace);
+    if (start == string::npos)
+    {
+        return "";
+    }
+    size_t end = value.find_last_not_of(whitespace);
+    return value.substr(start, end - start + 1);
+}
+
 bool AnalyseLine(const string &line, string &key, string &value)
 {
     if (line.empty())
@@ -638,3 +667,85 @@ void PrintConfig(const map<string, string> &config)
         cout << mIter->first << "=" << mIter->second << endl;
     }
 }
+
+AclLiteError SetCurrentThreadSched(const string             &name,
+                                   const AclLiteThreadSched &sched)
+{
+    pthread_setname_np(pthread_self(),
+                       name.substr(0, kThreadNameMaxLen).c_str());
+
+    AclLiteError ret = ACLLITE_OK;
+    if (!sched.cpus.empty())
+    {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        for (size_t i = 0; i < sched.cpus.size(); i++)
+        {
+            if (sched.cpus[i] >= 0 && sched.cpus[i] < CPU_SETSIZE)
+            {
+                CPU_SET(sched.cpus[i], &cpuSet);
+            }
+        }
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet),
+                                         &cpuSet);
+        if (err != 0)
+        {
+            ACLLITE_LOG_WARNING("Thread %s set cpu affinity failed, error %d",
+                                name.c_str(), err);
+            ret = ACLLITE_ERROR_SET_THREAD_SCHED;
+        }
+    }
+    if (sched.nice != ACLLITE_NICE_KEEP)
+    {
+        // nice value is per thread on linux
+        pid_t tid = (pid_t)syscall(SYS_gettid);
+        if (setpriority(PRIO_PROCESS, tid, sched.nice) != 0)
+        {
+            ACLLITE_LOG_WARNING("Thread %s set nice %d failed, errno %d",
+                                name.c_str(), sched.nice, errno);
+            ret = ACLLITE_ERROR_SET_THREAD_SCHED;
+        }
+    }
+    if (sched.fifoPriority > 0)
+    {
+        struct sched_param param;
+        param.sched_priority = sched.fifoPriority;
+        int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (err != 0)
+        {
+            // needs CAP_SYS_NICE or a RLIMIT_RTPRIO grant
+            ACLLITE_LOG_WARNING("Thread %s set SCHED_FIFO priority %d failed, "
+                                "error %d",
+                                name.c_str(), sched.fifoPriority, err);
+            ret = ACLLITE_ERROR_SET_THREAD_SCHED;
+        }
+    }
+    if (!sched.IsDefault() && ret == ACLLITE_OK)
+    {
+        ACLLITE_LOG_INFO("Thread %s sched: %zu cpus, nice %d, fifo %d",
+                         name.c_str(), sched.cpus.size(),
+                         sched.nice == ACLLITE_NICE_KEEP ? 0 : sched.nice,
+                         sched.fifoPriority);
+    }
+    return ret;
+}
+
+void SetHelperThreadSched(const string &role, const AclLiteThreadSched &sched)
+{
+    lock_guard<mutex> lock(g_helperSchedMutex);
+    g_helperSched[role] = sched;
+}
+
+void ApplyHelperThreadSched(const string &role, const string &name)
+{
+    AclLiteThreadSched sched;
+    {
+        lock_guard<mutex> lock(g_helperSchedMutex);
+        auto it = g_helperSched.find(role);
+        if (it != g_helperSched.end())
+        {
+            sched = it->second;
+        }
+    }
+    SetCurrentThreadSched(name, sched);
+}
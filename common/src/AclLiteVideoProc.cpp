@@ -71,11 +71,12 @@ AclLiteVideoProc::AclLiteVideoProc(uint32_t cameraId,
 #endif
 }
 
-AclLiteVideoProc::AclLiteVideoProc(const string &videoPath,
-                                   int32_t       deviceId,
-                                   aclrtContext  context)
+AclLiteVideoProc::AclLiteVideoProc(const string            &videoPath,
+                                   int32_t                  deviceId,
+                                   aclrtContext             context,
+                                   const VideoDecodeConfig &decodeConfig)
 {
-    cap_ = new VideoCapture(videoPath, deviceId, context);
+    cap_ = new VideoCapture(videoPath, deviceId, context, decodeConfig);
     Open();
 }
 
@@ -0,0 +1,266 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File AclLiteWorkerPool.cpp
+* Description: fixed size work stealing pool which runs AclLiteThread
+*              instances as actors
+*/
+#include "AclLiteWorkerPool.h"
+#include "AclLiteThreadMgr.h"
+#include "AclLiteUtils.h"
+#include <sched.h>
+
+using namespace std;
+namespace
+{
+// max messages one actor processes before the worker moves to next actor
+const uint32_t kActorMsgBudget = 4;
+const uint32_t kWorkerIdleWait = 10000;
+
+// per worker thread state
+thread_local AclLiteWorkerPool *tlsPool = nullptr;
+thread_local uint32_t           tlsWorkerIndex = 0;
+thread_local aclrtContext       tlsContext = nullptr;
+
+// cpus the process is allowed to run on
+vector<int> ProcessCpus()
+{
+    vector<int> cpus;
+    cpu_set_t   cpuSet;
+    CPU_ZERO(&cpuSet);
+    if (sched_getaffinity(0, sizeof(cpuSet), &cpuSet) != 0)
+    {
+        return cpus;
+    }
+    for (int i = 0; i < CPU_SETSIZE; i++)
+    {
+        if (CPU_ISSET(i, &cpuSet))
+        {
+            cpus.push_back(i);
+        }
+    }
+    return cpus;
+}
+} // namespace
+
+AclLiteWorkerPool::AclLiteWorkerPool(uint32_t workerNum, const vector<int> &cpus)
+    : workerNum_(workerNum), cpus_(cpus), running_(false), nextWorker_(0),
+      pendingNum_(0), idleNum_(0)
+{
+    if (cpus_.empty())
+    {
+        cpus_ = ProcessCpus();
+    }
+    if (workerNum_ == 0)
+    {
+        workerNum_ = thread::hardware_concurrency();
+        if (workerNum_ == 0)
+        {
+            workerNum_ = 1;
+        }
+    }
+    for (uint32_t i = 0; i < workerNum_; i++)
+    {
+        workers_.push_back(new Worker());
+    }
+}
+
+AclLiteWorkerPool::~AclLiteWorkerPool()
+{
+    Stop();
+    for (size_t i = 0; i < workers_.size(); i++)
+    {
+        delete workers_[i];
+    }
+    workers_.clear();
+}
+
+void AclLiteWorkerPool::Start()
+{
+    bool expected = false;
+    if (!running_.compare_exchange_strong(expected, true))
+    {
+        return;
+    }
+    for (uint32_t i = 0; i < workerNum_; i++)
+    {
+        workers_[i]->thread = thread(&AclLiteWorkerPool::WorkerEntry, this, i);
+    }
+    ACLLITE_LOG_INFO("AclLite worker pool started with %u workers",
+                     workerNum_);
+}
+
+void AclLiteWorkerPool::Stop()
+{
+    bool expected = true;
+    if (!running_.compare_exchange_strong(expected, false))
+    {
+        return;
+    }
+    {
+        lock_guard<mutex> lock(idleMutex_);
+        idleCond_.notify_all();
+    }
+    for (uint32_t i = 0; i < workerNum_; i++)
+    {
+        if (workers_[i]->thread.joinable())
+        {
+            workers_[i]->thread.join();
+        }
+        lock_guard<mutex> lock(workers_[i]->mutex);
+        workers_[i]->runQueue.clear();
+    }
+    pendingNum_ = 0;
+}
+
+void AclLiteWorkerPool::Submit(AclLiteThreadMgr *actor)
+{
+    // keep the actor on the current worker for cache locality, other
+    // workers can steal it when they are idle
+    uint32_t index;
+    if (tlsPool == this)
+    {
+        index = tlsWorkerIndex;
+    }
+    else
+    {
+        index = nextWorker_.fetch_add(1) % workerNum_;
+    }
+    {
+        lock_guard<mutex> lock(workers_[index]->mutex);
+        workers_[index]->runQueue.push_front(actor);
+    }
+    pendingNum_.fetch_add(1);
+    if (idleNum_.load() > 0)
+    {
+        lock_guard<mutex> lock(idleMutex_);
+        idleCond_.notify_one();
+    }
+}
+
+AclLiteThreadMgr *AclLiteWorkerPool::TakeTask(uint32_t index)
+{
+    AclLiteThreadMgr *actor = nullptr;
+    {
+        lock_guard<mutex> lock(workers_[index]->mutex);
+        if (!workers_[index]->runQueue.empty())
+        {
+            actor = workers_[index]->runQueue.front();
+            workers_[index]->runQueue.pop_front();
+        }
+    }
+    // steal from the tail of the other workers
+    for (uint32_t i = 1; actor == nullptr && i < workerNum_; i++)
+    {
+        Worker           *victim = workers_[(index + i) % workerNum_];
+        lock_guard<mutex> lock(victim->mutex);
+        if (!victim->runQueue.empty())
+        {
+            actor = victim->runQueue.back();
+            victim->runQueue.pop_back();
+        }
+    }
+    if (actor != nullptr)
+    {
+        pendingNum_.fetch_sub(1);
+    }
+    return actor;
+}
+
+void AclLiteWorkerPool::RunTask(AclLiteThreadMgr *actor)
+{
+    AclLiteThread *userInstance = actor->GetUserInstance();
+    if (userInstance == nullptr)
+    {
+        return;
+    }
+    aclrtContext context = userInstance->GetContext();
+    if (context != tlsContext)
+    {
+        aclError aclRet = aclrtSetCurrentContext(context);
+        if (aclRet != ACL_SUCCESS)
+        {
+            ACLLITE_LOG_ERROR("Worker %u set context for %s failed, error: %d",
+                              tlsWorkerIndex,
+                              actor->GetThreadName().c_str(),
+                              aclRet);
+            actor->SetStatus(THREAD_ERROR);
+            return;
+        }
+        tlsContext = context;
+    }
+    actor->RunActor(kActorMsgBudget);
+}
+
+bool AclLiteWorkerPool::RunOneTask()
+{
+    if (tlsPool != this)
+    {
+        return false;
+    }
+    AclLiteThreadMgr *actor = TakeTask(tlsWorkerIndex);
+    if (actor == nullptr)
+    {
+        return false;
+    }
+    // the blocked actor continues with its own context after helping
+    aclrtContext savedContext = tlsContext;
+    RunTask(actor);
+    if (tlsContext != savedContext)
+    {
+        aclrtSetCurrentContext(savedContext);
+        tlsContext = savedContext;
+    }
+    return true;
+}
+
+bool AclLiteWorkerPool::InWorker() { return tlsPool != nullptr; }
+
+bool AclLiteWorkerPool::HelpOnce()
+{
+    return (tlsPool != nullptr) && tlsPool->RunOneTask();
+}
+
+void AclLiteWorkerPool::WorkerEntry(uint32_t index)
+{
+    tlsPool = this;
+    tlsWorkerIndex = index;
+    tlsContext = nullptr;
+    // one worker per cpu keeps the actors it runs on a warm cache
+    AclLiteThreadSched sched;
+    if (!cpus_.empty())
+    {
+        sched.cpus.push_back(cpus_[index % cpus_.size()]);
+    }
+    SetCurrentThreadSched("acllite_pool" + to_string(index), sched);
+
+    while (running_)
+    {
+        AclLiteThreadMgr *actor = TakeTask(index);
+        if (actor != nullptr)
+        {
+            RunTask(actor);
+            continue;
+        }
+
+        unique_lock<mutex> lock(idleMutex_);
+        idleNum_.fetch_add(1);
+        idleCond_.wait_for(lock, chrono::microseconds(kWorkerIdleWait), [this] {
+            return pendingNum_.load() > 0 || !running_;
+        });
+        idleNum_.fetch_sub(1);
+    }
+    tlsPool = nullptr;
+}
@@ -0,0 +1,97 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File DisposablePacket.cpp
+* Description: finds the annexb packets which can be dropped before decoding
+*/
+#include "DisposablePacket.h"
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+}
+
+namespace
+{
+const int kHevcMaxNonRefType = 14; // RSV_VCL_N14
+const int kHevcFirstNonVclType = 32;
+const int kHevcSpsType = 33;
+} // namespace
+
+DisposablePacketFilter::DisposablePacketFilter()
+    : spsMaxTemporalId_(-1), seenMaxTemporalId_(0)
+{
+}
+
+void DisposablePacketFilter::Reset()
+{
+    spsMaxTemporalId_ = -1;
+    seenMaxTemporalId_ = 0;
+}
+
+bool DisposablePacketFilter::IsDisposable(const uint8_t *data,
+                                          int            size,
+                                          int            videoType)
+{
+    if (videoType != AV_CODEC_ID_H264 && videoType != AV_CODEC_ID_HEVC)
+    {
+        return false;
+    }
+    for (int i = 0; i + 3 < size; i++)
+    {
+        if (data[i] != 0 || data[i + 1] != 0 || data[i + 2] != 1)
+        {
+            continue;
+        }
+        uint8_t header = data[i + 3];
+        if (videoType == AV_CODEC_ID_H264)
+        {
+            int type = header & 0x1f;
+            if (type >= 1 && type <= 5)
+            {
+                return type != 5 && (header & 0x60) == 0;
+            }
+            i += 3;
+            continue;
+        }
+        if (i + 4 >= size)
+        {
+            break;
+        }
+        int type = (header >> 1) & 0x3f;
+        int temporalId = (data[i + 4] & 0x7) - 1;
+        if (type == kHevcSpsType && i + 5 < size)
+        {
+            // sps_video_parameter_set_id u(4), sps_max_sub_layers_minus1 u(3)
+            spsMaxTemporalId_ = (data[i + 5] >> 1) & 0x7;
+        }
+        else if (type < kHevcFirstNonVclType)
+        {
+            if (temporalId > seenMaxTemporalId_)
+            {
+                seenMaxTemporalId_ = temporalId;
+            }
+            if (type > kHevcMaxNonRefType || (type % 2) != 0)
+            {
+                return false;
+            }
+            int maxTemporalId =
+                spsMaxTemporalId_ >= 0 ? spsMaxTemporalId_ : seenMaxTemporalId_;
+            return temporalId >= maxTemporalId;
+        }
+        i += 4;
+    }
+    return false;
+}
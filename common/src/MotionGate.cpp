@@ -0,0 +1,128 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File MotionGate.cpp
+* Description: frame difference against a running background of a
+*              downscaled luma plane
+*/
+#include "MotionGate.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+namespace
+{
+const uint32_t kSampleStep = 2; // pixels read per cell row and column step
+}
+
+MotionGate::MotionGate(const MotionGateConfig &config)
+    : config_(config), width_(0), height_(0), cellSize_(1), cols_(0),
+      rows_(0), quietNum_(0), activity_(0), forced_(false)
+{
+    config_.gridWidth = max(config_.gridWidth, 1u);
+    config_.learningRate = min(max(config_.learningRate, 0.0f), 1.0f);
+}
+
+void MotionGate::Reset()
+{
+    width_ = 0;
+    height_ = 0;
+    background_.clear();
+    quietNum_ = 0;
+    activity_ = 0;
+}
+
+void MotionGate::Downscale(const uint8_t *luma, uint32_t stride)
+{
+    uint32_t step = min(kSampleStep, cellSize_);
+    uint32_t samples = ((cellSize_ + step - 1) / step) *
+                       ((cellSize_ + step - 1) / step);
+    for (uint32_t r = 0; r < rows_; r++)
+    {
+        for (uint32_t c = 0; c < cols_; c++)
+        {
+            const uint8_t *cell = luma + r * cellSize_ * stride + c * cellSize_;
+            uint32_t       sum = 0;
+            for (uint32_t y = 0; y < cellSize_; y += step)
+            {
+                const uint8_t *row = cell + y * stride;
+                for (uint32_t x = 0; x < cellSize_; x += step)
+                {
+                    sum += row[x];
+                }
+            }
+            cells_[r * cols_ + c] = (uint8_t)(sum / samples);
+        }
+    }
+}
+
+bool MotionGate::Update(const uint8_t *luma,
+                        uint32_t       width,
+                        uint32_t       height,
+                        uint32_t       stride)
+{
+    forced_ = false;
+    if ((width != width_) || (height != height_) || background_.empty())
+    {
+        // a partial cell at the right and bottom edges is left out
+        width_ = width;
+        height_ = height;
+        cellSize_ = max(width / config_.gridWidth, 1u);
+        cols_ = width / cellSize_;
+        rows_ = height / cellSize_;
+        cells_.assign(cols_ * rows_, 0);
+        Downscale(luma, stride);
+        background_.assign(cells_.begin(), cells_.end());
+        quietNum_ = 0;
+        activity_ = 0;
+        return true;
+    }
+    Downscale(luma, stride);
+
+    size_t cellNum = cells_.size();
+    float  offset = 0;
+    for (size_t i = 0; i < cellNum; i++)
+    {
+        offset += cells_[i] - background_[i];
+    }
+    offset /= cellNum;
+    size_t activeNum = 0;
+    float  rate = config_.learningRate;
+    for (size_t i = 0; i < cellNum; i++)
+    {
+        float diff = cells_[i] - background_[i];
+        if (fabs(diff - offset) > config_.pixelThreshold)
+        {
+            activeNum++;
+        }
+        background_[i] += rate * diff;
+    }
+    activity_ = (float)activeNum / cellNum;
+
+    // a threshold of 0 still needs one active cell
+    if ((activeNum > 0) && (activity_ >= config_.activityThreshold))
+    {
+        quietNum_ = 0;
+        return true;
+    }
+    quietNum_++;
+    if ((config_.maxSkipFrames > 0) && (quietNum_ > config_.maxSkipFrames))
+    {
+        quietNum_ = 0;
+        forced_ = true;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,256 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File PicDirReader.cpp
+* Description: reads a list of jpeg files ahead on a pool of jpegd workers
+*/
+#include "PicDirReader.h"
+#include "AclLiteUtils.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+PicDirReader::PicDirReader(const string         &name,
+                           const vector<string> &files,
+                           uint32_t              workerNum,
+                           uint32_t              prefetch,
+                           aclrtRunMode          runMode)
+    : name_(name), files_(files), workerNum_(max(workerNum, 1u)),
+      prefetch_(max(prefetch, max(workerNum, 1u))), runMode_(runMode),
+      context_(nullptr), slots_(prefetch_), nextDecode_(0), nextRead_(0),
+      startedNum_(0), failedNum_(0), stop_(false), decodeTime_(nullptr),
+      readWait_(nullptr), skippedNum_(nullptr)
+{
+}
+
+PicDirReader::~PicDirReader() { Close(); }
+
+AclLiteError PicDirReader::Open()
+{
+    if (!workers_.empty())
+    {
+        return ACLLITE_OK;
+    }
+    aclError aclRet = aclrtGetCurrentContext(&context_);
+    if (aclRet != ACL_SUCCESS)
+    {
+        ACLLITE_LOG_ERROR("Get current context failed, error %d", aclRet);
+        return ACLLITE_ERROR_GET_ACL_CONTEXT;
+    }
+    decodeTime_ = AclLiteMetrics::GetInstance().GetHistogram(name_ + ".decode");
+    readWait_ = AclLiteMetrics::GetInstance().GetHistogram(name_ + ".read_wait");
+    skippedNum_ =
+        AclLiteMetrics::GetInstance().GetCounter(name_ + ".skipped_files");
+
+    for (uint32_t i = 0; i < workerNum_; i++)
+    {
+        workers_.push_back(thread(&PicDirReader::WorkerEntry, this, i));
+    }
+    // each worker creates its jpegd channel on start
+    unique_lock<mutex> lock(mutex_);
+    decoded_.wait(lock, [this] { return startedNum_ == workerNum_; });
+    if (failedNum_ == workerNum_)
+    {
+        lock.unlock();
+        ACLLITE_LOG_ERROR("No jpegd channel of %s could be created",
+                          name_.c_str());
+        Close();
+        return ACLLITE_ERRROR_CREATE_DVPP_CHANNEL;
+    }
+    ACLLITE_LOG_INFO("%s reads %zu files on %u workers, %u ahead",
+                     name_.c_str(),
+                     files_.size(),
+                     workerNum_ - failedNum_,
+                     prefetch_);
+    return ACLLITE_OK;
+}
+
+void PicDirReader::Close()
+{
+    {
+        lock_guard<mutex> lock(mutex_);
+        stop_ = true;
+    }
+    consumed_.notify_all();
+    decoded_.notify_all();
+    for (auto &worker : workers_)
+    {
+        worker.join();
+    }
+    workers_.clear();
+}
+
+void PicDirReader::WorkerEntry(PicDirReader *self, uint32_t index)
+{
+    ApplyHelperThreadSched("decode", self->name_ + "_" + to_string(index));
+    AclLiteImageProc jpegd;
+    AclLiteError     ret = ACLLITE_ERROR_SET_ACL_CONTEXT;
+    if (aclrtSetCurrentContext(self->context_) == ACL_SUCCESS)
+    {
+        ret = jpegd.Init("DVPP_CHNMODE_JPEGD");
+    }
+    {
+        lock_guard<mutex> lock(self->mutex_);
+        self->startedNum_++;
+        if (ret != ACLLITE_OK)
+        {
+            self->failedNum_++;
+        }
+    }
+    self->decoded_.notify_all();
+    if (ret != ACLLITE_OK)
+    {
+        ACLLITE_LOG_ERROR("%s worker %u jpegd init failed, error %d",
+                          self->name_.c_str(),
+                          index,
+                          ret);
+        return;
+    }
+    self->WorkerLoop(jpegd);
+    jpegd.DestroyResource();
+}
+
+void PicDirReader::WorkerLoop(AclLiteImageProc &jpegd)
+{
+    unique_lock<mutex> lock(mutex_);
+    while (true)
+    {
+        // file i may only start once file i - prefetch has been read, its
+        // slot is free then
+        consumed_.wait(lock, [this] {
+            return stop_ || (nextDecode_ >= files_.size()) ||
+                   (nextDecode_ < nextRead_ + prefetch_);
+        });
+        if (stop_ || (nextDecode_ >= files_.size()))
+        {
+            return;
+        }
+        size_t index = nextDecode_++;
+        lock.unlock();
+
+        Slot slot;
+        slot.ret = DecodeFile(jpegd, files_[index], slot);
+        slot.ready = true;
+
+        lock.lock();
+        slots_[index % prefetch_] = slot;
+        decoded_.notify_all();
+    }
+}
+
+AclLiteError PicDirReader::DecodeFile(AclLiteImageProc &jpegd,
+                                      const string     &file,
+                                      Slot             &slot)
+{
+    AclLiteScopeTimer timer(decodeTime_);
+    int64_t           readUs = AclLiteNowUs();
+    ImageData         jpgImg, dvppJpg;
+    AclLiteError      ret = ReadJpeg(jpgImg, file);
+    if (ret != ACLLITE_OK)
+    {
+        return ret;
+    }
+    ret = CopyImageToDevice(dvppJpg, jpgImg, runMode_, MEMORY_DVPP);
+    if (ret != ACLLITE_OK)
+    {
+        return ret;
+    }
+    ret = jpegd.JpegD(slot.dvppImg, dvppJpg);
+    if (ret != ACLLITE_OK)
+    {
+        return ret;
+    }
+    // a picture has no pts, its capture is the file read
+    slot.dvppImg.captureUs = readUs;
+    slot.dvppImg.decodeUs = AclLiteNowUs();
+    return PackToHost(slot.hostImg, slot.dvppImg);
+}
+
+AclLiteError PicDirReader::PackToHost(ImageData &hostImg, ImageData &dvppImg)
+{
+    ImageData    alignImg;
+    AclLiteError ret = CopyImageToLocal(alignImg, dvppImg, runMode_);
+    if (ret != ACLLITE_OK)
+    {
+        return ret;
+    }
+    hostImg = alignImg;
+    hostImg.alignWidth = dvppImg.width;
+    hostImg.alignHeight = dvppImg.height;
+    hostImg.size = YUV420SP_SIZE(dvppImg.width, dvppImg.height);
+    if ((dvppImg.alignWidth == dvppImg.width) &&
+        (dvppImg.alignHeight == dvppImg.height))
+    {
+        return ACLLITE_OK;
+    }
+    // jpegd pads the rows to 64 or 128 bytes and the height to 16 lines
+    hostImg.data = shared_ptr<uint8_t>(new uint8_t[hostImg.size],
+                                       default_delete<uint8_t[]>());
+    const uint8_t *src = alignImg.data.get();
+    const uint8_t *srcUv = src + dvppImg.alignWidth * dvppImg.alignHeight;
+    uint8_t       *dst = hostImg.data.get();
+    uint8_t       *dstUv = dst + dvppImg.width * dvppImg.height;
+    for (uint32_t r = 0; r < dvppImg.height; r++)
+    {
+        memcpy(dst + r * dvppImg.width,
+               src + r * dvppImg.alignWidth,
+               dvppImg.width);
+    }
+    for (uint32_t r = 0; r < dvppImg.height / 2; r++)
+    {
+        memcpy(dstUv + r * dvppImg.width,
+               srcUv + r * dvppImg.alignWidth,
+               dvppImg.width);
+    }
+    return ACLLITE_OK;
+}
+
+AclLiteError PicDirReader::Read(ImageData &dvppImg, ImageData &hostImg)
+{
+    unique_lock<mutex> lock(mutex_);
+    while (nextRead_ < files_.size())
+    {
+        Slot &slot = slots_[nextRead_ % prefetch_];
+        if (!slot.ready)
+        {
+            AclLiteScopeTimer timer(readWait_);
+            decoded_.wait(lock, [this, &slot] {
+                return stop_ || slot.ready || (failedNum_ == workerNum_);
+            });
+            if (!slot.ready)
+            {
+                return ACLLITE_ERROR_DECODE_FINISH;
+            }
+        }
+        size_t       index = nextRead_++;
+        AclLiteError ret = slot.ret;
+        dvppImg = slot.dvppImg;
+        hostImg = slot.hostImg;
+        slot = Slot();
+        consumed_.notify_all();
+        if (ret == ACLLITE_OK)
+        {
+            return ACLLITE_OK;
+        }
+        lock.unlock();
+        skippedNum_->Add();
+        ACLLITE_LOG_WARNING("Skip picture %s, read or decode failed, error %d",
+                            files_[index].c_str(),
+                            ret);
+        lock.lock();
+    }
+    return ACLLITE_ERROR_DECODE_FINISH;
+}
@@ -0,0 +1,370 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File RawVideoReader.cpp
+* Description: reads uncompressed Y4M or headerless NV12 files through mmap
+*/
+#include "RawVideoReader.h"
+#include "AclLiteMetrics.h"
+#include "AclLiteUtils.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+namespace
+{
+const char    kY4mMagic[] = "YUV4MPEG2 ";
+const char    kY4mFrame[] = "FRAME";
+const size_t  kY4mHeaderMax = 1024; // a longer first line is not Y4M
+const int64_t kUsec = 1000000;
+
+size_t PlanarFrameSize(uint32_t width, uint32_t height)
+{
+    return (size_t)width * height + 2 * (size_t)(width / 2) * (height / 2);
+}
+} // namespace
+
+RawVideoReader::RawVideoReader(const string &path,
+                               uint32_t      width,
+                               uint32_t      height)
+    : path_(path), isY4m_(IsY4mFile(path)), width_(width), height_(height),
+      fileFps_(0), mapSize_(0), frameIndex_(0), readNum_(0), loop_(false),
+      intervalUs_(0),
+      nextDueUs_(0)
+{
+    Open();
+}
+
+RawVideoReader::~RawVideoReader() { Close(); }
+
+bool RawVideoReader::IsY4mFile(const string &path)
+{
+    size_t dot = path.find_last_of('.');
+    if (dot == string::npos)
+    {
+        return false;
+    }
+    string ext = path.substr(dot + 1);
+    return ext == "y4m" || ext == "Y4M";
+}
+
+AclLiteError RawVideoReader::Open()
+{
+    if (IsOpened())
+    {
+        return ACLLITE_OK;
+    }
+    int fd = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        ACLLITE_LOG_ERROR("Open raw video %s failed, errno %d",
+                          path_.c_str(),
+                          errno);
+        return ACLLITE_ERROR_OPEN_FILE;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        ACLLITE_LOG_ERROR("Raw video %s is empty or not accessible",
+                          path_.c_str());
+        close(fd);
+        return ACLLITE_ERROR_ACCESS_FILE;
+    }
+    size_t size = (size_t)st.st_size;
+    void  *addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file
+    if (addr == MAP_FAILED)
+    {
+        ACLLITE_LOG_ERROR("Map raw video %s failed, errno %d",
+                          path_.c_str(),
+                          errno);
+        return ACLLITE_ERROR_OPEN_FILE;
+    }
+    // frames are read front to back, let the kernel read ahead
+    madvise(addr, size, MADV_SEQUENTIAL);
+    mapSize_ = size;
+    mapping_ = shared_ptr<uint8_t>((uint8_t *)addr,
+                                   [size](uint8_t *p) { munmap(p, size); });
+
+    AclLiteError ret = isY4m_ ? ParseY4mHeader() : ACLLITE_OK;
+    if (ret == ACLLITE_OK)
+    {
+        ret = IndexFrames();
+    }
+    if (ret != ACLLITE_OK)
+    {
+        mapping_ = nullptr;
+        frameOffsets_.clear();
+        return ret;
+    }
+    ACLLITE_LOG_INFO("Raw video %s: %s %ux%u, %zu frames",
+                     path_.c_str(),
+                     isY4m_ ? "y4m" : "nv12",
+                     width_,
+                     height_,
+                     frameOffsets_.size());
+    return ACLLITE_OK;
+}
+
+AclLiteError RawVideoReader::ParseY4mHeader()
+{
+    const char *data = (const char *)mapping_.get();
+    size_t      magicLen = sizeof(kY4mMagic) - 1;
+    const char *eol = (const char *)memchr(
+        data, '\n', mapSize_ < kY4mHeaderMax ? mapSize_ : kY4mHeaderMax);
+    if (mapSize_ < magicLen || memcmp(data, kY4mMagic, magicLen) != 0 ||
+        eol == nullptr)
+    {
+        ACLLITE_LOG_ERROR("%s is not a Y4M file", path_.c_str());
+        return ACLLITE_ERROR_INVALID_FILE;
+    }
+    // W<width> H<height> F<num>:<den> I<interlace> A<aspect> C<colorspace>
+    istringstream header(string(data + magicLen, eol));
+    string        token;
+    string        colorspace = "420jpeg"; // default of the format
+    width_ = 0;
+    height_ = 0;
+    while (header >> token)
+    {
+        const char *value = token.c_str() + 1;
+        switch (token[0])
+        {
+        case 'W':
+            width_ = (uint32_t)strtoul(value, nullptr, 10);
+            break;
+        case 'H':
+            height_ = (uint32_t)strtoul(value, nullptr, 10);
+            break;
+        case 'F':
+            {
+                unsigned long num = strtoul(value, nullptr, 10);
+                const char   *colon = strchr(value, ':');
+                unsigned long den =
+                    colon ? strtoul(colon + 1, nullptr, 10) : 1;
+                fileFps_ = den > 0 ? (uint32_t)((num + den / 2) / den) : 0;
+            }
+            break;
+        case 'C':
+            colorspace = value;
+            break;
+        default:
+            break;
+        }
+    }
+    if (colorspace.compare(0, 3, "420") != 0 ||
+        colorspace.find("p1") != string::npos)
+    {
+        ACLLITE_LOG_ERROR("Y4M colorspace %s of %s is not supported, only "
+                          "8 bit 4:2:0",
+                          colorspace.c_str(),
+                          path_.c_str());
+        return ACLLITE_ERROR_INVALID_FILE;
+    }
+    frameOffsets_.clear();
+    frameOffsets_.push_back(eol + 1 - data); // first FRAME marker
+    return ACLLITE_OK;
+}
+
+AclLiteError RawVideoReader::IndexFrames()
+{
+    if (width_ == 0 || height_ == 0 || (width_ % 2) || (height_ % 2))
+    {
+        ACLLITE_LOG_ERROR("Raw video %s needs an even width and height, "
+                          "got %ux%u",
+                          path_.c_str(),
+                          width_,
+                          height_);
+        return ACLLITE_ERROR_INVALID_ARGS;
+    }
+    size_t frameSize = YUV420SP_SIZE((size_t)width_, height_);
+    if (!isY4m_)
+    {
+        frameOffsets_.clear();
+        for (size_t pos = 0; pos + frameSize <= mapSize_; pos += frameSize)
+        {
+            frameOffsets_.push_back(pos);
+        }
+        if (mapSize_ % frameSize != 0)
+        {
+            ACLLITE_LOG_WARNING("Raw video %s size is not a multiple of "
+                                "the %ux%u frame size, tail ignored",
+                                path_.c_str(),
+                                width_,
+                                height_);
+        }
+    }
+    else
+    {
+        // each frame is FRAME[ params]\n followed by the planes; the frame
+        // header may carry parameters, so the offsets are found by a scan
+        frameSize = PlanarFrameSize(width_, height_);
+        size_t      pos = frameOffsets_[0];
+        const char *data = (const char *)mapping_.get();
+        size_t      markLen = sizeof(kY4mFrame) - 1;
+        frameOffsets_.clear();
+        while (pos + markLen <= mapSize_ &&
+               memcmp(data + pos, kY4mFrame, markLen) == 0)
+        {
+            const char *eol =
+                (const char *)memchr(data + pos, '\n', mapSize_ - pos);
+            if (eol == nullptr || eol + 1 - data + frameSize > mapSize_)
+            {
+                ACLLITE_LOG_WARNING("Y4M %s ends with a truncated frame",
+                                    path_.c_str());
+                break;
+            }
+            frameOffsets_.push_back(eol + 1 - data);
+            pos = frameOffsets_.back() + frameSize;
+        }
+    }
+    if (frameOffsets_.empty())
+    {
+        ACLLITE_LOG_ERROR("Raw video %s has no complete frame", path_.c_str());
+        return ACLLITE_ERROR_INVALID_FILE;
+    }
+    return ACLLITE_OK;
+}
+
+AclLiteError RawVideoReader::Set(StreamProperty key, uint32_t value)
+{
+    switch (key)
+    {
+    case TARGET_FPS:
+        intervalUs_ = (value > 0) ? kUsec / value : 0;
+        nextDueUs_ = 0;
+        break;
+    case LOOP_PLAYBACK:
+        loop_ = (value != 0);
+        break;
+    default:
+        ACLLITE_LOG_ERROR("Unsurpport property %d to set for raw video %s",
+                          (int)key,
+                          path_.c_str());
+        return ACLLITE_ERROR_UNSURPPORT_PROPERTY;
+    }
+    return ACLLITE_OK;
+}
+
+uint32_t RawVideoReader::Get(StreamProperty key)
+{
+    switch (key)
+    {
+    case FRAME_WIDTH:
+        return width_;
+    case FRAME_HEIGHT:
+        return height_;
+    case VIDEO_FPS:
+        return fileFps_;
+    default:
+        ACLLITE_LOG_ERROR("Unsurpport property %d to get for raw video", key);
+        return 0;
+    }
+}
+
+void RawVideoReader::WaitFrameDue()
+{
+    if (intervalUs_ <= 0)
+    {
+        return;
+    }
+    int64_t now = AclLiteNowUs();
+    // fixed grid, a reader which fell behind by a whole frame restarts the
+    // grid instead of returning a burst
+    if (nextDueUs_ == 0 || now - nextDueUs_ > intervalUs_)
+    {
+        nextDueUs_ = now;
+    }
+    if (nextDueUs_ > now)
+    {
+        usleep(nextDueUs_ - now);
+    }
+    nextDueUs_ += intervalUs_;
+}
+
+void RawVideoReader::InterleaveChroma(const uint8_t *planar, uint8_t *nv12)
+{
+    size_t         lumaSize = (size_t)width_ * height_;
+    size_t         chromaSize = lumaSize / 4;
+    const uint8_t *u = planar + lumaSize;
+    const uint8_t *v = u + chromaSize;
+    uint8_t       *uv = nv12 + lumaSize;
+    memcpy(nv12, planar, lumaSize);
+    for (size_t i = 0; i < chromaSize; i++)
+    {
+        uv[2 * i] = u[i];
+        uv[2 * i + 1] = v[i];
+    }
+}
+
+AclLiteError RawVideoReader::Read(ImageData &frame)
+{
+    if (!IsOpened())
+    {
+        ACLLITE_LOG_ERROR("Read raw video %s which is not opened",
+                          path_.c_str());
+        return ACLLITE_ERROR_READ_EMPTY;
+    }
+    if (frameIndex_ >= frameOffsets_.size())
+    {
+        if (!loop_)
+        {
+            return ACLLITE_ERROR_DECODE_FINISH;
+        }
+        frameIndex_ = 0;
+    }
+    WaitFrameDue();
+    uint8_t *pixels = mapping_.get() + frameOffsets_[frameIndex_++];
+    frame.format = PIXEL_FORMAT_YUV_SEMIPLANAR_420;
+    frame.width = width_;
+    frame.height = height_;
+    frame.alignWidth = width_;
+    frame.alignHeight = height_;
+    frame.size = YUV420SP_SIZE(width_, height_);
+    if (isY4m_)
+    {
+        uint8_t *nv12 = new uint8_t[frame.size];
+        InterleaveChroma(pixels, nv12);
+        frame.data = shared_ptr<uint8_t>(nv12, default_delete<uint8_t[]>());
+    }
+    else
+    {
+        // shares ownership of the mapping, points into it
+        frame.data = shared_ptr<uint8_t>(mapping_, pixels);
+    }
+    // the Y4M rate gives each frame its place on the file timeline, which
+    // runs on across loops; a headerless file has no timeline
+    frame.ptsUs = (fileFps_ > 0) ? (int64_t)(readNum_ * 1000000 / fileFps_)
+                                 : -1;
+    readNum_++;
+    frame.captureUs = AclLiteNowUs();
+    frame.decodeUs = frame.captureUs;
+    return ACLLITE_OK;
+}
+
+AclLiteError RawVideoReader::Close()
+{
+    // frames still in flight keep the mapping
+    mapping_ = nullptr;
+    frameOffsets_.clear();
+    frameIndex_ = 0;
+    readNum_ = 0;
+    return ACLLITE_OK;
+}
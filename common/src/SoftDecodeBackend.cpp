@@ -0,0 +1,264 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File SoftDecodeBackend.cpp
+* Description: video decode backend on the libavcodec software decoder
+*/
+#include "SoftDecodeBackend.h"
+#include "AclLiteUtils.h"
+
+using namespace std;
+
+namespace
+{
+const int kErrorBufferSize = 1024;
+
+string AvError(int err)
+{
+    char buf[kErrorBufferSize];
+    av_strerror(err, buf, kErrorBufferSize);
+    return string(buf);
+}
+} // namespace
+
+SoftDecodeBackend::SoftDecodeBackend(int                  codecId,
+                                     uint32_t             width,
+                                     uint32_t             height,
+                                     uint32_t             threadNum,
+                                     aclrtRunMode         runMode,
+                                     DecodedFrameCallBack callback,
+                                     void                *userData)
+    : codecId_(codecId), width_(width), height_(height), threadNum_(threadNum),
+      format_(PIXEL_FORMAT_YUV_SEMIPLANAR_420), runMode_(runMode),
+      callback_(callback), userData_(userData), codecCtx_(nullptr),
+      packet_(nullptr), frame_(nullptr), swsCtx_(nullptr)
+{
+}
+
+SoftDecodeBackend::~SoftDecodeBackend()
+{
+    if (swsCtx_ != nullptr)
+    {
+        sws_freeContext(swsCtx_);
+        swsCtx_ = nullptr;
+    }
+    av_frame_free(&frame_);
+    av_packet_free(&packet_);
+    avcodec_free_context(&codecCtx_);
+}
+
+AclLiteError SoftDecodeBackend::Init()
+{
+    const AVCodec *codec = avcodec_find_decoder((AVCodecID)codecId_);
+    if (codec == nullptr)
+    {
+        ACLLITE_LOG_ERROR("No software decoder for codec %d", codecId_);
+        return ACLLITE_ERROR_FFMPEG_DECODER_INIT;
+    }
+    codecCtx_ = avcodec_alloc_context3(codec);
+    packet_ = av_packet_alloc();
+    frame_ = av_frame_alloc();
+    if (codecCtx_ == nullptr || packet_ == nullptr || frame_ == nullptr)
+    {
+        ACLLITE_LOG_ERROR("Alloc software decoder of codec %d failed",
+                          codecId_);
+        return ACLLITE_ERROR_MALLOC;
+    }
+    codecCtx_->width = width_;
+    codecCtx_->height = height_;
+    codecCtx_->thread_count = threadNum_;
+    codecCtx_->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+    int ret = avcodec_open2(codecCtx_, codec, nullptr);
+    if (ret < 0)
+    {
+        ACLLITE_LOG_ERROR("Open software decoder %s failed: %s",
+                          codec->name,
+                          AvError(ret).c_str());
+        return ACLLITE_ERROR_FFMPEG_DECODER_INIT;
+    }
+    ACLLITE_LOG_INFO("Software decoder %s, %ux%u, threads %d",
+                     codec->name,
+                     width_,
+                     height_,
+                     codecCtx_->thread_count);
+    return ACLLITE_OK;
+}
+
+AclLiteError SoftDecodeBackend::SetFormat(uint32_t format)
+{
+    if ((format != PIXEL_FORMAT_YUV_SEMIPLANAR_420) &&
+        (format != PIXEL_FORMAT_YVU_SEMIPLANAR_420))
+    {
+        ACLLITE_LOG_ERROR("Software decode output format %u is not supported, "
+                          "only %d(NV12) and %d(NV21)",
+                          format,
+                          (int)PIXEL_FORMAT_YUV_SEMIPLANAR_420,
+                          (int)PIXEL_FORMAT_YVU_SEMIPLANAR_420);
+        return ACLLITE_ERROR_VDEC_FORMAT_INVALID;
+    }
+    format_ = format;
+    return ACLLITE_OK;
+}
+
+AclLiteError SoftDecodeBackend::Decode(const void *data,
+                                       int         size,
+                                       uint32_t    frameId,
+                                       bool        keep)
+{
+    // not reference counted, libavcodec copies the data it keeps
+    packet_->data = (uint8_t *)data;
+    packet_->size = size;
+    // the pts is carried over to the frame through reordering, the lowest
+    // bit tells whether the frame is kept
+    packet_->pts = ((int64_t)frameId << 1) | (keep ? 1 : 0);
+    packet_->dts = AV_NOPTS_VALUE;
+    AclLiteError ret = SendPacket(packet_);
+    packet_->data = nullptr;
+    packet_->size = 0;
+    if (ret != ACLLITE_OK)
+    {
+        return ret;
+    }
+    return ReceiveFrames();
+}
+
+AclLiteError SoftDecodeBackend::Flush()
+{
+    AclLiteError ret = SendPacket(nullptr);
+    if (ret != ACLLITE_OK)
+    {
+        return ret;
+    }
+    return ReceiveFrames();
+}
+
+AclLiteError SoftDecodeBackend::SendPacket(AVPacket *packet)
+{
+    int ret = avcodec_send_packet(codecCtx_, packet);
+    if (ret == AVERROR(EAGAIN))
+    {
+        // output full, read it and send again
+        AclLiteError recvRet = ReceiveFrames();
+        if (recvRet != ACLLITE_OK)
+        {
+            return recvRet;
+        }
+        ret = avcodec_send_packet(codecCtx_, packet);
+    }
+    if (ret == AVERROR_INVALIDDATA)
+    {
+        // a damaged packet, e.g. lost rtp, the following ones still decode
+        ACLLITE_LOG_WARNING("Software decoder skipped a damaged packet");
+        return ACLLITE_OK;
+    }
+    if (ret < 0 && ret != AVERROR_EOF)
+    {
+        ACLLITE_LOG_ERROR("Send packet to software decoder failed: %s",
+                          AvError(ret).c_str());
+        return ACLLITE_ERROR_VDEC_SEND_FRAME;
+    }
+    return ACLLITE_OK;
+}
+
+AclLiteError SoftDecodeBackend::ReceiveFrames()
+{
+    while (true)
+    {
+        int ret = avcodec_receive_frame(codecCtx_, frame_);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+        {
+            return ACLLITE_OK;
+        }
+        if (ret < 0)
+        {
+            ACLLITE_LOG_ERROR("Receive frame from software decoder failed: %s",
+                              AvError(ret).c_str());
+            return ACLLITE_ERROR_VDEC_SEND_FRAME;
+        }
+        AclLiteError deliverRet = DeliverFrame(frame_);
+        av_frame_unref(frame_);
+        if (deliverRet != ACLLITE_OK)
+        {
+            return deliverRet;
+        }
+    }
+}
+
+AclLiteError SoftDecodeBackend::DeliverFrame(AVFrame *frame)
+{
+    int64_t  pts = (frame->pts != AV_NOPTS_VALUE) ? frame->pts
+                                                  : frame->best_effort_timestamp;
+    uint32_t frameId = (uint32_t)(pts >> 1);
+    if ((pts & 1) == 0)
+    {
+        // not due: skip the conversion and the copy to dvpp
+        callback_(userData_, nullptr, frameId);
+        return ACLLITE_OK;
+    }
+    uint32_t width = frame->width;
+    uint32_t height = frame->height;
+    uint32_t alignWidth = ALIGN_UP16(width);
+    uint32_t alignHeight = ALIGN_UP2(height);
+    uint32_t size = YUV420SP_SIZE(alignWidth, alignHeight);
+    AVPixelFormat dstFormat = (format_ == PIXEL_FORMAT_YVU_SEMIPLANAR_420)
+                                  ? AV_PIX_FMT_NV21
+                                  : AV_PIX_FMT_NV12;
+    // same size, only the pixel format changes; reused while the input
+    // format and size stay the same
+    swsCtx_ = sws_getCachedContext(swsCtx_,
+                                   width,
+                                   height,
+                                   (AVPixelFormat)frame->format,
+                                   width,
+                                   height,
+                                   dstFormat,
+                                   SWS_POINT,
+                                   nullptr,
+                                   nullptr,
+                                   nullptr);
+    if (swsCtx_ == nullptr)
+    {
+        ACLLITE_LOG_ERROR("Convert software decoded format %d to NV12 is "
+                          "not supported",
+                          frame->format);
+        return ACLLITE_ERROR_VDEC_FORMAT_INVALID;
+    }
+    hostBuf_.resize(size);
+    uint8_t *dst[4] = {hostBuf_.data(),
+                       hostBuf_.data() + alignWidth * alignHeight,
+                       nullptr,
+                       nullptr};
+    int      dstStride[4] = {(int)alignWidth, (int)alignWidth, 0, 0};
+    sws_scale(swsCtx_, frame->data, frame->linesize, 0, height, dst, dstStride);
+
+    // vpc reads its input from dvpp memory
+    void *buffer = CopyDataToDevice(hostBuf_.data(), size, runMode_,
+                                    MEMORY_DVPP);
+    if (buffer == nullptr)
+    {
+        ACLLITE_LOG_ERROR("Copy software decoded frame to dvpp failed");
+        return ACLLITE_ERROR_COPY_DATA;
+    }
+    shared_ptr<ImageData> image = make_shared<ImageData>();
+    image->format = (acldvppPixelFormat)format_;
+    image->width = width;
+    image->height = height;
+    image->alignWidth = alignWidth;
+    image->alignHeight = alignHeight;
+    image->size = size;
+    image->data = SHARED_PTR_DVPP_BUF(buffer);
+    callback_(userData_, image, frameId);
+    return ACLLITE_OK;
+}
@@ -0,0 +1,64 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File StreamClock.cpp
+* Description: maps source frame timestamps to the timeline of an output
+*              stream
+*/
+#include "StreamClock.h"
+
+namespace
+{
+const int64_t  kOneSecUs = 1000000;
+const uint32_t kDefaultFps = 25;
+// a longer step is a stall or a pts jump, not the spacing of frames
+const int64_t  kMaxStepUs = 2 * kOneSecUs;
+} // namespace
+
+StreamClock::StreamClock(uint32_t fps)
+    : frameIntervalUs_(kOneSecUs / (fps > 0 ? fps : kDefaultFps)),
+      started_(false), lastFromPts_(false), lastSrcUs_(-1), lastOutUs_(0)
+{
+}
+
+void StreamClock::Reset()
+{
+    started_ = false;
+    lastFromPts_ = false;
+    lastSrcUs_ = -1;
+    lastOutUs_ = 0;
+}
+
+int64_t StreamClock::Map(int64_t ptsUs, int64_t captureUs, bool gap)
+{
+    bool    fromPts = ptsUs >= 0;
+    int64_t srcUs = fromPts ? ptsUs : ((captureUs > 0) ? captureUs : -1);
+    int64_t outUs = started_ ? lastOutUs_ + frameIntervalUs_ : 0;
+    // pts and receive time are different clocks, a switch is not a step
+    if (started_ && !gap && (srcUs >= 0) && (lastSrcUs_ >= 0) &&
+        (fromPts == lastFromPts_))
+    {
+        int64_t stepUs = srcUs - lastSrcUs_;
+        if ((stepUs > 0) && (stepUs <= kMaxStepUs))
+        {
+            outUs = lastOutUs_ + stepUs;
+        }
+    }
+    started_ = true;
+    lastFromPts_ = fromPts;
+    lastSrcUs_ = srcUs;
+    lastOutUs_ = outUs;
+    return outUs;
+}
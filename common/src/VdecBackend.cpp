@@ -0,0 +1,122 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File VdecBackend.cpp
+* Description: video decode backend on the dvpp vdec hardware decoder
+*/
+#include "VdecBackend.h"
+#include "AclLiteUtils.h"
+
+using namespace std;
+
+VdecBackend::VdecBackend(int                  channelId,
+                         uint32_t             width,
+                         uint32_t             height,
+                         int                  streamFormat,
+                         aclrtRunMode         runMode,
+                         DecodedFrameCallBack callback,
+                         void                *userData)
+    : vdec_(channelId, width, height, streamFormat, VdecBackend::VdecCallback),
+      runMode_(runMode), callback_(callback), userData_(userData)
+{
+}
+
+AclLiteError VdecBackend::Init() { return vdec_.Init(); }
+
+AclLiteError VdecBackend::SetFormat(uint32_t format)
+{
+    return vdec_.SetFormat(format);
+}
+
+AclLiteError VdecBackend::Decode(const void *data, int size, uint32_t frameId,
+                                 bool keep)
+{
+    // vdec outputs every picture, the one not kept is released by the
+    // callback before the host copy
+    (void)keep;
+    // vdec reads the stream from dvpp memory, released in the callback
+    void *buffer = CopyDataToDevice(data, size, runMode_, MEMORY_DVPP);
+    if (buffer == nullptr)
+    {
+        ACLLITE_LOG_ERROR("Copy frame h26x data to dvpp failed");
+        return ACLLITE_ERROR_COPY_DATA;
+    }
+    shared_ptr<FrameData> videoFrame = make_shared<FrameData>();
+    videoFrame->frameId = frameId;
+    videoFrame->data = buffer;
+    videoFrame->size = size;
+    AclLiteError ret = vdec_.Process(videoFrame, this);
+    if (ret != ACLLITE_OK)
+    {
+        acldvppFree(buffer);
+    }
+    return ret;
+}
+
+AclLiteError VdecBackend::Flush()
+{
+    shared_ptr<FrameData> videoFrame = make_shared<FrameData>();
+    videoFrame->isFinished = true;
+    videoFrame->data = nullptr;
+    videoFrame->size = 0;
+    return vdec_.Process(videoFrame, this);
+}
+
+// NOTE: 使用DVPP解码后的回调函数
+void VdecBackend::VdecCallback(acldvppStreamDesc *input,
+                               acldvppPicDesc    *output,
+                               void              *userData)
+{
+    VdecBackend *self = (VdecBackend *)userData;
+    // Get decoded image parameters
+    shared_ptr<ImageData> image = make_shared<ImageData>();
+    image->format = acldvppGetPicDescFormat(output);
+    image->width = acldvppGetPicDescWidth(output);
+    image->height = acldvppGetPicDescHeight(output);
+    image->alignWidth = acldvppGetPicDescWidthStride(output);
+    image->alignHeight = acldvppGetPicDescHeightStride(output);
+    image->size = acldvppGetPicDescSize(output);
+
+    void *vdecOutBufferDev = acldvppGetPicDescData(output);
+    image->data = SHARED_PTR_DVPP_BUF(vdecOutBufferDev);
+
+    // the timestamp of the stream desc is the frame id set by VdecHelper
+    uint32_t frameId = 0;
+    if (input != nullptr)
+    {
+        frameId = (uint32_t)acldvppGetStreamDescTimestamp(input);
+    }
+    self->callback_(self->userData_, image, frameId);
+    // Release resouce
+    aclError ret = acldvppDestroyPicDesc(output);
+    if (ret != ACL_SUCCESS)
+    {
+        ACLLITE_LOG_ERROR("fail to destroy pic desc, error %d", ret);
+    }
+
+    if (input != nullptr)
+    {
+        void *inputBuf = acldvppGetStreamDescData(input);
+        if (inputBuf != nullptr)
+        {
+            acldvppFree(inputBuf);
+        }
+        ret = acldvppDestroyStreamDesc(input);
+        if (ret != ACL_SUCCESS)
+        {
+            ACLLITE_LOG_ERROR("fail to destroy input stream desc");
+        }
+    }
+}
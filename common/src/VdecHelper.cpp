@@ -118,6 +118,7 @@ void *VdecHelper::SubscribeReportThreadFunc(void *arg)
 
     // Notice: create context for this thread
     VdecHelper  *vdec = (VdecHelper *)arg;
+    ApplyHelperThreadSched("decode", "vdec_cb" + to_string(vdec->channelId_));
     aclrtContext context = vdec->GetContext();
     aclError     ret = aclrtSetCurrentContext(context);
     if (ret != ACL_SUCCESS)
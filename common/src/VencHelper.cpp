@@ -25,7 +25,7 @@ uint32_t kAsyncWait = 10000;            // 异步等待时间（微秒），影
 
 VencHelper::VencHelper(VencConfig &vencInfo)
         : vencInfo_(vencInfo), status_(STATUS_VENC_INIT), vencProc_(nullptr),
-            frameImageQueue_(kVencQueueSize)
+            frameImageQueue_(kVencQueueSize), lostNum_(nullptr)
 {
         // allocate once; ownership managed in DestroyResource
         vencProc_ = new DvppVenc(vencInfo_);
@@ -54,6 +54,8 @@ AclLiteError VencHelper::Init()
     {
         vencProc_ = new DvppVenc(vencInfo_);
     }
+    lostNum_ = AclLiteMetrics::GetInstance().GetCounter(
+        "venc" + to_string(vencInfo_.channelId) + ".lost_frames");
 
     thread asyncVencTh = thread(VencHelper::AsyncVencThreadEntry, (void *)this);
     asyncVencTh.detach();
@@ -78,6 +80,8 @@ void VencHelper::AsyncVencThreadEntry(void *arg)
     {
         return;
     }
+    ApplyHelperThreadSched(
+        "encode", "venc" + to_string(thisPtr->vencInfo_.channelId));
 
     AclLiteError ret = thisPtr->vencProc_->Init();
     if (ret != ACLLITE_OK)
@@ -117,14 +121,8 @@ AclLiteError VencHelper::Process(ImageData &image)
         ACLLITE_LOG_ERROR("The venc(status %d) is not working", status_);
         return ACLLITE_ERROR_VENC_STATUS;
     }
-    shared_ptr<ImageData> imagePtr = make_shared<ImageData>();
-    imagePtr->format = image.format;
-    imagePtr->width = image.width;
-    imagePtr->height = image.height;
-    imagePtr->alignWidth = image.alignWidth;
-    imagePtr->alignHeight = image.alignHeight;
-    imagePtr->size = image.size;
-    imagePtr->data = image.data;
+    // 连同时间戳一起入队, 编码输出时带回
+    shared_ptr<ImageData> imagePtr = make_shared<ImageData>(image);
 
     for (uint32_t count = 0; count < kImageEnQueueRetryTimes; count++)
     {
@@ -136,6 +134,7 @@ AclLiteError VencHelper::Process(ImageData &image)
     }
     ACLLITE_LOG_ERROR("Venc(%s) lost image for queue full",
                       vencInfo_.outFile.c_str());
+    lostNum_->Add();
 
     return ACLLITE_ERROR_VENC_QUEUE_FULL;
 }
@@ -184,6 +183,9 @@ void DvppVenc::Callback(acldvppPicDesc    *input,
 {
     // 从输出流描述符中获取编码后的数据指针
     void    *data = acldvppGetStreamDescData(output);
+    DvppVenc *venc = (DvppVenc *)userData;
+    // 每个输入帧回调一次, 失败的帧也要取走它的时间戳
+    int64_t  ptsUs = venc->TakeFramePts();
     // 获取编码结果码，0表示成功
     uint32_t retCode = acldvppGetStreamDescRetCode(output);
     if (retCode == 0)
@@ -191,10 +193,8 @@ void DvppVenc::Callback(acldvppPicDesc    *input,
         // 编码成功，处理输出数据
         // 获取编码数据的大小
         uint32_t     size = acldvppGetStreamDescSize(output);
-        // 将userData转换为DvppVenc对象指针
-        DvppVenc    *venc = (DvppVenc *)userData;
         // 调用保存函数，将编码数据保存到文件或通过回调传递
-        AclLiteError ret = venc->SaveVencFile(data, size);
+        AclLiteError ret = venc->SaveVencFile(data, size, ptsUs);
         if (ret != ACLLITE_OK)
         {
             ACLLITE_LOG_ERROR("Save venc file failed, error %d", ret);
@@ -216,7 +216,21 @@ void DvppVenc::Callback(acldvppPicDesc    *input,
     acldvppDestroyPicDesc(input);
 }
 
-AclLiteError DvppVenc::SaveVencFile(void *vencData, uint32_t size)
+int64_t DvppVenc::TakeFramePts()
+{
+    lock_guard<mutex> lock(ptsMutex_);
+    if (ptsQueue_.empty())
+    {
+        return -1;
+    }
+    int64_t ptsUs = ptsQueue_.front();
+    ptsQueue_.pop_front();
+    return ptsUs;
+}
+
+AclLiteError DvppVenc::SaveVencFile(void    *vencData,
+                                    uint32_t size,
+                                    int64_t  ptsUs)
 {
     AclLiteError atlRet = ACLLITE_OK;
     void        *data = vencData;
@@ -229,7 +243,7 @@ AclLiteError DvppVenc::SaveVencFile(void *vencData, uint32_t size)
     // 这里调用的是pictortsp.cpp中在AvInit中定义的g_vencConfig.dataCallback = VencDataCallbackStatic
     if (vencInfo_.dataCallback != nullptr)
     {
-        vencInfo_.dataCallback(data, size, vencInfo_.callbackUserData);
+        vencInfo_.dataCallback(data, size, ptsUs, vencInfo_.callbackUserData);
         
         if (vencInfo_.runMode == ACL_HOST)
         {
@@ -294,6 +308,8 @@ void *DvppVenc::SubscribleThreadFunc(void *arg)
         ACLLITE_LOG_ERROR("DvppVenc instance is nullptr");
         return ((void *)(-1));
     }
+    ApplyHelperThreadSched(
+        "encode", "venc_cb" + to_string(venc->vencInfo_.channelId));
     
     aclrtContext sharedContext = venc->vencInfo_.context;
     if (sharedContext == nullptr)
@@ -455,6 +471,10 @@ AclLiteError DvppVenc::Process(ImageData &image)
 
     // send frame
     acldvppStreamDesc *outputStreamDesc = nullptr;
+    {
+        lock_guard<mutex> lock(ptsMutex_);
+        ptsQueue_.push_back(image.ptsUs);
+    }
 
     ret = aclvencSendFrame(vencChannelDesc_,
                            inputPicDesc_,
@@ -463,6 +483,10 @@ AclLiteError DvppVenc::Process(ImageData &image)
                            (void *)this);
     if (ret != ACL_SUCCESS)
     {
+        {
+            lock_guard<mutex> lock(ptsMutex_);
+            ptsQueue_.pop_back();
+        }
         ACLLITE_LOG_ERROR("send venc frame failed, error %d", ret);
         return ACLLITE_ERROR_VENC_SEND_FRAME;
     }
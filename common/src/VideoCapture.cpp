@@ -32,6 +32,9 @@
  */
 #include "VideoCapture.h"
 #include "AclLiteUtils.h"
+#include "SoftDecodeBackend.h"
+#include "VdecBackend.h"
+#include <atomic>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -39,6 +42,7 @@
 #include <iostream>
 #include <malloc.h>
 #include <memory>
+#include <random>
 #include <sys/prctl.h>
 #include <sys/time.h>
 #include <thread>
@@ -62,8 +66,11 @@ const int      kDefaultFps = 1;
 const int      kReadSlow = 5;
 const uint32_t kVideoChannelMax310 = 32;
 const uint32_t kVideoChannelMax310P = 256;
+const int      kVdecFrameSizeMax = 4096;
 
 ChannelIdGenerator channelIdGenerator[DEVICE_MAX] = {};
+// software decoders take no vdec channel, numbered only for the metrics
+atomic<int>        softDecoderNum(0);
 
 const int      kNoFlag = 0;                      // no flag
 const int      kInvalidVideoIndex = -1;          // invalid video index
@@ -83,6 +90,10 @@ const string   kReorderQueueSizeValue = "0"; // reorder queue size value
 const int      kErrorBufferSize = 1024;      // buffer size for error info
 const uint32_t kDefaultStreamFps = 5;
 const uint32_t kOneSecUs = 1000 * 1000;
+const uint32_t kFrameTagNum = 64;     // more than the packets inside vdec
+const int64_t  kPtsResetUs = 1000000; // pts going back further restarts pacing
+const int64_t  kReconnectWaitMinUs = 200000;     // first reconnect backoff
+const int64_t  kStopCheckUs = 10000;
 } // namespace
 
 FFmpegDecoder::FFmpegDecoder(const std::string &streamName)
@@ -91,6 +102,13 @@ FFmpegDecoder::FFmpegDecoder(const std::string &streamName)
     rtspTransport_.assign(kTcp.c_str());
     isFinished_ = false;
     isStop_ = false;
+    streamChanged_ = false;
+    packetNum_ = 0;
+    frameWidth_ = 0;
+    frameHeight_ = 0;
+    videoType_ = kInvalidTpye;
+    profile_ = FF_PROFILE_UNKNOWN;
+    fps_ = 0;
     GetVideoInfo();
 }
 
@@ -224,43 +242,68 @@ bool FFmpegDecoder::InitVideoParams(int              videoIndex,
     return true;
 }
 
-void FFmpegDecoder::Decode(FrameProcessCallBack callback, void *callbackParam)
+AclLiteError FFmpegDecoder::Decode(FrameProcessCallBack callback,
+                                   void                *callbackParam,
+                                   bool                 waitKeyFrame)
 {
     ACLLITE_LOG_INFO("Start ffmpeg decode video %s ...", streamName_.c_str());
     avformat_network_init(); // init network
+    packetNum_ = 0;
 
     AVFormatContext *avFormatContext = avformat_alloc_context();
+    // a stop request aborts a blocking open or read of a dead rtsp source
+    avFormatContext->interrupt_callback.callback = &FFmpegDecoder::IsInterrupted;
+    avFormatContext->interrupt_callback.opaque = this;
 
     // check open video result
     if (!OpenVideo(avFormatContext))
     {
-        return;
+        return ACLLITE_ERROR_OPEN_VIDEO_UNREADY;
     }
 
     int videoIndex = GetVideoIndex(avFormatContext);
     if (videoIndex == kInvalidVideoIndex)
     { // check video index is valid
         ACLLITE_LOG_ERROR("Rtsp %s index is -1", streamName_.c_str());
-        return;
+        avformat_close_input(&avFormatContext);
+        return ACLLITE_ERROR_OPEN_VIDEO_UNREADY;
     }
+    // the parameters probed when the video was opened are kept, a reconnect
+    // only compares what the stream header tells
+    CheckStreamChanged(avFormatContext->streams[videoIndex]->codecpar);
 
     AVBSFContext *bsfCtx = nullptr;
     // check initialize video parameters result
     if (!InitVideoParams(videoIndex, avFormatContext, bsfCtx))
     {
-        return;
+        av_bsf_free(&bsfCtx);
+        avformat_close_input(&avFormatContext);
+        return ACLLITE_ERROR_OPEN_VIDEO_UNREADY;
     }
 
     ACLLITE_LOG_INFO("Start decode frame of video %s ...", streamName_.c_str());
 
-    AVPacket avPacket;
-    int      processOk = true;
+    AVRational   timeBase = avFormatContext->streams[videoIndex]->time_base;
+    AVRational   usBase = {1, (int)kUsec};
+    AVPacket     avPacket;
+    AclLiteError processRet = ACLLITE_OK;
     // loop to get every frame from video stream
-    while ((av_read_frame(avFormatContext, &avPacket) == 0) && processOk &&
-           !isStop_)
+    while ((av_read_frame(avFormatContext, &avPacket) == 0) &&
+           (processRet == ACLLITE_OK) && !isStop_)
     {
+        // receive time of the frame, the start of its end to end latency
+        int64_t recvUs = AclLiteNowUs();
+        if (waitKeyFrame && (avPacket.stream_index == videoIndex) &&
+            !(avPacket.flags & AV_PKT_FLAG_KEY))
+        {
+            // a reconnected stream may start inside a gop, whose pictures
+            // reference frames the decoder never had
+            av_packet_unref(&avPacket);
+            continue;
+        }
         if (avPacket.stream_index == videoIndex)
         {   // check current stream is video
+            waitKeyFrame = false;
             // send video packet to ffmpeg
             if (av_bsf_send_packet(bsfCtx, &avPacket))
             {
@@ -272,10 +315,20 @@ void FFmpegDecoder::Decode(FrameProcessCallBack callback, void *callbackParam)
             // receive single frame from ffmpeg
             while ((av_bsf_receive_packet(bsfCtx, &avPacket) == 0) && !isStop_)
             {
-                int ret = callback(callbackParam, avPacket.data, avPacket.size);
+                int64_t pts = (avPacket.pts != AV_NOPTS_VALUE) ? avPacket.pts
+                                                               : avPacket.dts;
+                int64_t ptsUs = (pts != AV_NOPTS_VALUE)
+                                    ? av_rescale_q(pts, timeBase, usBase)
+                                    : -1;
+                packetNum_++;
+                int ret = callback(callbackParam,
+                                   avPacket.data,
+                                   avPacket.size,
+                                   ptsUs,
+                                   recvUs);
                 if (ret != 0)
                 {
-                    processOk = false;
+                    processRet = ret;
                     break;
                 }
             }
@@ -288,6 +341,50 @@ void FFmpegDecoder::Decode(FrameProcessCallBack callback, void *callbackParam)
 
     isFinished_ = true;
     ACLLITE_LOG_INFO("Ffmpeg decoder %s finished", streamName_.c_str());
+    return processRet;
+}
+
+int FFmpegDecoder::IsInterrupted(void *decoder)
+{
+    return ((FFmpegDecoder *)decoder)->isStop_ ? 1 : 0;
+}
+
+void FFmpegDecoder::CheckStreamChanged(const AVCodecParameters *codecpar)
+{
+    // rtsp gets the size from the sdp, 0 if it has no sprop parameter sets
+    bool sizeKnown = (codecpar->width > 0) && (codecpar->height > 0);
+    bool profileKnown = (codecpar->profile != FF_PROFILE_UNKNOWN);
+    if ((codecpar->codec_id == videoType_) &&
+        (!sizeKnown || ((codecpar->width == frameWidth_) &&
+                        (codecpar->height == frameHeight_))) &&
+        (!profileKnown || (codecpar->profile == profile_)))
+    {
+        return;
+    }
+    ACLLITE_LOG_WARNING("Video %s changed to type %d, profile %d, %dx%d",
+                        streamName_.c_str(),
+                        codecpar->codec_id,
+                        codecpar->profile,
+                        codecpar->width,
+                        codecpar->height);
+    videoType_ = codecpar->codec_id;
+    if (profileKnown)
+    {
+        profile_ = codecpar->profile;
+    }
+    if (sizeKnown)
+    {
+        frameWidth_ = codecpar->width;
+        frameHeight_ = codecpar->height;
+    }
+    streamChanged_ = true;
+}
+
+bool FFmpegDecoder::TakeStreamChanged()
+{
+    bool changed = streamChanged_;
+    streamChanged_ = false;
+    return changed;
 }
 
 void FFmpegDecoder::GetVideoInfo()
@@ -377,16 +474,25 @@ void FFmpegDecoder::GetVideoInfo()
     return;
 }
 
-VideoCapture::VideoCapture(const std::string &videoName,
-                           int32_t            deviceId,
-                           aclrtContext       context)
+VideoCapture::VideoCapture(const std::string       &videoName,
+                           int32_t                  deviceId,
+                           aclrtContext             context,
+                           const VideoDecodeConfig &decodeConfig)
     : isStop_(false), isReleased_(false), isJam_(false),
       isFrameDecodeEnd_(false), streamType_(STREAM_VIDEO),
       status_(DECODE_UNINIT), deviceId_(deviceId), context_(context),
       channelId_(INVALID_CHANNEL_ID), streamFormat_(H264_MAIN_LEVEL),
       frameId_(0), finFrameCnt_(0), lastDecodeTime_(0), fpsInterval_(0),
-      streamName_(videoName), ffmpegDecoder_(nullptr), dvppVdec_(nullptr),
-      frameImageQueue_(kDecodeFrameQueueSize)
+      streamName_(videoName), ffmpegDecoder_(nullptr),
+      decodeConfig_(decodeConfig), decoder_(nullptr),
+      frameImageQueue_(kDecodeFrameQueueSize), decodedNum_(nullptr),
+      lostNum_(nullptr), paceIntervalUs_(0), nextDuePtsUs_(-1),
+      packetNum_(0), frameTags_(kFrameTagNum), skippedNum_(nullptr), pacedNum_(nullptr),
+      liveMode_(false), supersededNum_(nullptr), frameAge_(nullptr),
+      reconnectMaxWaitUs_((int64_t)decodeConfig.reconnectMaxMs * 1000),
+      reconnecting_(false),
+      gapPending_(false), gapStartUs_(0), frameGapPending_(false),
+      reconnectNum_(nullptr), streamGap_(nullptr)
 {
     if (IsRtspAddr(videoName))
     {
@@ -415,15 +521,15 @@ void VideoCapture::DestroyResource()
         ffmpegDecoder_ = nullptr;
     }
 
-    // 3. release dvpp vdec
-    if (dvppVdec_ != nullptr)
+    // 3. release vdec or software decoder
+    if (decoder_ != nullptr)
     {
         while (!isFrameDecodeEnd_)
         {
             usleep(kWaitDecodeFinishInterval);
         }
-        delete dvppVdec_;
-        dvppVdec_ = nullptr;
+        delete decoder_;
+        decoder_ = nullptr;
     }
     // 4. release image memory in decode output queue
     do
@@ -470,6 +576,97 @@ AclLiteError VideoCapture::InitResource()
     return ACLLITE_OK;
 }
 
+AclLiteError VideoCapture::InitDecoder()
+{
+    uint32_t backend = decodeConfig_.backend;
+    if (backend != DECODE_BACKEND_SOFT)
+    {
+        AclLiteError ret = ACLLITE_ERROR_VDEC_INVALID_PARAM;
+        if (IsVdecSupported())
+        {
+            ret = InitVdecDecoder();
+        }
+        else
+        {
+            ACLLITE_LOG_WARNING("Video %s, profile %d, %dx%d is beyond vdec",
+                                streamName_.c_str(),
+                                ffmpegDecoder_->GetProfile(),
+                                ffmpegDecoder_->GetFrameWidth(),
+                                ffmpegDecoder_->GetFrameHeight());
+        }
+        if (ret == ACLLITE_OK || backend == DECODE_BACKEND_VDEC)
+        {
+            return ret;
+        }
+        // auto: out of vdec channels, or a stream vdec can not decode
+        ACLLITE_LOG_WARNING("Video %s can not use vdec, error %d, decode "
+                            "by software",
+                            streamName_.c_str(),
+                            ret);
+        delete decoder_;
+        decoder_ = nullptr;
+        channelIdGenerator[deviceId_].ReleaseChannelId(channelId_);
+        channelId_ = INVALID_CHANNEL_ID;
+    }
+    return InitSoftDecoder();
+}
+
+bool VideoCapture::IsVdecSupported()
+{
+    // vdec decodes 8 bit 4:2:0 only, h265 main and h264 up to high
+    int profile = ffmpegDecoder_->GetProfile();
+    if (ffmpegDecoder_->GetVideoType() == AV_CODEC_ID_HEVC)
+    {
+        if (profile != FF_PROFILE_HEVC_MAIN && profile != FF_PROFILE_UNKNOWN)
+        {
+            return false;
+        }
+    }
+    else
+    {
+        switch (profile)
+        {
+        case FF_PROFILE_H264_HIGH_10:
+        case FF_PROFILE_H264_HIGH_10_INTRA:
+        case FF_PROFILE_H264_HIGH_422:
+        case FF_PROFILE_H264_HIGH_422_INTRA:
+        case FF_PROFILE_H264_HIGH_444:
+        case FF_PROFILE_H264_HIGH_444_PREDICTIVE:
+        case FF_PROFILE_H264_HIGH_444_INTRA:
+            return false;
+        default:
+            break;
+        }
+    }
+    int width = ffmpegDecoder_->GetFrameWidth();
+    int height = ffmpegDecoder_->GetFrameHeight();
+    if (width > kVdecFrameSizeMax || height > kVdecFrameSizeMax)
+    {
+        return false;
+    }
+    return true;
+}
+
+void VideoCapture::InitMetrics()
+{
+    decodedNum_ = AclLiteMetrics::GetInstance().GetCounter(decoderName_ +
+                                                           ".decoded_frames");
+    lostNum_ = AclLiteMetrics::GetInstance().GetCounter(decoderName_ +
+                                                        ".lost_frames");
+    skippedNum_ = AclLiteMetrics::GetInstance().GetCounter(
+        decoderName_ + ".skipped_packets");
+    pacedNum_ = AclLiteMetrics::GetInstance().GetCounter(decoderName_ +
+                                                         ".paced_frames");
+    supersededNum_ = AclLiteMetrics::GetInstance().GetCounter(
+        decoderName_ + ".superseded_frames");
+    frameAge_ = AclLiteMetrics::GetInstance().GetHistogram(decoderName_ +
+                                                           ".frame_age");
+    reconnectNum_ = AclLiteMetrics::GetInstance().GetCounter(decoderName_ +
+                                                             ".reconnects");
+    streamGap_ = AclLiteMetrics::GetInstance().GetHistogram(decoderName_ +
+                                                            ".stream_gap");
+}
+
 AclLiteError VideoCapture::InitVdecDecoder()
 {
     auto socVersion = aclrtGetSocName();
@@ -486,17 +683,21 @@ AclLiteError VideoCapture::InitVdecDecoder()
     channelId_ = channelIdGenerator[deviceId_].GenerateChannelId();
     if (channelId_ == INVALID_CHANNEL_ID || channelId_ >= videoChannelMax_)
     {
-        ACLLITE_LOG_ERROR("Decoder number excessive %d", VIDEO_CHANNEL_MAX);
+        ACLLITE_LOG_ERROR("Decoder number excessive %d", videoChannelMax_);
         return ACLLITE_ERROR_TOO_MANY_VIDEO_DECODERS;
     }
+    decoderName_ = "vdec" + to_string(channelId_);
+    InitMetrics();
 
     // Create dvpp vdec to decode h26x data
-    dvppVdec_ = new VdecHelper(channelId_,
+    decoder_ = new VdecBackend(channelId_,
                                ffmpegDecoder_->GetFrameWidth(),
                                ffmpegDecoder_->GetFrameHeight(),
                                streamFormat_,
-                               VideoCapture::DvppVdecCallback);
-    AclLiteError ret = dvppVdec_->Init();
+                               runMode_,
+                               VideoCapture::DecodedFrameCallback,
+                               (void *)this);
+    AclLiteError ret = decoder_->Init();
     if (ret != ACLLITE_OK)
     {
         ACLLITE_LOG_ERROR("Dvpp vdec init failed");
@@ -505,6 +706,30 @@ AclLiteError VideoCapture::InitVdecDecoder()
     return ret;
 }
 
+AclLiteError VideoCapture::InitSoftDecoder()
+{
+    decoderName_ = "swdec" + to_string(softDecoderNum++);
+    InitMetrics();
+
+    decoder_ = new SoftDecodeBackend(ffmpegDecoder_->GetVideoType(),
+                                     ffmpegDecoder_->GetFrameWidth(),
+                                     ffmpegDecoder_->GetFrameHeight(),
+                                     decodeConfig_.softThreads,
+                                     runMode_,
+                                     VideoCapture::DecodedFrameCallback,
+                                     (void *)this);
+    AclLiteError ret = decoder_->Init();
+    if (ret != ACLLITE_OK)
+    {
+        ACLLITE_LOG_ERROR("Software decoder init failed");
+        return ret;
+    }
+    ACLLITE_LOG_INFO("Video %s decoded by software as %s",
+                     streamName_.c_str(),
+                     decoderName_.c_str());
+    return ACLLITE_OK;
+}
+
 AclLiteError VideoCapture::InitFFmpegDecoder()
 {
     // Create ffmpeg decoder to parse video stream to h26x frame data
@@ -563,13 +788,14 @@ AclLiteError VideoCapture::Open()
                           ret);
         return ret;
     }
-    // Init dvpp vdec decoder
-    ret = InitVdecDecoder();
+    // Init dvpp vdec or software decoder
+    ret = InitDecoder();
     if (ret != ACLLITE_OK)
     {
         this->SetStatus(DECODE_ERROR);
-        ACLLITE_LOG_ERROR(
-            "Open %s failed for init vdec error: %d", streamName_.c_str(), ret);
+        ACLLITE_LOG_ERROR("Open %s failed for init decoder error: %d",
+                          streamName_.c_str(),
+                          ret);
         return ret;
     }
     // Set init ok
@@ -626,58 +852,48 @@ int VideoCapture::GetVdecType()
     return streamFormat_;
 }
 
-// dvpp vdec callback
-// NOTE: 使用DVPP解码后的回调函数
-void VideoCapture::DvppVdecCallback(acldvppStreamDesc *input,
-                                    acldvppPicDesc    *output,
-                                    void              *userData)
+// frames of the vdec or software decoder
+void VideoCapture::DecodedFrameCallback(void                 *userData,
+                                        shared_ptr<ImageData> frame,
+                                        uint32_t              frameId)
 {
     VideoCapture *decoder = (VideoCapture *)userData;
     if (decoder->GetEnd())
     {
         return;
     }
-    // Get decoded image parameters
-    shared_ptr<ImageData> image = make_shared<ImageData>();
-    image->format = acldvppGetPicDescFormat(output);
-    image->width = acldvppGetPicDescWidth(output);
-    image->height = acldvppGetPicDescHeight(output);
-    image->alignWidth = acldvppGetPicDescWidthStride(output);
-    image->alignHeight = acldvppGetPicDescHeightStride(output);
-    image->size = acldvppGetPicDescSize(output);
-    
-    void *vdecOutBufferDev = acldvppGetPicDescData(output);
-    image->data = SHARED_PTR_DVPP_BUF(vdecOutBufferDev);
-
-    // Put the decoded image to queue for read
-    decoder->ProcessDecodedImage(image);
-    // Release resouce
-    aclError ret = acldvppDestroyPicDesc(output);
-    if (ret != ACL_SUCCESS)
+    FrameTag tag;
+    if (!decoder->TakeFrameTag(frameId, &tag))
     {
-        ACLLITE_LOG_ERROR("fail to destroy pic desc, error %d", ret);
+        // an overwritten slot means the frame is unknown, keep it; the
+        // decoder output time stands in for the receive time
+        tag = FrameTag();
+        tag.captureUs = AclLiteNowUs();
     }
-
-    if (input != nullptr)
+    if (tag.gap)
     {
-        void *inputBuf = acldvppGetStreamDescData(input);
-        if (inputBuf != nullptr)
-        {
-            acldvppFree(inputBuf);
-        }
-        aclError ret = acldvppDestroyStreamDesc(input);
-        if (ret != ACL_SUCCESS)
-        {
-            ACLLITE_LOG_ERROR("fail to destroy input stream desc");
-        }
+        // marks the next frame read, even if this one is paced out
+        decoder->frameGapPending_ = true;
     }
+    if (frame == nullptr)
+    {
+        // the backend dropped a frame which is not due before producing it
+        decoder->ProcessDecodedImage(nullptr, false);
+        return;
+    }
+    frame->ptsUs = tag.ptsUs;
+    frame->captureUs = tag.captureUs;
+    // Put the decoded image to queue for read
+    decoder->ProcessDecodedImage(frame, tag.keep);
 }
 
-void VideoCapture::ProcessDecodedImage(shared_ptr<ImageData> frameData)
+void VideoCapture::ProcessDecodedImage(shared_ptr<ImageData> frameData,
+                                       bool                  keep)
 {
     finFrameCnt_++;
-    if (YUV420SP_SIZE(frameData->width, frameData->height) !=
-        frameData->size)
+    if (frameData != nullptr &&
+        YUV420SP_SIZE(frameData->width, frameData->height) !=
+            frameData->size)
     {
         ACLLITE_LOG_ERROR("Invalid decoded frame parameter, "
                           "width %d, height %d, size %d, buffer %p",
@@ -688,7 +904,17 @@ void VideoCapture::ProcessDecodedImage(shared_ptr<ImageData> frameData)
         return;
     }
 
-    FrameImageEnQueue(frameData);
+    if (keep)
+    {
+        frameData->streamGap = frameGapPending_;
+        frameGapPending_ = false;
+        FrameImageEnQueue(frameData);
+    }
+    else if (pacedNum_ != nullptr)
+    {
+        // a reference picture which is not due, released before host copy
+        pacedNum_->Add();
+    }
 
     if ((status_ == DECODE_FFMPEG_FINISHED) && (finFrameCnt_ >= frameId_))
     {
@@ -700,14 +926,40 @@ void VideoCapture::ProcessDecodedImage(shared_ptr<ImageData> frameData)
 
 AclLiteError VideoCapture::FrameImageEnQueue(shared_ptr<ImageData> frameData)
 {
+    frameData->decodeUs = AclLiteNowUs();
+    if (liveMode_)
+    {
+        // the vdec callback is the only producer, after the unread frames
+        // are dropped the push can not fail
+        shared_ptr<ImageData> unread;
+        while ((unread = frameImageQueue_.Pop()) != nullptr)
+        {
+            // the newest frame takes over the gap mark of a replaced one
+            frameData->streamGap = frameData->streamGap || unread->streamGap;
+            if (supersededNum_ != nullptr)
+            {
+                supersededNum_->Add();
+            }
+        }
+    }
     for (int count = 0; count < kFrameEnQueueRetryTimes; count++)
     {
         if (frameImageQueue_.Push(frameData))
+        {
+            if (decodedNum_ != nullptr)
+            {
+                decodedNum_->Add();
+            }
             return ACLLITE_OK;
+        }
         usleep(kDecodeQueueOpWait);
     }
     ACLLITE_LOG_ERROR("Video %s lost decoded image for queue full",
                       streamName_.c_str());
+    if (lostNum_ != nullptr)
+    {
+        lostNum_->Add();
+    }
 
     return ACLLITE_ERROR_VDEC_QUEUE_FULL;
 }
@@ -727,6 +979,10 @@ void VideoCapture::StartFrameDecoder()
 void VideoCapture::FrameDecodeThreadFunction(void *decoderSelf)
 {
     VideoCapture *thisPtr = (VideoCapture *)decoderSelf;
+    string threadName = (thisPtr->channelId_ != INVALID_CHANNEL_ID)
+                            ? "ffdemux" + to_string(thisPtr->channelId_)
+                            : "ffdemux-" + thisPtr->decoderName_;
+    ApplyHelperThreadSched("decode", threadName);
 
     aclError aclRet = thisPtr->SetAclContext();
     if (aclRet != ACL_SUCCESS)
@@ -737,19 +993,21 @@ void VideoCapture::FrameDecodeThreadFunction(void *decoderSelf)
     }
     // start decode until complete
     thisPtr->FFmpegDecode();
-    if (thisPtr->IsStop())
+    if (thisPtr->IsStop() || (thisPtr->decoder_ == nullptr))
     {
+        // no decoder left when recreating it for a changed stream failed
         thisPtr->SetEnd();
         thisPtr->SetStatus(DECODE_FINISHED);
         return;
     }
     thisPtr->SetStatus(DECODE_FFMPEG_FINISHED);
-    // when ffmpeg decode finish, send eos to vdec
-    shared_ptr<FrameData> videoFrame = make_shared<FrameData>();
-    videoFrame->isFinished = true;
-    videoFrame->data = nullptr;
-    videoFrame->size = 0;
-    thisPtr->dvppVdec_->Process(videoFrame, decoderSelf);
+    // when ffmpeg decode finish, send eos to the decoder
+    thisPtr->decoder_->Flush();
+    if (!thisPtr->decoder_->IsAsync())
+    {
+        // frames not counted in finFrameCnt_ (damaged packets) never come
+        thisPtr->SetStatus(DECODE_DVPP_FINISHED);
+    }
     while ((thisPtr->GetStatus() != DECODE_DVPP_FINISHED))
     {
         usleep(kWaitDecodeFinishInterval);
@@ -759,8 +1017,11 @@ void VideoCapture::FrameDecodeThreadFunction(void *decoderSelf)
 
 // callback of ffmpeg decode frame
 // FFMPEG获取视频帧后，调用的回调函数，用来传递数据包给硬件解码
-AclLiteError
-VideoCapture::FrameDecodeCallback(void *decoder, void *frameData, int frameSize)
+AclLiteError VideoCapture::FrameDecodeCallback(void   *decoder,
+                                               void   *frameData,
+                                               int     frameSize,
+                                               int64_t ptsUs,
+                                               int64_t recvUs)
 {
     if ((frameData == NULL) || (frameSize == 0))
     {
@@ -768,27 +1029,47 @@ VideoCapture::FrameDecodeCallback(void *decoder, void *frameData, int frameSize)
         return ACLLITE_ERROR_H26X_FRAME;
     }
 
-    // copy data to dvpp memory
     VideoCapture *videoDecoder = (VideoCapture *)decoder;
-
-    void *buffer = CopyDataToDevice(
-        frameData, frameSize, videoDecoder->runMode_, MEMORY_DVPP);
-    if (buffer == nullptr)
+    bool          gap = videoDecoder->gapPending_;
+    if (gap)
+    {
+        // first packet after a reconnect, a key frame
+        AclLiteError ret = videoDecoder->OnReconnected();
+        if (ret != ACLLITE_OK)
+        {
+            return ret;
+        }
+    }
+    // a packet which is not due is dropped here if nothing references it,
+    // otherwise it is decoded and the picture released in the vdec callback.
+    // The filter sees every packet so it follows the SPS of the stream
+    bool disposable = videoDecoder->disposableFilter_.IsDisposable(
+        (const uint8_t *)frameData,
+        frameSize,
+        videoDecoder->ffmpegDecoder_->GetVideoType());
+    bool keep = videoDecoder->PaceFrame(ptsUs);
+    if (!keep && disposable)
     {
-        ACLLITE_LOG_ERROR("Copy frame h26x data to dvpp failed");
-        return ACLLITE_ERROR_COPY_DATA;
+        videoDecoder->skippedNum_->Add();
+        videoDecoder->SleeptoNextFrameTime();
+        return ACLLITE_OK;
     }
 
-    shared_ptr<FrameData> videoFrame = make_shared<FrameData>();
     videoDecoder->frameId_++;
-    videoFrame->frameId = videoDecoder->frameId_;
-    videoFrame->data = buffer;
-    videoFrame->size = frameSize;
-    // decode data by dvpp vdec
-    AclLiteError ret = videoDecoder->dvppVdec_->Process(videoFrame, decoder);
+    FrameTag tag;
+    tag.frameId = videoDecoder->frameId_;
+    tag.keep = keep;
+    tag.gap = gap;
+    tag.ptsUs = ptsUs;
+    tag.captureUs = recvUs;
+    videoDecoder->TagFrame(tag);
+    // decode data by dvpp vdec or software
+    AclLiteError ret = videoDecoder->decoder_->Decode(
+        frameData, frameSize, videoDecoder->frameId_, keep);
     if (ret != ACLLITE_OK)
     {
-        ACLLITE_LOG_ERROR("Dvpp vdec process %dth frame failed, error:%d",
+        ACLLITE_LOG_ERROR("%s decode %dth frame failed, error:%d",
+                          videoDecoder->decoder_->Name(),
                           videoDecoder->frameId_,
                           ret);
         return ret;
@@ -799,6 +1080,158 @@ VideoCapture::FrameDecodeCallback(void *decoder, void *frameData, int frameSize)
     return ACLLITE_OK;
 }
 
+bool VideoCapture::PaceFrame(int64_t ptsUs)
+{
+    int64_t packetIndex = packetNum_++;
+    if (paceIntervalUs_ <= 0)
+    {
+        return true;
+    }
+    if (ptsUs < 0)
+    {
+        // no pts in the stream, assume a constant frame rate
+        ptsUs = packetIndex * fpsInterval_;
+    }
+    if (nextDuePtsUs_ < 0 || ptsUs < nextDuePtsUs_ - kPtsResetUs ||
+        ptsUs >= nextDuePtsUs_ + paceIntervalUs_)
+    {
+        // first packet, pts reset, or a gap: restart the grid from here
+        nextDuePtsUs_ = ptsUs + paceIntervalUs_;
+        return true;
+    }
+    if (ptsUs < nextDuePtsUs_)
+    {
+        return false;
+    }
+    nextDuePtsUs_ += paceIntervalUs_;
+    return true;
+}
+
+void VideoCapture::TagFrame(const FrameTag &tag)
+{
+    lock_guard<mutex> lock(frameTagMutex_);
+    frameTags_[tag.frameId % kFrameTagNum] = tag;
+}
+
+bool VideoCapture::TakeFrameTag(uint32_t frameId, FrameTag *tag)
+{
+    lock_guard<mutex> lock(frameTagMutex_);
+    const FrameTag &slot = frameTags_[frameId % kFrameTagNum];
+    if (slot.frameId != frameId)
+    {
+        return false;
+    }
+    *tag = slot;
+    return true;
+}
+
+void VideoCapture::FFmpegDecode()
+{
+    AclLiteError ret = ffmpegDecoder_->Decode(
+        &VideoCapture::FrameDecodeCallback, (void *)this);
+    uint32_t attempt = 0;
+    // a file ends, a live rtsp source only drops; a decoder error is not
+    // cured by reconnecting
+    while ((streamType_ == STREAM_RTSP) && (reconnectMaxWaitUs_ > 0) &&
+           !isStop_ &&
+           ((ret == ACLLITE_OK) || (ret == ACLLITE_ERROR_OPEN_VIDEO_UNREADY)))
+    {
+        if (ffmpegDecoder_->GetPacketNum() > 0)
+        {
+            // the session had data: the gap starts here, backoff starts over
+            attempt = 0;
+            gapStartUs_ = AclLiteNowUs();
+        }
+        // also when the first open failed, so Read waits for the retries
+        reconnecting_ = true;
+        int64_t waitUs = ReconnectWaitUs(attempt++);
+        ACLLITE_LOG_WARNING("Stream %s lost, reconnect attempt %u in %ld ms",
+                            streamName_.c_str(),
+                            attempt,
+                            (long)(waitUs / 1000));
+        if (!WaitUnlessStop(waitUs))
+        {
+            break;
+        }
+        gapPending_ = true;
+        ret = ffmpegDecoder_->Decode(
+            &VideoCapture::FrameDecodeCallback, (void *)this, true);
+    }
+    reconnecting_ = false;
+}
+
+int64_t VideoCapture::ReconnectWaitUs(uint32_t attempt)
+{
+    // doubles from kReconnectWaitMinUs up to the cap, the upper half is
+    // random so cameras which dropped together do not retry in lockstep
+    int64_t waitUs = kReconnectWaitMinUs;
+    for (uint32_t i = 0; (i < attempt) && (waitUs < reconnectMaxWaitUs_); i++)
+    {
+        waitUs *= 2;
+    }
+    waitUs = min(waitUs, reconnectMaxWaitUs_);
+    static thread_local mt19937 rng(random_device{}());
+    return waitUs / 2 + uniform_int_distribution<int64_t>(0, waitUs / 2)(rng);
+}
+
+bool VideoCapture::WaitUnlessStop(int64_t waitUs)
+{
+    int64_t deadline = AclLiteNowUs() + waitUs;
+    while (!isStop_ && (AclLiteNowUs() < deadline))
+    {
+        usleep(kStopCheckUs);
+    }
+    return !isStop_;
+}
+
+AclLiteError VideoCapture::OnReconnected()
+{
+    gapPending_ = false;
+    reconnecting_ = false;
+    reconnectNum_->Add();
+    if (gapStartUs_ > 0)
+    {
+        streamGap_->Record(AclLiteNowUs() - gapStartUs_);
+    }
+    ACLLITE_LOG_INFO("Stream %s reconnected", streamName_.c_str());
+    if (!ffmpegDecoder_->TakeStreamChanged())
+    {
+        // same codec and size, the decoder and its buffers are kept
+        return ACLLITE_OK;
+    }
+    return ResetDecoder();
+}
+
+AclLiteError VideoCapture::ResetDecoder()
+{
+    ACLLITE_LOG_WARNING("Stream %s changed, recreate %s decoder",
+                        streamName_.c_str(),
+                        decoderName_.c_str());
+    // the frames still inside come out before the eos, and vdec returns
+    // from destroying the channel after its last callback
+    decoder_->Flush();
+    delete decoder_;
+    decoder_ = nullptr;
+    finFrameCnt_ = frameId_;
+    channelIdGenerator[deviceId_].ReleaseChannelId(channelId_);
+    channelId_ = INVALID_CHANNEL_ID;
+    if (GetVdecType() == kInvalidTpye)
+    {
+        return ACLLITE_ERROR_FFMPEG_DECODER_INIT;
+    }
+    AclLiteError ret = InitDecoder();
+    if (ret != ACLLITE_OK)
+    {
+        // the decode thread ends the stream when no decoder is left, it must
+        // not flush one which failed to initialize
+        delete decoder_;
+        decoder_ = nullptr;
+        channelIdGenerator[deviceId_].ReleaseChannelId(channelId_);
+        channelId_ = INVALID_CHANNEL_ID;
+    }
+    return ret;
+}
+
 void VideoCapture::SleeptoNextFrameTime()
 {
     while (frameImageQueue_.Size() > kReadSlow)
@@ -881,6 +1314,11 @@ AclLiteError VideoCapture::Read(ImageData &image)
     // read frame from decode queue
     bool                  noWait = (status_ == DECODE_DVPP_FINISHED);
     shared_ptr<ImageData> frame = FrameImageOutQueue(noWait);
+    // a dropped rtsp input is being reconnected, no frame is not an error
+    while ((frame == nullptr) && !noWait && reconnecting_ && !isStop_)
+    {
+        frame = FrameImageOutQueue(false);
+    }
     if (noWait && (frame == nullptr))
     {
         while (!isFrameDecodeEnd_)
@@ -905,6 +1343,14 @@ AclLiteError VideoCapture::Read(ImageData &image)
     image.alignHeight = frame->alignHeight;
     image.size = frame->size;
     image.data = frame->data;
+    image.ptsUs = frame->ptsUs;
+    image.captureUs = frame->captureUs;
+    image.decodeUs = frame->decodeUs;
+    image.streamGap = frame->streamGap;
+    if (frameAge_ != nullptr)
+    {
+        frameAge_->Record(AclLiteNowUs() - frame->decodeUs);
+    }
 
     return ACLLITE_OK;
 }
@@ -928,17 +1374,30 @@ shared_ptr<ImageData> VideoCapture::FrameImageOutQueue(bool noWait)
     return nullptr;
 }
 
-AclLiteError VideoCapture::Set(StreamProperty key, int value)
+AclLiteError VideoCapture::Set(StreamProperty key, uint32_t value)
 {
     AclLiteError ret = ACLLITE_OK;
     switch (key)
     {
     case OUTPUT_IMAGE_FORMAT:
-        ret = dvppVdec_->SetFormat(value);
+        ret = decoder_->SetFormat(value);
         break;
     case RTSP_TRANSPORT:
         ret = SetRtspTransType(value);
         break;
+    case TARGET_FPS:
+        paceIntervalUs_ = (value > 0) ? (int64_t)kUsec / value : 0;
+        nextDuePtsUs_ = -1;
+        break;
+    case LATENCY_MODE:
+        if (value != LATENCY_MODE_ACCURATE && value != LATENCY_MODE_LIVE)
+        {
+            ret = ACLLITE_ERROR_INVALID_PROPERTY_VALUE;
+            ACLLITE_LOG_ERROR("Unsurport latency mode %u", value);
+            break;
+        }
+        liveMode_ = (value == LATENCY_MODE_LIVE);
+        break;
     default:
         ret = ACLLITE_ERROR_UNSURPPORT_PROPERTY;
         ACLLITE_LOG_ERROR("Unsurpport property %d to set for video %s",
@@ -0,0 +1,187 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File BgrFrameView.h
+* Description: BGR view of a host NV12 frame, converted on demand
+*/
+#ifndef BGR_FRAME_VIEW_H
+#define BGR_FRAME_VIEW_H
+#pragma once
+
+#include "AclLiteType.h"
+#include "opencv2/opencv.hpp"
+#include "opencv2/imgproc/types_c.h"
+#include <algorithm>
+#include <cstring>
+
+// 读帧时只保留 host 上的 NV12, 不再整帧转换 BGR. 需要 BGR 的消费者按需取:
+// Full 转换整帧(视频/图片输出), Roi 只转换给定区域(跟踪搜索窗口).
+// 最近一次转换的区域会缓存, 同一帧内落在其中的区域不再重复转换.
+// 只在持有消息的单个线程中使用, 不加锁
+class BgrFrameView
+{
+  public:
+    BgrFrameView() {}
+    // nv12: host 内存, 每行 alignWidth 字节, UV 平面从第 alignHeight 行开始;
+    // 二者为 0 时分别按 width / height
+    explicit BgrFrameView(const ImageData &nv12) : nv12_(nv12) {}
+    // 已转换好的 BGR 图像
+    explicit BgrFrameView(const cv::Mat &bgr) : full_(bgr) {}
+
+    bool Empty() const { return full_.empty() && nv12_.data == nullptr; }
+    // host 上的 NV12, 由 BGR 图像构造时 data 为空
+    const ImageData &Nv12() const { return nv12_; }
+    int  Width() const
+    {
+        return full_.empty() ? (int)nv12_.width : full_.cols;
+    }
+    int  Height() const
+    {
+        return full_.empty() ? (int)nv12_.height : full_.rows;
+    }
+
+    // 整帧 BGR, 首次调用时转换
+    const cv::Mat &Full()
+    {
+        if (full_.empty() && nv12_.data != nullptr)
+        {
+            if ((Stride() == (int)nv12_.width) &&
+                (PlaneRows() == (int)nv12_.height))
+            {
+                cv::cvtColor(cv::Mat((int)nv12_.height * 3 / 2,
+                                     (int)nv12_.width,
+                                     CV_8UC1,
+                                     nv12_.data.get()),
+                             full_,
+                             CV_YUV2BGR_NV12);
+            }
+            else
+            {
+                // 解码输出带行对齐, 先拷成紧凑的 NV12 再转换
+                cv::Mat packed;
+                PackNv12(0, 0, (int)nv12_.width, (int)nv12_.height, &packed);
+                cv::cvtColor(packed, full_, CV_YUV2BGR_NV12);
+            }
+            roi_ = cv::Mat();
+        }
+        return full_;
+    }
+
+    // rect 与图像相交部分的 BGR, 不相交时返回空. 返回值与缓存共享数据,
+    // 之后再转换其他区域不会改写已返回的图像
+    cv::Mat Roi(const cv::Rect &rect)
+    {
+        cv::Rect area = rect & cv::Rect(0, 0, Width(), Height());
+        if (area.area() <= 0)
+        {
+            return cv::Mat();
+        }
+        if (!full_.empty())
+        {
+            return full_(area);
+        }
+        if ((area & roiRect_) != area || roi_.empty())
+        {
+            ConvertRoi(area);
+        }
+        return roi_(cv::Rect(area.x - roiRect_.x,
+                             area.y - roiRect_.y,
+                             area.width,
+                             area.height));
+    }
+
+    // 整帧 BGR 均值. 未转换时由 NV12 的 Y/UV 均值换算, 与逐像素转换后求均值
+    // 仅在饱和截断处有差别
+    cv::Scalar Mean()
+    {
+        if (!full_.empty() || nv12_.data == nullptr)
+        {
+            return cv::mean(full_);
+        }
+        int        w = (int)nv12_.width;
+        int        h = (int)nv12_.height;
+        size_t     stride = (size_t)Stride();
+        uint8_t   *base = nv12_.data.get();
+        cv::Scalar y = cv::mean(cv::Mat(h, w, CV_8UC1, base, stride));
+        cv::Scalar uv = cv::mean(cv::Mat(h / 2, w / 2, CV_8UC2,
+                                         base + stride * PlaneRows(), stride));
+        // 2x2 的 NV12 图像, 像素取均值, 转换后即为均值的 BGR
+        uint8_t pixel[6] = {(uint8_t)cvRound(y[0]),
+                            (uint8_t)cvRound(y[0]),
+                            (uint8_t)cvRound(y[0]),
+                            (uint8_t)cvRound(y[0]),
+                            (uint8_t)cvRound(uv[0]),
+                            (uint8_t)cvRound(uv[1])};
+        cv::Mat bgr;
+        cv::cvtColor(cv::Mat(3, 2, CV_8UC1, pixel), bgr, CV_YUV2BGR_NV12);
+        cv::Vec3b mean = bgr.at<cv::Vec3b>(0, 0);
+        return cv::Scalar(mean[0], mean[1], mean[2]);
+    }
+
+  private:
+    // 每行字节数与 Y 平面的行数(UV 平面的起点)
+    int Stride() const
+    {
+        return nv12_.alignWidth > 0 ? (int)nv12_.alignWidth : (int)nv12_.width;
+    }
+    int PlaneRows() const
+    {
+        return nv12_.alignHeight > 0 ? (int)nv12_.alignHeight
+                                     : (int)nv12_.height;
+    }
+
+    // 拷出 (x0, y0) 起 w x h 区域的 Y 与 UV, 拼成一幅紧凑的 NV12 图像
+    void PackNv12(int x0, int y0, int w, int h, cv::Mat *dst) const
+    {
+        dst->create(h * 3 / 2, w, CV_8UC1);
+        int      stride = Stride();
+        uint8_t *yPlane = nv12_.data.get();
+        uint8_t *uvPlane = yPlane + stride * PlaneRows();
+        for (int r = 0; r < h; r++)
+        {
+            memcpy(dst->ptr<uint8_t>(r), yPlane + (y0 + r) * stride + x0, w);
+        }
+        for (int r = 0; r < h / 2; r++)
+        {
+            memcpy(dst->ptr<uint8_t>(h + r),
+                   uvPlane + (y0 / 2 + r) * stride + x0,
+                   w);
+        }
+    }
+
+    void ConvertRoi(const cv::Rect &area)
+    {
+        // NV12 的色度按 2x2 采样, 区域对齐到偶数坐标
+        int x0 = area.x & ~1;
+        int y0 = area.y & ~1;
+        int x1 = std::min((area.x + area.width + 1) & ~1, (int)nv12_.width);
+        int y1 = std::min((area.y + area.height + 1) & ~1, (int)nv12_.height);
+        int w = x1 - x0;
+        int h = y1 - y0;
+        PackNv12(x0, y0, w, h, &roiNv12_);
+        roi_ = cv::Mat(); // 不复用缓冲, 之前返回的区域仍然有效
+        cv::cvtColor(roiNv12_, roi_, CV_YUV2BGR_NV12);
+        roiRect_ = cv::Rect(x0, y0, w, h);
+    }
+
+  private:
+    ImageData nv12_;
+    cv::Mat   full_;
+    cv::Rect  roiRect_;  // 已转换区域在整帧中的位置
+    cv::Mat   roi_;      // 已转换区域的 BGR
+    cv::Mat   roiNv12_;  // 区域 NV12 的中转缓冲
+};
+
+#endif
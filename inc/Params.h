@@ -22,8 +22,10 @@
 
 #include "AclLiteImageProc.h"
 #include "AclLiteModel.h"
+#include "AclLiteTrace.h"
 #include "AclLiteType.h"
 #include "AclLiteThread.h"
+#include "BgrFrameView.h"
 // Lightweight detection box for cross-thread messaging
 struct DetectionOBB {
     float x0;
@@ -46,6 +48,7 @@ struct TrackInfo {
 #include "opencv2/imgproc/types_c.h"
 #include "opencv2/opencv.hpp"
 #include "X11/Xlib.h"
+#include <atomic>
 #include <iostream>
 #include <memory>
 #include <mutex>
@@ -97,9 +100,12 @@ struct DetectDataMsg
                         // has been decoded
     int msgNum;         // record frameID in rtsp/video of this channel
     int64_t startTimestamp;  // timestamp when frame processing starts (microseconds)
+    // 首帧的源时间, 每帧各自的时间在 decodedImg[i] 中
+    int64_t ptsUs = -1;      // 源码流 pts(微秒), 无 pts 的输入为 -1
+    int64_t captureUs = 0;   // 输入收到该帧的时间(AclLiteNowUs), 采集到显示时延的起点
     std::vector<ImageData> decodedImg;    // original image (NV12)
     ImageData              modelInputImg; // image after detect preprocess
-    std::vector<cv::Mat>   frame; // original image (BGR) needed by postprocess
+    std::vector<BgrFrameView> frame; // original image, BGR converted on demand
     std::vector<InferenceOutput> inferenceOutput; // yolo detect output
     bool                         hasDetectOutputDims = false;
     aclmdlIODims                 detectOutputDims = {};
@@ -131,6 +137,118 @@ struct DetectDataMsg
     // ============ 跳帧复用 ============
     bool   decimatedFrame = false;         // 是否为跳帧(仅做轻量处理)
     bool   reusePrevResult = false;        // 是否复用上一帧的检测/跟踪结果
+    bool   streamGap = false;              // 输入断流重连后的第一帧, 跟踪据此复位
+    // ============ 通道代数 ============
+    uint32_t epoch = 0;                                  // 读帧时的通道代数
+    std::shared_ptr<std::atomic<uint32_t>> channelEpoch; // 通道当前代数, 跟踪丢失时递增
+    // ============ 帧追踪 ============
+    AclLiteFrameTrace trace; // 被采样的帧记录各阶段起止时间, 回收时写出
+
+    // 读帧之后通道代数已变化(跟踪丢失转入重新检测), 各阶段跳过耗时处理,
+    // 仅把帧透传到下游以保持输出顺序. 代数只增不减, 过期后一直过期
+    bool IsStale() const
+    {
+        return channelEpoch != nullptr &&
+               epoch != channelEpoch->load(std::memory_order_relaxed);
+    }
+
+    // 复位为值初始化状态, 保留各 vector 的容量, 供对象池回收复用
+    void Reset()
+    {
+        std::vector<ImageData>       decodedImgBuf;
+        std::vector<BgrFrameView>    frameBuf;
+        std::vector<InferenceOutput> inferenceOutputBuf;
+        std::vector<std::string>     textPrintBuf;
+        std::vector<DetectionOBB>    detectionsBuf;
+        decodedImgBuf.swap(decodedImg);
+        frameBuf.swap(frame);
+        inferenceOutputBuf.swap(inferenceOutput);
+        textPrintBuf.swap(textPrint);
+        detectionsBuf.swap(detections);
+        decodedImgBuf.clear();
+        frameBuf.clear();
+        inferenceOutputBuf.clear();
+        textPrintBuf.clear();
+        detectionsBuf.clear();
+
+        *this = DetectDataMsg();
+        decodedImg.swap(decodedImgBuf);
+        frame.swap(frameBuf);
+        inferenceOutput.swap(inferenceOutputBuf);
+        textPrint.swap(textPrintBuf);
+        detections.swap(detectionsBuf);
+    }
+};
+
+// 每通道 DetectDataMsg 对象池中保留的空闲对象上限
+const uint32_t kDetectDataMsgPoolSize = 64;
+
+// ============ 运行时可热更新的参数 ============
+// 配置文件变化时由 main 重新解析, 以 AclLiteSnapshot 整体替换; 各阶段每帧
+// 读取一次, 指针变化时才应用到自己的成员. 模型路径、通道等结构性配置仍需重启
+
+// 后处理: 置信度/NMS阈值与目标类别过滤
+struct PostTuning
+{
+    float            confThresh = 0.25f;
+    float            nmsThresh = 0.45f;
+    std::vector<int> targetClassIds; // 为空时不过滤
+
+    bool operator==(const PostTuning &other) const
+    {
+        return confThresh == other.confThresh &&
+               nmsThresh == other.nmsThresh &&
+               targetClassIds == other.targetClassIds;
+    }
+    bool operator!=(const PostTuning &other) const { return !(*this == other); }
+};
+
+// 读帧: 跳帧间隔与跟踪检测验证的触发间隔
+struct InputTuning
+{
+    int  frameDecimation = 0;
+    bool trackingValidationEnabled = false;
+    int  trackingValidationInterval = 0;
+
+    bool operator==(const InputTuning &other) const
+    {
+        return frameDecimation == other.frameDecimation &&
+               trackingValidationEnabled == other.trackingValidationEnabled &&
+               trackingValidationInterval == other.trackingValidationInterval;
+    }
+    bool operator!=(const InputTuning &other) const { return !(*this == other); }
+};
+
+// 跟踪: 置信度阈值、静止目标过滤与检测验证, 默认值与 Tracking 成员一致
+struct TrackTuning
+{
+    float confidenceActiveThreshold = 0.70f;
+    float confidenceRedetectThreshold = 0.40f;
+    int   maxTrackLossFrames = 10;
+    float scoreDecayFactor = 0.98f;
+    bool  filterStaticTarget = false;
+    float staticCenterThreshold = 2.0f;
+    float staticSizeThreshold = 2.0f;
+    int   staticFrameThreshold = 30;
+    bool  validationEnabled = false;
+    float validationIouThreshold = 0.30f;
+    int   validationMaxErrors = 3;
+
+    bool operator==(const TrackTuning &other) const
+    {
+        return confidenceActiveThreshold == other.confidenceActiveThreshold &&
+               confidenceRedetectThreshold == other.confidenceRedetectThreshold &&
+               maxTrackLossFrames == other.maxTrackLossFrames &&
+               scoreDecayFactor == other.scoreDecayFactor &&
+               filterStaticTarget == other.filterStaticTarget &&
+               staticCenterThreshold == other.staticCenterThreshold &&
+               staticSizeThreshold == other.staticSizeThreshold &&
+               staticFrameThreshold == other.staticFrameThreshold &&
+               validationEnabled == other.validationEnabled &&
+               validationIouThreshold == other.validationIouThreshold &&
+               validationMaxErrors == other.validationMaxErrors;
+    }
+    bool operator!=(const TrackTuning &other) const { return !(*this == other); }
 };
 
 #endif
@@ -23,11 +23,10 @@
 
 namespace
 {
-const uint32_t kYuvMultiplier = 3;
-const uint32_t kYuvDivisor = 2;
-const uint32_t kSleepTime = 500;
-const uint32_t kOneSec = 1000000;
-const uint32_t kOneMSec = 1000;
+// 帧消息对象池命中率的打印间隔(帧)
+const int kPoolLogInterval = 300;
+// 自适应跳帧连续空闲这么多个周期后才减小一级
+const int kDecimationCalmWindows = 3;
 } // namespace
 using namespace std;
 
@@ -54,12 +53,15 @@ DataInputThread::DataInputThread(
       inferDoneReady_(true),
       inputDataType_(inputDataType),
       inputDataPath_(inputDataPath),
-      inferName_(inferName),
       outputType_(outputType),
       postThreadNum_(postThreadNum),
       postproId_(0),
       runMode_(runMode),
       cap_(nullptr),
+      raw_(nullptr), picReader_(nullptr), motionGate_(nullptr),
+      motionPending_(false), forcedPending_(false), motionFrames_(nullptr),
+      motionSkipped_(nullptr), motionForced_(nullptr),
+      motionActivity_(nullptr), motionGateTime_(nullptr),
       selfThreadId_(INVALID_INSTANCE_ID),
       preThreadId_(INVALID_INSTANCE_ID),
       inferThreadId_(INVALID_INSTANCE_ID),
@@ -68,10 +70,17 @@ DataInputThread::DataInputThread(
       rtspDisplayThreadId_(INVALID_INSTANCE_ID),
       hdmiDisplayThreadId_(INVALID_INSTANCE_ID),
       framesPerSecond_(framesPerSecond),
+      liveMode_(false),
       frameSkip_(
           frameSkip < 0
               ? 0
               : frameSkip), // 跳帧参数: 跳过 frameSkip_ 帧; 0 = 不跳帧
+      inferTime_(nullptr),
+      inferCount_(0),
+      inferSumUs_(0),
+      lastAdaptUs_(0),
+      calmWindows_(0),
+      decimationGauge_(nullptr),
       trackThreadId_(INVALID_INSTANCE_ID),
       isTrackingActive_(false),
       currentTrackingConfidence_(0.0f),
@@ -87,22 +96,82 @@ DataInputThread::DataInputThread(
       staticSizeThreshold_(0.0f),
       trackingValidationEnabled_(trackingValidationEnabled),
       trackingValidationInterval_(trackingValidationInterval),
-      trackingValidationFrameCount_(0)
+      trackingValidationFrameCount_(0),
+      epoch_(make_shared<atomic<uint32_t>>(0)),
+      msgPool_(kDetectDataMsgPoolSize, [](DetectDataMsg &msg) {
+          // 最后一个阶段释放帧时各阶段的 span 已写完
+          if (msg.trace.sampled)
+          {
+              AclLiteTracer::GetInstance().Submit(
+                  msg.channelId, msg.msgNum, msg.trace);
+          }
+          msg.Reset();
+      })
 {
+    // 默认按线程命名约定组装本通道的路由
+    string channel = to_string(channelId);
+    route_.preName = kPreName + channel;
+    route_.inferName = inferName;
+    for (int i = 0; i < postThreadNum; i++)
+    {
+        route_.postNames.push_back(kPostName + channel + "_" + to_string(i));
+    }
+    route_.trackName = kTrackName + channel;
+    route_.dataOutputName = kDataOutputName + channel;
+    route_.rtspDisplayName = kRtspDisplayName + channel;
+    if (outputType == "hdmi")
+    {
+        route_.hdmiDisplayName = kHdmiDisplayName + channel;
+    }
 }
 
-DataInputThread::~DataInputThread()
+void DataInputThread::SetRoute(const DataInputRoute &route)
 {
-    if (inputDataType_ == "pic")
+    route_ = route;
+    postThreadNum_ = route_.postNames.size();
+    postThreadId_.assign(postThreadNum_, INVALID_INSTANCE_ID);
+}
+
+void DataInputThread::UpdateTuning(shared_ptr<const InputTuning> tuning)
+{
+    tuning_.Store(tuning);
+}
+
+void DataInputThread::ApplyTuning(const InputTuning &tuning)
+{
+    frameSkip_ = tuning.frameDecimation < 0 ? 0 : tuning.frameDecimation;
+    if (adaptiveConfig_.enable)
     {
-        dvpp_.DestroyResource();
+        // 自适应时作为新的起点
+        frameSkip_ = max(adaptiveConfig_.minDecimation,
+                         min(frameSkip_, adaptiveConfig_.maxDecimation));
+        calmWindows_ = 0;
     }
+    trackingValidationEnabled_ = tuning.trackingValidationEnabled;
+    trackingValidationInterval_ = tuning.trackingValidationInterval;
+    trackingValidationFrameCount_ = 0;
+    ACLLITE_LOG_INFO("[DataInput Ch%d] frame_decimation=%d, tracking "
+                     "validation %s interval=%d",
+                     channelId_,
+                     frameSkip_,
+                     trackingValidationEnabled_ ? "on" : "off",
+                     trackingValidationInterval_);
+}
+
+DataInputThread::~DataInputThread()
+{
+    delete picReader_;
+    picReader_ = nullptr;
+    delete motionGate_;
+    motionGate_ = nullptr;
     if (cap_ != nullptr)
     {
         cap_->Close();
         delete cap_;
         cap_ = nullptr;
     }
+    delete raw_;
+    raw_ = nullptr;
 }
 
 AclLiteError DataInputThread::OpenPicsDir()
@@ -115,7 +184,20 @@ AclLiteError DataInputThread::OpenPicsDir()
                           inputImageDir.c_str());
         return ACLLITE_ERROR;
     }
-
+    // 多个 JPEGD 线程预读解码, 按文件顺序取出
+    picReader_ = new PicDirReader("picdec" + to_string(channelId_),
+                                  fileVec_,
+                                  picConfig_.workers,
+                                  picConfig_.prefetch,
+                                  runMode_);
+    AclLiteError ret = picReader_->Open();
+    if (ret != ACLLITE_OK)
+    {
+        ACLLITE_LOG_ERROR("Open pic reader of %s failed, error %d",
+                          inputImageDir.c_str(),
+                          ret);
+        return ACLLITE_ERROR;
+    }
     return ACLLITE_OK;
 }
 
@@ -123,7 +205,8 @@ AclLiteError DataInputThread::OpenVideoCapture()
 {
     if (IsRtspAddr(inputDataPath_))
     {
-        cap_ = new AclLiteVideoProc(inputDataPath_, deviceId_);
+        cap_ = new AclLiteVideoProc(
+            inputDataPath_, deviceId_, nullptr, decodeConfig_);
     }
     else if (IsVideoFile(inputDataPath_))
     {
@@ -132,7 +215,8 @@ AclLiteError DataInputThread::OpenVideoCapture()
             ACLLITE_LOG_ERROR("The %s is inaccessible", inputDataPath_.c_str());
             return ACLLITE_ERROR;
         }
-        cap_ = new AclLiteVideoProc(inputDataPath_, deviceId_);
+        cap_ = new AclLiteVideoProc(
+            inputDataPath_, deviceId_, nullptr, decodeConfig_);
     }
     else
     {
@@ -152,20 +236,39 @@ AclLiteError DataInputThread::OpenVideoCapture()
     return ACLLITE_OK;
 }
 
+AclLiteError DataInputThread::OpenRawVideo()
+{
+    raw_ = new RawVideoReader(inputDataPath_, rawConfig_.width,
+                              rawConfig_.height);
+    if (!raw_->IsOpened())
+    {
+        delete raw_;
+        raw_ = nullptr;
+        ACLLITE_LOG_ERROR("Failed to open raw video %s",
+                          inputDataPath_.c_str());
+        return ACLLITE_ERROR;
+    }
+    raw_->Set(TARGET_FPS, rawConfig_.fps);
+    raw_->Set(LOOP_PLAYBACK, rawConfig_.loop ? 1 : 0);
+    return ACLLITE_OK;
+}
+
 AclLiteError DataInputThread::Init()
 {
     AclLiteError aclRet;
-    if (inputDataType_ == "pic")
+    if (inputDataType_ == "raw")
     {
-        aclRet = OpenPicsDir();
+        aclRet = OpenRawVideo();
         if (aclRet != ACLLITE_OK)
         {
             return ACLLITE_ERROR;
         }
-        aclRet = dvpp_.Init("DVPP_CHNMODE_JPEGD");
-        if (aclRet)
+    }
+    else if (inputDataType_ == "pic")
+    {
+        aclRet = OpenPicsDir();
+        if (aclRet != ACLLITE_OK)
         {
-            ACLLITE_LOG_ERROR("Dvpp init failed, error %d", aclRet);
             return ACLLITE_ERROR;
         }
     }
@@ -177,31 +280,34 @@ AclLiteError DataInputThread::Init()
             return ACLLITE_ERROR;
         }
     }
+    InitMotionGate();
+    InitAdaptiveDecimation();
     // Get the relevant thread instance id
-    // 获取相关线程实例id
+    // 获取相关线程实例id, 之后每帧直接使用, 不再按名称查找
     selfThreadId_ = SelfInstanceId();
-    inferThreadId_ = GetAclLiteThreadIdByName(inferName_);
-    preThreadId_ = GetAclLiteThreadIdByName(kPreName + to_string(channelId_));
-    dataOutputThreadId_ =
-        GetAclLiteThreadIdByName(kDataOutputName + to_string(channelId_));
-    rtspDisplayThreadId_ =
-        GetAclLiteThreadIdByName(kRtspDisplayName + to_string(channelId_));
-    if (outputType_ == "hdmi")
-    {
-        hdmiDisplayThreadId_ =
-            GetAclLiteThreadIdByName(kHdmiDisplayName + to_string(channelId_));
+    inferThreadId_ = GetAclLiteThreadIdByName(route_.inferName);
+    preThreadId_ = GetAclLiteThreadIdByName(route_.preName);
+    dataOutputThreadId_ = GetAclLiteThreadIdByName(route_.dataOutputName);
+    if (!route_.rtspDisplayName.empty())
+    {
+        rtspDisplayThreadId_ = GetAclLiteThreadIdByName(route_.rtspDisplayName);
+    }
+    if (!route_.hdmiDisplayName.empty())
+    {
+        hdmiDisplayThreadId_ = GetAclLiteThreadIdByName(route_.hdmiDisplayName);
         if (hdmiDisplayThreadId_ == INVALID_INSTANCE_ID)
         {
             ACLLITE_LOG_ERROR("hdmi display instance id %d", hdmiDisplayThreadId_);
             return ACLLITE_ERROR;
         }
     }
-    trackThreadId_ =
-        GetAclLiteThreadIdByName(kTrackName + to_string(channelId_));
+    if (!route_.trackName.empty())
+    {
+        trackThreadId_ = GetAclLiteThreadIdByName(route_.trackName);
+    }
     for (int i = 0; i < postThreadNum_; i++)
     {
-        postThreadId_[i] = GetAclLiteThreadIdByName(
-            kPostName + to_string(channelId_) + "_" + to_string(i));
+        postThreadId_[i] = GetAclLiteThreadIdByName(route_.postNames[i]);
         if (postThreadId_[i] == INVALID_INSTANCE_ID)
         {
             ACLLITE_LOG_ERROR(
@@ -224,9 +330,21 @@ AclLiteError DataInputThread::Init()
             dataOutputThreadId_);
         return ACLLITE_ERROR;
     }
-    int oneSecond = 1000;
-    lastDecodeTime_ = 0;
-    waitTime_ = oneSecond / framesPerSecond_;
+    if (cap_ != nullptr && framesPerSecond_ > 0)
+    {
+        // 未到期的帧在解码前(非参考帧)或拷贝到host前(参考帧)丢弃
+        cap_->Set(TARGET_FPS, framesPerSecond_);
+    }
+    if (cap_ != nullptr && liveMode_)
+    {
+        cap_->Set(LATENCY_MODE, LATENCY_MODE_LIVE);
+    }
+    else if (liveMode_)
+    {
+        ACLLITE_LOG_WARNING("[DataInput Ch%d] latency_mode live only applies "
+                            "to video/rtsp input, ignored",
+                            channelId_);
+    }
     
     ACLLITE_LOG_INFO(
         "DataInputThread initialized: frameSkip=%d (run heavy pipeline every %d frame, reuse results for skipped frames)",
@@ -238,17 +356,28 @@ AclLiteError DataInputThread::Init()
 
 AclLiteError DataInputThread::Process(int msgId, shared_ptr<void> msgData)
 {
-    auto start = std::chrono::high_resolution_clock::now();
-    
-    shared_ptr<DetectDataMsg> detectDataMsg = make_shared<DetectDataMsg>();
     switch (msgId)
     {
     case MSG_APP_START:
         AppStart();
         break;
     case MSG_READ_FRAME:
-        MsgRead(detectDataMsg);
-        MsgSend(detectDataMsg);
+        {
+            shared_ptr<DetectDataMsg> detectDataMsg = msgPool_.Acquire();
+            detectDataMsg->trace.sampled =
+                AclLiteTracer::GetInstance().ShouldSample(msgNum_);
+            int span = detectDataMsg->trace.Begin("read");
+            MsgRead(detectDataMsg);
+            detectDataMsg->trace.End(span);
+            MsgSend(detectDataMsg);
+            if (msgNum_ % kPoolLogInterval == 0)
+            {
+                ACLLITE_LOG_INFO("[DataInput Ch%d] msg pool hit: %lu, miss: %lu",
+                                 channelId_,
+                                 (unsigned long)msgPool_.GetHitNum(),
+                                 (unsigned long)msgPool_.GetMissNum());
+            }
+        }
         break;
     case MSG_TRACK_STATE_CHANGE:
         {
@@ -301,16 +430,11 @@ AclLiteError DataInputThread::Process(int msgId, shared_ptr<void> msgData)
                         // 重新检测时把标记复位，确保下一帧走检测逻辑
                         isFirstFrame_ = true;
                     
-                    // 清空检测预处理、推理、后处理的队列
-                    AclLiteApp &app = GetAclLiteAppInstance();
-                    app.ClearThreadQueue(preThreadId_);
-                    app.ClearThreadQueue(inferThreadId_);
-                    for (int i = 0; i < postThreadNum_; i++)
-                    {
-                        app.ClearThreadQueue(postThreadId_[i]);
-                    }
-                    ACLLITE_LOG_INFO("[DataInput Ch%d] Cleared detection queues (preprocess, inference, postprocess)",
-                                     channelId_);
+                    // 递增通道代数: 在途帧不出队, 由各阶段跳过缩放/推理/跟踪后透传,
+                    // 保证每个 postId 的输出队列不缺帧
+                    uint32_t epoch = epoch_->fetch_add(1) + 1;
+                    ACLLITE_LOG_INFO("[DataInput Ch%d] Invalidate in-flight frames, epoch %u",
+                                     channelId_, epoch);
                 }
             }
         }
@@ -339,16 +463,8 @@ AclLiteError DataInputThread::Process(int msgId, shared_ptr<void> msgData)
                           msgId);
         break;
     }
-    
-        auto end = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
-        if (frameCnt_ % 30 == 0)
-        {
-            ACLLITE_LOG_INFO("[DataInputThread] Process time: %ld ms", duration);
-            // 每30帧打印一次所有线程的队列状态
-            AclLiteApp &app = GetAclLiteAppInstance();
-            app.PrintQueueStatus();
-        }    return ACLLITE_OK;
+
+    return ACLLITE_OK;
 }
 
 AclLiteError DataInputThread::AppStart()
@@ -364,79 +480,100 @@ AclLiteError DataInputThread::AppStart()
 
 AclLiteError DataInputThread::ReadPic(shared_ptr<DetectDataMsg> &detectDataMsg)
 {
-    AclLiteError ret = ACLLITE_OK;
-    if (frameCnt_ == fileVec_.size())
+    // 每个文件只由 JPEGD 解码一次, host 上的 NV12 由解码结果拷回,
+    // BGR 由跟踪/输出按需转换, 不再 imread 第二次解码
+    ImageData    decodedImg, hostImg;
+    AclLiteError ret = picReader_->Read(decodedImg, hostImg);
+    if (ret == ACLLITE_ERROR_DECODE_FINISH)
     {
         detectDataMsg->isLastFrame = true;
         return ACLLITE_OK;
     }
-    ImageData jpgImg, dvppImg, decodedImg;
-    string    picFile = fileVec_[frameCnt_];
-    ret = ReadJpeg(jpgImg, picFile);
-    if (ret == ACLLITE_ERROR)
+    else if (ret != ACLLITE_OK)
     {
-        ACLLITE_LOG_ERROR("Read Jpeg image failed");
+        ACLLITE_LOG_ERROR("Read pic failed, error %d", ret);
         return ACLLITE_ERROR;
     }
-    ret = CopyImageToDevice(dvppImg, jpgImg, runMode_, MEMORY_DVPP);
-    if (ret == ACLLITE_ERROR)
+    detectDataMsg->decodedImg.push_back(decodedImg);
+    detectDataMsg->frame.push_back(BgrFrameView(hostImg));
+    return ACLLITE_OK;
+}
+
+AclLiteError
+DataInputThread::ReadStream(shared_ptr<DetectDataMsg> &detectDataMsg)
+{
+    // 节流在解码器中按 pts 完成, 这里读到的每一帧都需要处理
+    ImageData    decodedImg;
+    AclLiteError ret = cap_->Read(decodedImg);
+    if (ret == ACLLITE_ERROR_DECODE_FINISH)
     {
-        ACLLITE_LOG_ERROR("Copy image to device failed");
+        detectDataMsg->isLastFrame = true;
+        return ACLLITE_ERROR_DECODE_FINISH;
+    }
+    else if (ret != ACLLITE_OK)
+    {
+        detectDataMsg->isLastFrame = true;
+        ACLLITE_LOG_ERROR("Read frame failed, error %d", ret);
         return ACLLITE_ERROR;
     }
-    ret = dvpp_.JpegD(decodedImg, dvppImg);
+    // get frame, host 上保留读帧时的 NV12 快照(输出阶段会在 decodedImg 上
+    // 画框), BGR 由跟踪/输出按需转换
+    ImageData yuvImage;
+    ret = CopyImageToLocal(yuvImage, decodedImg, runMode_);
     if (ret == ACLLITE_ERROR)
     {
-        ACLLITE_LOG_ERROR("Pic decode failed");
+        ACLLITE_LOG_ERROR("Copy image to host failed");
         return ACLLITE_ERROR;
     }
-    cv::Mat frame = cv::imread(picFile);
+    if (decodedImg.streamGap)
+    {
+        detectDataMsg->streamGap = true;
+    }
     detectDataMsg->decodedImg.push_back(decodedImg);
-    detectDataMsg->frame.push_back(frame);
+    detectDataMsg->frame.push_back(BgrFrameView(yuvImage));
     return ACLLITE_OK;
 }
 
-AclLiteError
-DataInputThread::ReadStream(shared_ptr<DetectDataMsg> &detectDataMsg)
+AclLiteError DataInputThread::CopyRawToDvpp(ImageData &dvppImg,
+                                            ImageData &hostImg)
 {
-    // get time now
-    timeval tv;
-    gettimeofday(&tv, 0);
-    int64_t now =
-        ((int64_t)tv.tv_sec * kOneSec + (int64_t)tv.tv_usec) / kOneMSec;
-    // get time last record
-    if (lastDecodeTime_ == 0)
+    // VPC 输入的宽按 16、高按 2 对齐, 不对齐时逐行拷入对齐的缓冲
+    uint32_t alignWidth = ALIGN_UP16(hostImg.width);
+    uint32_t alignHeight = ALIGN_UP2(hostImg.height);
+    if (alignWidth == hostImg.width && alignHeight == hostImg.height)
     {
-        lastDecodeTime_ = now;
+        return CopyImageToDevice(dvppImg, hostImg, runMode_, MEMORY_DVPP);
     }
-    // calculate interval
-    realWaitTime_ = (now - lastDecodeTime_);
-
-    AclLiteError ret = ACLLITE_OK;
-    ImageData    decodedImg;
-
-    while (realWaitTime_ < waitTime_)
+    ImageData alignImg = hostImg;
+    alignImg.alignWidth = alignWidth;
+    alignImg.alignHeight = alignHeight;
+    alignImg.size = YUV420SP_SIZE(alignWidth, alignHeight);
+    alignImg.data = shared_ptr<uint8_t>(new uint8_t[alignImg.size](),
+                                        default_delete<uint8_t[]>());
+    uint8_t *src = hostImg.data.get();
+    uint8_t *dst = alignImg.data.get();
+    uint8_t *srcUv = src + hostImg.width * hostImg.height;
+    uint8_t *dstUv = dst + alignWidth * alignHeight;
+    for (uint32_t r = 0; r < hostImg.height; r++)
     {
-        ret = cap_->Read(decodedImg);
-        if (ret == ACLLITE_ERROR_DECODE_FINISH)
-        {
-            detectDataMsg->isLastFrame = true;
-            return ACLLITE_ERROR_DECODE_FINISH;
-        }
-        else if (ret != ACLLITE_OK)
-        {
-            detectDataMsg->isLastFrame = true;
-            ACLLITE_LOG_ERROR("Read frame failed, error %d", ret);
-            return ACLLITE_ERROR;
-        }
-        // get time now
-        gettimeofday(&tv, 0);
-        now = ((int64_t)tv.tv_sec * kOneSec + (int64_t)tv.tv_usec) / kOneMSec;
-        // calculate interval agian
-        realWaitTime_ = (now - lastDecodeTime_);
+        memcpy(dst + r * alignWidth, src + r * hostImg.width, hostImg.width);
     }
+    for (uint32_t r = 0; r < hostImg.height / 2; r++)
+    {
+        memcpy(dstUv + r * alignWidth,
+               srcUv + r * hostImg.width,
+               hostImg.width);
+    }
+    return CopyImageToDevice(dvppImg, alignImg, runMode_, MEMORY_DVPP);
+}
 
-    ret = cap_->Read(decodedImg);
+AclLiteError
+DataInputThread::ReadRaw(shared_ptr<DetectDataMsg> &detectDataMsg)
+{
+    // host 上的帧直接指向文件映射(NV12)或 Y4M 交织后的缓冲, 不再拷贝;
+    // 只为预处理拷一份到 DVPP 内存
+    ImageData    hostImg;
+    AclLiteError ret = raw_->Read(hostImg);
     if (ret == ACLLITE_ERROR_DECODE_FINISH)
     {
         detectDataMsg->isLastFrame = true;
@@ -445,33 +582,29 @@ DataInputThread::ReadStream(shared_ptr<DetectDataMsg> &detectDataMsg)
     else if (ret != ACLLITE_OK)
     {
         detectDataMsg->isLastFrame = true;
-        ACLLITE_LOG_ERROR("Read frame failed, error %d", ret);
+        ACLLITE_LOG_ERROR("Read raw frame failed, error %d", ret);
         return ACLLITE_ERROR;
     }
-    // get frame
-    ImageData yuvImage;
-    ret = CopyImageToLocal(yuvImage, decodedImg, runMode_);
-    if (ret == ACLLITE_ERROR)
+    ImageData dvppImg;
+    ret = CopyRawToDvpp(dvppImg, hostImg);
+    if (ret != ACLLITE_OK)
     {
-        ACLLITE_LOG_ERROR("Copy image to host failed");
+        ACLLITE_LOG_ERROR("Copy raw frame to device failed, error %d", ret);
         return ACLLITE_ERROR;
     }
-    cv::Mat frame;
-    cv::Mat yuvimg(yuvImage.height * kYuvMultiplier / kYuvDivisor,
-                   yuvImage.width,
-                   CV_8UC1,
-                   yuvImage.data.get());
-    cv::cvtColor(yuvimg, frame, CV_YUV2BGR_NV12);
-    detectDataMsg->decodedImg.push_back(decodedImg);
-    detectDataMsg->frame.push_back(frame);
-    lastDecodeTime_ = now;
+    dvppImg.ptsUs = hostImg.ptsUs;
+    dvppImg.captureUs = hostImg.captureUs;
+    dvppImg.decodeUs = hostImg.decodeUs;
+    detectDataMsg->decodedImg.push_back(dvppImg);
+    detectDataMsg->frame.push_back(BgrFrameView(hostImg));
     return ACLLITE_OK;
 }
 
 AclLiteError
 DataInputThread::GetOneFrame(shared_ptr<DetectDataMsg> &detectDataMsg)
 {
-    AclLiteError ret;
+    AclLiteTraceScope span(detectDataMsg->trace, "decode");
+    AclLiteError      ret;
     if (inputDataType_ == "pic")
     {
         ret = ReadPic(detectDataMsg);
@@ -481,6 +614,14 @@ DataInputThread::GetOneFrame(shared_ptr<DetectDataMsg> &detectDataMsg)
             return ACLLITE_ERROR;
         }
     }
+    else if (inputDataType_ == "raw")
+    {
+        ret = ReadRaw(detectDataMsg);
+        if (ret != ACLLITE_OK)
+        {
+            return ACLLITE_ERROR;
+        }
+    }
     else if (inputDataType_ == "video" || inputDataType_ == "rtsp")
     {
         ret = ReadStream(detectDataMsg);
@@ -504,7 +645,14 @@ AclLiteError DataInputThread::MsgRead(shared_ptr<DetectDataMsg> &detectDataMsg)
     struct timeval tv;
     gettimeofday(&tv, nullptr);
     detectDataMsg->startTimestamp = tv.tv_sec * 1000000 + tv.tv_usec;
-    
+    // 每帧只读一次快照, 配置重新加载后从本帧开始生效
+    shared_ptr<const InputTuning> tuning = tuning_.Load();
+    if (tuning != appliedTuning_)
+    {
+        ApplyTuning(*tuning);
+        appliedTuning_ = tuning;
+    }
+
     postproId_ = msgNum_ % postThreadNum_;
     detectDataMsg->isLastFrame = false;
     detectDataMsg->detectPreThreadId = preThreadId_;
@@ -515,11 +663,13 @@ AclLiteError DataInputThread::MsgRead(shared_ptr<DetectDataMsg> &detectDataMsg)
     detectDataMsg->rtspDisplayThreadId = rtspDisplayThreadId_;
     detectDataMsg->hdmiDisplayThreadId = hdmiDisplayThreadId_;
     // Set track thread instance id (if configured, otherwise INVALID_INSTANCE_ID)
-    detectDataMsg->trackThreadId = GetAclLiteThreadIdByName(kTrackName + to_string(channelId_));
+    detectDataMsg->trackThreadId = trackThreadId_;
     detectDataMsg->dataInputThreadId = selfThreadId_;
     detectDataMsg->deviceId = deviceId_;
     detectDataMsg->channelId = channelId_;
     detectDataMsg->msgNum = msgNum_;
+    detectDataMsg->epoch = epoch_->load();
+    detectDataMsg->channelEpoch = epoch_;
     
     // 设置跟踪状态信息
     detectDataMsg->trackingActive = isTrackingActive_;
@@ -545,8 +695,10 @@ AclLiteError DataInputThread::MsgRead(shared_ptr<DetectDataMsg> &detectDataMsg)
     detectDataMsg->blockedHeight = blockedHeight_;
     detectDataMsg->staticCenterThreshold = staticCenterThreshold_;
     detectDataMsg->staticSizeThreshold = staticSizeThreshold_;
+    UpdateDecimation();
+    int frameSkip = EffectiveDecimation();
     detectDataMsg->decimatedFrame =
-        frameSkip_ > 0 && (detectDataMsg->msgNum % (frameSkip_ + 1) != 0);
+        frameSkip > 0 && (detectDataMsg->msgNum % (frameSkip + 1) != 0);
     if (forceValidation && detectDataMsg->decimatedFrame)
     {
         detectDataMsg->decimatedFrame = false;
@@ -559,6 +711,11 @@ AclLiteError DataInputThread::MsgRead(shared_ptr<DetectDataMsg> &detectDataMsg)
     {
         return ACLLITE_OK;
     }
+    if (!detectDataMsg->decodedImg.empty())
+    {
+        detectDataMsg->ptsUs = detectDataMsg->decodedImg[0].ptsUs;
+        detectDataMsg->captureUs = detectDataMsg->decodedImg[0].captureUs;
+    }
     frameCnt_++;
     while (frameCnt_ % batch_)
     {
@@ -569,10 +726,251 @@ AclLiteError DataInputThread::MsgRead(shared_ptr<DetectDataMsg> &detectDataMsg)
         }
         frameCnt_++;
     }
+    if (detectDataMsg->streamGap)
+    {
+        // 断流期间目标可能已移出原位置, 重连后的首帧重新检测
+        ACLLITE_LOG_INFO("[DataInput Ch%d] stream reconnected, tracking reset",
+                         channelId_);
+        isTrackingActive_ = false;
+        isFirstFrame_ = true;
+        trackingValidationFrameCount_ = 0;
+        // 断流前读入的在途帧不再更新跟踪器
+        detectDataMsg->epoch = epoch_->fetch_add(1) + 1;
+        detectDataMsg->trackingActive = false;
+        detectDataMsg->skipInference = false;
+        detectDataMsg->decimatedFrame = false;
+        detectDataMsg->reusePrevResult = false;
+    }
+    ApplyMotionGate(detectDataMsg);
 
     return ACLLITE_OK;
 }
 
+void DataInputThread::InitAdaptiveDecimation()
+{
+    if (!adaptiveConfig_.enable)
+    {
+        return;
+    }
+    AdaptiveDecimationConfig &config = adaptiveConfig_;
+    config.minDecimation = max(config.minDecimation, 0);
+    config.maxDecimation = max(config.maxDecimation, config.minDecimation);
+    frameSkip_ =
+        max(config.minDecimation, min(frameSkip_, config.maxDecimation));
+    // 显示线程的队列按丢帧策略自行排空, 不计入
+    vector<string> names = route_.postNames;
+    names.push_back(route_.preName);
+    names.push_back(route_.inferName);
+    names.push_back(route_.trackName);
+    names.push_back(route_.dataOutputName);
+    AclLiteMetrics &metrics = AclLiteMetrics::GetInstance();
+    for (const string &name : names)
+    {
+        if (!name.empty())
+        {
+            downstreamStages_.push_back(metrics.GetStageMetrics(name));
+        }
+    }
+    if (config.maxInferMs > 0)
+    {
+        inferTime_ = metrics.GetHistogram(route_.inferName + ".execute");
+    }
+    decimationGauge_ = metrics.GetGauge(SelfInstanceName() + ".decimation");
+    decimationGauge_->Set(frameSkip_);
+    lastAdaptUs_ = AclLiteNowUs();
+    ACLLITE_LOG_INFO("[DataInput Ch%d] adaptive decimation %d..%d, start %d, "
+                     "queue %u/%u, infer %u ms",
+                     channelId_,
+                     config.minDecimation,
+                     config.maxDecimation,
+                     frameSkip_,
+                     config.queueLow,
+                     config.queueHigh,
+                     config.maxInferMs);
+}
+
+void DataInputThread::UpdateDecimation()
+{
+    if (!adaptiveConfig_.enable)
+    {
+        return;
+    }
+    const AdaptiveDecimationConfig &config = adaptiveConfig_;
+    int64_t                         now = AclLiteNowUs();
+    if (now - lastAdaptUs_ < (int64_t)config.intervalMs * 1000)
+    {
+        return;
+    }
+    lastAdaptUs_ = now;
+
+    int64_t depth = 0;
+    for (AclLiteStageMetrics *stage : downstreamStages_)
+    {
+        depth = max(depth, stage->queueDepth.Get());
+    }
+    // 本周期内的推理平均耗时, 推理线程可能由多个通道共用
+    int64_t inferUs = 0;
+    if (inferTime_ != nullptr)
+    {
+        AclLiteHistogramSnapshot snapshot;
+        inferTime_->GetSnapshot(snapshot);
+        if (snapshot.count > inferCount_)
+        {
+            inferUs = (int64_t)((snapshot.sum - inferSumUs_) /
+                                (snapshot.count - inferCount_));
+        }
+        inferCount_ = snapshot.count;
+        inferSumUs_ = snapshot.sum;
+    }
+    int64_t maxInferUs = (int64_t)config.maxInferMs * 1000;
+    bool    overload = (depth >= (int64_t)config.queueHigh) ||
+                    ((maxInferUs > 0) && (inferUs > maxInferUs));
+    bool    idle = (depth <= (int64_t)config.queueLow) &&
+                ((maxInferUs == 0) || (inferUs <= maxInferUs * 3 / 4));
+    int     frameSkip = frameSkip_;
+    if (overload)
+    {
+        // 过载时成倍加大, 空闲时逐级减小, 尽快把时延压回来又不来回振荡
+        calmWindows_ = 0;
+        frameSkip = min(frameSkip * 2 + 1, config.maxDecimation);
+    }
+    else if (idle)
+    {
+        if (++calmWindows_ >= kDecimationCalmWindows)
+        {
+            calmWindows_ = 0;
+            frameSkip = max(frameSkip - 1, config.minDecimation);
+        }
+    }
+    else
+    {
+        calmWindows_ = 0;
+    }
+    if (frameSkip != frameSkip_)
+    {
+        ACLLITE_LOG_INFO("[DataInput Ch%d] decimation %d -> %d, queue depth "
+                         "%ld, infer %ld us",
+                         channelId_,
+                         frameSkip_,
+                         frameSkip,
+                         (long)depth,
+                         (long)inferUs);
+        frameSkip_ = frameSkip;
+        decimationGauge_->Set(frameSkip_);
+    }
+}
+
+int DataInputThread::EffectiveDecimation() const
+{
+    // 跟踪中的通道按下限跳帧, 负载由其余通道多跳帧来分担
+    if (adaptiveConfig_.enable && isTrackingActive_)
+    {
+        return min(frameSkip_, adaptiveConfig_.minDecimation);
+    }
+    return frameSkip_;
+}
+
+void DataInputThread::InitMotionGate()
+{
+    if (!motionGateConfig_.enable)
+    {
+        return;
+    }
+    motionGate_ = new MotionGate(motionGateConfig_);
+    string name = SelfInstanceName();
+    motionFrames_ =
+        AclLiteMetrics::GetInstance().GetCounter(name + ".motion_frames");
+    motionSkipped_ =
+        AclLiteMetrics::GetInstance().GetCounter(name + ".motion_skipped");
+    motionForced_ =
+        AclLiteMetrics::GetInstance().GetCounter(name + ".motion_forced");
+    motionActivity_ =
+        AclLiteMetrics::GetInstance().GetGauge(name + ".motion_activity_ppm");
+    motionGateTime_ =
+        AclLiteMetrics::GetInstance().GetHistogram(name + ".motion_gate");
+    ACLLITE_LOG_INFO("[DataInput Ch%d] motion gate on: grid %u, pixel %u, "
+                     "activity %.6f, learning %.3f, max skip %u",
+                     channelId_,
+                     motionGateConfig_.gridWidth,
+                     motionGateConfig_.pixelThreshold,
+                     motionGateConfig_.activityThreshold,
+                     motionGateConfig_.learningRate,
+                     motionGateConfig_.maxSkipFrames);
+}
+
+bool DataInputThread::DetectMotion(shared_ptr<DetectDataMsg> &detectDataMsg)
+{
+    AclLiteScopeTimer timer(motionGateTime_);
+    bool              motion = false;
+    for (BgrFrameView &frame : detectDataMsg->frame)
+    {
+        const ImageData &nv12 = frame.Nv12();
+        if (nv12.data == nullptr)
+        {
+            // 没有 host NV12 无法判断, 按有运动处理
+            motion = true;
+            continue;
+        }
+        // 解码输出按 alignWidth 存放每行
+        uint32_t stride = nv12.alignWidth > 0 ? nv12.alignWidth : nv12.width;
+        if (motionGate_->Update(
+                nv12.data.get(), nv12.width, nv12.height, stride))
+        {
+            if (motionGate_->Forced())
+            {
+                forcedPending_ = true;
+            }
+            else
+            {
+                motion = true;
+            }
+        }
+        motionActivity_->Set((int64_t)(motionGate_->Activity() * 1000000));
+    }
+    return motion;
+}
+
+void DataInputThread::ApplyMotionGate(shared_ptr<DetectDataMsg> &detectDataMsg)
+{
+    if ((motionGate_ == nullptr) || detectDataMsg->frame.empty())
+    {
+        return;
+    }
+    if (detectDataMsg->streamGap)
+    {
+        motionGate_->Reset();
+    }
+    // 跳帧和跟踪的帧也更新背景, 其间出现的运动留到下一个检测帧
+    if (DetectMotion(detectDataMsg))
+    {
+        motionPending_ = true;
+    }
+    if (detectDataMsg->decimatedFrame || detectDataMsg->trackingActive)
+    {
+        // 本就不检测: 跳帧, 或由跟踪线程处理(含定期检测验证)
+        return;
+    }
+    if (motionPending_)
+    {
+        motionFrames_->Add();
+    }
+    else if (forcedPending_)
+    {
+        // 长时间无运动时仍定期检测, 防止静止或缓慢的目标一直漏检
+        motionForced_->Add();
+    }
+    else
+    {
+        // 无运动: 与跳帧相同, 复用上一帧结果直接送输出
+        motionSkipped_->Add();
+        detectDataMsg->decimatedFrame = true;
+        detectDataMsg->reusePrevResult = true;
+        return;
+    }
+    motionPending_ = false;
+    forcedPending_ = false;
+}
+
 AclLiteError DataInputThread::MsgSend(shared_ptr<DetectDataMsg> &detectDataMsg)
 {
     AclLiteError ret;
@@ -584,26 +982,14 @@ AclLiteError DataInputThread::MsgSend(shared_ptr<DetectDataMsg> &detectDataMsg)
             // 轻量跳帧: 复用上一帧的检测/跟踪结果，仅将当前帧发送到输出
             detectDataMsg->trackingActive = isTrackingActive_;
             detectDataMsg->trackingConfidence = currentTrackingConfidence_;
-            while (1)
+            ret = SendMessageByPolicy(dataOutputThreadId_,
+                                      MSG_OUTPUT_FRAME,
+                                      detectDataMsg);
+            if (ret != ACLLITE_OK && ret != ACLLITE_ERROR_MSG_DROPPED)
             {
-                ret = SendMessage(dataOutputThreadId_,
-                                  MSG_OUTPUT_FRAME,
-                                  detectDataMsg);
-                if (ret == ACLLITE_ERROR_ENQUEUE)
-                {
-                    usleep(kSleepTime);
-                    continue;
-                }
-                else if (ret == ACLLITE_OK)
-                {
-                    break;
-                }
-                else
-                {
-                    ACLLITE_LOG_ERROR(
-                        "Send decimated frame message failed, error %d", ret);
-                    return ret;
-                }
+                ACLLITE_LOG_ERROR(
+                    "Send decimated frame message failed, error %d", ret);
+                return ret;
             }
 
             ret = SendMessage(selfThreadId_, MSG_READ_FRAME, nullptr);
@@ -623,56 +1009,34 @@ AclLiteError DataInputThread::MsgSend(shared_ptr<DetectDataMsg> &detectDataMsg)
         if (isTrackingMode)
         {
             // 跳过检测推理,直接进行跟踪
-            while (1)
+            ret = SendMessageByPolicy(trackThreadId_,
+                                      MSG_TRACK_ONLY,
+                                      detectDataMsg);
+            if (ret == ACLLITE_OK)
             {
-                ret = SendMessage(trackThreadId_,
-                                  MSG_TRACK_ONLY,
-                                  detectDataMsg);
-                if (ret == ACLLITE_ERROR_ENQUEUE)
-                {
-                    usleep(kSleepTime);
-                    continue;
-                }
-                else if (ret == ACLLITE_OK)
+                if (isFirstFrame_)
                 {
-                    if (isFirstFrame_)
-                    {
-                        isFirstFrame_ = false;
-                    }
-                    break;
-                }
-                else
-                {
-                    ACLLITE_LOG_ERROR("Send tracking message failed, error %d", ret);
-                    return ret;
+                    isFirstFrame_ = false;
                 }
             }
+            else if (ret != ACLLITE_ERROR_MSG_DROPPED)
+            {
+                ACLLITE_LOG_ERROR("Send tracking message failed, error %d", ret);
+                return ret;
+            }
         }
         else
         {
             // 条件B: 首帧或跟踪失败 -> 执行完整检浊推理流程
-            while (1)
+            ret = SendMessageByPolicy(detectDataMsg->detectPreThreadId,
+                                      MSG_PREPROC_DETECTDATA,
+                                      detectDataMsg);
+            if (ret != ACLLITE_OK && ret != ACLLITE_ERROR_MSG_DROPPED)
             {
-                ret = SendMessage(detectDataMsg->detectPreThreadId,
-                                  MSG_PREPROC_DETECTDATA,
-                                  detectDataMsg);
-                if (ret == ACLLITE_ERROR_ENQUEUE)
-                {
-                    usleep(kSleepTime);
-                    continue;
-                }
-                else if (ret == ACLLITE_OK)
-                {
-                    break;
-                }
-                else
-                {
-                    ACLLITE_LOG_ERROR("Send read frame message failed, error %d",
-                                      ret);
-                    return ret;
-                }
+                ACLLITE_LOG_ERROR("Send read frame message failed, error %d",
+                                  ret);
+                return ret;
             }
-            
         }
 
         ret = SendMessage(selfThreadId_, MSG_READ_FRAME, nullptr);
@@ -684,54 +1048,33 @@ AclLiteError DataInputThread::MsgSend(shared_ptr<DetectDataMsg> &detectDataMsg)
     }
     else
     {
+        // 最后一帧携带结束标记, 不能被丢弃, 始终阻塞发送
         if (detectDataMsg->decimatedFrame)
         {
             detectDataMsg->trackingActive = isTrackingActive_;
             detectDataMsg->trackingConfidence = currentTrackingConfidence_;
-            while (1)
+            ret = SendMessage(dataOutputThreadId_,
+                              MSG_OUTPUT_FRAME,
+                              detectDataMsg,
+                              ACLLITE_SEND_BLOCK);
+            if (ret != ACLLITE_OK)
             {
-                ret = SendMessage(dataOutputThreadId_,
-                                  MSG_OUTPUT_FRAME,
-                                  detectDataMsg);
-                if (ret == ACLLITE_ERROR_ENQUEUE)
-                {
-                    usleep(kSleepTime);
-                    continue;
-                }
-                else if (ret == ACLLITE_OK)
-                {
-                    break;
-                }
-                else
-                {
-                    ACLLITE_LOG_ERROR(
-                        "Send decimated last frame failed, error %d", ret);
-                    return ret;
-                }
+                ACLLITE_LOG_ERROR(
+                    "Send decimated last frame failed, error %d", ret);
+                return ret;
             }
 
             for (int i = 0; i < postThreadNum_; i++)
             {
-                while (1)
+                ret = SendMessage(dataOutputThreadId_,
+                                  MSG_ENCODE_FINISH,
+                                  detectDataMsg,
+                                  ACLLITE_PRIO_HIGH_FENCED);
+                if (ret != ACLLITE_OK)
                 {
-                    ret = SendMessage(dataOutputThreadId_,
-                                      MSG_ENCODE_FINISH,
-                                      detectDataMsg);
-                    if (ret == ACLLITE_ERROR_ENQUEUE)
-                    {
-                        usleep(kSleepTime);
-                        continue;
-                    }
-                    else if (ret == ACLLITE_OK)
-                    {
-                        break;
-                    }
-                    else
-                    {
-                        ACLLITE_LOG_ERROR(
-                            "Send encode finish for decimated frame failed, error %d", ret);
-                        return ret;
-                    }
+                    ACLLITE_LOG_ERROR(
+                        "Send encode finish for decimated frame failed, error %d", ret);
+                    return ret;
                 }
             }
             return ACLLITE_OK;
@@ -739,26 +1082,15 @@ AclLiteError DataInputThread::MsgSend(shared_ptr<DetectDataMsg> &detectDataMsg)
 
         for (int i = 0; i < postThreadNum_; i++)
         {
-            while (1)
+            ret = SendMessage(detectDataMsg->detectPreThreadId,
+                              MSG_PREPROC_DETECTDATA,
+                              detectDataMsg,
+                              ACLLITE_SEND_BLOCK);
+            if (ret != ACLLITE_OK)
             {
-                ret = SendMessage(detectDataMsg->detectPreThreadId,
-                                  MSG_PREPROC_DETECTDATA,
-                                  detectDataMsg);
-                if (ret == ACLLITE_ERROR_ENQUEUE)
-                {
-                    usleep(kSleepTime);
-                    continue;
-                }
-                else if (ret == ACLLITE_OK)
-                {
-                    break;
-                }
-                else
-                {
-                    ACLLITE_LOG_ERROR(
-                        "Send read frame message failed, error %d", ret);
-                    return ret;
-                }
+                ACLLITE_LOG_ERROR(
+                    "Send read frame message failed, error %d", ret);
+                return ret;
             }
         }
     }
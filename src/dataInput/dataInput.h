@@ -21,12 +21,59 @@
 #pragma once
 #include "AclLiteApp.h"
 #include "AclLiteImageProc.h"
+#include "AclLiteSnapshot.h"
 #include "AclLiteThread.h"
+#include "MotionGate.h"
+#include "ObjectPool.h"
 #include "Params.h"
+#include "PicDirReader.h"
+#include "RawVideoReader.h"
 #include "VideoCapture.h"
+#include <atomic>
 #include <mutex>
 #include <unistd.h>
 
+// input_type 为 pic 时的参数
+struct PicInputConfig
+{
+    uint32_t workers = 2;  // JPEGD 解码线程数, 每个线程占一个 JPEGD 通道
+    uint32_t prefetch = 8; // 最多预读解码的图片数
+};
+
+// 自适应跳帧: 按下游队列深度与推理耗时在 [minDecimation, maxDecimation]
+// 内调整本通道的跳帧数
+struct AdaptiveDecimationConfig
+{
+    bool     enable = false;
+    int      minDecimation = 0;  // 也是跟踪中的上限, 跟踪帧优先
+    int      maxDecimation = 8;
+    uint32_t intervalMs = 200;   // 调整周期
+    uint32_t queueHigh = 2;      // 下游最深队列达到此值即过载
+    uint32_t queueLow = 0;       // 不超过此值且推理不慢时视为空闲
+    uint32_t maxInferMs = 0;     // 推理平均耗时上限, 0 为不看耗时
+};
+
+// 本通道下游各线程的实例名, Init 时解析为线程 id; 名称为空表示没有该线程
+struct DataInputRoute
+{
+    std::string              preName;
+    std::string              inferName;
+    std::vector<std::string> postNames;
+    std::string              trackName;
+    std::string              dataOutputName;
+    std::string              rtspDisplayName;
+    std::string              hdmiDisplayName;
+};
+
+// input_type 为 raw 时的参数
+struct RawInputConfig
+{
+    uint32_t width = 0;   // 无文件头的 NV12 必填, Y4M 从文件头读取
+    uint32_t height = 0;
+    uint32_t fps = 0;     // 0 表示尽快读取
+    bool     loop = false; // 读完后从头循环
+};
+
 class DataInputThread : public AclLiteThread
 {
   public:
@@ -45,6 +92,39 @@ class DataInputThread : public AclLiteThread
                     int           trackingValidationInterval = 0);
 
     ~DataInputThread();
+    // replace the default route built from the thread naming convention,
+    // must be called before the app starts
+    void         SetRoute(const DataInputRoute &route);
+    // live: 解码输出只保留最新一帧, 下游忙时读帧总是取最新帧, 旧帧直接丢弃;
+    // 默认逐帧处理(文件). 须在应用启动前调用
+    void         SetLiveMode(bool liveMode) { liveMode_ = liveMode; }
+    // input_type 为 raw 时使用, 须在应用启动前调用
+    void         SetRawConfig(const RawInputConfig &config)
+    {
+        rawConfig_ = config;
+    }
+    // input_type 为 pic 时使用, 须在应用启动前调用
+    void         SetPicConfig(const PicInputConfig &config)
+    {
+        picConfig_ = config;
+    }
+    // 运动门控: 无运动的帧不做检测, 按跳帧路由. 须在应用启动前调用
+    void         SetMotionGateConfig(const MotionGateConfig &config)
+    {
+        motionGateConfig_ = config;
+    }
+    // 须在应用启动前调用, 启用时 frame_decimation 为初始值
+    void         SetAdaptiveDecimation(const AdaptiveDecimationConfig &config)
+    {
+        adaptiveConfig_ = config;
+    }
+    // video/rtsp 的解码后端(vdec/软解/自动), 须在应用启动前调用
+    void         SetDecodeConfig(const VideoDecodeConfig &config)
+    {
+        decodeConfig_ = config;
+    }
+    // 可在任意线程调用, 从下一次读帧开始生效
+    void         UpdateTuning(std::shared_ptr<const InputTuning> tuning);
     AclLiteError Init();
     AclLiteError Process(int msgId, std::shared_ptr<void> msgData);
 
@@ -54,9 +134,19 @@ class DataInputThread : public AclLiteThread
     AclLiteError MsgSend(std::shared_ptr<DetectDataMsg> &detectDataMsg);
     AclLiteError OpenPicsDir();
     AclLiteError OpenVideoCapture();
+    AclLiteError OpenRawVideo();
     AclLiteError ReadPic(std::shared_ptr<DetectDataMsg> &detectDataMsg);
     AclLiteError ReadStream(std::shared_ptr<DetectDataMsg> &detectDataMsg);
+    AclLiteError ReadRaw(std::shared_ptr<DetectDataMsg> &detectDataMsg);
+    AclLiteError CopyRawToDvpp(ImageData &dvppImg, ImageData &hostImg);
     AclLiteError GetOneFrame(std::shared_ptr<DetectDataMsg> &detectDataMsg);
+    void         ApplyTuning(const InputTuning &tuning);
+    void         InitMotionGate();
+    void         InitAdaptiveDecimation();
+    void         UpdateDecimation();
+    int          EffectiveDecimation() const;
+    bool         DetectMotion(std::shared_ptr<DetectDataMsg> &detectDataMsg);
+    void         ApplyMotionGate(std::shared_ptr<DetectDataMsg> &detectDataMsg);
 
   private:
     uint32_t deviceId_;
@@ -69,14 +159,27 @@ class DataInputThread : public AclLiteThread
 
     std::string inputDataType_;
     std::string inputDataPath_;
-    std::string inferName_;
-    std::string outputType_;
+    std::string    outputType_;
+    DataInputRoute route_;
     int         postThreadNum_;
     int         postproId_;
 
     aclrtRunMode      runMode_;
     AclLiteVideoProc *cap_;
-    AclLiteImageProc  dvpp_;
+    RawVideoReader   *raw_;       // input_type 为 raw
+    RawInputConfig    rawConfig_;
+    VideoDecodeConfig decodeConfig_;
+    PicDirReader     *picReader_; // input_type 为 pic
+    PicInputConfig    picConfig_;
+    MotionGateConfig  motionGateConfig_;
+    MotionGate       *motionGate_;   // 未启用时为空
+    bool              motionPending_; // 上次检测后出现过运动
+    bool              forcedPending_; // 上次检测后门控要求过强制检测
+    AclLiteCounter   *motionFrames_;  // 有运动而检测的帧
+    AclLiteCounter   *motionSkipped_; // 无运动而跳过检测的帧
+    AclLiteCounter   *motionForced_;  // 连续无运动后强制检测的帧
+    AclLiteGauge     *motionActivity_; // 最近一帧活动格比例, 百万分之一
+    AclLiteHistogram *motionGateTime_; // 门控计算耗时
 
     int                      selfThreadId_;
     int                      preThreadId_;
@@ -87,11 +190,18 @@ class DataInputThread : public AclLiteThread
     int                      hdmiDisplayThreadId_;
     std::vector<std::string> fileVec_;
 
-    int64_t lastDecodeTime_;
-    int64_t realWaitTime_;
-    int64_t waitTime_;
-    int     framesPerSecond_;
+    int     framesPerSecond_; // 视频/rtsp 按码流 pts 节流到此帧率
+    bool    liveMode_;        // latency_mode 为 live
     int     frameSkip_;  // 跳帧参数: 跳过 frameSkip_ 帧; 0 = 不跳帧 (process every frame)
+    // ============ 自适应跳帧 ============
+    AdaptiveDecimationConfig           adaptiveConfig_;
+    std::vector<AclLiteStageMetrics *> downstreamStages_; // 检测链路各线程
+    AclLiteHistogram                  *inferTime_;  // 推理线程 execute 耗时
+    uint64_t                           inferCount_; // 上个周期末的样本数
+    uint64_t                           inferSumUs_; // 上个周期末的累计耗时
+    int64_t                            lastAdaptUs_;
+    int                                calmWindows_; // 连续空闲的周期数
+    AclLiteGauge                      *decimationGauge_;
     
     // ============ 跟踪状态管理 ============
     int     trackThreadId_;              // 跟踪线程id
@@ -110,6 +220,14 @@ class DataInputThread : public AclLiteThread
     bool    trackingValidationEnabled_;  // 是否启用检测验证跟踪
     int     trackingValidationInterval_; // 检测验证间隔帧数
     int     trackingValidationFrameCount_; // 跟踪内计数
+    AclLiteSnapshot<InputTuning>       tuning_;        // 热更新参数
+    std::shared_ptr<const InputTuning> appliedTuning_; // 最近一次应用的快照
+
+    // 通道代数, 跟踪丢失时递增, 使在途的检测帧失效
+    std::shared_ptr<std::atomic<uint32_t>> epoch_;
+
+    // 本通道帧消息对象池, 最后一个阶段释放后复位并回收
+    ObjectPool<DetectDataMsg> msgPool_;
 };
 
 #endif
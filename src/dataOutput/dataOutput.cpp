@@ -29,11 +29,22 @@ using namespace std;
 
 namespace
 {
-const uint32_t kSleepTime = 500;
 uint32_t       kWaitTime = 1000;
 const uint32_t kOneSec = 1000000;
 const uint32_t kOneMSec = 1000;
 const uint32_t kCountFps = 100;
+// 实时输出落后时每次最多取出的帧数, 只绘制发送其中最新的一帧
+const uint32_t kOutputMaxBatch = 8;
+const uint32_t kDefaultVideoFps = 15;
+
+// DVPP 缩放得到的新图不带时间, 从原图带过去, 推流按它打时间戳
+void CopyFrameTime(ImageData &dst, const ImageData &src)
+{
+    dst.ptsUs = src.ptsUs;
+    dst.captureUs = src.captureUs;
+    dst.decodeUs = src.decodeUs;
+    dst.streamGap = src.streamGap;
+}
 } // namespace
 
 DataOutputThread::DataOutputThread(aclrtRunMode &runMode,
@@ -46,8 +57,24 @@ DataOutputThread::DataOutputThread(aclrtRunMode &runMode,
             outputPath_(outputPath),
             shutdown_(0),
             postNum_(postThreadNum),
-            g_vencConfig(vencConfig)
+            g_vencConfig(vencConfig),
+            e2eLatency_(nullptr),
+            captureLatency_(nullptr),
+            outputNum_(nullptr),
+            outOfOrderNum_(nullptr),
+            supersededNum_(nullptr),
+            displayDropNum_(nullptr),
+            deferOutput_(false),
+            videoClock_(vencConfig.outputFps > 0 ? vencConfig.outputFps
+                                                 : kDefaultVideoFps),
+            videoFrameNum_(0)
 {
+    // 文件类输出保留每一帧, 实时输出只关心最新画面
+    if (outputDataType_ == "rtsp" || outputDataType_ == "hdmi" ||
+        outputDataType_ == "imshow")
+    {
+        SetMaxBatchSize(kOutputMaxBatch);
+    }
 }
 
 DataOutputThread::~DataOutputThread()
@@ -64,7 +91,8 @@ AclLiteError DataOutputThread::SetOutputVideo()
     stringstream sstream;
     sstream.str("");
     sstream << outputPath_;
-    int fps = g_vencConfig.outputFps > 0 ? g_vencConfig.outputFps : 15;
+    int fps = g_vencConfig.outputFps > 0 ? g_vencConfig.outputFps
+                                         : kDefaultVideoFps;
     outputVideo_.open(sstream.str(),
                       cv::VideoWriter::fourcc('m', 'p', '4', 'v'),
                       fps,
@@ -95,13 +123,23 @@ AclLiteError DataOutputThread::Init()
     {
         kWaitTime = 1;
     }
+    e2eLatency_ = AclLiteMetrics::GetInstance().GetHistogram(
+        SelfInstanceName() + ".e2e");
+    captureLatency_ = AclLiteMetrics::GetInstance().GetHistogram(
+        SelfInstanceName() + ".capture_latency");
+    outputNum_ = AclLiteMetrics::GetInstance().GetCounter(
+        SelfInstanceName() + ".output_frames");
+    outOfOrderNum_ = AclLiteMetrics::GetInstance().GetCounter(
+        SelfInstanceName() + ".out_of_order_drop");
+    supersededNum_ = AclLiteMetrics::GetInstance().GetCounter(
+        SelfInstanceName() + ".superseded_drop");
+    displayDropNum_ = AclLiteMetrics::GetInstance().GetCounter(
+        SelfInstanceName() + ".display_drop");
     return ACLLITE_OK;
 }
 
 AclLiteError DataOutputThread::Process(int msgId, shared_ptr<void> data)
 {
-    auto start = std::chrono::high_resolution_clock::now();
-    
     AclLiteError ret = ACLLITE_OK;
     switch (msgId)
     {
@@ -133,21 +171,42 @@ AclLiteError DataOutputThread::Process(int msgId, shared_ptr<void> data)
                          msgId);
         break;
     }
-    
-    auto end = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
-    if (msgId == MSG_OUTPUT_FRAME) {
-        static int logCount = 0;
-        if (++logCount % 30 == 0) {
-            ACLLITE_LOG_INFO("[DataOutputThread] Process time: %ld ms", duration);
-        }
-    }
 
     return ret;
 }
 
+AclLiteError DataOutputThread::ProcessBatch(vector<AclLiteThreadMsg> &msgs)
+{
+    // 积压时一次取出多帧: 乱序等检查在处理时完成, 通过的帧只暂存,
+    // 被同批之后通过的帧取代, 整批处理完才绘制发送最后一帧
+    deferOutput_ = true;
+    AclLiteError ret = ACLLITE_OK;
+    for (size_t i = 0; i < msgs.size() && ret == ACLLITE_OK; i++)
+    {
+        ret = Process(msgs[i].msgId, msgs[i].data);
+        msgs[i].data = nullptr;
+    }
+    deferOutput_ = false;
+    AclLiteError flushRet = FlushDeferredFrame();
+    return ret != ACLLITE_OK ? ret : flushRet;
+}
+
+AclLiteError DataOutputThread::FlushDeferredFrame()
+{
+    if (deferredFrame_ == nullptr)
+    {
+        return ACLLITE_OK;
+    }
+    shared_ptr<DetectDataMsg> detectDataMsg = deferredFrame_;
+    deferredFrame_ = nullptr;
+    return OutputFrame(detectDataMsg);
+}
+
 AclLiteError DataOutputThread::ShutDownProcess()
 {
+    // 结束前的帧都要送出, 不再暂存
+    FlushDeferredFrame();
+    deferOutput_ = false;
     for (int i = 0; i < postNum_; i++)
     {
         if (!postQueue_[i].empty())
@@ -160,7 +219,7 @@ AclLiteError DataOutputThread::ShutDownProcess()
     }
     if (outputDataType_ != "rtsp" && outputDataType_ != "hdmi")
     {
-        SendMessage(g_MainThreadId, MSG_APP_EXIT, nullptr);
+        SendMessage(g_MainThreadId, MSG_APP_EXIT, nullptr, ACLLITE_PRIO_HIGH);
     }
     return ACLLITE_OK;
 }
@@ -209,8 +268,8 @@ DataOutputThread::ProcessOutput(shared_ptr<DetectDataMsg> detectDataMsg)
     auto last_it = lastOutputMsgNum_.find(channel_id);
     if (last_it != lastOutputMsgNum_.end() && current_msg <= last_it->second)
     {
-        static int drop_count = 0; // 乱序/回退帧计数
-        if (++drop_count % 30 == 0)
+        outOfOrderNum_->Add();
+        if (outOfOrderNum_->Get() % 30 == 0)
         {
             ACLLITE_LOG_WARNING(
                 "[DataOutput] Drop out-of-order frame: ch=%d, msg=%d, last=%d",
@@ -220,24 +279,40 @@ DataOutputThread::ProcessOutput(shared_ptr<DetectDataMsg> detectDataMsg)
         }
         return ACLLITE_OK;
     }
+    if (deferOutput_)
+    {
+        // 先更新缓存结果与帧序号, 保证后续帧的复用与顺序检查;
+        // 之前暂存的帧被本帧取代, 不再绘制和发送
+        if (deferredFrame_ != nullptr)
+        {
+            supersededNum_->Add();
+        }
+        UpdateCachedResult(detectDataMsg);
+        lastOutputMsgNum_[channel_id] = current_msg;
+        deferredFrame_ = detectDataMsg;
+        return ACLLITE_OK;
+    }
+    return OutputFrame(detectDataMsg);
+}
 
+AclLiteError
+DataOutputThread::OutputFrame(shared_ptr<DetectDataMsg> detectDataMsg)
+{
     // Calculate end-to-end latency
     struct timeval tv;
     gettimeofday(&tv, nullptr);
     int64_t endTimestamp = tv.tv_sec * 1000000 + tv.tv_usec;
-    int64_t latencyUs = endTimestamp - detectDataMsg->startTimestamp;
-    double latencyMs = latencyUs / 1000.0;
-    
-    static int logCount = 0;
-    if (++logCount % 30 == 0) {
-        ACLLITE_LOG_INFO("[E2E Latency] Frame %d: %.2f ms (from DataInput to DataOutput)", 
-                         detectDataMsg->msgNum, latencyMs);
+    e2eLatency_->Record(endTimestamp - detectDataMsg->startTimestamp);
+    if (detectDataMsg->captureUs > 0)
+    {
+        captureLatency_->Record(AclLiteNowUs() - detectDataMsg->captureUs);
     }
     
     // YUV color map for drawing (only draw on YUV, no BGR drawing)
     static const YUVColor kYUVColorTracking = YUVColor(149, 100, 237);  // Purple for tracking
     static const YUVColor kYUVColorDetection = YUVColor(215, 255, 0);   // Cyan for detections
 
+    int drawSpan = detectDataMsg->trace.Begin("draw");
     if (!detectDataMsg->decodedImg.empty())
     {
         // If tracking is active: only draw tracking box and text
@@ -325,6 +400,7 @@ DataOutputThread::ProcessOutput(shared_ptr<DetectDataMsg> detectDataMsg)
             }
         }
     }
+    detectDataMsg->trace.End(drawSpan);
 
     AclLiteError ret;
     if (outputDataType_ == "video")
@@ -386,7 +462,8 @@ DataOutputThread::ProcessOutput(shared_ptr<DetectDataMsg> detectDataMsg)
     }
 
     UpdateCachedResult(detectDataMsg);
-    lastOutputMsgNum_[channel_id] = current_msg;
+    lastOutputMsgNum_[detectDataMsg->channelId] = detectDataMsg->msgNum;
+    outputNum_->Add();
 
     return ACLLITE_OK;
 }
@@ -448,12 +525,34 @@ DataOutputThread::SaveResultVideo(shared_ptr<DetectDataMsg> &detectDataMsg)
         resizedFrame = cv::Mat((int)g_vencConfig.outputHeight, (int)g_vencConfig.outputWidth, CV_8UC3);
     }
     
+    // cv::VideoWriter 只能按固定帧率写, 帧的时间由它在文件中的位置决定:
+    // 源时间轴上超前的帧重复写入补齐, 落在已写帧位上的帧丢弃, 录像时长与
+    // 源保持一致, 不随处理速度漂移
+    int64_t intervalUs = videoClock_.FrameIntervalUs();
     for (int i = 0; i < detectDataMsg->frame.size(); i++)
     {
-        cv::resize(detectDataMsg->frame[i], resizedFrame,
+        int64_t streamUs = -1;
+        if (i < detectDataMsg->decodedImg.size())
+        {
+            const ImageData &img = detectDataMsg->decodedImg[i];
+            streamUs = videoClock_.Map(img.ptsUs, img.captureUs, img.streamGap);
+        }
+        else
+        {
+            streamUs = videoClock_.Map(-1, 0, false);
+        }
+        int64_t slot = (streamUs + intervalUs / 2) / intervalUs;
+        if (slot < videoFrameNum_)
+        {
+            continue;
+        }
+        cv::resize(detectDataMsg->frame[i].Full(), resizedFrame,
                cv::Size(g_vencConfig.outputWidth, g_vencConfig.outputHeight),
                    0, 0, cv::INTER_LINEAR);
-        outputVideo_ << resizedFrame;
+        for (; videoFrameNum_ <= slot; videoFrameNum_++)
+        {
+            outputVideo_ << resizedFrame;
+        }
     }
     return ACLLITE_OK;
 }
@@ -468,7 +567,7 @@ DataOutputThread::SaveResultPic(shared_ptr<DetectDataMsg> &detectDataMsg)
     {
         snprintf(filepath, sizeof(filepath), "../out/channel_%d_out_pic_%d%d.jpg",
                  detectDataMsg->channelId, detectDataMsg->msgNum, i);
-        cv::imwrite(filepath, detectDataMsg->frame[i]);
+        cv::imwrite(filepath, detectDataMsg->frame[i].Full());
     }
     return ACLLITE_OK;
 }
@@ -523,7 +622,7 @@ DataOutputThread::SendCVImshow(shared_ptr<DetectDataMsg> &detectDataMsg)
     
     for (int i = 0; i < detectDataMsg->frame.size(); i++)
     {
-        cv::resize(detectDataMsg->frame[i], resizedFrame,
+        cv::resize(detectDataMsg->frame[i].Full(), resizedFrame,
                cv::Size(g_vencConfig.outputWidth, g_vencConfig.outputHeight));
         cv::imshow("frame", resizedFrame);
         cv::waitKey(kWaitTime);
@@ -534,48 +633,39 @@ DataOutputThread::SendCVImshow(shared_ptr<DetectDataMsg> &detectDataMsg)
 AclLiteError
 DataOutputThread::DisplayMsgSend(shared_ptr<DetectDataMsg> detectDataMsg)
 {
-    AclLiteError ret;
-    int retryCount = 0;
-    const int maxRetry = 3;  // 最多重试3次,避免阻塞
-    
-    while (retryCount < maxRetry)
+    AclLiteTraceScope span(detectDataMsg->trace, "encode_enqueue");
+    AclLiteError      ret = ACLLITE_OK;
+    // 显示队列满时的处理方式由 display 边的发送策略决定(默认短暂阻塞后丢帧)
+    if (outputDataType_ == "rtsp")
     {
-        if (outputDataType_ == "rtsp")
-        {
-            ret = SendMessage(detectDataMsg->rtspDisplayThreadId,
-                              MSG_RTSP_DISPLAY,
-                              detectDataMsg);
-        }
-        else if (outputDataType_ == "hdmi")
-        {
-            ret = SendMessage(detectDataMsg->hdmiDisplayThreadId,
-                              MSG_HDMI_DISPLAY,
-                              detectDataMsg);
-        }
-        if (ret == ACLLITE_ERROR_ENQUEUE)
-        {
-            retryCount++;
-            if (retryCount >= maxRetry) {
-                // 队列满,丢弃此帧
-                static int dropCount = 0;
-                if (++dropCount % 30 == 0) {
-                    ACLLITE_LOG_INFO("[DataOutput] Dropped %d frames due to rtsp queue full", dropCount);
-                }
-                return ACLLITE_OK;  // 返回OK,继续处理下一帧
-            }
-            usleep(kSleepTime);
-            continue;
-        }
-        else if (ret == ACLLITE_OK)
-        {
-            break;
-        }
-        else
-        {
-            ACLLITE_LOG_ERROR("Send rtsp display message failed, error %d",
-                              ret);
-            return ret;
+        ret = SendMessageByPolicy(detectDataMsg->rtspDisplayThreadId,
+                                  MSG_RTSP_DISPLAY,
+                                  detectDataMsg);
+    }
+    else if (outputDataType_ == "hdmi")
+    {
+        ret = SendMessageByPolicy(detectDataMsg->hdmiDisplayThreadId,
+                                  MSG_HDMI_DISPLAY,
+                                  detectDataMsg);
+    }
+    if (ret == ACLLITE_ERROR_MSG_DROPPED)
+    {
+        // 队列满,丢弃此帧
+        displayDropNum_->Add();
+        uint64_t dropNum = displayDropNum_->Get();
+        if (dropNum % 30 == 0) {
+            ACLLITE_LOG_INFO("[%s] Dropped %lu frames due to %s queue full",
+                             SelfInstanceName().c_str(),
+                             (unsigned long)dropNum,
+                             outputDataType_.c_str());
         }
+        return ACLLITE_OK;  // 返回OK,继续处理下一帧
+    }
+    else if (ret != ACLLITE_OK)
+    {
+        ACLLITE_LOG_ERROR("Send rtsp display message failed, error %d",
+                          ret);
+        return ret;
     }
 
     return ACLLITE_OK;
@@ -585,6 +675,7 @@ AclLiteError
 DataOutputThread::SendImageToRtsp(shared_ptr<DetectDataMsg> &detectDataMsg)
 {
     // Resize 图像到推流分辨率: 使用 DVPP 进行 YUV Resize 并替换 decodedImg
+    int span = detectDataMsg->trace.Begin("output_resize");
     for (int i = 0; i < detectDataMsg->decodedImg.size(); i++) {
         ImageData &srcImg = detectDataMsg->decodedImg[i];
         if (srcImg.width != g_vencConfig.outputWidth || srcImg.height != g_vencConfig.outputHeight) {
@@ -595,22 +686,18 @@ DataOutputThread::SendImageToRtsp(shared_ptr<DetectDataMsg> &detectDataMsg)
                 return ACLLITE_ERROR;
             }
             // replace decoded image with resized one
+            CopyFrameTime(resizedImg, srcImg);
             detectDataMsg->decodedImg[i] = resizedImg;
-            // 同时更新对应的 cv::Mat frame，以便 video/show 使用（拷贝到Host）
+            // 同时更新对应的 frame（拷贝到Host），BGR 仅在用到时转换
             ImageData hostImg;
             ret = CopyImageToLocal(hostImg, resizedImg, runMode_);
             if (ret == ACLLITE_OK) {
-                cv::Mat yuvimg(hostImg.height * 3 / 2,
-                               hostImg.width,
-                               CV_8UC1,
-                               hostImg.data.get());
-                cv::Mat bgr;
-                cv::cvtColor(yuvimg, bgr, CV_YUV2BGR_NV12);
-                detectDataMsg->frame[i] = bgr;
+                detectDataMsg->frame[i] = BgrFrameView(hostImg);
             }
         }
     }
-    
+    detectDataMsg->trace.End(span);
+
     AclLiteError ret = DisplayMsgSend(detectDataMsg);
     if (ret != ACLLITE_OK)
     {
@@ -625,6 +712,7 @@ AclLiteError
 DataOutputThread::SendImageToHdmi(shared_ptr<DetectDataMsg> &detectDataMsg)
 {
     // 调整尺寸到HDMI输出分辨率（NV12）
+    int span = detectDataMsg->trace.Begin("output_resize");
     for (int i = 0; i < detectDataMsg->decodedImg.size(); i++) {
         ImageData &srcImg = detectDataMsg->decodedImg[i];
         if (srcImg.width != g_vencConfig.outputWidth || srcImg.height != g_vencConfig.outputHeight) {
@@ -634,9 +722,11 @@ DataOutputThread::SendImageToHdmi(shared_ptr<DetectDataMsg> &detectDataMsg)
                 ACLLITE_LOG_ERROR("Dvpp resize in DataOutput (hdmi) failed, error %d", ret);
                 return ACLLITE_ERROR;
             }
+            CopyFrameTime(resizedImg, srcImg);
             detectDataMsg->decodedImg[i] = resizedImg;
         }
     }
+    detectDataMsg->trace.End(span);
 
     AclLiteError ret = DisplayMsgSend(detectDataMsg);
     if (ret != ACLLITE_OK)
@@ -22,12 +22,14 @@
 
 #include "AclLiteApp.h"
 #include "AclLiteError.h"
+#include "AclLiteMetrics.h"
 #include "AclLiteThread.h"
 #include "AclLiteUtils.h"
 #include "Params.h"
 #include "acl/acl.h"
 #include "AclLiteType.h"
 #include "AclLiteImageProc.h"
+#include "StreamClock.h"
 #include <iostream>
 #include <mutex>
 #include <queue>
@@ -46,6 +48,7 @@ class DataOutputThread : public AclLiteThread
 
     AclLiteError Init();
     AclLiteError Process(int msgId, std::shared_ptr<void> data);
+    AclLiteError ProcessBatch(std::vector<AclLiteThreadMsg> &msgs);
 
   private:
     AclLiteError SetOutputVideo();
@@ -53,6 +56,8 @@ class DataOutputThread : public AclLiteThread
     AclLiteError RecordQueue(std::shared_ptr<DetectDataMsg> detectDataMsg);
     AclLiteError DataProcess();
     AclLiteError ProcessOutput(std::shared_ptr<DetectDataMsg> detectDataMsg);
+    AclLiteError OutputFrame(std::shared_ptr<DetectDataMsg> detectDataMsg);
+    AclLiteError FlushDeferredFrame();
 
     AclLiteError SaveResultVideo(std::shared_ptr<DetectDataMsg> &detectDataMsg);
     AclLiteError SaveResultPic(std::shared_ptr<DetectDataMsg> &detectDataMsg);
@@ -96,6 +101,18 @@ class DataOutputThread : public AclLiteThread
     };
     std::unordered_map<uint32_t, CachedResult> lastResults_;
     std::unordered_map<uint32_t, int>          lastOutputMsgNum_; // 每路通道最后输出的帧序号
+    AclLiteHistogram                          *e2eLatency_; // 读帧到输出的端到端时延
+    AclLiteHistogram                          *captureLatency_; // 输入收到帧到输出的时延
+    AclLiteCounter                            *outputNum_;  // 已输出帧数, 用于统计 fps
+    AclLiteCounter                            *outOfOrderNum_; // 乱序/回退丢弃帧数
+    AclLiteCounter                            *supersededNum_; // 被同批更新帧取代而未绘制发送的帧数
+    AclLiteCounter                            *displayDropNum_; // 显示队列满丢弃的帧数
+    // 批处理时通过检查的帧先暂存, 整批处理完只绘制发送最后一帧
+    bool                                       deferOutput_;
+    std::shared_ptr<DetectDataMsg>             deferredFrame_;
+    // video 输出为定帧率写入, 按源时间轴决定每帧落在第几帧位(补帧或丢帧)
+    StreamClock                                videoClock_;
+    int64_t                                    videoFrameNum_; // 已写入的帧位数
 };
 
 #endif
@@ -31,9 +31,17 @@ namespace
 const uint32_t kSleepTime = 500;
 }
 
-DetectInferenceThread::DetectInferenceThread(string modelPath)
-    : model_(modelPath), isReleased(false)
+DetectInferenceThread::DetectInferenceThread(string   modelPath,
+                                             uint32_t batch,
+                                             uint32_t batchDeadlineUs)
+    : model_(modelPath), isReleased(false), executeTime_(nullptr),
+      batch_(batch), slotSize_(0), slotNum_(nullptr), paddedNum_(nullptr)
 {
+    if (batch_ > 1 && batchDeadlineUs > 0)
+    {
+        SetMaxBatchSize(batch_);
+        SetBatchDeadline(batchDeadlineUs);
+    }
 }
 
 DetectInferenceThread::~DetectInferenceThread()
@@ -53,12 +61,38 @@ AclLiteError DetectInferenceThread::Init()
         ACLLITE_LOG_ERROR("Model init failed, error:%d", ret);
         return ret;
     }
+    executeTime_ = AclLiteMetrics::GetInstance().GetHistogram(
+        SelfInstanceName() + ".execute");
     modelOutputInfo_.clear();
     ret = model_.GetModelOutputInfo(modelOutputInfo_);
     if (ret != ACLLITE_OK || modelOutputInfo_.empty())
     {
         ACLLITE_LOG_WARNING("Get model output info failed, fallback to size only");
     }
+    if (GetMaxBatchSize() > 1)
+    {
+        size_t inputSize = model_.GetModelInputSize(0);
+        slotSize_ = inputSize / batch_;
+        void *buf = nullptr;
+        aclError aclRet =
+            aclrtMalloc(&buf, inputSize, ACL_MEM_MALLOC_HUGE_FIRST);
+        if ((buf == nullptr) || (aclRet != ACL_SUCCESS))
+        {
+            ACLLITE_LOG_ERROR("Malloc batch input buffer failed, error %d",
+                              aclRet);
+            return ACLLITE_ERROR;
+        }
+        batchInput_ = SHARED_PTR_DEV_BUF(buf);
+        slotNum_ = AclLiteMetrics::GetInstance().GetCounter(
+            SelfInstanceName() + ".batch_slots");
+        paddedNum_ = AclLiteMetrics::GetInstance().GetCounter(
+            SelfInstanceName() + ".padded_slots");
+        ACLLITE_LOG_INFO("%s batches frames of all channels, batch %u, "
+                         "deadline %u us",
+                         SelfInstanceName().c_str(),
+                         batch_,
+                         GetBatchDeadline());
+    }
     return ACLLITE_OK;
 }
 
@@ -74,7 +108,10 @@ DetectInferenceThread::ModelExecute(shared_ptr<DetectDataMsg> detectDataMsg)
         return ACLLITE_ERROR;
     }
 
-    ret = model_.ExecuteV2(detectDataMsg->inferenceOutput);
+    {
+        AclLiteScopeTimer timer(executeTime_);
+        ret = model_.ExecuteV2(detectDataMsg->inferenceOutput);
+    }
     if (ret != ACLLITE_OK)
     {
         ACLLITE_LOG_ERROR("Execute detect model inference failed, error: %d",
@@ -90,28 +127,98 @@ DetectInferenceThread::ModelExecute(shared_ptr<DetectDataMsg> detectDataMsg)
     return ACLLITE_OK;
 }
 
-AclLiteError
-DetectInferenceThread::MsgSend(shared_ptr<DetectDataMsg> detectDataMsg)
+AclLiteError DetectInferenceThread::BatchExecute()
 {
-    while (1)
+    uint32_t num = slotMsgs_.size();
+    uint8_t *base = (uint8_t *)batchInput_.get();
+    for (uint32_t i = 0; i < num; i++)
     {
-        AclLiteError ret = SendMessage(detectDataMsg->detectPostThreadId,
-                                       MSG_POSTPROC_DETECTDATA,
-                                       detectDataMsg);
-        if (ret == ACLLITE_ERROR_ENQUEUE)
+        ImageData &input = slotMsgs_[i]->modelInputImg;
+        aclError aclRet = aclrtMemcpy(base + i * slotSize_,
+                                      slotSize_,
+                                      input.data.get(),
+                                      slotSize_,
+                                      ACL_MEMCPY_DEVICE_TO_DEVICE);
+        input.data = nullptr; // 拷入整批输入后即可释放
+        if (aclRet != ACL_SUCCESS)
         {
-            usleep(kSleepTime);
-            continue;
+            ACLLITE_LOG_ERROR("Copy batch slot %u input failed, error: %d",
+                              i, aclRet);
+            return ACLLITE_ERROR;
         }
-        else if (ret == ACLLITE_OK)
+    }
+    if (num < batch_)
+    {
+        uint32_t padSize = (batch_ - num) * slotSize_;
+        aclError aclRet =
+            aclrtMemset(base + num * slotSize_, padSize, 0, padSize);
+        if (aclRet != ACL_SUCCESS)
         {
-            break;
+            ACLLITE_LOG_ERROR("Pad batch slots %u-%u failed, error: %d",
+                              num, batch_ - 1, aclRet);
+            return ACLLITE_ERROR;
         }
-        else
+    }
+    slotNum_->Add(batch_);
+    paddedNum_->Add(batch_ - num);
+
+    AclLiteError ret = model_.CreateInput(base, slotSize_ * batch_);
+    if (ret != ACLLITE_OK)
+    {
+        ACLLITE_LOG_ERROR("Create model input dataset failed");
+        return ACLLITE_ERROR;
+    }
+    vector<InferenceOutput> outputs;
+    {
+        AclLiteScopeTimer timer(executeTime_);
+        ret = model_.ExecuteV2(outputs);
+    }
+    model_.DestroyInput();
+    if (ret != ACLLITE_OK)
+    {
+        ACLLITE_LOG_ERROR("Execute detect model inference failed, error: %d",
+                          ret);
+        return ACLLITE_ERROR;
+    }
+    // 每个槽位取输出的第 i 段, 与整批输出共享所有权
+    for (uint32_t i = 0; i < num; i++)
+    {
+        shared_ptr<DetectDataMsg> &detectDataMsg = slotMsgs_[i];
+        for (const InferenceOutput &output : outputs)
         {
-            ACLLITE_LOG_ERROR("Send read frame message failed, error %d", ret);
-            return ret;
+            InferenceOutput slot;
+            slot.size = output.size / batch_;
+            slot.data = shared_ptr<void>(
+                output.data, (uint8_t *)output.data.get() + i * slot.size);
+            detectDataMsg->inferenceOutput.push_back(slot);
         }
+        if (!modelOutputInfo_.empty())
+        {
+            detectDataMsg->detectOutputDims = modelOutputInfo_[0].dims;
+            detectDataMsg->detectOutputDims.dims[0] = 1;
+            detectDataMsg->hasDetectOutputDims = true;
+        }
+    }
+    return ACLLITE_OK;
+}
+
+AclLiteError
+DetectInferenceThread::MsgSend(shared_ptr<DetectDataMsg> detectDataMsg)
+{
+    // 最后一帧不能被丢弃, 始终阻塞发送
+    AclLiteError ret =
+        detectDataMsg->isLastFrame
+            ? SendMessage(detectDataMsg->detectPostThreadId,
+                          MSG_POSTPROC_DETECTDATA,
+                          detectDataMsg,
+                          ACLLITE_SEND_BLOCK)
+            : SendMessageByPolicy(detectDataMsg->detectPostThreadId,
+                                  MSG_POSTPROC_DETECTDATA,
+                                  detectDataMsg);
+    if (ret != ACLLITE_OK && ret != ACLLITE_ERROR_MSG_DROPPED)
+    {
+        ACLLITE_LOG_ERROR("Send read frame message failed, error %d", ret);
+        return ret;
     }
 
     // FIXME: Send MSG_INFER_DONE to DataInputThread for flow control
@@ -141,27 +248,88 @@ DetectInferenceThread::MsgSend(shared_ptr<DetectDataMsg> detectDataMsg)
 
 AclLiteError DetectInferenceThread::Process(int msgId, shared_ptr<void> data)
 {
-    auto start = std::chrono::high_resolution_clock::now();
-    
+    if (GetMaxBatchSize() > 1)
+    {
+        // 队列中只有一帧, 也按组批处理(补零)
+        vector<AclLiteThreadMsg> msgs(1);
+        msgs[0].msgId = msgId;
+        msgs[0].data = data;
+        return ProcessBatch(msgs);
+    }
     switch (msgId)
     {
     case MSG_DO_DETECT_INFER:
-        ModelExecute(static_pointer_cast<DetectDataMsg>(data));
-        MsgSend(static_pointer_cast<DetectDataMsg>(data));
+    {
+        shared_ptr<DetectDataMsg> detectDataMsg =
+            static_pointer_cast<DetectDataMsg>(data);
+        // 过期帧不占用 NPU, 直接透传
+        int span = detectDataMsg->trace.Begin("inference");
+        if (!detectDataMsg->IsStale())
+        {
+            ModelExecute(detectDataMsg);
+        }
+        detectDataMsg->trace.End(span);
+        MsgSend(detectDataMsg);
         break;
+    }
     default:
         ACLLITE_LOG_INFO("Inference thread ignore msg %d", msgId);
         break;
     }
-    
-    auto end = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
-    if (msgId == MSG_DO_DETECT_INFER) {
-        static int logCount = 0;
-        if (++logCount % 30 == 0) {
-            ACLLITE_LOG_INFO("[DetectInferenceThread] Process time: %ld ms", duration);
+
+    return ACLLITE_OK;
+}
+
+int DetectInferenceThread::ProcessBatch(vector<AclLiteThreadMsg> &msgs)
+{
+    batchMsgs_.clear();
+    slotMsgs_.clear();
+    batchSpans_.clear();
+    for (AclLiteThreadMsg &msg : msgs)
+    {
+        if (msg.msgId != MSG_DO_DETECT_INFER)
+        {
+            ACLLITE_LOG_INFO("Inference thread ignore msg %d", msg.msgId);
+            continue;
         }
+        shared_ptr<DetectDataMsg> detectDataMsg =
+            static_pointer_cast<DetectDataMsg>(msg.data);
+        msg.data = nullptr;
+        batchSpans_.push_back(detectDataMsg->trace.Begin("inference"));
+        // 过期帧与没有图像的结束帧不占槽位, 直接透传
+        if (!detectDataMsg->IsStale() &&
+            detectDataMsg->modelInputImg.data != nullptr)
+        {
+            if (detectDataMsg->modelInputImg.size == slotSize_)
+            {
+                slotMsgs_.push_back(detectDataMsg);
+            }
+            else
+            {
+                ACLLITE_LOG_ERROR("Channel %u model input size %u does not "
+                                  "match batch slot size %u",
+                                  detectDataMsg->channelId,
+                                  detectDataMsg->modelInputImg.size,
+                                  slotSize_);
+            }
+        }
+        batchMsgs_.push_back(detectDataMsg);
     }
-
+    if (!slotMsgs_.empty() && BatchExecute() != ACLLITE_OK)
+    {
+        // 推理失败的帧不带检测结果透传
+        for (shared_ptr<DetectDataMsg> &detectDataMsg : slotMsgs_)
+        {
+            detectDataMsg->inferenceOutput.clear();
+        }
+    }
+    // 按到达顺序发送, 同一通道的帧保持原有顺序
+    for (size_t i = 0; i < batchMsgs_.size(); i++)
+    {
+        batchMsgs_[i]->trace.End(batchSpans_[i]);
+        MsgSend(batchMsgs_[i]);
+    }
+    batchMsgs_.clear();
+    slotMsgs_.clear();
     return ACLLITE_OK;
 }
@@ -20,6 +20,7 @@
 #define DETECTINFERENCETHREAD_H
 #pragma once
 
+#include "AclLiteMetrics.h"
 #include "AclLiteModel.h"
 #include "AclLiteThread.h"
 #include "Params.h"
@@ -32,19 +33,36 @@
 class DetectInferenceThread : public AclLiteThread
 {
   public:
-    DetectInferenceThread(std::string modelPath);
+    // batch > 1 且 batchDeadlineUs > 0 时跨通道组批: 每条消息只带一帧,
+    // 多个通道的帧凑满 batch 或第一帧等待超过 batchDeadlineUs 后一起推理,
+    // 不足的槽位补零, 输出按槽位切分回各帧的消息
+    DetectInferenceThread(std::string modelPath,
+                          uint32_t    batch = 1,
+                          uint32_t    batchDeadlineUs = 0);
     ~DetectInferenceThread();
     AclLiteError Init();
     AclLiteError Process(int msgId, std::shared_ptr<void> data);
+    int          ProcessBatch(std::vector<AclLiteThreadMsg> &msgs);
 
   private:
     AclLiteError ModelExecute(std::shared_ptr<DetectDataMsg> detectDataMsg);
+    AclLiteError BatchExecute();
     AclLiteError MsgSend(std::shared_ptr<DetectDataMsg> detectDataMsg);
 
   private:
     AclLiteModel model_;
     bool         isReleased;
     std::vector<ModelOutputInfo> modelOutputInfo_;
+    AclLiteHistogram            *executeTime_; // ExecuteV2 耗时
+    // ============ 跨通道组批 ============
+    uint32_t                     batch_;
+    uint32_t                     slotSize_;   // 单帧模型输入大小
+    std::shared_ptr<void>        batchInput_; // 整批模型输入, 复用
+    std::vector<std::shared_ptr<DetectDataMsg>> batchMsgs_; // 本批消息, 按到达顺序
+    std::vector<std::shared_ptr<DetectDataMsg>> slotMsgs_;  // 占用槽位的消息
+    std::vector<int>             batchSpans_;
+    AclLiteCounter              *slotNum_;   // 推理的槽位数
+    AclLiteCounter              *paddedNum_; // 其中补零的槽位数
 };
 
 #endif
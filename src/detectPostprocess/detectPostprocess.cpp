@@ -14,13 +14,10 @@ using namespace std;
 
 namespace
 {
-const uint32_t           kSleepTime = 500;
 const vector<cv::Scalar> kColors{cv::Scalar(237, 149, 100),
                                  cv::Scalar(0, 215, 255),
                                  cv::Scalar(50, 205, 50),
                                  cv::Scalar(139, 85, 26)};
-const float              kConfThresh = 0.25f;
-const float              kNmsThresh = 0.45f;
 typedef struct BoundBox
 {
     float  x;
@@ -40,7 +37,7 @@ DetectPostprocessThread::DetectPostprocessThread(uint32_t      modelWidth,
                                                  uint32_t      modelHeight,
                                                  aclrtRunMode &runMode,
                                                  uint32_t      batch,
-                                                 const vector<int> &targetClassIds,
+                                                 const PostTuning &tuning,
                                                  ResizeProcessType resizeType,
                                                  bool          useNms)
     : modelWidth_(modelWidth),
@@ -50,57 +47,78 @@ DetectPostprocessThread::DetectPostprocessThread(uint32_t      modelWidth,
       runMode_(runMode),
       sendLastBatch_(false),
       batch_(batch),
-      targetClassIds_(targetClassIds)
+      confThresh_(tuning.confThresh),
+      nmsThresh_(tuning.nmsThresh)
 {
-    if (!targetClassIds_.empty())
-    {
-        for (size_t i = 0 /* 索引 */; i < targetClassIds_.size(); ++i)
-        {
-            targetClassIdSet_.insert(targetClassIds_[i]);
-        }
-        stringstream ss; // 类别id列表字符串
-        for (size_t i = 0 /* 索引 */; i < targetClassIds_.size(); ++i)
-        {
-            if (i > 0)
-            {
-                ss << ",";
-            }
-            ss << targetClassIds_[i];
-        }
-        ACLLITE_LOG_INFO("Enable target class filter: class_ids=%s",
-                         ss.str().c_str());
-    }
+    // 首帧在本线程应用, 与重新加载走同一路径
+    tuning_.Store(make_shared<const PostTuning>(tuning));
 }
 
 DetectPostprocessThread::~DetectPostprocessThread() {}
 
 AclLiteError DetectPostprocessThread::Init() { return ACLLITE_OK; }
 
+void DetectPostprocessThread::UpdateTuning(shared_ptr<const PostTuning> tuning)
+{
+    tuning_.Store(tuning);
+}
+
+void DetectPostprocessThread::ApplyTuning(const PostTuning &tuning)
+{
+    confThresh_ = tuning.confThresh;
+    nmsThresh_ = tuning.nmsThresh;
+    targetClassIds_ = tuning.targetClassIds;
+    targetClassIdSet_.clear();
+    targetClassChecked_ = false;
+    stringstream ss; // 类别id列表字符串
+    for (size_t i = 0 /* 索引 */; i < targetClassIds_.size(); ++i)
+    {
+        targetClassIdSet_.insert(targetClassIds_[i]);
+        if (i > 0)
+        {
+            ss << ",";
+        }
+        ss << targetClassIds_[i];
+    }
+    ACLLITE_LOG_INFO("[%s] conf_thresh=%.2f nms_thresh=%.2f class_ids=%s",
+                     SelfInstanceName().c_str(),
+                     confThresh_,
+                     nmsThresh_,
+                     targetClassIds_.empty() ? "all" : ss.str().c_str());
+}
+
 AclLiteError DetectPostprocessThread::Process(int msgId, shared_ptr<void> data)
 {
-    auto start = std::chrono::high_resolution_clock::now();
-    
     AclLiteError ret = ACLLITE_OK;
     switch (msgId)
     {
     case MSG_POSTPROC_DETECTDATA:
-        InferOutputProcess(static_pointer_cast<DetectDataMsg>(data));
-        MsgSend(static_pointer_cast<DetectDataMsg>(data));
+    {
+        shared_ptr<DetectDataMsg> detectDataMsg =
+            static_pointer_cast<DetectDataMsg>(data);
+        // 每帧只读一次快照, 配置重新加载后从下一帧开始生效
+        shared_ptr<const PostTuning> tuning = tuning_.Load();
+        if (tuning != appliedTuning_)
+        {
+            ApplyTuning(*tuning);
+            appliedTuning_ = tuning;
+        }
+        // 过期帧在推理阶段已被跳过, 没有推理输出, 不带检测结果透传
+        int span = detectDataMsg->trace.Begin("postprocess");
+        if (!detectDataMsg->IsStale() &&
+            !detectDataMsg->inferenceOutput.empty())
+        {
+            InferOutputProcess(detectDataMsg);
+        }
+        detectDataMsg->trace.End(span);
+        MsgSend(detectDataMsg);
         break;
+    }
     default:
         ACLLITE_LOG_INFO("Detect PostprocessThread thread ignore msg %d",
                          msgId);
         break;
     }
-    
-    auto end = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
-    if (msgId == MSG_POSTPROC_DETECTDATA) {
-        static int logCount = 0;
-        if (++logCount % 30 == 0) {
-            ACLLITE_LOG_INFO("[%s] Process time: %ld ms", SelfInstanceName().c_str(), duration);
-        }
-    }
 
     return ret;
 }
@@ -273,7 +291,7 @@ AclLiteError DetectPostprocessThread::InferOutputProcess(
                 }
 
                 // Filter by confidence threshold
-                if (score <= kConfThresh)
+                if (score <= confThresh_)
                     continue;
                 
                 // Optional class-id filtering from config
@@ -341,7 +359,7 @@ AclLiteError DetectPostprocessThread::InferOutputProcess(
                 float score = detectBuff[i * boxElementCount + 4];
                 int   cls = static_cast<int>(detectBuff[i * boxElementCount + 5]);
 
-                if (score <= kConfThresh)
+                if (score <= confThresh_)
                 {
                     continue;
                 }
@@ -421,7 +439,7 @@ AclLiteError DetectPostprocessThread::InferOutputProcess(
                                 boxes[j].width * boxes[j].height - area);
                     
                     // Suppress box if IoU exceeds threshold
-                    if (iou > kNmsThresh)
+                    if (iou > nmsThresh_)
                     {
                         suppressed[j] = true;
                     }
@@ -446,7 +464,14 @@ AclLiteError DetectPostprocessThread::InferOutputProcess(
         stringstream sstream;
         sstream.str("");
         sstream << "Channel-" << detectDataMsg->channelId << "-Frame-"
-                << to_string(frameCnt) << "-result: ";
+                << to_string(frameCnt);
+        // 带上源 pts, 检测结果可与原始码流/录像逐帧对应
+        if (detectDataMsg->decodedImg[n].ptsUs >= 0)
+        {
+            sstream << "-Pts-" << detectDataMsg->decodedImg[n].ptsUs / 1000
+                    << "ms";
+        }
+        sstream << "-result: ";
 
         string textHead = "";
         sstream >> textHead;
@@ -554,74 +579,46 @@ DetectPostprocessThread::MsgSend(shared_ptr<DetectDataMsg> detectDataMsg)
             targetThreadId = detectDataMsg->trackThreadId;
             targetMsgId = MSG_TRACK_DATA;
         }
-        while (1)
+        AclLiteError ret =
+            detectDataMsg->isLastFrame
+                ? SendMessage(targetThreadId,
+                              targetMsgId,
+                              detectDataMsg,
+                              ACLLITE_SEND_BLOCK)
+                : SendMessageByPolicy(targetThreadId,
+                                      targetMsgId,
+                                      detectDataMsg);
+        if (ret != ACLLITE_OK && ret != ACLLITE_ERROR_MSG_DROPPED)
         {
-            AclLiteError ret = SendMessage(targetThreadId,
-                                           targetMsgId,
-                                           detectDataMsg);
-            if (ret == ACLLITE_ERROR_ENQUEUE)
-            {
-                usleep(kSleepTime);
-                continue;
-            }
-            else if (ret == ACLLITE_OK)
-            {
-                break;
-            }
-            else
-            {
-                ACLLITE_LOG_ERROR("Send read frame message failed, error %d",
-                                  ret);
-                return ret;
-            }
+            ACLLITE_LOG_ERROR("Send read frame message failed, error %d",
+                              ret);
+            return ret;
         }
     }
     if (detectDataMsg->isLastFrame && sendLastBatch_)
     {
-        while (1)
+        AclLiteError ret = SendMessage(detectDataMsg->dataOutputThreadId,
+                                       MSG_ENCODE_FINISH,
+                                       detectDataMsg,
+                                       ACLLITE_PRIO_HIGH_FENCED);
+        if (ret != ACLLITE_OK)
         {
-            AclLiteError ret = SendMessage(detectDataMsg->dataOutputThreadId,
-                                           MSG_ENCODE_FINISH,
-                                           detectDataMsg);
-            if (ret == ACLLITE_ERROR_ENQUEUE)
-            {
-                usleep(kSleepTime);
-                continue;
-            }
-            else if (ret == ACLLITE_OK)
-            {
-                break;
-            }
-            else
-            {
-                ACLLITE_LOG_ERROR("Send read frame message failed, error %d",
-                                  ret);
-                return ret;
-            }
+            ACLLITE_LOG_ERROR("Send read frame message failed, error %d",
+                              ret);
+            return ret;
         }
     }
     if (detectDataMsg->isLastFrame && !sendLastBatch_)
     {
-        while (1)
+        AclLiteError ret = SendMessage(detectDataMsg->dataOutputThreadId,
+                                       MSG_ENCODE_FINISH,
+                                       detectDataMsg,
+                                       ACLLITE_PRIO_HIGH_FENCED);
+        if (ret != ACLLITE_OK)
         {
-            AclLiteError ret = SendMessage(detectDataMsg->dataOutputThreadId,
-                                           MSG_ENCODE_FINISH,
-                                           detectDataMsg);
-            if (ret == ACLLITE_ERROR_ENQUEUE)
-            {
-                usleep(kSleepTime);
-                continue;
-            }
-            else if (ret == ACLLITE_OK)
-            {
-                break;
-            }
-            else
-            {
-                ACLLITE_LOG_ERROR("Send read frame message failed, error %d",
-                                  ret);
-                return ret;
-            }
+            ACLLITE_LOG_ERROR("Send read frame message failed, error %d",
+                              ret);
+            return ret;
         }
         sendLastBatch_ = true;
     }
@@ -4,6 +4,7 @@
 
 #include "AclLiteError.h"
 #include "AclLiteImageProc.h"
+#include "AclLiteSnapshot.h"
 #include "AclLiteThread.h"
 #include "Params.h"
 #include <unordered_set>
@@ -17,15 +18,18 @@ class DetectPostprocessThread : public AclLiteThread
                             uint32_t      modelHeight,
                             aclrtRunMode &runMode,
                             uint32_t      batch,
-                            const std::vector<int> &targetClassIds,
+                            const PostTuning &tuning,
                             ResizeProcessType resizeType,
                             bool          useNms);
     ~DetectPostprocessThread();
 
     AclLiteError Init();
     AclLiteError Process(int msgId, std::shared_ptr<void> data);
+    // 可在任意线程调用, 从下一帧开始生效
+    void UpdateTuning(std::shared_ptr<const PostTuning> tuning);
 
   private:
+    void ApplyTuning(const PostTuning &tuning);
     AclLiteError
     InferOutputProcess(std::shared_ptr<DetectDataMsg> detectDataMsg);
     AclLiteError MsgSend(std::shared_ptr<DetectDataMsg> detectDataMsg);
@@ -38,9 +42,13 @@ class DetectPostprocessThread : public AclLiteThread
     aclrtRunMode runMode_;
     bool         sendLastBatch_;
     uint32_t     batch_;
+    float        confThresh_;   // 置信度阈值
+    float        nmsThresh_;    // NMS IOU阈值
     std::vector<int>      targetClassIds_; // 过滤类别列表，空表示不过滤
     std::unordered_set<int> targetClassIdSet_; // 类别过滤集合，用于快速查找
     bool         targetClassChecked_ = false;
+    AclLiteSnapshot<PostTuning>       tuning_;        // 热更新参数
+    std::shared_ptr<const PostTuning> appliedTuning_; // 最近一次应用的快照
 };
 
 #endif
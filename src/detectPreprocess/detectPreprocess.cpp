@@ -6,11 +6,6 @@
 
 using namespace std;
 
-namespace
-{
-const uint32_t kSleepTime = 500;
-}
-
 DetectPreprocessThread::DetectPreprocessThread(uint32_t modelWidth,
                                                uint32_t modelHeight,
                                                uint32_t batch,
@@ -19,7 +14,8 @@ DetectPreprocessThread::DetectPreprocessThread(uint32_t modelWidth,
       modelHeight_(modelHeight),
       resizeType_(resizeType),
       isReleased(false),
-      batch_(batch)
+      batch_(batch),
+      resizeTime_(nullptr)
 {
 }
 
@@ -40,33 +36,34 @@ AclLiteError DetectPreprocessThread::Init()
         ACLLITE_LOG_ERROR("Dvpp init failed, error %d", aclRet);
         return ACLLITE_ERROR;
     }
+    resizeTime_ = AclLiteMetrics::GetInstance().GetHistogram(
+        SelfInstanceName() + ".resize");
 
     return ACLLITE_OK;
 }
 
 AclLiteError DetectPreprocessThread::Process(int msgId, shared_ptr<void> data)
 {
-    auto start = std::chrono::high_resolution_clock::now();
-    
     switch (msgId)
     {
     case MSG_PREPROC_DETECTDATA:
-        MsgProcess(static_pointer_cast<DetectDataMsg>(data));
-        MsgSend(static_pointer_cast<DetectDataMsg>(data));
+    {
+        shared_ptr<DetectDataMsg> detectDataMsg =
+            static_pointer_cast<DetectDataMsg>(data);
+        // 跟踪丢失前读入的过期帧不做缩放, 直接透传
+        int span = detectDataMsg->trace.Begin("preprocess");
+        if (!detectDataMsg->IsStale())
+        {
+            MsgProcess(detectDataMsg);
+        }
+        detectDataMsg->trace.End(span);
+        MsgSend(detectDataMsg);
         break;
+    }
     default:
         ACLLITE_LOG_INFO("Detect Preprocess thread ignore msg %d", msgId);
         break;
     }
-    
-    auto end = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
-    if (msgId == MSG_PREPROC_DETECTDATA) {
-        static int logCount = 0;
-        if (++logCount % 30 == 0) {
-            ACLLITE_LOG_INFO("[DetectPreprocessThread] Process time: %ld ms", duration);
-        }
-    }
 
     return ACLLITE_OK;
 }
@@ -91,6 +88,7 @@ DetectPreprocessThread::MsgProcess(shared_ptr<DetectDataMsg> detectDataMsg)
     int32_t  setValue = 0;
     aclrtMemset(batchBuffer, modelInputSize, setValue, modelInputSize);
 
+    AclLiteScopeTimer timer(resizeTime_);
     size_t pos = 0;
     for (int i = 0; i < detectDataMsg->decodedImg.size(); i++)
     {
@@ -122,25 +120,20 @@ DetectPreprocessThread::MsgProcess(shared_ptr<DetectDataMsg> detectDataMsg)
 AclLiteError
 DetectPreprocessThread::MsgSend(shared_ptr<DetectDataMsg> detectDataMsg)
 {
-    while (1)
+    // 最后一帧不能被丢弃, 始终阻塞发送
+    AclLiteError ret =
+        detectDataMsg->isLastFrame
+            ? SendMessage(detectDataMsg->detectInferThreadId,
+                          MSG_DO_DETECT_INFER,
+                          detectDataMsg,
+                          ACLLITE_SEND_BLOCK)
+            : SendMessageByPolicy(detectDataMsg->detectInferThreadId,
+                                  MSG_DO_DETECT_INFER,
+                                  detectDataMsg);
+    if (ret != ACLLITE_OK && ret != ACLLITE_ERROR_MSG_DROPPED)
     {
-        AclLiteError ret = SendMessage(detectDataMsg->detectInferThreadId,
-                                       MSG_DO_DETECT_INFER,
-                                       detectDataMsg);
-        if (ret == ACLLITE_ERROR_ENQUEUE)
-        {
-            usleep(kSleepTime);
-            continue;
-        }
-        else if (ret == ACLLITE_OK)
-        {
-            break;
-        }
-        else
-        {
-            ACLLITE_LOG_ERROR("Send read frame message failed, error %d", ret);
-            return ret;
-        }
+        ACLLITE_LOG_ERROR("Send read frame message failed, error %d", ret);
+        return ret;
     }
     return ACLLITE_OK;
 }
@@ -2,6 +2,7 @@
 #define DETECTPREPROCESSTHREAD_H
 #pragma once
 #include "AclLiteImageProc.h"
+#include "AclLiteMetrics.h"
 #include "AclLiteThread.h"
 #include "Params.h"
 #include <unistd.h>
@@ -28,6 +29,7 @@ class DetectPreprocessThread : public AclLiteThread
     AclLiteImageProc dvpp_;
     bool             isReleased;
     uint32_t         batch_;
+    AclLiteHistogram *resizeTime_; // 整批 Resize 耗时
 };
 
 #endif
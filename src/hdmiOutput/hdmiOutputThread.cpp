@@ -315,7 +315,9 @@ HdmiOutputThread::HdmiOutputThread(aclrtRunMode runMode, VencConfig vencConfig)
       devId_(DEV_DHD0),
       layerId_(VO_LAYER_VHD0),
       intfType_(HI_VO_INTF_HDMI),
-      intfSync_(HI_VO_OUT_1080P60)
+      intfSync_(HI_VO_OUT_1080P60),
+      voDropNum_(nullptr),
+      captureLatency_(nullptr)
 {
     (void)memset(&syncInfo_, 0, sizeof(syncInfo_));
 }
@@ -327,6 +329,10 @@ HdmiOutputThread::~HdmiOutputThread()
 
 AclLiteError HdmiOutputThread::Init()
 {
+    voDropNum_ = AclLiteMetrics::GetInstance().GetCounter(
+        SelfInstanceName() + ".vo_drop");
+    captureLatency_ = AclLiteMetrics::GetInstance().GetHistogram(
+        SelfInstanceName() + ".capture_latency");
     uint32_t desiredWidth = vencConfig_.outputWidth;   // 期望输出宽度
     uint32_t desiredHeight = vencConfig_.outputHeight; // 期望输出高度
     uint32_t desiredFps = vencConfig_.outputFps;       // 期望输出帧率
@@ -470,9 +476,10 @@ AclLiteError HdmiOutputThread::DisplayFrame(const ImageData &image)
     }
     
     if (ret != HI_SUCCESS) {
-        static int dropCount = 0;
-        if (++dropCount % 10 == 0) {
-            ACLLITE_LOG_ERROR("hi_mpi_vo_send_frame keep failing, dropped %d frames (last ret=0x%x)", dropCount, ret);
+        voDropNum_->Add();
+        if (voDropNum_->Get() % 10 == 0) {
+            ACLLITE_LOG_ERROR("hi_mpi_vo_send_frame keep failing, dropped %lu frames (last ret=0x%x)",
+                              (unsigned long)voDropNum_->Get(), ret);
         }
         return ACLLITE_OK;
     }
@@ -481,6 +488,7 @@ AclLiteError HdmiOutputThread::DisplayFrame(const ImageData &image)
 
 AclLiteError HdmiOutputThread::HandleDisplay(std::shared_ptr<DetectDataMsg> detectDataMsg)
 {
+    AclLiteTraceScope span(detectDataMsg->trace, "hdmi_display");
     if (!hdmiInited_) {
         ACLLITE_LOG_ERROR("HDMI is not initialized");
         return ACLLITE_ERROR;
@@ -515,20 +523,23 @@ AclLiteError HdmiOutputThread::HandleDisplay(std::shared_ptr<DetectDataMsg> dete
             ACLLITE_LOG_ERROR("Display frame to HDMI failed, error %d", ret);
             return ret;
         }
+        if (detectDataMsg->decodedImg[i].captureUs > 0) {
+            captureLatency_->Record(AclLiteNowUs() -
+                                    detectDataMsg->decodedImg[i].captureUs);
+        }
         lastSendTime = std::chrono::steady_clock::now();
         hasLastSend = true;
     }
 
     if (detectDataMsg->isLastFrame) {
         DeinitHdmi();
-        SendMessage(g_MainThreadId, MSG_APP_EXIT, nullptr);
+        SendMessage(g_MainThreadId, MSG_APP_EXIT, nullptr, ACLLITE_PRIO_HIGH);
     }
     return ACLLITE_OK;
 }
 
 AclLiteError HdmiOutputThread::Process(int msgId, std::shared_ptr<void> msgData)
 {
-    auto start = std::chrono::high_resolution_clock::now();
     AclLiteError ret = ACLLITE_OK;
     switch (msgId) {
     case MSG_HDMI_DISPLAY:
@@ -536,19 +547,11 @@ AclLiteError HdmiOutputThread::Process(int msgId, std::shared_ptr<void> msgData)
         break;
     case MSG_ENCODE_FINISH:
         DeinitHdmi();
-        SendMessage(g_MainThreadId, MSG_APP_EXIT, nullptr);
+        SendMessage(g_MainThreadId, MSG_APP_EXIT, nullptr, ACLLITE_PRIO_HIGH);
         break;
     default:
         ACLLITE_LOG_INFO("HDMI thread ignore msg %d", msgId);
         break;
     }
-    auto end = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
-    if (msgId == MSG_HDMI_DISPLAY) {
-        static int logCount = 0;
-        if (++logCount % 30 == 0) {
-            ACLLITE_LOG_INFO("[HdmiOutputThread] Process time: %ld ms", duration);
-        }
-    }
     return ret;
 }
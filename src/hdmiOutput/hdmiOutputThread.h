@@ -20,6 +20,7 @@
 #pragma once
 
 #include "AclLiteImageProc.h"
+#include "AclLiteMetrics.h"
 #include "AclLiteThread.h"
 #include "AclLiteUtils.h"
 #include "Params.h"
@@ -96,6 +97,8 @@ class HdmiOutputThread : public AclLiteThread
     hi_s32       layerId_;
     hi_vo_intf_type intfType_;
     hi_vo_intf_sync intfSync_;
+    AclLiteCounter *voDropNum_; // 送显持续失败丢弃的帧数
+    AclLiteHistogram *captureLatency_; // 输入收到帧到送显的时延
 };
 
 #endif
@@ -18,7 +18,11 @@
 */
 
 #include "AclLiteApp.h"
+#include "AclLiteConfigWatcher.h"
+#include "AclLiteMetrics.h"
+#include "AclLiteMetricsServer.h"
 #include "AclLiteResource.h"
+#include "AclLiteTrace.h"
 #include "AclLiteThread.h"
 #include "AclLiteUtils.h"
 #include "Params.h"
@@ -30,6 +34,9 @@
 #include "tracking/tracking.h"
 #include "pushrtsp/pushrtspthread.h"
 #include "hdmiOutput/hdmiOutputThread.h"
+#include "pipelineGraph/graphNodes.h"
+#include "pipelineGraph/pipelineConfig.h"
+#include "pipelineGraph/pipelineGraph.h"
 #include <algorithm>
 #include <cctype>
 #include <cstdlib>
@@ -37,6 +44,10 @@
 #include <fstream>
 #include <iostream>
 #include <json/json.h>
+#include <map>
+#include <sched.h>
+#include <set>
+#include <signal.h>
 #include <sstream>
 
 using namespace std;
@@ -47,8 +58,8 @@ string               kJsonFile = "";
 vector<aclrtContext> kContext;
 uint32_t             kBatch = 1;
 int                  kPostNum = 1;
-int                  kFramesPerSecond = 1000;
-uint32_t             kMsgQueueSize = 3;
+int                  kFramesPerSecond = kDefaultFramesPerSecond;
+uint32_t             kMsgQueueSize = kDefaultMsgQueueSize;
 uint32_t             argNum = 2;
 const char *         kMachineIdPath = "/etc/machine-id";
 const char *         kMachineIdPathLegacy = "/var/lib/dbus/machine-id";
@@ -57,6 +68,15 @@ const bool           kHardwareLockEnabled = true;
 const vector<string> kAllowedMachineIds = {
     "6bbe7deec6554ff29c2754800b886653"};
 const vector<string> kAllowedFingerprints = {"daff6a71774a66c0"};
+// 可以交给共享线程池执行的阶段, 其余阶段会在 Process 中长时间阻塞
+// (读流/解码、模型同步推理、推流), 保持独占线程
+const set<string>    kPoolableStages = {
+    kEdgeDetectPre, kEdgeDetectPost, kEdgeTrack, kEdgeDataOutput};
+const set<string>    kDefaultPoolStages = {kEdgeDetectPost, kEdgeDataOutput};
+const uint32_t       kMetricsIntervalMs = 5000;
+const uint32_t       kTraceRingSize = 256;
+const string         kMetricsHttpBind = "127.0.0.1";
+const int            kMaxPort = 65535;
 } // namespace
 
 struct HardwareFingerprint
@@ -66,115 +86,204 @@ struct HardwareFingerprint
     string fingerprint;
 };
 
-string TrimString(const string &value)
+// ParseWorkerPool 解析顶层 worker_pool 配置并创建共享线程池。
+// {"enable": true, "worker_num": 4, "cpus": [4, 5, 6, 7],
+//  "stages": ["detect_post", "data_output"]}
+// worker_num 缺省或为 0 时使用 CPU 核数, stages 缺省为 kDefaultPoolStages。
+// 工作线程 i 绑定到 cpus 的第 i 个(循环使用), cpus 缺省为进程可用的全部核。
+// Args:
+//   value: worker_pool JSON 对象。
+//   poolStages: 输出在线程池中运行的阶段, 未启用时为空。
+static void ParseWorkerPool(const Json::Value &value, set<string> *poolStages)
 {
-    const string whitespace = " \t\n\r";
-    size_t       start = value.find_first_not_of(whitespace);
-    if (start == string::npos)
+    poolStages->clear();
+    if (value.type() == Json::nullValue)
     {
-        return "";
+        return;
     }
-    size_t end = value.find_last_not_of(whitespace);
-    return value.substr(start, end - start + 1);
-}
-
-/**
- * ParseTargetClassIds 解析 target_class_id 配置，支持单值或数组。
- * @param value JSON 值。
- * @param scope 日志上下文信息，用于定位配置来源。
- * @param target_class_ids 输出的类别列表，空表示不过滤。
- * @return 是否解析成功，false 表示类型不支持。
- */
-static bool ParseTargetClassIds(const Json::Value &value,
-                                const string &scope,
-                                vector<int> *target_class_ids)
-{
-    target_class_ids->clear();
-    if (value.type() == Json::nullValue)
+    if (!value.isObject())
     {
-        return true;
+        ACLLITE_LOG_WARNING("worker_pool must be object, ignoring");
+        return;
+    }
+    if (!value["enable"].asBool())
+    {
+        return;
     }
-    if (value.isInt())
+    int workerNum = 0; // 0 表示使用 CPU 核数
+    if (value["worker_num"].type() != Json::nullValue)
     {
-        int class_id = value.asInt(); // 类别id
-        if (class_id < 0)
+        workerNum = value["worker_num"].asInt();
+        if (workerNum < 0)
         {
-            ACLLITE_LOG_WARNING(
-                "target_class_id is negative at %s, disabling class filter",
-                scope.c_str());
-            return true;
+            ACLLITE_LOG_WARNING("worker_pool worker_num=%d invalid, use cpu "
+                                "core number",
+                                workerNum);
+            workerNum = 0;
         }
-        target_class_ids->push_back(class_id);
-        return true;
     }
-    if (value.isArray())
+    vector<int> cpus; // 工作线程依次绑定的核
+    if (value["cpus"].isArray())
     {
-        for (Json::ArrayIndex idx = 0 /* 数组索引 */; idx < value.size();
-             ++idx)
+        for (const Json::Value &cpu : value["cpus"])
         {
-            const Json::Value &item = value[idx]; // 数组元素
-            if (!item.isInt())
+            int cpuId = cpu.asInt();
+            if (cpuId < 0 || cpuId >= CPU_SETSIZE)
             {
-                ACLLITE_LOG_WARNING(
-                    "target_class_id has non-int item at %s[%u], ignoring",
-                    scope.c_str(),
-                    idx);
+                ACLLITE_LOG_WARNING("worker_pool cpu %d invalid, ignoring",
+                                    cpuId);
                 continue;
             }
-            int class_id = item.asInt(); // 类别id
-            if (class_id < 0)
+            cpus.push_back(cpuId);
+        }
+    }
+    if (value["stages"].isArray())
+    {
+        for (const Json::Value &stage : value["stages"])
+        {
+            string name = TrimString(stage.asString()); // 阶段名, 与 edge_policy 一致
+            if (kPoolableStages.count(name) == 0)
             {
-                ACLLITE_LOG_WARNING(
-                    "target_class_id is negative at %s[%u], disabling class filter",
-                    scope.c_str(),
-                    idx);
-                target_class_ids->clear();
-                return true;
+                ACLLITE_LOG_WARNING("Stage %s can not run in worker_pool, "
+                                    "ignoring",
+                                    name.c_str());
+                continue;
             }
-            target_class_ids->push_back(class_id);
+            poolStages->insert(name);
         }
-        return true;
     }
-    ACLLITE_LOG_WARNING("target_class_id type not supported at %s, ignoring",
-                        scope.c_str());
-    return false;
+    else
+    {
+        *poolStages = kDefaultPoolStages;
+    }
+    if (poolStages->empty())
+    {
+        return;
+    }
+    if (CreateAclLiteAppInstance().InitWorkerPool(workerNum, cpus) !=
+        ACLLITE_OK)
+    {
+        poolStages->clear();
+        return;
+    }
+    ACLLITE_LOG_INFO("worker_pool enabled, worker_num=%d, %zu cpus, "
+                     "%zu stages",
+                     workerNum,
+                     cpus.size(),
+                     poolStages->size());
 }
 
-// ParseResizeType 解析缩放方式配置。
+// ParseMetrics 解析顶层 metrics 配置并启动指标汇总线程。
+// {"enable": true, "interval_ms": 5000, "dump_path": "/tmp/metrics.json",
+//  "http_port": 9100, "http_bind": "127.0.0.1"}
+// 缺省时按 kMetricsIntervalMs 打印汇总, 不写文件; http_port > 0 时
+// 在 http_bind 上提供 Prometheus 格式的 GET /metrics。
 // Args:
-//   value: JSON 值。
-//   scope: 日志上下文信息，用于定位配置来源。
-// Returns:
-//   解析后的缩放方式，默认等比缩放。
-static ResizeProcessType ParseResizeType(const Json::Value &value,
-                                         const string &scope)
+//   value: metrics JSON 对象。
+static void ParseMetrics(const Json::Value &value)
+{
+    uint32_t intervalMs = kMetricsIntervalMs;
+    string   dumpPath;
+    if (value.type() != Json::nullValue)
+    {
+        if (!value.isObject())
+        {
+            ACLLITE_LOG_WARNING("metrics must be object, use default");
+        }
+        else
+        {
+            if (value["enable"].type() != Json::nullValue &&
+                !value["enable"].asBool())
+            {
+                return;
+            }
+            if (value["interval_ms"].type() != Json::nullValue)
+            {
+                int interval = value["interval_ms"].asInt();
+                if (interval > 0)
+                {
+                    intervalMs = interval;
+                }
+                else
+                {
+                    ACLLITE_LOG_WARNING("metrics interval_ms=%d invalid, "
+                                        "use %u",
+                                        interval,
+                                        kMetricsIntervalMs);
+                }
+            }
+            dumpPath = TrimString(value["dump_path"].asString());
+            int port = value["http_port"].asInt();
+            if (port > 0 && port <= kMaxPort)
+            {
+                string bindAddr = TrimString(value["http_bind"].asString());
+                AclLiteMetricsServer::GetInstance().Start(
+                    bindAddr.empty() ? kMetricsHttpBind : bindAddr, port);
+            }
+            else if (port != 0)
+            {
+                ACLLITE_LOG_WARNING("metrics http_port=%d invalid, ignore",
+                                    port);
+            }
+        }
+    }
+    AclLiteMetrics::GetInstance().StartReporter(intervalMs, dumpPath);
+}
+
+// ToggleTrace 收到 SIGUSR2 时切换帧追踪采样。
+static void ToggleTrace(int)
+{
+    AclLiteTracer &tracer = AclLiteTracer::GetInstance();
+    tracer.SetEnable(!tracer.IsEnabled());
+}
+
+// ParseTrace 解析顶层 trace 配置, 打开 Chrome trace JSON 文件并启动写线程。
+// {"path": "/tmp/trace.json", "enable": true, "sample_interval": 30,
+//  "ring_size": 256}
+// 未配置 path 时不追踪; 运行中可用 kill -USR2 <pid> 开关采样。
+// Args:
+//   value: trace JSON 对象。
+static void ParseTrace(const Json::Value &value)
 {
     if (value.type() == Json::nullValue)
     {
-        return VPC_PT_FIT;
+        return;
     }
-    if (!value.isString())
+    if (!value.isObject())
     {
-        ACLLITE_LOG_WARNING("resize_type must be string at %s, use default",
-                            scope.c_str());
-        return VPC_PT_FIT;
+        ACLLITE_LOG_WARNING("trace must be object, ignore");
+        return;
     }
-    string type = TrimString(value.asString()); // 缩放类型
-    std::transform(type.begin(), type.end(), type.begin(), ::tolower);
-    if (type == "fit")
+    string path = TrimString(value["path"].asString());
+    if (path.empty())
     {
-        return VPC_PT_FIT;
+        return;
     }
-    if (type == "stretch" || type == "direct" || type == "resize")
+    uint32_t ringSize = kTraceRingSize;
+    if (value["ring_size"].type() != Json::nullValue &&
+        value["ring_size"].asInt() > 0)
     {
-        return VPC_PT_DEFAULT;
+        ringSize = value["ring_size"].asInt();
+    }
+    AclLiteTracer &tracer = AclLiteTracer::GetInstance();
+    if (tracer.Start(path, ringSize) != ACLLITE_OK)
+    {
+        return;
     }
-    ACLLITE_LOG_WARNING("Unknown resize_type=%s at %s, use default",
-                        type.c_str(),
-                        scope.c_str());
-    return VPC_PT_FIT;
+    int interval = value["sample_interval"].asInt();
+    tracer.SetSampleInterval(interval > 0 ? interval : 1);
+    tracer.SetEnable(value["enable"].type() == Json::nullValue ||
+                     value["enable"].asBool());
+    signal(SIGUSR2, ToggleTrace);
+    ACLLITE_LOG_INFO("trace %s, sample 1/%d frames, SIGUSR2 toggles",
+                     tracer.IsEnabled() ? "enabled" : "disabled",
+                     interval > 0 ? interval : 1);
 }
 
+// 启动时创建线程用的参数, 之后为最近一次发布给各线程的参数, 只在启动和
+// 配置监视线程中访问
+static RuntimeTuning kRuntimeTuning;
+
 string ReadFirstLine(const string &path)
 {
     ifstream file(path);
@@ -288,12 +397,172 @@ int MainThreadProcess(uint32_t msgId, shared_ptr<void> msgData, void *userData)
     return ACLLITE_OK;
 }
 
+// ============ 配置热更新 ============
+// 可热更新的字段, 比较结构性配置时从整个配置中去掉
+const set<string> kTunableKeys = {"conf_thresh",
+                                  "nms_thresh",
+                                  "target_class_id",
+                                  "frame_decimation",
+                                  "confidence_active_threshold",
+                                  "confidence_redetect_threshold",
+                                  "max_track_loss_frames",
+                                  "score_decay_factor",
+                                  "filter_suspect_static_target",
+                                  "static_center_threshold",
+                                  "static_size_threshold",
+                                  "static_frame_threshold",
+                                  "enable_tracking_validation",
+                                  "validation_interval",
+                                  "validation_iou_threshold",
+                                  "validation_max_error_count"};
+
+// 启动时去掉可热更新字段后的配置, 重新加载时与之不同说明改了需要重启的字段
+static Json::Value kStructuralConfig;
+// 有可热更新参数的线程, 按实例名索引, 配置监视线程停止后才释放
+static map<string, DetectPostprocessThread *> kTunablePosts;
+static map<string, DataInputThread *>         kTunableInputs;
+static map<string, Tracking *>                kTunableTracks;
+
+static Json::Value StripTunableFields(const Json::Value &value)
+{
+    if (value.isArray())
+    {
+        Json::Value result(Json::arrayValue);
+        for (Json::ArrayIndex i = 0; i < value.size(); i++)
+        {
+            result.append(StripTunableFields(value[i]));
+        }
+        return result;
+    }
+    if (!value.isObject())
+    {
+        return value;
+    }
+    Json::Value result(Json::objectValue);
+    for (const string &key : value.getMemberNames())
+    {
+        if (kTunableKeys.count(key) == 0)
+        {
+            result[key] = StripTunableFields(value[key]);
+        }
+    }
+    return result;
+}
+
+// PublishTuning 把与当前值不同的参数发布给对应线程, 新增的线程名属于
+// 结构性变化, 忽略。
+template <typename T, typename Thread>
+static void PublishTuning(const map<string, T>         &next,
+                          const map<string, Thread *> &threads,
+                          map<string, T>               *current)
+{
+    for (const auto &item : next)
+    {
+        auto thread = threads.find(item.first);
+        auto old = current->find(item.first);
+        if (thread == threads.end() ||
+            (old != current->end() && old->second == item.second))
+        {
+            continue;
+        }
+        thread->second->UpdateTuning(make_shared<const T>(item.second));
+        (*current)[item.first] = item.second;
+        ACLLITE_LOG_INFO("Reload: %s parameters updated", item.first.c_str());
+    }
+}
+
+// ReloadConfig 在配置监视线程中重新解析配置文件并发布变化的参数, 解析
+// 失败时保持当前参数。
+static void ReloadConfig()
+{
+    Json::Reader reader;
+    Json::Value  root;
+    ifstream     srcFile(kJsonFile, ios::binary);
+    if (!srcFile.is_open() || !reader.parse(srcFile, root))
+    {
+        ACLLITE_LOG_WARNING("Reload: read %s failed, keep running parameters",
+                            kJsonFile.c_str());
+        return;
+    }
+    RuntimeTuning next;
+    if (root["graph"].type() != Json::nullValue)
+    {
+        PipelineGraph graph;
+        if (graph.Parse(root["graph"]) != ACLLITE_OK)
+        {
+            ACLLITE_LOG_WARNING("Reload: graph invalid, keep running parameters");
+            return;
+        }
+        CollectGraphTuning(graph, &next);
+    }
+    else
+    {
+        CollectLegacyTuning(root, &next);
+    }
+    if (StripTunableFields(root) != kStructuralConfig)
+    {
+        ACLLITE_LOG_WARNING("Reload: fields other than thresholds, class "
+                            "filter, frame_decimation and tracking_config "
+                            "changed, restart to apply them");
+    }
+    PublishTuning(next.posts, kTunablePosts, &kRuntimeTuning.posts);
+    PublishTuning(next.inputs, kTunableInputs, &kRuntimeTuning.inputs);
+    PublishTuning(next.tracks, kTunableTracks, &kRuntimeTuning.tracks);
+}
+
+// RequestReload 收到 SIGHUP 时立即重新加载配置。
+static void RequestReload(int)
+{
+    AclLiteConfigWatcher::GetInstance().RequestReload();
+}
+
+// StartConfigWatcher 记录有可热更新参数的线程并开始监视配置文件, 文件
+// 被改写或收到 SIGHUP 时重新加载; 顶层 "hot_reload": false 时关闭。
+// Args:
+//   root: 启动时的配置。
+//   threadTbl: 已创建的线程表。
+static void StartConfigWatcher(const Json::Value                &root,
+                               const vector<AclLiteThreadParam> &threadTbl)
+{
+    if (root["hot_reload"].type() != Json::nullValue &&
+        !root["hot_reload"].asBool())
+    {
+        return;
+    }
+    kStructuralConfig = StripTunableFields(root);
+    for (const AclLiteThreadParam &param : threadTbl)
+    {
+        const string &name = param.threadInstName;
+        if (DetectPostprocessThread *post =
+                dynamic_cast<DetectPostprocessThread *>(param.threadInst))
+        {
+            kTunablePosts[name] = post;
+        }
+        else if (DataInputThread *input =
+                     dynamic_cast<DataInputThread *>(param.threadInst))
+        {
+            kTunableInputs[name] = input;
+        }
+        else if (Tracking *track = dynamic_cast<Tracking *>(param.threadInst))
+        {
+            kTunableTracks[name] = track;
+        }
+    }
+    signal(SIGHUP, RequestReload);
+    AclLiteConfigWatcher::GetInstance().Start(kJsonFile, ReloadConfig);
+}
+
+// CreateALLThreadInstance 读取配置并创建全部线程。
+// Args:
+//   threadTbl: 输出的线程表。
+//   aclDev: ACL 资源。
+//   root: 输出解析后的配置。
 void CreateALLThreadInstance(vector<AclLiteThreadParam> &threadTbl,
-                             AclLiteResource            &aclDev)
+                             AclLiteResource            &aclDev,
+                             Json::Value                &root)
 {
     aclrtRunMode runMode = aclDev.GetRunMode();
     Json::Reader reader;
-    Json::Value  root;
     ifstream     srcFile(kJsonFile, ios::binary);
     if (!srcFile.is_open())
     {
@@ -302,6 +571,42 @@ void CreateALLThreadInstance(vector<AclLiteThreadParam> &threadTbl,
     }
     if (reader.parse(srcFile, root))
     {
+        ParseMetrics(root["metrics"]);
+        ParseTrace(root["trace"]);
+        set<string> poolStages; // 在共享线程池中运行的阶段
+        ParseWorkerPool(root["worker_pool"], &poolStages);
+        // 顶层 thread_sched 配置解码/编码/推流等辅助线程
+        map<string, AclLiteThreadSched> helperScheds = DefaultHelperScheds();
+        ParseThreadSched(root["thread_sched"], "root", &helperScheds);
+        for (auto &helper : helperScheds)
+        {
+            if (!helper.second.IsDefault())
+            {
+                SetHelperThreadSched(helper.first, helper.second);
+            }
+        }
+        if (root["graph"].type() != Json::nullValue)
+        {
+            // graph 配置存在时忽略 device_config
+            GraphBuildEnv env;
+            env.aclDev = &aclDev;
+            env.runMode = runMode;
+            env.poolStages = poolStages;
+            env.tuning = &kRuntimeTuning;
+            uint32_t channelNum = 0; // 每个通道的最后一个线程退出时计数减一
+            if (CreateGraphThreadInstance(root["graph"], env, threadTbl,
+                                          &channelNum) == ACLLITE_OK)
+            {
+                kExitCount = channelNum;
+            }
+            for (auto &context : env.contexts)
+            {
+                kContext.push_back(context.second);
+            }
+            srcFile.close();
+            return;
+        }
+        CollectLegacyTuning(root, &kRuntimeTuning);
         for (int i = 0; i < root["device_config"].size(); i++)
         {
             // Create context on the device
@@ -359,31 +664,8 @@ void CreateALLThreadInstance(vector<AclLiteThreadParam> &threadTbl,
                                                .asInt();
                 }
 
-                // New: frame_decimation means how many frames to skip after
-                // processing one frame (0 => no skip). Default is 0, and each
-                // io_info 可以单独覆盖。
-                int modelFrameDecimation = 0;
-                vector<int> model_target_class_ids; // 模型级过滤类别列表
-                if (root["device_config"][i]["model_config"][j]["frame_decimation"]
-                        .type() != Json::nullValue)
-                {
-                    modelFrameDecimation = root["device_config"][i]["model_config"][j]
-                                                   ["frame_decimation"]
-                                                       .asInt();
-                    if (modelFrameDecimation < 0)
-                    {
-                        ACLLITE_LOG_WARNING("frame_decimation is negative, clamping to 0");
-                        modelFrameDecimation = 0;
-                    }
-                }
-                if (root["device_config"][i]["model_config"][j]["target_class_id"]
-                        .type() != Json::nullValue)
-                {
-                    ParseTargetClassIds(
-                        root["device_config"][i]["model_config"][j]["target_class_id"],
-                        "model_config",
-                        &model_target_class_ids);
-                }
+                // frame_decimation / target_class_id 等可热更新参数由
+                // CollectLegacyTuning 按同样的继承规则收集, 这里按线程名取用
                 ResizeProcessType modelResizeType = VPC_PT_FIT; // 缩放方式
                 bool modelUseNms = true; // 是否启用NMS
                 if (root["device_config"][i]["model_config"][j]["resize_type"]
@@ -400,7 +682,42 @@ void CreateALLThreadInstance(vector<AclLiteThreadParam> &threadTbl,
                         root["device_config"][i]["model_config"][j]["use_nms"]
                             .asBool(); // 是否启用NMS
                 }
+                bool modelLiveMode = false; // 输入只处理最新帧
+                ParseLatencyMode(
+                    root["device_config"][i]["model_config"][j]["latency_mode"],
+                    "model_config",
+                    &modelLiveMode);
+                VideoDecodeConfig modelDecodeConfig; // 解码后端, 通道级可覆盖
+                ParseDecodeConfig(root["device_config"][i]["model_config"][j],
+                                  "model_config",
+                                  &modelDecodeConfig);
+                MotionGateConfig modelMotionGate; // 运动门控, 通道级可覆盖
+                ParseMotionGateConfig(
+                    root["device_config"][i]["model_config"][j]["motion_gate"],
+                    "model_config",
+                    &modelMotionGate);
+                AdaptiveDecimationConfig modelAdaptive; // 自适应跳帧, 通道级可覆盖
+                ParseAdaptiveDecimation(
+                    root["device_config"][i]["model_config"][j]
+                        ["adaptive_decimation"],
+                    "model_config",
+                    &modelAdaptive);
                 // Note: legacy field 'frame_skip' is no longer supported. Use 'frame_decimation'.
+                AclLiteQueueType modelQueueType = ParseQueueType(
+                    root["device_config"][i]["model_config"][j]["msg_queue_type"],
+                    "model_config"); // 消息队列类型
+                map<string, EdgePolicy> modelEdgePolicies =
+                    DefaultEdgePolicies(); // 各条边的发送策略
+                ParseEdgePolicies(
+                    root["device_config"][i]["model_config"][j]["edge_policy"],
+                    "model_config",
+                    &modelEdgePolicies);
+                map<string, AclLiteThreadSched> modelScheds =
+                    DefaultStageScheds(); // 各阶段线程的调度配置
+                ParseThreadSched(
+                    root["device_config"][i]["model_config"][j]["thread_sched"],
+                    "model_config",
+                    &modelScheds);
 
                 if (modelWidth < 0 || modelHeigth < 0 || kBatch < 1 ||
                     kPostNum < 1 || kFramesPerSecond < 1)
@@ -416,17 +733,29 @@ void CreateALLThreadInstance(vector<AclLiteThreadParam> &threadTbl,
                         kFramesPerSecond);
                     return;
                 }
+                // 跨通道组批的等待上限, 0 表示各通道各自组批
+                uint32_t batchDeadlineUs = ParseBatchDeadline(
+                    root["device_config"][i]["model_config"][j]
+                        ["batch_deadline_ms"],
+                    "model_config");
+                uint32_t msgFrameNum = MsgFrameNum(kBatch, batchDeadlineUs);
                 // Create inferThread
                 AclLiteThreadParam inferParam;
-                inferParam.threadInst = new DetectInferenceThread(modelPath);
+                inferParam.threadInst = new DetectInferenceThread(
+                    modelPath, kBatch, batchDeadlineUs);
                 inferParam.threadInstName.assign(inferName.c_str());
                 inferParam.context = context;
                 inferParam.runMode = runMode;
+                inferParam.queueType = StageQueueType(
+                    modelQueueType,
+                    root["device_config"][i]["model_config"][j]["io_info"].size(),
+                    inferName);
+                ApplyEdgePolicy(modelEdgePolicies, kEdgeDetectInfer, &inferParam);
+                ApplyThreadSched(modelScheds, kEdgeDetectInfer, &inferParam);
                 threadTbl.push_back(inferParam);
                 // Read track configuration from model_config -> track_config (same level as io_info)
                 bool enableTrackingModel = true; // default behavior remains true
                 string trackModelPathModel = "";
-                Json::Value trackingConfigModel;
                 bool hasTrackConfigModel = false;
                 if (root["device_config"][i]["model_config"][j]["track_config"].type() != Json::nullValue)
                 {
@@ -440,10 +769,6 @@ void CreateALLThreadInstance(vector<AclLiteThreadParam> &threadTbl,
                     {
                         trackModelPathModel = trackConf["track_model_path"].asString();
                     }
-                    if (trackConf["tracking_config"].type() != Json::nullValue)
-                    {
-                        trackingConfigModel = trackConf["tracking_config"];
-                    }
                 }
 
                 for (int k = 0;
@@ -469,6 +794,16 @@ void CreateALLThreadInstance(vector<AclLiteThreadParam> &threadTbl,
                             [k]["channel_id"]
                                 .asInt();
                     ResizeProcessType channelResizeType = modelResizeType; // 缩放方式
+                    AclLiteQueueType channelQueueType = modelQueueType; // 消息队列类型
+                    if (root["device_config"][i]["model_config"][j]["io_info"][k]
+                            ["msg_queue_type"]
+                                .type() != Json::nullValue)
+                    {
+                        channelQueueType = ParseQueueType(
+                            root["device_config"][i]["model_config"][j]["io_info"][k]
+                                ["msg_queue_type"],
+                            "io_info");
+                    }
                     bool channelUseNms = modelUseNms; // 是否启用NMS
                     if (root["device_config"][i]["model_config"][j]["io_info"][k]
                             ["resize_type"]
@@ -479,6 +814,20 @@ void CreateALLThreadInstance(vector<AclLiteThreadParam> &threadTbl,
                                 ["resize_type"],
                             "io_info");
                     }
+                    map<string, EdgePolicy> channelEdgePolicies =
+                        modelEdgePolicies; // 通道级可覆盖发送策略
+                    ParseEdgePolicies(
+                        root["device_config"][i]["model_config"][j]["io_info"][k]
+                            ["edge_policy"],
+                        "io_info",
+                        &channelEdgePolicies);
+                    map<string, AclLiteThreadSched> channelScheds =
+                        modelScheds; // 通道级可覆盖调度配置
+                    ParseThreadSched(
+                        root["device_config"][i]["model_config"][j]["io_info"][k]
+                            ["thread_sched"],
+                        "io_info",
+                        &channelScheds);
                     if (root["device_config"][i]["model_config"][j]["io_info"][k]
                             ["use_nms"]
                                 .type() != Json::nullValue)
@@ -490,118 +839,9 @@ void CreateALLThreadInstance(vector<AclLiteThreadParam> &threadTbl,
                     }
                     
                     // 解析 RTSP 和 H264 编码配置
-                    VencConfig vencConfig;
-                    vencConfig.maxWidth = modelWidth;
-                    vencConfig.maxHeight = modelHeigth;
-                    
-                    // 解析 rtsp_config（仅 rtsp 输出生效）
-                    if (outputType == "rtsp" &&
-                        root["device_config"][i]["model_config"][j]["io_info"][k]["rtsp_config"].type() != Json::nullValue)
-                    {
-                        Json::Value rtspCfg = root["device_config"][i]["model_config"][j]["io_info"][k]["rtsp_config"];
-                        if (rtspCfg["output_width"].type() != Json::nullValue)
-                        {
-                            vencConfig.outputWidth = rtspCfg["output_width"].asUInt();
-                        }
-                        if (rtspCfg["output_height"].type() != Json::nullValue)
-                        {
-                            vencConfig.outputHeight = rtspCfg["output_height"].asUInt();
-                        }
-                        if (rtspCfg["output_fps"].type() != Json::nullValue)
-                        {
-                            vencConfig.outputFps = rtspCfg["output_fps"].asUInt();
-                            if (vencConfig.outputFps < 1 || vencConfig.outputFps > 60)
-                            {
-                                ACLLITE_LOG_WARNING("Output FPS %u out of range [1,60], using default 25", vencConfig.outputFps);
-                                vencConfig.outputFps = 25;
-                            }
-                        }
-                        if (rtspCfg["transport"].type() != Json::nullValue)
-                        {
-                            vencConfig.rtspTransport = rtspCfg["transport"].asString();
-                        }
-                        if (rtspCfg["buffer_size"].type() != Json::nullValue)
-                        {
-                            vencConfig.rtspBufferSize = rtspCfg["buffer_size"].asUInt();
-                        }
-                        if (rtspCfg["max_delay"].type() != Json::nullValue)
-                        {
-                            vencConfig.rtspMaxDelay = rtspCfg["max_delay"].asUInt();
-                        }
-                    }
-
-                    // 解析 hdmi_config（仅 hdmi 输出生效）
-                    if (outputType == "hdmi" &&
-                        root["device_config"][i]["model_config"][j]["io_info"][k]["hdmi_config"].type() != Json::nullValue)
-                    {
-                        Json::Value hdmiCfg = root["device_config"][i]["model_config"][j]["io_info"][k]["hdmi_config"];
-                        if (hdmiCfg["output_width"].type() != Json::nullValue)
-                        {
-                            vencConfig.outputWidth = hdmiCfg["output_width"].asUInt();
-                        }
-                        if (hdmiCfg["output_height"].type() != Json::nullValue)
-                        {
-                            vencConfig.outputHeight = hdmiCfg["output_height"].asUInt();
-                        }
-                        if (hdmiCfg["output_fps"].type() != Json::nullValue)
-                        {
-                            vencConfig.outputFps = hdmiCfg["output_fps"].asUInt();
-                            if (vencConfig.outputFps < 1 || vencConfig.outputFps > 60)
-                            {
-                                ACLLITE_LOG_WARNING("HDMI output FPS %u out of range [1,60], using default 25", vencConfig.outputFps);
-                                vencConfig.outputFps = 25;
-                            }
-                        }
-                    }
-                    
-                    // 解析 h264_config
-                    if (root["device_config"][i]["model_config"][j]["io_info"][k]["h264_config"].type() != Json::nullValue)
-                    {
-                        Json::Value h264Cfg = root["device_config"][i]["model_config"][j]["io_info"][k]["h264_config"];
-                        if (h264Cfg["gop_size"].type() != Json::nullValue)
-                        {
-                            vencConfig.gopSize = h264Cfg["gop_size"].asUInt();
-                            if (vencConfig.gopSize < 1 || vencConfig.gopSize > 300)
-                            {
-                                ACLLITE_LOG_WARNING("GOP size %u out of range [1,300], using default 16", vencConfig.gopSize);
-                                vencConfig.gopSize = 16;
-                            }
-                        }
-                        if (h264Cfg["rc_mode"].type() != Json::nullValue)
-                        {
-                            vencConfig.rcMode = h264Cfg["rc_mode"].asUInt();
-                            if (vencConfig.rcMode > 2)
-                            {
-                                ACLLITE_LOG_WARNING("RC mode %u invalid (0=CBR,1=VBR,2=AVBR), using default 2", vencConfig.rcMode);
-                                vencConfig.rcMode = 2;
-                            }
-                        }
-                        if (h264Cfg["max_bitrate"].type() != Json::nullValue)
-                        {
-                            vencConfig.maxBitrate = h264Cfg["max_bitrate"].asUInt();
-                            if (vencConfig.maxBitrate < 500 || vencConfig.maxBitrate > 50000)
-                            {
-                                ACLLITE_LOG_WARNING("Bitrate %u kbps out of range [500,50000], using default 10000", vencConfig.maxBitrate);
-                                vencConfig.maxBitrate = 10000;
-                            }
-                        }
-                        if (h264Cfg["profile"].type() != Json::nullValue)
-                        {
-                            std::string profile = h264Cfg["profile"].asString();
-                            if (profile == "baseline")
-                            {
-                                vencConfig.enType = H264_BASELINE_LEVEL;
-                            }
-                            else if (profile == "main")
-                            {
-                                vencConfig.enType = H264_MAIN_LEVEL;
-                            }
-                            else if (profile == "high")
-                            {
-                                vencConfig.enType = H264_HIGH_LEVEL;
-                            }
-                        }
-                    }
+                    VencConfig vencConfig = ParseVencConfig(
+                        root["device_config"][i]["model_config"][j]["io_info"][k], outputType, modelWidth, modelHeigth);
+                    vencConfig.channelId = channelId;
                     string dataInputName =
                         kDataInputName + to_string(channelId);
                     string preName = kPreName + to_string(channelId);
@@ -610,37 +850,9 @@ void CreateALLThreadInstance(vector<AclLiteThreadParam> &threadTbl,
                     string rtspDisplayName =
                         kRtspDisplayName + to_string(channelId);
 
-                    // per-channel frame decimation override (defaults to model-level)
-                    int channelFrameDecimation = modelFrameDecimation;
-                    vector<int> channel_target_class_ids = model_target_class_ids; // 通道级过滤类别列表
-                    if (root["device_config"][i]["model_config"][j]["io_info"][k]["frame_decimation"]
-                            .type() != Json::nullValue)
-                    {
-                        channelFrameDecimation =
-                            root["device_config"][i]["model_config"][j]["io_info"][k]
-                                ["frame_decimation"]
-                                    .asInt();
-                        if (channelFrameDecimation < 0)
-                        {
-                            ACLLITE_LOG_WARNING(
-                                "io_info[%d] frame_decimation is negative, clamping to 0",
-                                channelId);
-                            channelFrameDecimation = 0;
-                        }
-                    }
-                    if (root["device_config"][i]["model_config"][j]["io_info"][k]["target_class_id"]
-                            .type() != Json::nullValue)
-                    {
-                        ParseTargetClassIds(
-                            root["device_config"][i]["model_config"][j]["io_info"][k]["target_class_id"],
-                            "io_info",
-                            &channel_target_class_ids);
-                    }
-
                     // 解析跟踪配置（通道级可覆盖）
                     bool enableTracking = enableTrackingModel;
                     string trackModelPath = trackModelPathModel;
-                    Json::Value trackingConfig;
                     if (!hasTrackConfigModel)
                     {
                         if (root["device_config"][i]["model_config"][j]["io_info"][k]["enable_tracking"].type() != Json::nullValue)
@@ -652,86 +864,36 @@ void CreateALLThreadInstance(vector<AclLiteThreadParam> &threadTbl,
                             trackModelPath = root["device_config"][i]["model_config"][j]["io_info"][k]["track_model_path"].asString();
                         }
                     }
-                    if (trackingConfigModel.type() != Json::nullValue)
-                    {
-                        trackingConfig = trackingConfigModel;
-                    }
-                    else if (root["device_config"][i]["model_config"][j]["io_info"][k]["tracking_config"].type() != Json::nullValue)
-                    {
-                        trackingConfig = root["device_config"][i]["model_config"][j]["io_info"][k]["tracking_config"];
-                    }
 
-                    bool  enableTrackingValidation = false; // 是否启用检测验证
-                    int   trackingValidationInterval = 0;   // 验证间隔
-                    float trackingValidationIouThreshold = 0.30f; // IOU阈值
-                    int   trackingValidationMaxErrors = 3;  // 最大错误次数
-                    if (trackingConfig.type() != Json::nullValue)
-                    {
-                        if (trackingConfig["enable_tracking_validation"].type() != Json::nullValue)
-                        {
-                            enableTrackingValidation =
-                                trackingConfig["enable_tracking_validation"].asBool();
-                        }
-                        if (trackingConfig["validation_interval"].type() != Json::nullValue)
-                        {
-                            int interval =
-                                trackingConfig["validation_interval"].asInt(); // 验证间隔
-                            if (interval > 0)
-                            {
-                                trackingValidationInterval = interval;
-                            }
-                            else
-                            {
-                                ACLLITE_LOG_WARNING(
-                                    "tracking validation_interval=%d invalid for channel %d",
-                                    interval,
-                                    channelId);
-                            }
-                        }
-                        if (trackingConfig["validation_iou_threshold"].type() != Json::nullValue)
-                        {
-                            float threshold =
-                                trackingConfig["validation_iou_threshold"].asFloat(); // IOU阈值
-                            if (threshold >= 0.0f && threshold <= 1.0f)
-                            {
-                                trackingValidationIouThreshold = threshold;
-                            }
-                            else
-                            {
-                                ACLLITE_LOG_WARNING(
-                                    "tracking validation_iou_threshold=%.2f out of range for channel %d",
-                                    threshold,
-                                    channelId);
-                            }
-                        }
-                        if (trackingConfig["validation_max_error_count"].type() != Json::nullValue)
-                        {
-                            int maxErrors =
-                                trackingConfig["validation_max_error_count"].asInt(); // 最大错误次数
-                            if (maxErrors > 0)
-                            {
-                                trackingValidationMaxErrors = maxErrors;
-                            }
-                            else
-                            {
-                                ACLLITE_LOG_WARNING(
-                                    "tracking validation_max_error_count=%d invalid for channel %d",
-                                    maxErrors,
-                                    channelId);
-                            }
-                        }
-                    }
-                    if (enableTrackingValidation && trackingValidationInterval <= 0)
-                    {
-                        ACLLITE_LOG_WARNING(
-                            "tracking validation enabled but interval invalid for channel %d, disabling validation",
-                            channelId);
-                        enableTrackingValidation = false;
-                    }
+                    const InputTuning &inputTuning =
+                        kRuntimeTuning.inputs[dataInputName]; // 跳帧与检测验证
+
+                    bool channelLiveMode = modelLiveMode; // 通道级可覆盖
+                    ParseLatencyMode(
+                        root["device_config"][i]["model_config"][j]["io_info"][k]
+                            ["latency_mode"],
+                        "io_info",
+                        &channelLiveMode);
+                    VideoDecodeConfig channelDecodeConfig = modelDecodeConfig;
+                    ParseDecodeConfig(
+                        root["device_config"][i]["model_config"][j]["io_info"][k],
+                        "io_info",
+                        &channelDecodeConfig);
+                    MotionGateConfig channelMotionGate = modelMotionGate;
+                    ParseMotionGateConfig(
+                        root["device_config"][i]["model_config"][j]["io_info"][k]
+                            ["motion_gate"],
+                        "io_info",
+                        &channelMotionGate);
+                    AdaptiveDecimationConfig channelAdaptive = modelAdaptive;
+                    ParseAdaptiveDecimation(
+                        root["device_config"][i]["model_config"][j]["io_info"][k]
+                            ["adaptive_decimation"],
+                        "io_info",
+                        &channelAdaptive);
 
                     // Create Thread for the input data:
-                    AclLiteThreadParam dataInputParam;
-                    dataInputParam.threadInst =
+                    DataInputThread *dataInput =
                         new DataInputThread(deviceId,
                                             channelId,
                                             runMode,
@@ -739,28 +901,50 @@ void CreateALLThreadInstance(vector<AclLiteThreadParam> &threadTbl,
                                             inputPath,
                                             inferName,
                                             kPostNum,
-                                            kBatch,
+                                            msgFrameNum,
                                             kFramesPerSecond,
-                                            channelFrameDecimation,
+                                            inputTuning.frameDecimation,
                                             outputType,
-                                            enableTrackingValidation,
-                                            trackingValidationInterval);
+                                            inputTuning.trackingValidationEnabled,
+                                            inputTuning.trackingValidationInterval);
+                    dataInput->SetLiveMode(channelLiveMode);
+                    dataInput->SetRawConfig(ParseRawConfig(
+                        root["device_config"][i]["model_config"][j]["io_info"][k]
+                            ["raw_config"],
+                        "io_info"));
+                    dataInput->SetPicConfig(ParsePicConfig(
+                        root["device_config"][i]["model_config"][j]["io_info"][k]
+                            ["pic_config"],
+                        "io_info"));
+                    dataInput->SetDecodeConfig(channelDecodeConfig);
+                    dataInput->SetMotionGateConfig(channelMotionGate);
+                    dataInput->SetAdaptiveDecimation(channelAdaptive);
+                    AclLiteThreadParam dataInputParam;
+                    dataInputParam.threadInst = dataInput;
                     dataInputParam.threadInstName.assign(dataInputName.c_str());
                     dataInputParam.context = context;
                     dataInputParam.runMode = runMode;
                     dataInputParam.queueSize = kMsgQueueSize;
+                    dataInputParam.queueType =
+                        StageQueueType(channelQueueType, 1, dataInputName);
+                    ApplyThreadSched(channelScheds, kStageDataInput, &dataInputParam);
                     threadTbl.push_back(dataInputParam);
 
                     AclLiteThreadParam detectPreParam;
                     detectPreParam.threadInst = new DetectPreprocessThread(
                         modelWidth,
                         modelHeigth,
-                        kBatch,
+                        msgFrameNum,
                         channelResizeType);
                     detectPreParam.threadInstName.assign(preName.c_str());
                     detectPreParam.context = context;
                     detectPreParam.runMode = runMode;
                     detectPreParam.queueSize = kMsgQueueSize;
+                    detectPreParam.queueType =
+                        StageQueueType(channelQueueType, 1, preName);
+                    ApplyEdgePolicy(channelEdgePolicies, kEdgeDetectPre, &detectPreParam);
+                    ApplyThreadSched(channelScheds, kEdgeDetectPre, &detectPreParam);
+                    ApplyExecMode(poolStages, kEdgeDetectPre, &detectPreParam);
                     threadTbl.push_back(detectPreParam);
                     for (int m = 0; m < kPostNum; m++)
                     {
@@ -772,13 +956,18 @@ void CreateALLThreadInstance(vector<AclLiteThreadParam> &threadTbl,
                                 modelWidth,
                                 modelHeigth,
                                 runMode,
-                                kBatch,
-                                channel_target_class_ids,
+                                msgFrameNum,
+                                kRuntimeTuning.posts[postName],
                                 channelResizeType,
                                 channelUseNms);
                         detectPostParam.threadInstName.assign(postName.c_str());
                         detectPostParam.context = context;
                         detectPostParam.runMode = runMode;
+                        detectPostParam.queueType =
+                            StageQueueType(channelQueueType, 1, postName);
+                        ApplyEdgePolicy(channelEdgePolicies, kEdgeDetectPost, &detectPostParam);
+                        ApplyThreadSched(channelScheds, kEdgeDetectPost, &detectPostParam);
+                        ApplyExecMode(poolStages, kEdgeDetectPost, &detectPostParam);
                         threadTbl.push_back(detectPostParam);
                     }
 
@@ -788,83 +977,20 @@ void CreateALLThreadInstance(vector<AclLiteThreadParam> &threadTbl,
                     if (enableTracking)
                     {
                         trackingInst = new Tracking(trackModelPath); // 使用配置文件中的模型路径
-                        
-                        // 读取并设置跟踪配置参数
-                        if (trackingConfig.type() != Json::nullValue)
-                        {
-                            
-                            if (trackingConfig["confidence_active_threshold"].type() != Json::nullValue)
-                            {
-                                float threshold = trackingConfig["confidence_active_threshold"].asFloat();
-                                trackingInst->setConfidenceActiveThreshold(threshold);
-                                ACLLITE_LOG_INFO("Set tracking confidence_active_threshold=%.2f for channel %d", threshold, channelId);
-                            }
-                            
-                            if (trackingConfig["confidence_redetect_threshold"].type() != Json::nullValue)
-                            {
-                                float threshold = trackingConfig["confidence_redetect_threshold"].asFloat();
-                                trackingInst->setConfidenceRedetectThreshold(threshold);
-                                ACLLITE_LOG_INFO("Set tracking confidence_redetect_threshold=%.2f for channel %d", threshold, channelId);
-                            }
-                            
-                            if (trackingConfig["max_track_loss_frames"].type() != Json::nullValue)
-                            {
-                                int maxLossFrames = trackingConfig["max_track_loss_frames"].asInt();
-                                trackingInst->setMaxTrackLossFrames(maxLossFrames);
-                                ACLLITE_LOG_INFO("Set tracking max_track_loss_frames=%d for channel %d", maxLossFrames, channelId);
-                            }
-                            
-                            if (trackingConfig["score_decay_factor"].type() != Json::nullValue)
-                            {
-                                float decay = trackingConfig["score_decay_factor"].asFloat();
-                                trackingInst->setMaxScoreDecay(decay);
-                                ACLLITE_LOG_INFO("Set tracking score_decay_factor=%.2f for channel %d", decay, channelId);
-                            }
-
-                            if (trackingConfig["filter_suspect_static_target"].type() != Json::nullValue)
-                            {
-                                bool enabled = trackingConfig["filter_suspect_static_target"].asBool();
-                                trackingInst->setStaticTargetFilterEnabled(enabled);
-                                ACLLITE_LOG_INFO("Set tracking filter_suspect_static_target=%s for channel %d",
-                                                 enabled ? "true" : "false", channelId);
-                            }
-                            if (trackingConfig["static_center_threshold"].type() != Json::nullValue)
-                            {
-                                float threshold = trackingConfig["static_center_threshold"].asFloat();
-                                trackingInst->setStaticCenterThreshold(threshold);
-                                ACLLITE_LOG_INFO("Set tracking static_center_threshold=%.2f for channel %d", threshold, channelId);
-                            }
-                            if (trackingConfig["static_size_threshold"].type() != Json::nullValue)
-                            {
-                                float threshold = trackingConfig["static_size_threshold"].asFloat();
-                                trackingInst->setStaticSizeThreshold(threshold);
-                                ACLLITE_LOG_INFO("Set tracking static_size_threshold=%.2f for channel %d", threshold, channelId);
-                            }
-                            if (trackingConfig["static_frame_threshold"].type() != Json::nullValue)
-                            {
-                                int threshold = trackingConfig["static_frame_threshold"].asInt();
-                                trackingInst->setStaticFrameThreshold(threshold);
-                                ACLLITE_LOG_INFO("Set tracking static_frame_threshold=%d for channel %d", threshold, channelId);
-                            }
-                        }
+                        trackingInst->UpdateTuning(make_shared<const TrackTuning>(
+                            kRuntimeTuning.tracks[trackName]));
 
-                        trackingInst->setTrackingValidationEnabled(enableTrackingValidation);
-                        trackingInst->setTrackingValidationIouThreshold(trackingValidationIouThreshold);
-                        trackingInst->setTrackingValidationMaxErrors(trackingValidationMaxErrors);
-                        ACLLITE_LOG_INFO(
-                            "Set tracking validation enable=%s interval=%d iou_threshold=%.2f max_errors=%d for channel %d",
-                            enableTrackingValidation ? "true" : "false",
-                            trackingValidationInterval,
-                            trackingValidationIouThreshold,
-                            trackingValidationMaxErrors,
-                            channelId);
-                        
                         AclLiteThreadParam trackParam;
                         trackParam.threadInst = trackingInst;
                         trackParam.threadInstName.assign(trackName.c_str());
                         trackParam.context = context;
                         trackParam.runMode = runMode;
                         trackParam.queueSize = kMsgQueueSize;
+                        trackParam.queueType =
+                            StageQueueType(channelQueueType, 2, trackName);
+                        ApplyEdgePolicy(channelEdgePolicies, kEdgeTrack, &trackParam);
+                        ApplyThreadSched(channelScheds, kEdgeTrack, &trackParam);
+                        ApplyExecMode(poolStages, kEdgeTrack, &trackParam);
                         threadTbl.push_back(trackParam);
                     }
 
@@ -875,6 +1001,11 @@ void CreateALLThreadInstance(vector<AclLiteThreadParam> &threadTbl,
                         dataOutputName.c_str());
                     dataOutputParam.context = context;
                     dataOutputParam.runMode = runMode;
+                    dataOutputParam.queueType =
+                        StageQueueType(channelQueueType, 2, dataOutputName);
+                    ApplyEdgePolicy(channelEdgePolicies, kEdgeDataOutput, &dataOutputParam);
+                    ApplyThreadSched(channelScheds, kEdgeDataOutput, &dataOutputParam);
+                    ApplyExecMode(poolStages, kEdgeDataOutput, &dataOutputParam);
                     threadTbl.push_back(dataOutputParam);
 
                     if (outputType == "rtsp")
@@ -886,7 +1017,11 @@ void CreateALLThreadInstance(vector<AclLiteThreadParam> &threadTbl,
                             rtspDisplayName.c_str());
                         rtspDisplayThreadParam.context = context;
                         rtspDisplayThreadParam.runMode = runMode;
-                        rtspDisplayThreadParam.queueSize = 1000;  // 增大队列避免积压
+                        rtspDisplayThreadParam.queueSize = kDisplayQueueSize;  // 增大队列避免积压
+                        rtspDisplayThreadParam.queueType =
+                            StageQueueType(channelQueueType, 1, rtspDisplayName);
+                        ApplyEdgePolicy(channelEdgePolicies, kEdgeDisplay, &rtspDisplayThreadParam);
+                        ApplyThreadSched(channelScheds, kEdgeDisplay, &rtspDisplayThreadParam);
                         threadTbl.push_back(rtspDisplayThreadParam);
                     }
                     else if (outputType == "hdmi")
@@ -897,7 +1032,13 @@ void CreateALLThreadInstance(vector<AclLiteThreadParam> &threadTbl,
                             (kHdmiDisplayName + to_string(channelId)).c_str());
                         hdmiDisplayParam.context = context;
                         hdmiDisplayParam.runMode = runMode;
-                        hdmiDisplayParam.queueSize = 1000; // 与 RTSP 输出一致，避免 decimation 模式下排队失败
+                        hdmiDisplayParam.queueSize = kDisplayQueueSize; // 与 RTSP 输出一致，避免 decimation 模式下排队失败
+                        hdmiDisplayParam.queueType = StageQueueType(
+                            channelQueueType,
+                            1,
+                            hdmiDisplayParam.threadInstName);
+                        ApplyEdgePolicy(channelEdgePolicies, kEdgeDisplay, &hdmiDisplayParam);
+                        ApplyThreadSched(channelScheds, kEdgeDisplay, &hdmiDisplayParam);
                         threadTbl.push_back(hdmiDisplayParam);
                     }
                     kExitCount++;
@@ -910,12 +1051,19 @@ void CreateALLThreadInstance(vector<AclLiteThreadParam> &threadTbl,
 
 void ExitApp(AclLiteApp &app, vector<AclLiteThreadParam> &threadTbl)
 {
+    // a reload must not publish to instances that are about to be freed
+    AclLiteConfigWatcher::GetInstance().Stop();
+    // stop threads and pool workers before the instances they run are freed
+    app.Exit();
+    // final summary and dump after the last message is processed
+    AclLiteMetricsServer::GetInstance().Stop();
+    AclLiteMetrics::GetInstance().StopReporter();
+    AclLiteTracer::GetInstance().Stop();
     for (int i = 0; i < threadTbl.size(); i++)
     {
         aclrtSetCurrentContext(threadTbl[i].context);
         delete threadTbl[i].threadInst;
     }
-    app.Exit();
 
     for (int i = 0; i < kContext.size(); i++)
     {
@@ -930,7 +1078,13 @@ void ExitApp(AclLiteApp &app, vector<AclLiteThreadParam> &threadTbl)
 void StartApp(AclLiteResource &aclDev)
 {
     vector<AclLiteThreadParam> threadTbl;
-    CreateALLThreadInstance(threadTbl, aclDev);
+    Json::Value                root;
+    CreateALLThreadInstance(threadTbl, aclDev, root);
+    if (threadTbl.empty())
+    {
+        ACLLITE_LOG_ERROR("No thread is created, check %s", kJsonFile.c_str());
+        return;
+    }
     AclLiteApp  &app = CreateAclLiteAppInstance();
     AclLiteError ret = app.Start(threadTbl);
     if (ret != ACLLITE_OK)
@@ -940,9 +1094,14 @@ void StartApp(AclLiteResource &aclDev)
         return;
     }
 
+    StartConfigWatcher(root, threadTbl);
     for (int i = 0; i < threadTbl.size(); i++)
     {
-        ret = SendMessage(threadTbl[i].threadInstId, MSG_APP_START, nullptr);
+        // 走控制通道, 不占用 spsc 队列的唯一发送方
+        ret = SendMessage(threadTbl[i].threadInstId,
+                          MSG_APP_START,
+                          nullptr,
+                          ACLLITE_PRIO_HIGH);
     }
     app.Wait(MainThreadProcess, nullptr);
     ExitApp(app, threadTbl);
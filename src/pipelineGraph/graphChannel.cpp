@@ -0,0 +1,224 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File graphChannel.cpp
+* Description: resolves the input channels of a pipeline graph
+*/
+#include "graphChannel.h"
+#include "AclLiteUtils.h"
+#include "pipelineConfig.h"
+
+using namespace std;
+
+// the only element of nodes, nullptr and an error if there are more or none
+static const GraphNode *OnlyNode(const vector<const GraphNode *> &nodes,
+                                 const GraphNode                 &node,
+                                 const char                      *what)
+{
+    if (nodes.size() != 1)
+    {
+        ACLLITE_LOG_ERROR("graph node %s needs exactly one %s, found %zu",
+                          node.name.c_str(),
+                          what,
+                          nodes.size());
+        return nullptr;
+    }
+    return nodes[0];
+}
+
+static bool HasGraphEdge(const PipelineGraph &graph,
+                         const GraphNode     &from,
+                         const GraphNode     &to)
+{
+    for (const GraphNode *next : graph.Successors(from.name, to.type))
+    {
+        if (next == &to)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+GraphModel ReadGraphModel(const GraphNode &infer)
+{
+    GraphModel model;
+    model.width = infer.params["model_width"].asUInt();
+    // device_config spells it model_heigth
+    model.height = infer.params.isMember("model_height")
+                       ? infer.params["model_height"].asUInt()
+                       : infer.params["model_heigth"].asUInt();
+    if (infer.params["model_batch"].type() != Json::nullValue)
+    {
+        model.batch = infer.params["model_batch"].asUInt();
+    }
+    model.batchDeadlineUs =
+        ParseBatchDeadline(infer.params["batch_deadline_ms"], infer.name);
+    return model;
+}
+
+// data_input node of the channel the node belongs to; detect_infer may be
+// shared by several channels and belongs to none
+static const GraphNode *GraphChannelInput(const PipelineGraph &graph,
+                                          const GraphNode     &node)
+{
+    if (node.type == kStageDataInput)
+    {
+        return &node;
+    }
+    if (node.type == kEdgeDetectPost)
+    {
+        vector<const GraphNode *> next =
+            graph.Successors(node.name, kEdgeDataOutput);
+        vector<const GraphNode *> track = graph.Successors(node.name, kEdgeTrack);
+        next.insert(next.end(), track.begin(), track.end());
+        const GraphNode *target =
+            OnlyNode(next, node, "data_output or track successor");
+        return target == nullptr ? nullptr : GraphChannelInput(graph, *target);
+    }
+    if (node.type == kNodeRtspDisplay || node.type == kNodeHdmiDisplay)
+    {
+        const GraphNode *output =
+            OnlyNode(graph.Predecessors(node.name, kEdgeDataOutput),
+                     node,
+                     "data_output predecessor");
+        return output == nullptr ? nullptr : GraphChannelInput(graph, *output);
+    }
+    return OnlyNode(graph.Predecessors(node.name, kStageDataInput),
+                    node,
+                    "data_input predecessor");
+}
+
+AclLiteError CollectGraphChannels(const PipelineGraph &graph,
+                                  set<uint32_t>       *channelIds)
+{
+    channelIds->clear();
+    for (const GraphNode &node : graph.Nodes())
+    {
+        if (node.type != kStageDataInput)
+        {
+            continue;
+        }
+        if (!node.params["channel_id"].isIntegral() ||
+            node.params["channel_id"].asInt() < 0 ||
+            !channelIds->insert(node.params["channel_id"].asUInt()).second)
+        {
+            ACLLITE_LOG_ERROR("graph node %s channel_id is missing, negative "
+                              "or duplicated",
+                              node.name.c_str());
+            return ACLLITE_ERROR;
+        }
+    }
+    if (channelIds->empty())
+    {
+        ACLLITE_LOG_ERROR("graph has no data_input node");
+        return ACLLITE_ERROR;
+    }
+    return ACLLITE_OK;
+}
+
+AclLiteError ResolveGraphChannel(const PipelineGraph &graph,
+                                 const GraphNode     &input,
+                                 GraphChannel        *channel)
+{
+    *channel = GraphChannel();
+    channel->input = &input;
+    channel->channelId = input.params["channel_id"].asUInt();
+    channel->pre = OnlyNode(graph.Successors(input.name, kEdgeDetectPre),
+                            input,
+                            "detect_pre successor");
+    channel->output = OnlyNode(graph.Successors(input.name, kEdgeDataOutput),
+                               input,
+                               "data_output successor");
+    if (channel->pre == nullptr || channel->output == nullptr)
+    {
+        return ACLLITE_ERROR;
+    }
+    channel->infer = OnlyNode(graph.Successors(channel->pre->name, kEdgeDetectInfer),
+                              *channel->pre,
+                              "detect_infer successor");
+    if (channel->infer == nullptr ||
+        OnlyNode(graph.Predecessors(channel->output->name, kStageDataInput),
+                 *channel->output,
+                 "data_input predecessor") == nullptr)
+    {
+        return ACLLITE_ERROR;
+    }
+    vector<const GraphNode *> tracks = graph.Successors(input.name, kEdgeTrack);
+    if (tracks.size() > 1)
+    {
+        ACLLITE_LOG_ERROR("graph node %s has %zu track successors, at most one",
+                          input.name.c_str(),
+                          tracks.size());
+        return ACLLITE_ERROR;
+    }
+    if (!tracks.empty())
+    {
+        channel->track = tracks[0];
+        if (!HasGraphEdge(graph, *channel->track, *channel->output))
+        {
+            ACLLITE_LOG_ERROR("graph needs edge %s -> %s",
+                              channel->track->name.c_str(),
+                              channel->output->name.c_str());
+            return ACLLITE_ERROR;
+        }
+    }
+    // post results go through track, if any, before output
+    const GraphNode *sink =
+        channel->track != nullptr ? channel->track : channel->output;
+    for (const GraphNode *post :
+         graph.Successors(channel->infer->name, kEdgeDetectPost))
+    {
+        if (HasGraphEdge(graph, *post, *sink))
+        {
+            channel->posts.push_back(post);
+        }
+    }
+    if (channel->posts.empty())
+    {
+        ACLLITE_LOG_ERROR("graph channel %s has no detect_post from %s to %s",
+                          input.name.c_str(),
+                          channel->infer->name.c_str(),
+                          sink->name.c_str());
+        return ACLLITE_ERROR;
+    }
+    vector<const GraphNode *> displays =
+        graph.Successors(channel->output->name, kNodeRtspDisplay);
+    vector<const GraphNode *> hdmis =
+        graph.Successors(channel->output->name, kNodeHdmiDisplay);
+    displays.insert(displays.end(), hdmis.begin(), hdmis.end());
+    if (displays.size() > 1)
+    {
+        ACLLITE_LOG_ERROR("graph node %s has %zu display successors, at most "
+                          "one",
+                          channel->output->name.c_str(),
+                          displays.size());
+        return ACLLITE_ERROR;
+    }
+    channel->display = displays.empty() ? nullptr : displays[0];
+    return ACLLITE_OK;
+}
+
+AclLiteError ResolveNodeChannel(const PipelineGraph &graph,
+                                const GraphNode     &node,
+                                GraphChannel        *channel)
+{
+    const GraphNode *input = GraphChannelInput(graph, node);
+    if (input == nullptr)
+    {
+        return ACLLITE_ERROR;
+    }
+    return ResolveGraphChannel(graph, *input, channel);
+}
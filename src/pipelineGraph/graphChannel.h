@@ -0,0 +1,75 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File graphChannel.h
+* Description: resolves the input channels of a pipeline graph
+*/
+#ifndef GRAPHCHANNEL_H
+#define GRAPHCHANNEL_H
+#pragma once
+#include "pipelineGraph.h"
+#include <set>
+#include <vector>
+
+// nodes one input channel goes through, resolved once at startup
+struct GraphChannel
+{
+    uint32_t                       channelId = 0;
+    const GraphNode               *input = nullptr;
+    const GraphNode               *pre = nullptr;
+    const GraphNode               *infer = nullptr;
+    std::vector<const GraphNode *> posts;
+    const GraphNode               *track = nullptr; // optional
+    const GraphNode               *output = nullptr;
+    const GraphNode               *display = nullptr; // optional, rtsp or hdmi
+};
+
+// input size and batch of the detection model, from the detect_infer node
+struct GraphModel
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t batch = 1;
+    uint32_t batchDeadlineUs = 0; // > 0: the infer thread batches channels
+};
+
+GraphModel ReadGraphModel(const GraphNode &infer);
+
+/**
+ * @brief Channel ids of all data_input nodes
+ * @param [out]: channelIds: one per channel, they tell the channels apart in
+ *               metrics, traces and push urls
+ * @return ACLLITE_ERROR if there is no data_input or an id is missing,
+ *         negative or duplicated
+ */
+AclLiteError CollectGraphChannels(const PipelineGraph &graph,
+                                  std::set<uint32_t>  *channelIds);
+
+/**
+ * @brief Resolve the channel starting at a data_input node. The topology is
+ *        the one of device_config: input -> pre -> infer -> post (one or
+ *        more) -> [track ->] output -> [display]. Decimated frames go from
+ *        input straight to output, so the input -> output edge is required,
+ *        as is input -> track when there is a track.
+ */
+AclLiteError ResolveGraphChannel(const PipelineGraph &graph,
+                                 const GraphNode     &input,
+                                 GraphChannel        *channel);
+// resolve the channel a node belongs to
+AclLiteError ResolveNodeChannel(const PipelineGraph &graph,
+                                const GraphNode     &node,
+                                GraphChannel        *channel);
+
+#endif
@@ -0,0 +1,483 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File graphNodes.cpp
+* Description: factories of the detection node types of a pipeline graph
+*/
+#include "graphNodes.h"
+#include "AclLiteUtils.h"
+#include "dataInput/dataInput.h"
+#include "dataOutput/dataOutput.h"
+#include "detectInference/detectInference.h"
+#include "detectPostprocess/detectPostprocess.h"
+#include "detectPreprocess/detectPreprocess.h"
+#include "graphChannel.h"
+#include "hdmiOutput/hdmiOutputThread.h"
+#include "pushrtsp/pushrtspthread.h"
+#include "tracking/tracking.h"
+#include <algorithm>
+#include <memory>
+
+using namespace std;
+
+
+typedef AclLiteError (*GraphNodeCreator)(GraphBuildEnv       &env,
+                                         const PipelineGraph &graph,
+                                         const GraphNode     &node,
+                                         AclLiteThreadParam  *param);
+
+// context of the device, acquired on first use and kept in env.contexts
+static aclrtContext GetGraphContext(GraphBuildEnv &env, uint32_t deviceId)
+{
+    auto it = env.contexts.find(deviceId);
+    if (it != env.contexts.end())
+    {
+        return it->second;
+    }
+    aclrtContext context = env.aclDev->GetContextByDevice(deviceId);
+    if (context == nullptr)
+    {
+        ACLLITE_LOG_ERROR("Get acl context in device %u failed", deviceId);
+        return nullptr;
+    }
+    env.contexts[deviceId] = context;
+    return context;
+}
+
+// The thread_sched of a node is the sched of its one thread, e.g.
+// {"cpus": [2]}. Data messages only travel along graph edges, plus the
+// MSG_READ_FRAME a data_input sends to itself.
+static AclLiteError InitGraphNodeParam(GraphBuildEnv       &env,
+                                       const PipelineGraph &graph,
+                                       const GraphNode     &node,
+                                       const string        &stage,
+                                       AclLiteThreadParam  *param)
+{
+    param->context = GetGraphContext(env, node.deviceId);
+    if (param->context == nullptr)
+    {
+        return ACLLITE_ERROR;
+    }
+    param->runMode = env.runMode;
+    uint32_t senderNum = graph.InEdges(node.name).size() +
+                         (stage == kStageDataInput ? 1 : 0);
+    param->queueType = StageQueueType(
+        ParseQueueType(node.config["msg_queue_type"], node.name),
+        senderNum,
+        node.name);
+    map<string, AclLiteThreadSched> scheds = DefaultStageScheds();
+    if (node.config["thread_sched"].type() != Json::nullValue)
+    {
+        Json::Value stageSched;
+        stageSched[stage] = node.config["thread_sched"];
+        ParseThreadSched(stageSched, node.name, &scheds);
+    }
+    ApplyThreadSched(scheds, stage, param);
+    ApplyExecMode(env.poolStages, stage, param);
+    return ACLLITE_OK;
+}
+
+static VencConfig GraphVencConfig(const GraphChannel &channel)
+{
+    GraphModel model = ReadGraphModel(*channel.infer);
+    VencConfig vencConfig =
+        ParseVencConfig(channel.output->params,
+                        channel.output->params["output_type"].asString(),
+                        model.width,
+                        model.height);
+    vencConfig.channelId = channel.channelId;
+    return vencConfig;
+}
+
+// frame decimation of the input and validation interval of the track node
+static InputTuning GraphInputTuning(const GraphNode    &node,
+                                    const GraphChannel &channel)
+{
+    InputTuning tuning;
+    tuning.frameDecimation = node.params["frame_decimation"].asInt();
+    if (channel.track != nullptr)
+    {
+        TrackingValidation validation = ParseTrackingValidation(
+            channel.track->params["tracking_config"], channel.channelId);
+        tuning.trackingValidationEnabled = validation.enable;
+        tuning.trackingValidationInterval = validation.interval;
+    }
+    return tuning;
+}
+
+static PostTuning GraphPostTuning(const GraphNode &node)
+{
+    PostTuning tuning;
+    ParsePostTuning(node.params, node.name, &tuning);
+    return tuning;
+}
+
+static TrackTuning GraphTrackTuning(const GraphNode &node, uint32_t channelId)
+{
+    const Json::Value &trackingConfig = node.params["tracking_config"];
+    return ParseTrackTuning(trackingConfig,
+                            ParseTrackingValidation(trackingConfig, channelId));
+}
+
+void CollectGraphTuning(const PipelineGraph &graph, RuntimeTuning *tuning)
+{
+    for (const GraphNode &node : graph.Nodes())
+    {
+        GraphChannel channel;
+        if (node.type == kStageDataInput &&
+            ResolveGraphChannel(graph, node, &channel) == ACLLITE_OK)
+        {
+            tuning->inputs[node.name] = GraphInputTuning(node, channel);
+        }
+        else if (node.type == kEdgeDetectPost)
+        {
+            tuning->posts[node.name] = GraphPostTuning(node);
+        }
+        else if (node.type == kEdgeTrack &&
+                 ResolveNodeChannel(graph, node, &channel) == ACLLITE_OK)
+        {
+            tuning->tracks[node.name] =
+                GraphTrackTuning(node, channel.channelId);
+        }
+    }
+}
+
+static AclLiteError CreateGraphDataInput(GraphBuildEnv       &env,
+                                         const PipelineGraph &graph,
+                                         const GraphNode     &node,
+                                         AclLiteThreadParam  *param)
+{
+    GraphChannel channel;
+    if (ResolveGraphChannel(graph, node, &channel) != ACLLITE_OK)
+    {
+        return ACLLITE_ERROR;
+    }
+    const Json::Value &params = node.params;
+    string inputType = params["input_type"].asString();
+    string inputPath = params["input_path"].asString();
+    int    framesPerSecond = kDefaultFramesPerSecond;
+    if (params["frames_per_second"].type() != Json::nullValue)
+    {
+        framesPerSecond = params["frames_per_second"].asInt();
+    }
+    const InputTuning &tuning = env.tuning->inputs[node.name];
+    if (inputType.empty() || inputPath.empty() || framesPerSecond < 1 ||
+        tuning.frameDecimation < 0)
+    {
+        ACLLITE_LOG_ERROR("graph node %s: invalid input_type %s, input_path "
+                          "%s, frames_per_second %d or frame_decimation %d",
+                          node.name.c_str(),
+                          inputType.c_str(),
+                          inputPath.c_str(),
+                          framesPerSecond,
+                          tuning.frameDecimation);
+        return ACLLITE_ERROR;
+    }
+    GraphModel     model = ReadGraphModel(*channel.infer);
+    DataInputRoute route;
+    route.preName = channel.pre->name;
+    route.inferName = channel.infer->name;
+    for (const GraphNode *post : channel.posts)
+    {
+        route.postNames.push_back(post->name);
+    }
+    route.dataOutputName = channel.output->name;
+    if (channel.track != nullptr)
+    {
+        route.trackName = channel.track->name;
+    }
+    if (channel.display != nullptr && channel.display->type == kNodeRtspDisplay)
+    {
+        route.rtspDisplayName = channel.display->name;
+    }
+    if (channel.display != nullptr && channel.display->type == kNodeHdmiDisplay)
+    {
+        route.hdmiDisplayName = channel.display->name;
+    }
+    DataInputThread *dataInput = new DataInputThread(
+        node.deviceId,
+        channel.channelId,
+        env.runMode,
+        inputType,
+        inputPath,
+        route.inferName,
+        route.postNames.size(),
+        MsgFrameNum(model.batch, model.batchDeadlineUs),
+        framesPerSecond,
+        tuning.frameDecimation,
+        channel.output->params["output_type"].asString(),
+        tuning.trackingValidationEnabled,
+        tuning.trackingValidationInterval);
+    bool liveMode = false;
+    ParseLatencyMode(params["latency_mode"], node.name, &liveMode);
+    dataInput->SetRoute(route);
+    dataInput->SetLiveMode(liveMode);
+    dataInput->SetRawConfig(ParseRawConfig(params["raw_config"], node.name));
+    dataInput->SetPicConfig(ParsePicConfig(params["pic_config"], node.name));
+    MotionGateConfig motionGate;
+    ParseMotionGateConfig(params["motion_gate"], node.name, &motionGate);
+    dataInput->SetMotionGateConfig(motionGate);
+    AdaptiveDecimationConfig adaptive;
+    ParseAdaptiveDecimation(
+        params["adaptive_decimation"], node.name, &adaptive);
+    dataInput->SetAdaptiveDecimation(adaptive);
+    VideoDecodeConfig decodeConfig;
+    ParseDecodeConfig(params, node.name, &decodeConfig);
+    dataInput->SetDecodeConfig(decodeConfig);
+    param->threadInst = dataInput;
+    return InitGraphNodeParam(env, graph, node, kStageDataInput, param);
+}
+
+static AclLiteError CreateGraphDetectPre(GraphBuildEnv       &env,
+                                         const PipelineGraph &graph,
+                                         const GraphNode     &node,
+                                         AclLiteThreadParam  *param)
+{
+    GraphChannel channel;
+    if (ResolveNodeChannel(graph, node, &channel) != ACLLITE_OK)
+    {
+        return ACLLITE_ERROR;
+    }
+    GraphModel model = ReadGraphModel(*channel.infer);
+    param->threadInst = new DetectPreprocessThread(
+        model.width,
+        model.height,
+        MsgFrameNum(model.batch, model.batchDeadlineUs),
+        ParseResizeType(node.params["resize_type"], node.name));
+    return InitGraphNodeParam(env, graph, node, kEdgeDetectPre, param);
+}
+
+static AclLiteError CreateGraphDetectInfer(GraphBuildEnv       &env,
+                                           const PipelineGraph &graph,
+                                           const GraphNode     &node,
+                                           AclLiteThreadParam  *param)
+{
+    string     modelPath = node.params["model_path"].asString();
+    GraphModel model = ReadGraphModel(node);
+    if (modelPath.empty() || model.width == 0 || model.height == 0 ||
+        model.batch < 1)
+    {
+        ACLLITE_LOG_ERROR("graph node %s: invalid model_path %s or model "
+                          "size %ux%u batch %u",
+                          node.name.c_str(),
+                          modelPath.c_str(),
+                          model.width,
+                          model.height,
+                          model.batch);
+        return ACLLITE_ERROR;
+    }
+    param->threadInst =
+        new DetectInferenceThread(modelPath, model.batch, model.batchDeadlineUs);
+    return InitGraphNodeParam(env, graph, node, kEdgeDetectInfer, param);
+}
+
+static AclLiteError CreateGraphDetectPost(GraphBuildEnv       &env,
+                                          const PipelineGraph &graph,
+                                          const GraphNode     &node,
+                                          AclLiteThreadParam  *param)
+{
+    GraphChannel channel;
+    if (ResolveNodeChannel(graph, node, &channel) != ACLLITE_OK)
+    {
+        return ACLLITE_ERROR;
+    }
+    if (find(channel.posts.begin(), channel.posts.end(), &node) ==
+        channel.posts.end())
+    {
+        ACLLITE_LOG_ERROR("graph node %s is not fed by %s",
+                          node.name.c_str(),
+                          channel.infer->name.c_str());
+        return ACLLITE_ERROR;
+    }
+    GraphModel model = ReadGraphModel(*channel.infer);
+    bool useNms = node.params["use_nms"].type() == Json::nullValue ||
+                  node.params["use_nms"].asBool();
+    // boxes must be mapped back the way the pre of this channel resized
+    param->threadInst = new DetectPostprocessThread(
+        model.width,
+        model.height,
+        env.runMode,
+        MsgFrameNum(model.batch, model.batchDeadlineUs),
+        env.tuning->posts[node.name],
+        ParseResizeType(channel.pre->params["resize_type"], channel.pre->name),
+        useNms);
+    return InitGraphNodeParam(env, graph, node, kEdgeDetectPost, param);
+}
+
+static AclLiteError CreateGraphTrack(GraphBuildEnv       &env,
+                                     const PipelineGraph &graph,
+                                     const GraphNode     &node,
+                                     AclLiteThreadParam  *param)
+{
+    GraphChannel channel;
+    if (ResolveNodeChannel(graph, node, &channel) != ACLLITE_OK)
+    {
+        return ACLLITE_ERROR;
+    }
+    string trackModelPath = node.params["track_model_path"].asString();
+    if (trackModelPath.empty())
+    {
+        ACLLITE_LOG_ERROR("graph node %s needs track_model_path",
+                          node.name.c_str());
+        return ACLLITE_ERROR;
+    }
+    Tracking *trackingInst = new Tracking(trackModelPath);
+    trackingInst->UpdateTuning(
+        make_shared<const TrackTuning>(env.tuning->tracks[node.name]));
+    param->threadInst = trackingInst;
+    return InitGraphNodeParam(env, graph, node, kEdgeTrack, param);
+}
+
+static AclLiteError CreateGraphDataOutput(GraphBuildEnv       &env,
+                                          const PipelineGraph &graph,
+                                          const GraphNode     &node,
+                                          AclLiteThreadParam  *param)
+{
+    GraphChannel channel;
+    if (ResolveNodeChannel(graph, node, &channel) != ACLLITE_OK)
+    {
+        return ACLLITE_ERROR;
+    }
+    string outputType = node.params["output_type"].asString();
+    // rtsp / hdmi output needs the matching display node, others allow none
+    string displayType = outputType == "rtsp"   ? kNodeRtspDisplay
+                         : outputType == "hdmi" ? kNodeHdmiDisplay
+                                                : "";
+    string actualType =
+        channel.display == nullptr ? "" : channel.display->type;
+    if (outputType.empty() || displayType != actualType)
+    {
+        ACLLITE_LOG_ERROR("graph node %s: output_type \"%s\" does not match "
+                          "display successor \"%s\"",
+                          node.name.c_str(),
+                          outputType.c_str(),
+                          actualType.c_str());
+        return ACLLITE_ERROR;
+    }
+    param->threadInst = new DataOutputThread(env.runMode,
+                                             outputType,
+                                             node.params["output_path"].asString(),
+                                             channel.posts.size(),
+                                             GraphVencConfig(channel));
+    return InitGraphNodeParam(env, graph, node, kEdgeDataOutput, param);
+}
+
+static AclLiteError CreateGraphRtspDisplay(GraphBuildEnv       &env,
+                                           const PipelineGraph &graph,
+                                           const GraphNode     &node,
+                                           AclLiteThreadParam  *param)
+{
+    GraphChannel channel;
+    if (ResolveNodeChannel(graph, node, &channel) != ACLLITE_OK)
+    {
+        return ACLLITE_ERROR;
+    }
+    // defaults to the output path plus channel id, like device_config
+    string rtspUrl = node.params["output_path"].asString();
+    if (rtspUrl.empty())
+    {
+        rtspUrl = channel.output->params["output_path"].asString() +
+                  to_string(channel.channelId);
+    }
+    param->threadInst = new PushRtspThread(rtspUrl, GraphVencConfig(channel));
+    return InitGraphNodeParam(env, graph, node, kEdgeDisplay, param);
+}
+
+static AclLiteError CreateGraphHdmiDisplay(GraphBuildEnv       &env,
+                                           const PipelineGraph &graph,
+                                           const GraphNode     &node,
+                                           AclLiteThreadParam  *param)
+{
+    GraphChannel channel;
+    if (ResolveNodeChannel(graph, node, &channel) != ACLLITE_OK)
+    {
+        return ACLLITE_ERROR;
+    }
+    param->threadInst =
+        new HdmiOutputThread(env.runMode, GraphVencConfig(channel));
+    return InitGraphNodeParam(env, graph, node, kEdgeDisplay, param);
+}
+
+static void RegisterGraphNodeType(PipelineGraphBuilder &builder,
+                                  GraphBuildEnv        &env,
+                                  const string         &type,
+                                  GraphNodeCreator      creator,
+                                  uint32_t              queueSize,
+                                  const EdgePolicy     &policy)
+{
+    GraphNodeType nodeType;
+    nodeType.factory = [&env, creator](const PipelineGraph &graph,
+                                       const GraphNode     &node,
+                                       AclLiteThreadParam  *param) {
+        return creator(env, graph, node, param);
+    };
+    nodeType.queueSize = queueSize;
+    nodeType.policy = policy.policy;
+    nodeType.timeoutUs = policy.timeoutUs;
+    builder.RegisterType(type, nodeType);
+}
+
+AclLiteError CreateGraphThreadInstance(const Json::Value          &value,
+                                       GraphBuildEnv              &env,
+                                       vector<AclLiteThreadParam> &threadTbl,
+                                       uint32_t                   *channelNum)
+{
+    PipelineGraph graph;
+    if (graph.Parse(value) != ACLLITE_OK)
+    {
+        return ACLLITE_ERROR;
+    }
+    set<uint32_t> channelIds;
+    if (CollectGraphChannels(graph, &channelIds) != ACLLITE_OK)
+    {
+        return ACLLITE_ERROR;
+    }
+
+    CollectGraphTuning(graph, env.tuning);
+
+    map<string, EdgePolicy> policies = DefaultEdgePolicies();
+    PipelineGraphBuilder    builder;
+    RegisterGraphNodeType(builder, env, kStageDataInput, CreateGraphDataInput,
+                          kDefaultMsgQueueSize, EdgePolicy());
+    RegisterGraphNodeType(builder, env, kEdgeDetectPre, CreateGraphDetectPre,
+                          kDefaultMsgQueueSize, policies[kEdgeDetectPre]);
+    RegisterGraphNodeType(builder, env, kEdgeDetectInfer, CreateGraphDetectInfer,
+                          0, policies[kEdgeDetectInfer]);
+    RegisterGraphNodeType(builder, env, kEdgeDetectPost, CreateGraphDetectPost,
+                          0, policies[kEdgeDetectPost]);
+    RegisterGraphNodeType(builder, env, kEdgeTrack, CreateGraphTrack,
+                          kDefaultMsgQueueSize, policies[kEdgeTrack]);
+    RegisterGraphNodeType(builder, env, kEdgeDataOutput, CreateGraphDataOutput,
+                          0, policies[kEdgeDataOutput]);
+    RegisterGraphNodeType(builder, env, kNodeRtspDisplay, CreateGraphRtspDisplay,
+                          kDisplayQueueSize, policies[kEdgeDisplay]);
+    RegisterGraphNodeType(builder, env, kNodeHdmiDisplay, CreateGraphHdmiDisplay,
+                          kDisplayQueueSize, policies[kEdgeDisplay]);
+    if (builder.Build(graph, threadTbl) != ACLLITE_OK)
+    {
+        for (AclLiteThreadParam &param : threadTbl)
+        {
+            delete param.threadInst;
+        }
+        threadTbl.clear();
+        return ACLLITE_ERROR;
+    }
+    // the app exits once the last thread of every channel has exited
+    *channelNum = channelIds.size();
+    ACLLITE_LOG_INFO("graph built %zu threads for %zu channels",
+                     threadTbl.size(),
+                     channelIds.size());
+    return ACLLITE_OK;
+}
@@ -0,0 +1,60 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File graphNodes.h
+* Description: factories of the detection node types of a pipeline graph
+*/
+#ifndef GRAPHNODES_H
+#define GRAPHNODES_H
+#pragma once
+#include "AclLiteResource.h"
+#include "pipelineConfig.h"
+#include "pipelineGraph.h"
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// shared by the node factories while a graph is built
+struct GraphBuildEnv
+{
+    AclLiteResource                 *aclDev = nullptr;
+    aclrtRunMode                     runMode = ACL_HOST;
+    std::set<std::string>            poolStages;
+    RuntimeTuning                   *tuning = nullptr; // filled by the build
+    std::map<uint32_t, aclrtContext> contexts; // per device, the caller
+                                               // destroys them
+};
+
+// hot reloadable parameters of the graph nodes; nodes whose channel can not
+// be resolved are skipped, their factory reports the error
+void CollectGraphTuning(const PipelineGraph &graph, RuntimeTuning *tuning);
+
+/**
+ * @brief Create the threads of the top level graph config. Only the declared
+ *        nodes get a thread, so a channel without tracking or display just
+ *        leaves out its track / display node. The data_input of a channel
+ *        looks up the ids of its downstream threads once in Init.
+ * @param [in]: value: graph JSON object
+ * @param [in]: env: must stay valid while the threads are built
+ * @param [out]: threadTbl: the threads, empty on failure
+ * @param [out]: channelNum: number of input channels
+ */
+AclLiteError CreateGraphThreadInstance(const Json::Value               &value,
+                                       GraphBuildEnv                   &env,
+                                       std::vector<AclLiteThreadParam> &threadTbl,
+                                       uint32_t                        *channelNum);
+
+#endif
@@ -0,0 +1,999 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File pipelineConfig.cpp
+* Description: parsers of the config fields shared by device_config and graph
+*/
+#include "pipelineConfig.h"
+#include "AclLiteUtils.h"
+#include "pipelineGraph.h"
+#include <algorithm>
+#include <cctype>
+#include <sched.h>
+
+using namespace std;
+
+bool ParseTargetClassIds(const Json::Value &value,
+                         const string &scope,
+                         vector<int> *target_class_ids)
+{
+    target_class_ids->clear();
+    if (value.type() == Json::nullValue)
+    {
+        return true;
+    }
+    if (value.isInt())
+    {
+        int class_id = value.asInt();
+        if (class_id < 0)
+        {
+            ACLLITE_LOG_WARNING(
+                "target_class_id is negative at %s, disabling class filter",
+                scope.c_str());
+            return true;
+        }
+        target_class_ids->push_back(class_id);
+        return true;
+    }
+    if (value.isArray())
+    {
+        for (Json::ArrayIndex idx = 0; idx < value.size();
+             ++idx)
+        {
+            const Json::Value &item = value[idx];
+            if (!item.isInt())
+            {
+                ACLLITE_LOG_WARNING(
+                    "target_class_id has non-int item at %s[%u], ignoring",
+                    scope.c_str(),
+                    idx);
+                continue;
+            }
+            int class_id = item.asInt();
+            if (class_id < 0)
+            {
+                ACLLITE_LOG_WARNING(
+                    "target_class_id is negative at %s[%u], disabling class filter",
+                    scope.c_str(),
+                    idx);
+                target_class_ids->clear();
+                return true;
+            }
+            target_class_ids->push_back(class_id);
+        }
+        return true;
+    }
+    ACLLITE_LOG_WARNING("target_class_id type not supported at %s, ignoring",
+                        scope.c_str());
+    return false;
+}
+
+ResizeProcessType ParseResizeType(const Json::Value &value,
+                                  const string &scope)
+{
+    if (value.type() == Json::nullValue)
+    {
+        return VPC_PT_FIT;
+    }
+    if (!value.isString())
+    {
+        ACLLITE_LOG_WARNING("resize_type must be string at %s, use default",
+                            scope.c_str());
+        return VPC_PT_FIT;
+    }
+    string type = TrimString(value.asString());
+    std::transform(type.begin(), type.end(), type.begin(), ::tolower);
+    if (type == "fit")
+    {
+        return VPC_PT_FIT;
+    }
+    if (type == "stretch" || type == "direct" || type == "resize")
+    {
+        return VPC_PT_DEFAULT;
+    }
+    ACLLITE_LOG_WARNING("Unknown resize_type=%s at %s, use default",
+                        type.c_str(),
+                        scope.c_str());
+    return VPC_PT_FIT;
+}
+
+AclLiteQueueType ParseQueueType(const Json::Value &value,
+                                const string &scope)
+{
+    if (value.type() == Json::nullValue)
+    {
+        return ACLLITE_QUEUE_MUTEX;
+    }
+    if (!value.isString())
+    {
+        ACLLITE_LOG_WARNING("msg_queue_type must be string at %s, use default",
+                            scope.c_str());
+        return ACLLITE_QUEUE_MUTEX;
+    }
+    string type = TrimString(value.asString());
+    std::transform(type.begin(), type.end(), type.begin(), ::tolower);
+    if (type == "mutex")
+    {
+        return ACLLITE_QUEUE_MUTEX;
+    }
+    if (type == "lockfree" || type == "mpsc")
+    {
+        return ACLLITE_QUEUE_MPSC;
+    }
+    if (type == "spsc")
+    {
+        return ACLLITE_QUEUE_SPSC;
+    }
+    ACLLITE_LOG_WARNING("Unknown msg_queue_type=%s at %s, use default",
+                        type.c_str(),
+                        scope.c_str());
+    return ACLLITE_QUEUE_MUTEX;
+}
+
+// Control messages (MSG_APP_START, end markers, track feedback) use the
+// control lane and never enter the ring, so only data lane senders count:
+// data_input only sends MSG_READ_FRAME to itself, pre, post and display have
+// one upstream each and infer has the pre threads of the channels sharing
+// it; track and output receive from both data_input and post. spsc with more
+// than one sender corrupts the queue, so those stages get mpsc.
+AclLiteQueueType StageQueueType(AclLiteQueueType type,
+                                uint32_t         senderNum,
+                                const string    &name)
+{
+    if (type != ACLLITE_QUEUE_SPSC || senderNum == 1)
+    {
+        return type;
+    }
+    ACLLITE_LOG_INFO("%s has %u message senders, use mpsc instead of spsc",
+                     name.c_str(),
+                     senderNum);
+    return ACLLITE_QUEUE_MPSC;
+}
+
+void ParseLatencyMode(const Json::Value &value,
+                      const string      &scope,
+                      bool              *liveMode)
+{
+    if (value.type() == Json::nullValue)
+    {
+        return;
+    }
+    string mode = value.isString() ? TrimString(value.asString()) : "";
+    std::transform(mode.begin(), mode.end(), mode.begin(), ::tolower);
+    if (mode == "live")
+    {
+        *liveMode = true;
+    }
+    else if (mode == "accurate")
+    {
+        *liveMode = false;
+    }
+    else
+    {
+        ACLLITE_LOG_WARNING("Unknown latency_mode at %s, ignoring",
+                            scope.c_str());
+    }
+}
+
+// missing fields keep the defaults
+RawInputConfig ParseRawConfig(const Json::Value &value,
+                              const string      &scope)
+{
+    RawInputConfig config;
+    if (value.type() == Json::nullValue)
+    {
+        return config;
+    }
+    if (!value.isObject())
+    {
+        ACLLITE_LOG_WARNING("raw_config must be object at %s, ignoring",
+                            scope.c_str());
+        return config;
+    }
+    config.width = value["width"].asUInt();
+    config.height = value["height"].asUInt();
+    config.fps = value["fps"].asUInt();
+    config.loop = value["loop"].asBool();
+    return config;
+}
+
+// missing or 0 fields keep the defaults
+PicInputConfig ParsePicConfig(const Json::Value &value,
+                              const string      &scope)
+{
+    PicInputConfig config;
+    if (value.type() == Json::nullValue)
+    {
+        return config;
+    }
+    if (!value.isObject())
+    {
+        ACLLITE_LOG_WARNING("pic_config must be object at %s, ignoring",
+                            scope.c_str());
+        return config;
+    }
+    if (value["workers"].isUInt() && value["workers"].asUInt() > 0)
+    {
+        config.workers = value["workers"].asUInt();
+    }
+    if (value["prefetch"].isUInt() && value["prefetch"].asUInt() > 0)
+    {
+        config.prefetch = value["prefetch"].asUInt();
+    }
+    return config;
+}
+
+// motion_gate: {"enable", "grid_width", "pixel_threshold",
+// "activity_threshold", "learning_rate", "max_skip_frames"}, only the present
+// fields override config
+void ParseMotionGateConfig(const Json::Value &value,
+                           const string      &scope,
+                           MotionGateConfig  *config)
+{
+    if (value.type() == Json::nullValue)
+    {
+        return;
+    }
+    if (!value.isObject())
+    {
+        ACLLITE_LOG_WARNING("motion_gate must be object at %s, ignoring",
+                            scope.c_str());
+        return;
+    }
+    if (value.isMember("enable"))
+    {
+        config->enable = value["enable"].asBool();
+    }
+    if (value["grid_width"].isUInt() && value["grid_width"].asUInt() > 0)
+    {
+        config->gridWidth = value["grid_width"].asUInt();
+    }
+    if (value["pixel_threshold"].isUInt())
+    {
+        config->pixelThreshold = value["pixel_threshold"].asUInt();
+    }
+    if (value["max_skip_frames"].isUInt())
+    {
+        config->maxSkipFrames = value["max_skip_frames"].asUInt();
+    }
+    const Json::Value &activity = value["activity_threshold"];
+    if (activity.isNumeric() && activity.asFloat() >= 0.0f &&
+        activity.asFloat() <= 1.0f)
+    {
+        config->activityThreshold = activity.asFloat();
+    }
+    else if (activity.type() != Json::nullValue)
+    {
+        ACLLITE_LOG_WARNING("activity_threshold must be in [0, 1] at %s, "
+                            "ignoring",
+                            scope.c_str());
+    }
+    const Json::Value &rate = value["learning_rate"];
+    if (rate.isNumeric() && rate.asFloat() > 0.0f && rate.asFloat() <= 1.0f)
+    {
+        config->learningRate = rate.asFloat();
+    }
+    else if (rate.type() != Json::nullValue)
+    {
+        ACLLITE_LOG_WARNING("learning_rate must be in (0, 1] at %s, ignoring",
+                            scope.c_str());
+    }
+}
+
+// adaptive_decimation: {"enable", "min", "max", "interval_ms", "queue_high",
+// "queue_low", "max_infer_ms"}, only the present fields override config
+void ParseAdaptiveDecimation(const Json::Value        &value,
+                             const string             &scope,
+                             AdaptiveDecimationConfig *config)
+{
+    if (value.type() == Json::nullValue)
+    {
+        return;
+    }
+    if (!value.isObject())
+    {
+        ACLLITE_LOG_WARNING("adaptive_decimation must be object at %s, "
+                            "ignoring",
+                            scope.c_str());
+        return;
+    }
+    if (value.isMember("enable"))
+    {
+        config->enable = value["enable"].asBool();
+    }
+    if (value["min"].isUInt())
+    {
+        config->minDecimation = (int)value["min"].asUInt();
+    }
+    if (value["max"].isUInt())
+    {
+        config->maxDecimation = (int)value["max"].asUInt();
+    }
+    if (value["interval_ms"].isUInt() && value["interval_ms"].asUInt() > 0)
+    {
+        config->intervalMs = value["interval_ms"].asUInt();
+    }
+    if (value["queue_high"].isUInt() && value["queue_high"].asUInt() > 0)
+    {
+        config->queueHigh = value["queue_high"].asUInt();
+    }
+    if (value["queue_low"].isUInt())
+    {
+        config->queueLow = value["queue_low"].asUInt();
+    }
+    if (value["max_infer_ms"].isUInt())
+    {
+        config->maxInferMs = value["max_infer_ms"].asUInt();
+    }
+    if (config->maxDecimation < config->minDecimation ||
+        config->queueLow >= config->queueHigh)
+    {
+        ACLLITE_LOG_WARNING("adaptive_decimation at %s needs min <= max and "
+                            "queue_low < queue_high, disabled",
+                            scope.c_str());
+        config->enable = false;
+    }
+}
+
+// decoder: "auto" (default), "vdec" or "soft"; decoder_threads: soft decode
+// threads, 0 for one per cpu; reconnect_max_ms: cap of the rtsp reconnect
+// backoff, 0 to never reconnect
+void ParseDecodeConfig(const Json::Value &value,
+                       const string      &scope,
+                       VideoDecodeConfig *config)
+{
+    if (!value.isObject())
+    {
+        return;
+    }
+    const Json::Value &decoder = value["decoder"];
+    if (decoder.type() != Json::nullValue)
+    {
+        string name = decoder.isString() ? TrimString(decoder.asString()) : "";
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        if (name == "auto")
+        {
+            config->backend = DECODE_BACKEND_AUTO;
+        }
+        else if (name == "vdec")
+        {
+            config->backend = DECODE_BACKEND_VDEC;
+        }
+        else if (name == "soft")
+        {
+            config->backend = DECODE_BACKEND_SOFT;
+        }
+        else
+        {
+            ACLLITE_LOG_WARNING("Unknown decoder at %s, ignoring",
+                                scope.c_str());
+        }
+    }
+    const Json::Value &threads = value["decoder_threads"];
+    if (threads.type() != Json::nullValue)
+    {
+        if (threads.isUInt())
+        {
+            config->softThreads = threads.asUInt();
+        }
+        else
+        {
+            ACLLITE_LOG_WARNING("decoder_threads must be >= 0 at %s, "
+                                "ignoring",
+                                scope.c_str());
+        }
+    }
+    const Json::Value &reconnect = value["reconnect_max_ms"];
+    if (reconnect.type() != Json::nullValue)
+    {
+        if (reconnect.isUInt())
+        {
+            config->reconnectMaxMs = reconnect.asUInt();
+        }
+        else
+        {
+            ACLLITE_LOG_WARNING("reconnect_max_ms must be >= 0 at %s, "
+                                "ignoring",
+                                scope.c_str());
+        }
+    }
+}
+
+// The detection chain blocks (back pressure up to data_input), display blocks
+// briefly and then drops, like the old display queue that dropped after
+// three retries
+map<string, EdgePolicy> DefaultEdgePolicies()
+{
+    map<string, EdgePolicy> policies;
+    policies[kEdgeDetectPre] = EdgePolicy();
+    policies[kEdgeDetectInfer] = EdgePolicy();
+    policies[kEdgeDetectPost] = EdgePolicy();
+    policies[kEdgeTrack] = EdgePolicy();
+    policies[kEdgeDataOutput] = EdgePolicy();
+    policies[kEdgeDisplay].timeoutUs = kDisplaySendTimeoutUs;
+    return policies;
+}
+
+// timeout_ms only applies to block, 0 or missing waits forever
+void ParseEdgePolicies(const Json::Value       &value,
+                       const string            &scope,
+                       map<string, EdgePolicy> *policies)
+{
+    if (value.type() == Json::nullValue)
+    {
+        return;
+    }
+    if (!value.isObject())
+    {
+        ACLLITE_LOG_WARNING("edge_policy must be object at %s, ignoring",
+                            scope.c_str());
+        return;
+    }
+    for (const string &edge : value.getMemberNames())
+    {
+        auto it = policies->find(edge);
+        if (it == policies->end())
+        {
+            ACLLITE_LOG_WARNING("Unknown edge %s in edge_policy at %s, ignoring",
+                                edge.c_str(),
+                                scope.c_str());
+            continue;
+        }
+        const Json::Value &item = value[edge];
+        EdgePolicy         edgePolicy = it->second;
+        Json::Value        name = item.isObject() ? item["policy"] : item;
+        if (name.isString() &&
+            !ParseSendPolicyName(name.asString(), &edgePolicy.policy))
+        {
+            ACLLITE_LOG_WARNING("Unknown send policy %s for edge %s at %s, "
+                                "ignoring",
+                                name.asString().c_str(),
+                                edge.c_str(),
+                                scope.c_str());
+        }
+        if (item.isObject() && item["timeout_ms"].type() != Json::nullValue)
+        {
+            int timeoutMs = item["timeout_ms"].asInt();
+            edgePolicy.timeoutUs =
+                timeoutMs > 0 ? (uint32_t)timeoutMs * 1000 : ACLLITE_WAIT_FOREVER;
+        }
+        it->second = edgePolicy;
+    }
+}
+
+void ApplyEdgePolicy(const map<string, EdgePolicy> &policies,
+                     const string                  &edge,
+                     AclLiteThreadParam            *param)
+{
+    const EdgePolicy &edgePolicy = policies.at(edge);
+    param->sendPolicy = edgePolicy.policy;
+    param->sendTimeoutUs = edgePolicy.timeoutUs;
+}
+
+void ApplyExecMode(const set<string> &poolStages,
+                   const string      &stage,
+                   AclLiteThreadParam *param)
+{
+    if (poolStages.count(stage) > 0)
+    {
+        param->execMode = ACLLITE_EXEC_POOL;
+        // the stage has no thread of its own, worker_pool.cpus places it
+        if (!param->sched.IsDefault())
+        {
+            ACLLITE_LOG_WARNING("thread_sched of stage %s is ignored, %s runs "
+                                "in worker_pool, use worker_pool.cpus instead",
+                                stage.c_str(),
+                                param->threadInstName.c_str());
+            param->sched = AclLiteThreadSched();
+        }
+    }
+}
+
+// left alone by default, the system scheduler decides
+map<string, AclLiteThreadSched> DefaultStageScheds()
+{
+    map<string, AclLiteThreadSched> scheds;
+    scheds[kStageDataInput] = AclLiteThreadSched();
+    scheds[kEdgeDetectPre] = AclLiteThreadSched();
+    scheds[kEdgeDetectInfer] = AclLiteThreadSched();
+    scheds[kEdgeDetectPost] = AclLiteThreadSched();
+    scheds[kEdgeTrack] = AclLiteThreadSched();
+    scheds[kEdgeDataOutput] = AclLiteThreadSched();
+    scheds[kEdgeDisplay] = AclLiteThreadSched();
+    return scheds;
+}
+
+// An unconfigured helper inherits the stage thread creating it: decode from
+// data_input, encode and rtsp_push from display
+map<string, AclLiteThreadSched> DefaultHelperScheds()
+{
+    map<string, AclLiteThreadSched> scheds;
+    scheds[kHelperDecode] = AclLiteThreadSched();
+    scheds[kHelperEncode] = AclLiteThreadSched();
+    scheds[kHelperRtspPush] = AclLiteThreadSched();
+    return scheds;
+}
+
+// Each entry is {"cpus": [2, 3], "nice": -5, "fifo_priority": 10}, all
+// optional: cpus lists the allowed cpus, nice is -20..19 and fifo_priority
+// 1..99 selects SCHED_FIFO (needs CAP_SYS_NICE)
+void ParseThreadSched(const Json::Value               &value,
+                      const string                    &scope,
+                      map<string, AclLiteThreadSched> *scheds)
+{
+    if (value.type() == Json::nullValue)
+    {
+        return;
+    }
+    if (!value.isObject())
+    {
+        ACLLITE_LOG_WARNING("thread_sched must be object at %s, ignoring",
+                            scope.c_str());
+        return;
+    }
+    for (const string &name : value.getMemberNames())
+    {
+        auto it = scheds->find(name);
+        if (it == scheds->end())
+        {
+            ACLLITE_LOG_WARNING("Unknown thread %s in thread_sched at %s, "
+                                "ignoring",
+                                name.c_str(),
+                                scope.c_str());
+            continue;
+        }
+        const Json::Value &item = value[name];
+        if (!item.isObject())
+        {
+            ACLLITE_LOG_WARNING("thread_sched.%s must be object at %s, ignoring",
+                                name.c_str(),
+                                scope.c_str());
+            continue;
+        }
+        AclLiteThreadSched sched = it->second;
+        if (item["cpus"].isArray())
+        {
+            sched.cpus.clear();
+            for (const Json::Value &cpu : item["cpus"])
+            {
+                int cpuId = cpu.asInt();
+                if (cpuId < 0 || cpuId >= CPU_SETSIZE)
+                {
+                    ACLLITE_LOG_WARNING("thread_sched.%s cpu %d invalid at %s",
+                                        name.c_str(),
+                                        cpuId,
+                                        scope.c_str());
+                    continue;
+                }
+                sched.cpus.push_back(cpuId);
+            }
+        }
+        if (item["nice"].type() != Json::nullValue)
+        {
+            int nice = item["nice"].asInt();
+            if (nice >= -20 && nice <= 19)
+            {
+                sched.nice = nice;
+            }
+            else
+            {
+                ACLLITE_LOG_WARNING("thread_sched.%s nice=%d out of range at %s",
+                                    name.c_str(),
+                                    nice,
+                                    scope.c_str());
+            }
+        }
+        if (item["fifo_priority"].type() != Json::nullValue)
+        {
+            int priority = item["fifo_priority"].asInt();
+            if (priority >= 0 && priority <= 99)
+            {
+                sched.fifoPriority = priority;
+            }
+            else
+            {
+                ACLLITE_LOG_WARNING("thread_sched.%s fifo_priority=%d out of "
+                                    "range at %s",
+                                    name.c_str(),
+                                    priority,
+                                    scope.c_str());
+            }
+        }
+        it->second = sched;
+    }
+}
+
+void ApplyThreadSched(const map<string, AclLiteThreadSched> &scheds,
+                      const string                          &stage,
+                      AclLiteThreadParam                    *param)
+{
+    param->sched = scheds.at(stage);
+}
+
+VencConfig ParseVencConfig(const Json::Value &value,
+                           const string      &outputType,
+                           uint32_t           modelWidth,
+                           uint32_t           modelHeight)
+{
+    VencConfig vencConfig;
+    vencConfig.maxWidth = modelWidth;
+    vencConfig.maxHeight = modelHeight;
+
+    // rtsp_config, rtsp output only
+    if (outputType == "rtsp" &&
+        value["rtsp_config"].type() != Json::nullValue)
+    {
+        Json::Value rtspCfg = value["rtsp_config"];
+        if (rtspCfg["output_width"].type() != Json::nullValue)
+        {
+            vencConfig.outputWidth = rtspCfg["output_width"].asUInt();
+        }
+        if (rtspCfg["output_height"].type() != Json::nullValue)
+        {
+            vencConfig.outputHeight = rtspCfg["output_height"].asUInt();
+        }
+        if (rtspCfg["output_fps"].type() != Json::nullValue)
+        {
+            vencConfig.outputFps = rtspCfg["output_fps"].asUInt();
+            if (vencConfig.outputFps < 1 || vencConfig.outputFps > 60)
+            {
+                ACLLITE_LOG_WARNING("Output FPS %u out of range [1,60], using default 25", vencConfig.outputFps);
+                vencConfig.outputFps = 25;
+            }
+        }
+        if (rtspCfg["transport"].type() != Json::nullValue)
+        {
+            vencConfig.rtspTransport = rtspCfg["transport"].asString();
+        }
+        if (rtspCfg["buffer_size"].type() != Json::nullValue)
+        {
+            vencConfig.rtspBufferSize = rtspCfg["buffer_size"].asUInt();
+        }
+        if (rtspCfg["max_delay"].type() != Json::nullValue)
+        {
+            vencConfig.rtspMaxDelay = rtspCfg["max_delay"].asUInt();
+        }
+    }
+
+    // hdmi_config, hdmi output only
+    if (outputType == "hdmi" &&
+        value["hdmi_config"].type() != Json::nullValue)
+    {
+        Json::Value hdmiCfg = value["hdmi_config"];
+        if (hdmiCfg["output_width"].type() != Json::nullValue)
+        {
+            vencConfig.outputWidth = hdmiCfg["output_width"].asUInt();
+        }
+        if (hdmiCfg["output_height"].type() != Json::nullValue)
+        {
+            vencConfig.outputHeight = hdmiCfg["output_height"].asUInt();
+        }
+        if (hdmiCfg["output_fps"].type() != Json::nullValue)
+        {
+            vencConfig.outputFps = hdmiCfg["output_fps"].asUInt();
+            if (vencConfig.outputFps < 1 || vencConfig.outputFps > 60)
+            {
+                ACLLITE_LOG_WARNING("HDMI output FPS %u out of range [1,60], using default 25", vencConfig.outputFps);
+                vencConfig.outputFps = 25;
+            }
+        }
+    }
+
+    // h264_config
+    if (value["h264_config"].type() != Json::nullValue)
+    {
+        Json::Value h264Cfg = value["h264_config"];
+        if (h264Cfg["gop_size"].type() != Json::nullValue)
+        {
+            vencConfig.gopSize = h264Cfg["gop_size"].asUInt();
+            if (vencConfig.gopSize < 1 || vencConfig.gopSize > 300)
+            {
+                ACLLITE_LOG_WARNING("GOP size %u out of range [1,300], using default 16", vencConfig.gopSize);
+                vencConfig.gopSize = 16;
+            }
+        }
+        if (h264Cfg["rc_mode"].type() != Json::nullValue)
+        {
+            vencConfig.rcMode = h264Cfg["rc_mode"].asUInt();
+            if (vencConfig.rcMode > 2)
+            {
+                ACLLITE_LOG_WARNING("RC mode %u invalid (0=CBR,1=VBR,2=AVBR), using default 2", vencConfig.rcMode);
+                vencConfig.rcMode = 2;
+            }
+        }
+        if (h264Cfg["max_bitrate"].type() != Json::nullValue)
+        {
+            vencConfig.maxBitrate = h264Cfg["max_bitrate"].asUInt();
+            if (vencConfig.maxBitrate < 500 || vencConfig.maxBitrate > 50000)
+            {
+                ACLLITE_LOG_WARNING("Bitrate %u kbps out of range [500,50000], using default 10000", vencConfig.maxBitrate);
+                vencConfig.maxBitrate = 10000;
+            }
+        }
+        if (h264Cfg["profile"].type() != Json::nullValue)
+        {
+            std::string profile = h264Cfg["profile"].asString();
+            if (profile == "baseline")
+            {
+                vencConfig.enType = H264_BASELINE_LEVEL;
+            }
+            else if (profile == "main")
+            {
+                vencConfig.enType = H264_MAIN_LEVEL;
+            }
+            else if (profile == "high")
+            {
+                vencConfig.enType = H264_HIGH_LEVEL;
+            }
+        }
+    }
+    return vencConfig;
+}
+
+// invalid values keep the defaults, validation enabled without a valid
+// interval is disabled
+TrackingValidation ParseTrackingValidation(
+    const Json::Value &trackingConfig, uint32_t channelId)
+{
+    TrackingValidation validation;
+    if (trackingConfig.type() != Json::nullValue)
+    {
+        if (trackingConfig["enable_tracking_validation"].type() != Json::nullValue)
+        {
+            validation.enable =
+                trackingConfig["enable_tracking_validation"].asBool();
+        }
+        if (trackingConfig["validation_interval"].type() != Json::nullValue)
+        {
+            int interval =
+                trackingConfig["validation_interval"].asInt();
+            if (interval > 0)
+            {
+                validation.interval = interval;
+            }
+            else
+            {
+                ACLLITE_LOG_WARNING(
+                    "tracking validation_interval=%d invalid for channel %d",
+                    interval,
+                    channelId);
+            }
+        }
+        if (trackingConfig["validation_iou_threshold"].type() != Json::nullValue)
+        {
+            float threshold =
+                trackingConfig["validation_iou_threshold"].asFloat();
+            if (threshold >= 0.0f && threshold <= 1.0f)
+            {
+                validation.iouThreshold = threshold;
+            }
+            else
+            {
+                ACLLITE_LOG_WARNING(
+                    "tracking validation_iou_threshold=%.2f out of range for channel %d",
+                    threshold,
+                    channelId);
+            }
+        }
+        if (trackingConfig["validation_max_error_count"].type() != Json::nullValue)
+        {
+            int maxErrors =
+                trackingConfig["validation_max_error_count"].asInt();
+            if (maxErrors > 0)
+            {
+                validation.maxErrors = maxErrors;
+            }
+            else
+            {
+                ACLLITE_LOG_WARNING(
+                    "tracking validation_max_error_count=%d invalid for channel %d",
+                    maxErrors,
+                    channelId);
+            }
+        }
+    }
+    if (validation.enable && validation.interval <= 0)
+    {
+        ACLLITE_LOG_WARNING(
+            "tracking validation enabled but interval invalid for channel %d, disabling validation",
+            channelId);
+        validation.enable = false;
+    }
+    return validation;
+}
+
+// missing fields keep the TrackTuning defaults, which match the Tracking
+// member defaults
+TrackTuning ParseTrackTuning(const Json::Value        &trackingConfig,
+                             const TrackingValidation &validation)
+{
+    TrackTuning tuning;
+    if (trackingConfig.type() != Json::nullValue)
+    {
+        if (trackingConfig["confidence_active_threshold"].type() != Json::nullValue)
+        {
+            tuning.confidenceActiveThreshold =
+                trackingConfig["confidence_active_threshold"].asFloat();
+        }
+        if (trackingConfig["confidence_redetect_threshold"].type() != Json::nullValue)
+        {
+            tuning.confidenceRedetectThreshold =
+                trackingConfig["confidence_redetect_threshold"].asFloat();
+        }
+        if (trackingConfig["max_track_loss_frames"].type() != Json::nullValue)
+        {
+            tuning.maxTrackLossFrames =
+                trackingConfig["max_track_loss_frames"].asInt();
+        }
+        if (trackingConfig["score_decay_factor"].type() != Json::nullValue)
+        {
+            tuning.scoreDecayFactor =
+                trackingConfig["score_decay_factor"].asFloat();
+        }
+        if (trackingConfig["filter_suspect_static_target"].type() != Json::nullValue)
+        {
+            tuning.filterStaticTarget =
+                trackingConfig["filter_suspect_static_target"].asBool();
+        }
+        if (trackingConfig["static_center_threshold"].type() != Json::nullValue)
+        {
+            tuning.staticCenterThreshold =
+                trackingConfig["static_center_threshold"].asFloat();
+        }
+        if (trackingConfig["static_size_threshold"].type() != Json::nullValue)
+        {
+            tuning.staticSizeThreshold =
+                trackingConfig["static_size_threshold"].asFloat();
+        }
+        if (trackingConfig["static_frame_threshold"].type() != Json::nullValue)
+        {
+            tuning.staticFrameThreshold =
+                trackingConfig["static_frame_threshold"].asInt();
+        }
+    }
+    tuning.validationEnabled = validation.enable;
+    tuning.validationIouThreshold = validation.iouThreshold;
+    tuning.validationMaxErrors = validation.maxErrors;
+    return tuning;
+}
+
+// threshold in [0, 1], missing or out of range keeps the input value
+static void ParseThresh(const Json::Value &value,
+                        const string      &key,
+                        const string      &scope,
+                        float             *thresh)
+{
+    if (value[key].type() == Json::nullValue)
+    {
+        return;
+    }
+    float threshold = value[key].asFloat();
+    if (threshold < 0.0f || threshold > 1.0f)
+    {
+        ACLLITE_LOG_WARNING("%s %s=%.2f out of range, keep %.2f",
+                            scope.c_str(),
+                            key.c_str(),
+                            threshold,
+                            *thresh);
+        return;
+    }
+    *thresh = threshold;
+}
+
+// missing fields keep the input values so io_info inherits model_config
+void ParsePostTuning(const Json::Value &value,
+                     const string      &scope,
+                     PostTuning        *tuning)
+{
+    ParseThresh(value, "conf_thresh", scope, &tuning->confThresh);
+    ParseThresh(value, "nms_thresh", scope, &tuning->nmsThresh);
+    if (value["target_class_id"].type() != Json::nullValue)
+    {
+        ParseTargetClassIds(value["target_class_id"], scope, &tuning->targetClassIds);
+    }
+}
+
+// negative values are clamped to 0
+void ParseFrameDecimation(const Json::Value &value,
+                          const string      &scope,
+                          int               *frameDecimation)
+{
+    if (value["frame_decimation"].type() == Json::nullValue)
+    {
+        return;
+    }
+    *frameDecimation = value["frame_decimation"].asInt();
+    if (*frameDecimation < 0)
+    {
+        ACLLITE_LOG_WARNING("%s frame_decimation is negative, clamping to 0",
+                            scope.c_str());
+        *frameDecimation = 0;
+    }
+}
+
+uint32_t MsgFrameNum(uint32_t batch, uint32_t batchDeadlineUs)
+{
+    return (batch > 1 && batchDeadlineUs > 0) ? 1 : batch;
+}
+
+uint32_t ParseBatchDeadline(const Json::Value &value,
+                            const string      &scope)
+{
+    if (value.type() == Json::nullValue)
+    {
+        return 0;
+    }
+    if (!value.isNumeric() || value.asDouble() < 0 ||
+        value.asDouble() > 1000)
+    {
+        ACLLITE_LOG_WARNING("batch_deadline_ms must be 0-1000 at %s, "
+                            "batching per channel",
+                            scope.c_str());
+        return 0;
+    }
+    return (uint32_t)(value.asDouble() * 1000);
+}
+
+void CollectLegacyTuning(const Json::Value &root, RuntimeTuning *tuning)
+{
+    // like kPostNum, a model without postnum keeps the previous value
+    int                postNum = 1;
+    const Json::Value &devices = root["device_config"];
+    for (Json::ArrayIndex i = 0; i < devices.size(); i++)
+    {
+        const Json::Value &models = devices[i]["model_config"];
+        for (Json::ArrayIndex j = 0; j < models.size(); j++)
+        {
+            const Json::Value &model = models[j];
+            if (model["postnum"].type() != Json::nullValue)
+            {
+                postNum = model["postnum"].asInt();
+            }
+            PostTuning modelPost;
+            ParsePostTuning(model, "model_config", &modelPost);
+            int modelFrameDecimation = 0;
+            ParseFrameDecimation(model, "model_config", &modelFrameDecimation);
+            // model_config.track_config.tracking_config wins over io_info.tracking_config
+            const Json::Value &modelTrackingConfig =
+                model["track_config"]["tracking_config"];
+            for (Json::ArrayIndex k = 0; k < model["io_info"].size(); k++)
+            {
+                const Json::Value &io = model["io_info"][k];
+                uint32_t           channelId = io["channel_id"].asInt();
+                string             channel = to_string(channelId);
+                PostTuning         post = modelPost;
+                ParsePostTuning(io, "io_info", &post);
+                for (int m = 0; m < postNum; m++)
+                {
+                    tuning->posts[kPostName + channel + "_" + to_string(m)] = post;
+                }
+                const Json::Value &trackingConfig =
+                    modelTrackingConfig.type() != Json::nullValue
+                        ? modelTrackingConfig
+                        : io["tracking_config"];
+                TrackingValidation validation =
+                    ParseTrackingValidation(trackingConfig, channelId);
+                InputTuning input;
+                input.frameDecimation = modelFrameDecimation;
+                ParseFrameDecimation(io, "io_info", &input.frameDecimation);
+                input.trackingValidationEnabled = validation.enable;
+                input.trackingValidationInterval = validation.interval;
+                tuning->inputs[kDataInputName + channel] = input;
+                tuning->tracks[kTrackName + channel] =
+                    ParseTrackTuning(trackingConfig, validation);
+            }
+        }
+    }
+}
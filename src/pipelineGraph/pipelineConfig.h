@@ -0,0 +1,177 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File pipelineConfig.h
+* Description: parsers of the config fields shared by device_config and graph
+*/
+#ifndef PIPELINECONFIG_H
+#define PIPELINECONFIG_H
+#pragma once
+#include "AclLiteThread.h"
+#include "AclLiteType.h"
+#include "AclLiteVideoCapBase.h"
+#include "MotionGate.h"
+#include "Params.h"
+#include "ResizeHelper.h"
+#include "dataInput/dataInput.h"
+#include <json/json.h>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// Stage names used by edge_policy, thread_sched and worker_pool, and the
+// node types of the graph; the display stage is rtsp_display or
+// hdmi_display in a graph
+const std::string kStageDataInput = "data_input";
+const std::string kEdgeDetectPre = "detect_pre";
+const std::string kEdgeDetectInfer = "detect_infer";
+const std::string kEdgeDetectPost = "detect_post";
+const std::string kEdgeTrack = "track";
+const std::string kEdgeDataOutput = "data_output";
+const std::string kEdgeDisplay = "display";
+const std::string kNodeRtspDisplay = "rtsp_display";
+const std::string kNodeHdmiDisplay = "hdmi_display";
+// helper thread roles of the top level thread_sched
+const std::string kHelperDecode = "decode";
+const std::string kHelperEncode = "encode";
+const std::string kHelperRtspPush = "rtsp_push";
+
+const uint32_t kDefaultMsgQueueSize = 3;
+const int      kDefaultFramesPerSecond = 1000;
+const uint32_t kDisplaySendTimeoutUs = 1000;
+const uint32_t kDisplayQueueSize = 1000;
+
+// what the sender does when the queue of one edge is full
+struct EdgePolicy
+{
+    AclLiteSendPolicy policy = ACLLITE_SEND_BLOCK;
+    uint32_t          timeoutUs = ACLLITE_WAIT_FOREVER;
+};
+
+// detection validation settings of tracking_config
+struct TrackingValidation
+{
+    bool  enable = false;
+    int   interval = 0;
+    float iouThreshold = 0.30f;
+    int   maxErrors = 3;
+};
+
+// all hot reloadable parameters of one config parse, by thread instance name
+struct RuntimeTuning
+{
+    std::map<std::string, PostTuning>  posts;
+    std::map<std::string, InputTuning> inputs;
+    std::map<std::string, TrackTuning> tracks;
+};
+
+/**
+ * The parsers below take the JSON value and a scope naming where it comes
+ * from in the log. Invalid values are logged and ignored, the output keeps
+ * its default or the value it had on input, so that io_info can override
+ * model_config by parsing into a copy of the model level result.
+ */
+
+// target_class_id: one id or an array, empty output means no filter;
+// false if the type is not supported
+bool ParseTargetClassIds(const Json::Value      &value,
+                         const std::string      &scope,
+                         std::vector<int>       *targetClassIds);
+// resize_type: "fit" (default) or "stretch"
+ResizeProcessType ParseResizeType(const Json::Value &value,
+                                  const std::string &scope);
+// msg_queue_type: "mutex" (default), "lockfree"/"mpsc" or "spsc"; spsc only
+// takes effect through StageQueueType
+AclLiteQueueType ParseQueueType(const Json::Value &value,
+                                const std::string &scope);
+// queue type a stage really uses: spsc falls back to mpsc unless exactly
+// one thread sends data messages to the stage
+AclLiteQueueType StageQueueType(AclLiteQueueType   type,
+                                uint32_t           senderNum,
+                                const std::string &name);
+// latency_mode: "accurate" (every frame) or "live" (newest frame only)
+void ParseLatencyMode(const Json::Value &value,
+                      const std::string &scope,
+                      bool              *liveMode);
+RawInputConfig ParseRawConfig(const Json::Value &value,
+                              const std::string &scope);
+PicInputConfig ParsePicConfig(const Json::Value &value,
+                              const std::string &scope);
+void ParseMotionGateConfig(const Json::Value &value,
+                           const std::string &scope,
+                           MotionGateConfig  *config);
+void ParseAdaptiveDecimation(const Json::Value        &value,
+                             const std::string        &scope,
+                             AdaptiveDecimationConfig *config);
+// decoder, decoder_threads and reconnect_max_ms of an input
+void ParseDecodeConfig(const Json::Value &value,
+                       const std::string &scope,
+                       VideoDecodeConfig *config);
+
+std::map<std::string, EdgePolicy> DefaultEdgePolicies();
+// edge_policy: per edge a policy name or {"policy", "timeout_ms"}
+void ParseEdgePolicies(const Json::Value                 &value,
+                       const std::string                 &scope,
+                       std::map<std::string, EdgePolicy> *policies);
+void ApplyEdgePolicy(const std::map<std::string, EdgePolicy> &policies,
+                     const std::string                       &edge,
+                     AclLiteThreadParam                      *param);
+// the stage runs on the worker pool if it is in poolStages; its
+// thread_sched is dropped with a warning then, call after ApplyThreadSched
+void ApplyExecMode(const std::set<std::string> &poolStages,
+                   const std::string           &stage,
+                   AclLiteThreadParam          *param);
+
+std::map<std::string, AclLiteThreadSched> DefaultStageScheds();
+std::map<std::string, AclLiteThreadSched> DefaultHelperScheds();
+// thread_sched: per stage {"cpus", "nice", "fifo_priority"}, keys not in
+// scheds are ignored
+void ParseThreadSched(const Json::Value                         &value,
+                      const std::string                         &scope,
+                      std::map<std::string, AclLiteThreadSched> *scheds);
+void ApplyThreadSched(const std::map<std::string, AclLiteThreadSched> &scheds,
+                      const std::string                               &stage,
+                      AclLiteThreadParam                              *param);
+
+// rtsp_config / hdmi_config (for the matching outputType) and h264_config
+VencConfig ParseVencConfig(const Json::Value &value,
+                           const std::string &outputType,
+                           uint32_t           modelWidth,
+                           uint32_t           modelHeight);
+TrackingValidation ParseTrackingValidation(const Json::Value &trackingConfig,
+                                           uint32_t           channelId);
+TrackTuning ParseTrackTuning(const Json::Value        &trackingConfig,
+                             const TrackingValidation &validation);
+// conf_thresh, nms_thresh and target_class_id
+void ParsePostTuning(const Json::Value &value,
+                     const std::string &scope,
+                     PostTuning        *tuning);
+void ParseFrameDecimation(const Json::Value &value,
+                          const std::string &scope,
+                          int               *frameDecimation);
+
+// frames per message: one when the infer thread batches across channels,
+// else each channel reads a whole batch into one message
+uint32_t MsgFrameNum(uint32_t batch, uint32_t batchDeadlineUs);
+// batch_deadline_ms in microseconds, 0 if missing or invalid
+uint32_t ParseBatchDeadline(const Json::Value &value,
+                            const std::string &scope);
+
+// hot reloadable parameters of device_config, io_info overrides
+// model_config; the thread names match CreateALLThreadInstance
+void CollectLegacyTuning(const Json::Value &root, RuntimeTuning *tuning);
+
+#endif
@@ -0,0 +1,363 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File pipelineGraph.cpp
+* Description: declarative pipeline graph and the builder creating its threads
+*/
+#include "pipelineGraph.h"
+#include "AclLiteUtils.h"
+#include <algorithm>
+#include <cctype>
+
+using namespace std;
+
+bool ParseSendPolicyName(string name, AclLiteSendPolicy *policy)
+{
+    name = TrimString(name);
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    if (name == "block")
+    {
+        *policy = ACLLITE_SEND_BLOCK;
+    }
+    else if (name == "drop_oldest")
+    {
+        *policy = ACLLITE_SEND_DROP_OLDEST;
+    }
+    else if (name == "drop_newest")
+    {
+        *policy = ACLLITE_SEND_DROP_NEWEST;
+    }
+    else if (name == "fail_fast")
+    {
+        *policy = ACLLITE_SEND_FAIL_FAST;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+AclLiteError PipelineGraph::Parse(const Json::Value &value)
+{
+    nodes_.clear();
+    edges_.clear();
+    nodeIndex_.clear();
+    if (!value.isObject() || !value["nodes"].isArray() ||
+        value["nodes"].empty())
+    {
+        ACLLITE_LOG_ERROR("graph must be object with a non-empty nodes array");
+        return ACLLITE_ERROR;
+    }
+    const Json::Value &nodes = value["nodes"];
+    for (Json::ArrayIndex i = 0; i < nodes.size(); i++)
+    {
+        if (ParseNode(nodes[i], i) != ACLLITE_OK)
+        {
+            return ACLLITE_ERROR;
+        }
+    }
+    const Json::Value &edges = value["edges"];
+    if (edges.type() != Json::nullValue && !edges.isArray())
+    {
+        ACLLITE_LOG_ERROR("graph edges must be array");
+        return ACLLITE_ERROR;
+    }
+    for (Json::ArrayIndex i = 0; i < edges.size(); i++)
+    {
+        if (ParseEdge(edges[i], i) != ACLLITE_OK)
+        {
+            return ACLLITE_ERROR;
+        }
+    }
+    ACLLITE_LOG_INFO("graph has %zu nodes, %zu edges",
+                     nodes_.size(),
+                     edges_.size());
+    return ACLLITE_OK;
+}
+
+AclLiteError PipelineGraph::ParseNode(const Json::Value &value, uint32_t index)
+{
+    if (!value.isObject() || !value["name"].isString() ||
+        !value["type"].isString())
+    {
+        ACLLITE_LOG_ERROR("graph nodes[%u] needs string name and type", index);
+        return ACLLITE_ERROR;
+    }
+    GraphNode node;
+    node.name = value["name"].asString();
+    node.type = value["type"].asString();
+    if (node.name.empty() || nodeIndex_.count(node.name) > 0)
+    {
+        ACLLITE_LOG_ERROR("graph nodes[%u] name \"%s\" is empty or duplicated",
+                          index,
+                          node.name.c_str());
+        return ACLLITE_ERROR;
+    }
+    if (value["device_id"].type() != Json::nullValue)
+    {
+        if (!value["device_id"].isIntegral() ||
+            value["device_id"].asInt() < 0)
+        {
+            ACLLITE_LOG_ERROR("graph node %s device_id invalid",
+                              node.name.c_str());
+            return ACLLITE_ERROR;
+        }
+        node.deviceId = value["device_id"].asUInt();
+    }
+    node.config = value;
+    node.params = value["params"];
+    if (node.params.type() == Json::nullValue)
+    {
+        node.params = Json::Value(Json::objectValue);
+    }
+    else if (!node.params.isObject())
+    {
+        ACLLITE_LOG_ERROR("graph node %s params must be object",
+                          node.name.c_str());
+        return ACLLITE_ERROR;
+    }
+    nodeIndex_[node.name] = nodes_.size();
+    nodes_.push_back(node);
+    return ACLLITE_OK;
+}
+
+AclLiteError PipelineGraph::ParseEdge(const Json::Value &value, uint32_t index)
+{
+    if (!value.isObject() || !value["from"].isString() ||
+        !value["to"].isString())
+    {
+        ACLLITE_LOG_ERROR("graph edges[%u] needs string from and to", index);
+        return ACLLITE_ERROR;
+    }
+    GraphEdge edge;
+    edge.from = value["from"].asString();
+    edge.to = value["to"].asString();
+    if (FindNode(edge.from) == nullptr || FindNode(edge.to) == nullptr ||
+        edge.from == edge.to)
+    {
+        ACLLITE_LOG_ERROR("graph edges[%u] %s -> %s has an unknown endpoint or "
+                          "is a self loop",
+                          index,
+                          edge.from.c_str(),
+                          edge.to.c_str());
+        return ACLLITE_ERROR;
+    }
+    for (const GraphEdge &other : edges_)
+    {
+        if (other.from == edge.from && other.to == edge.to)
+        {
+            ACLLITE_LOG_ERROR("graph edge %s -> %s is duplicated",
+                              edge.from.c_str(),
+                              edge.to.c_str());
+            return ACLLITE_ERROR;
+        }
+    }
+    if (value["queue_size"].type() != Json::nullValue)
+    {
+        if (!value["queue_size"].isIntegral() ||
+            value["queue_size"].asInt() < 1)
+        {
+            ACLLITE_LOG_ERROR("graph edge %s -> %s queue_size invalid",
+                              edge.from.c_str(),
+                              edge.to.c_str());
+            return ACLLITE_ERROR;
+        }
+        edge.queueSize = value["queue_size"].asUInt();
+    }
+    if (value["policy"].type() != Json::nullValue)
+    {
+        if (!value["policy"].isString() ||
+            !ParseSendPolicyName(value["policy"].asString(), &edge.policy))
+        {
+            ACLLITE_LOG_ERROR("graph edge %s -> %s policy is unknown",
+                              edge.from.c_str(),
+                              edge.to.c_str());
+            return ACLLITE_ERROR;
+        }
+        edge.hasPolicy = true;
+    }
+    if (value["timeout_ms"].type() != Json::nullValue)
+    {
+        // like edge_policy: only applies to block, 0 waits forever
+        if (!value["timeout_ms"].isIntegral())
+        {
+            ACLLITE_LOG_ERROR("graph edge %s -> %s timeout_ms invalid",
+                              edge.from.c_str(),
+                              edge.to.c_str());
+            return ACLLITE_ERROR;
+        }
+        int timeoutMs = value["timeout_ms"].asInt();
+        edge.timeoutUs =
+            timeoutMs > 0 ? (uint32_t)timeoutMs * 1000 : ACLLITE_WAIT_FOREVER;
+        edge.hasPolicy = true;
+    }
+    edges_.push_back(edge);
+    return ACLLITE_OK;
+}
+
+const GraphNode *PipelineGraph::FindNode(const string &name) const
+{
+    auto it = nodeIndex_.find(name);
+    return it == nodeIndex_.end() ? nullptr : &nodes_[it->second];
+}
+
+vector<const GraphNode *> PipelineGraph::Successors(const string &name,
+                                                    const string &type) const
+{
+    vector<const GraphNode *> nodes;
+    for (const GraphEdge &edge : edges_)
+    {
+        const GraphNode *node = FindNode(edge.to);
+        if (edge.from == name && (type.empty() || node->type == type))
+        {
+            nodes.push_back(node);
+        }
+    }
+    return nodes;
+}
+
+vector<const GraphNode *> PipelineGraph::Predecessors(const string &name,
+                                                      const string &type) const
+{
+    vector<const GraphNode *> nodes;
+    for (const GraphEdge &edge : edges_)
+    {
+        const GraphNode *node = FindNode(edge.from);
+        if (edge.to == name && (type.empty() || node->type == type))
+        {
+            nodes.push_back(node);
+        }
+    }
+    return nodes;
+}
+
+vector<const GraphEdge *> PipelineGraph::InEdges(const string &name) const
+{
+    vector<const GraphEdge *> edges;
+    for (const GraphEdge &edge : edges_)
+    {
+        if (edge.to == name)
+        {
+            edges.push_back(&edge);
+        }
+    }
+    return edges;
+}
+
+void PipelineGraphBuilder::RegisterType(const string        &type,
+                                        const GraphNodeType &nodeType)
+{
+    types_[type] = nodeType;
+}
+
+AclLiteError PipelineGraphBuilder::ApplyInEdges(const PipelineGraph &graph,
+                                                const GraphNode     &node,
+                                                AclLiteThreadParam  *param) const
+{
+    // A node has one message queue shared by all its in-edges, so the edges
+    // setting queue_size or policy must agree; edges leaving them out take
+    // whatever the others set.
+    const GraphEdge *sizeEdge = nullptr;
+    const GraphEdge *policyEdge = nullptr;
+    for (const GraphEdge *edge : graph.InEdges(node.name))
+    {
+        if (edge->queueSize > 0)
+        {
+            if (sizeEdge != nullptr && sizeEdge->queueSize != edge->queueSize)
+            {
+                ACLLITE_LOG_ERROR("graph edges %s -> %s and %s -> %s set "
+                                  "different queue_size %u and %u",
+                                  sizeEdge->from.c_str(),
+                                  node.name.c_str(),
+                                  edge->from.c_str(),
+                                  node.name.c_str(),
+                                  sizeEdge->queueSize,
+                                  edge->queueSize);
+                return ACLLITE_ERROR;
+            }
+            sizeEdge = edge;
+        }
+        if (!edge->hasPolicy)
+        {
+            continue;
+        }
+        if (policyEdge != nullptr &&
+            (policyEdge->policy != edge->policy ||
+             policyEdge->timeoutUs != edge->timeoutUs))
+        {
+            ACLLITE_LOG_ERROR("graph edges %s -> %s and %s -> %s set "
+                              "different policy or timeout_ms",
+                              policyEdge->from.c_str(),
+                              node.name.c_str(),
+                              edge->from.c_str(),
+                              node.name.c_str());
+            return ACLLITE_ERROR;
+        }
+        policyEdge = edge;
+    }
+    if (sizeEdge != nullptr)
+    {
+        param->queueSize = sizeEdge->queueSize;
+    }
+    if (policyEdge != nullptr)
+    {
+        param->sendPolicy = policyEdge->policy;
+        param->sendTimeoutUs = policyEdge->timeoutUs;
+    }
+    return ACLLITE_OK;
+}
+
+AclLiteError PipelineGraphBuilder::Build(const PipelineGraph        &graph,
+                                         vector<AclLiteThreadParam> &threadTbl) const
+{
+    for (const GraphNode &node : graph.Nodes())
+    {
+        if (types_.count(node.type) == 0)
+        {
+            ACLLITE_LOG_ERROR("graph node %s has unknown type %s",
+                              node.name.c_str(),
+                              node.type.c_str());
+            return ACLLITE_ERROR;
+        }
+    }
+    for (const GraphNode &node : graph.Nodes())
+    {
+        const GraphNodeType &nodeType = types_.at(node.type);
+        AclLiteThreadParam   param;
+        param.threadInstName = node.name;
+        if (nodeType.queueSize > 0)
+        {
+            param.queueSize = nodeType.queueSize;
+        }
+        param.sendPolicy = nodeType.policy;
+        param.sendTimeoutUs = nodeType.timeoutUs;
+        if (ApplyInEdges(graph, node, &param) != ACLLITE_OK)
+        {
+            return ACLLITE_ERROR;
+        }
+        AclLiteError ret = nodeType.factory(graph, node, &param);
+        if (ret != ACLLITE_OK || param.threadInst == nullptr)
+        {
+            ACLLITE_LOG_ERROR("Create graph node %s(%s) failed",
+                              node.name.c_str(),
+                              node.type.c_str());
+            delete param.threadInst;
+            return ACLLITE_ERROR;
+        }
+        threadTbl.push_back(param);
+    }
+    return ACLLITE_OK;
+}
@@ -0,0 +1,130 @@
+/**
+* Copyright (c) Huawei Technologies Co., Ltd. 2020-2022. All rights reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+
+* http://www.apache.org/licenses/LICENSE-2.0
+
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+
+* File pipelineGraph.h
+* Description: declarative pipeline graph and the builder creating its threads
+*/
+#ifndef PIPELINEGRAPH_H
+#define PIPELINEGRAPH_H
+#pragma once
+#include "AclLiteError.h"
+#include "AclLiteThread.h"
+#include <functional>
+#include <json/json.h>
+#include <map>
+#include <string>
+#include <vector>
+
+// one node of the graph is one thread instance, name is the instance name
+struct GraphNode
+{
+    std::string name;
+    std::string type;
+    uint32_t    deviceId = 0;
+    Json::Value config; // whole node config (msg_queue_type, thread_sched...)
+    Json::Value params; // parameters of the node type
+};
+
+// queue size and full queue policy of an edge apply to the message queue
+// of the receiving node
+struct GraphEdge
+{
+    std::string       from;
+    std::string       to;
+    uint32_t          queueSize = 0; // 0: default of the node type
+    bool              hasPolicy = false;
+    AclLiteSendPolicy policy = ACLLITE_SEND_BLOCK;
+    uint32_t          timeoutUs = ACLLITE_WAIT_FOREVER;
+};
+
+/**
+ * Nodes and edges of the "graph" config section:
+ * {"nodes": [{"name": "pre0", "type": "detect_pre", "device_id": 0,
+ *             "params": {...}}],
+ *  "edges": [{"from": "input0", "to": "pre0", "queue_size": 3,
+ *             "policy": "block", "timeout_ms": 40}]}
+ * Only the structure is checked here, what a node type accepts is up to
+ * the factory registered for it.
+ */
+class PipelineGraph
+{
+  public:
+    AclLiteError Parse(const Json::Value &value);
+
+    const std::vector<GraphNode> &Nodes() const { return nodes_; }
+    const GraphNode *FindNode(const std::string &name) const;
+    // direct successors / predecessors of node name, all types if type is ""
+    std::vector<const GraphNode *> Successors(const std::string &name,
+                                              const std::string &type) const;
+    std::vector<const GraphNode *> Predecessors(const std::string &name,
+                                                const std::string &type) const;
+    std::vector<const GraphEdge *> InEdges(const std::string &name) const;
+
+  private:
+    AclLiteError ParseNode(const Json::Value &value, uint32_t index);
+    AclLiteError ParseEdge(const Json::Value &value, uint32_t index);
+
+  private:
+    std::vector<GraphNode>        nodes_;
+    std::vector<GraphEdge>        edges_;
+    std::map<std::string, size_t> nodeIndex_;
+};
+
+// creates the thread instance of a node and fills context, run mode, queue
+// type and scheduling of param, queue size and send policy are set by the
+// builder from the edges
+typedef std::function<AclLiteError(const PipelineGraph &graph,
+                                   const GraphNode     &node,
+                                   AclLiteThreadParam  *param)>
+    GraphNodeFactory;
+
+struct GraphNodeType
+{
+    GraphNodeFactory  factory;
+    // used when no edge into the node sets them, queueSize 0 keeps the
+    // AclLiteThreadParam default
+    uint32_t          queueSize = 0;
+    AclLiteSendPolicy policy = ACLLITE_SEND_BLOCK;
+    uint32_t          timeoutUs = ACLLITE_WAIT_FOREVER;
+};
+
+class PipelineGraphBuilder
+{
+  public:
+    void RegisterType(const std::string &type, const GraphNodeType &nodeType);
+    /**
+     * @brief Create one thread per node in the declared order
+     * @param [out] threadTbl: the created threads are appended, on error the
+     *        ones created so far are left for the caller to free
+     */
+    AclLiteError Build(const PipelineGraph             &graph,
+                       std::vector<AclLiteThreadParam> &threadTbl) const;
+
+  private:
+    // queue size and send policy from the edges into node, an error if
+    // they disagree
+    AclLiteError ApplyInEdges(const PipelineGraph &graph,
+                              const GraphNode     &node,
+                              AclLiteThreadParam  *param) const;
+
+  private:
+    std::map<std::string, GraphNodeType> types_;
+};
+
+// block | drop_oldest | drop_newest | fail_fast, policy is kept if the name
+// is unknown
+bool ParseSendPolicyName(std::string name, AclLiteSendPolicy *policy);
+
+#endif
@@ -6,7 +6,7 @@
 #include <BasicUsageEnvironment.hh>
 #include <GroupsockHelper.hh>
 #include <H264VideoRTPSink.hh>
-#include <H264VideoStreamFramer.hh>
+#include <H264VideoStreamDiscreteFramer.hh>
 #include <OnDemandServerMediaSubsession.hh>
 #include <liveMedia.hh>
 
@@ -62,6 +62,30 @@ std::string GetLocalHostIp()
 
     return ip;
 }
+
+// data[from, size) 中下一个 Annex-B 起始码的位置, 没有时返回 size
+size_t FindStartCode(const std::vector<uint8_t> &data, size_t from, size_t *codeLen)
+{
+    for (size_t i = from; i + 3 <= data.size(); i++)
+    {
+        if (data[i] != 0 || data[i + 1] != 0)
+        {
+            continue;
+        }
+        if (data[i + 2] == 1)
+        {
+            *codeLen = 3;
+            return i;
+        }
+        if (i + 4 <= data.size() && data[i + 2] == 0 && data[i + 3] == 1)
+        {
+            *codeLen = 4;
+            return i;
+        }
+    }
+    *codeLen = 0;
+    return data.size();
+}
 } // namespace
 
 // ==================== Live555H264Source 实现 ====================
@@ -75,7 +99,8 @@ class Live555H264Source : public FramedSource
         std::mutex              *queueMutex,
         std::condition_variable *queueCond,
         std::atomic<bool>       *running,
-        unsigned                 fps);
+        unsigned                 fps,
+        AclLiteCounter          *truncatedNum);
 
   protected:
     Live555H264Source(
@@ -84,7 +109,8 @@ class Live555H264Source : public FramedSource
         std::mutex              *queueMutex,
         std::condition_variable *queueCond,
         std::atomic<bool>       *running,
-        unsigned                 fps);
+        unsigned                 fps,
+        AclLiteCounter          *truncatedNum);
 
     virtual ~Live555H264Source();
 
@@ -97,15 +123,24 @@ class Live555H264Source : public FramedSource
     std::mutex              *fQueueMutex;
     std::condition_variable *fQueueCond;
     std::atomic<bool>       *fRunning;
+    AclLiteCounter          *fTruncatedNum; // 超过 fMaxSize 被截断的 NAL
+
+    void           UpdatePacketTime();
 
     unsigned       fFrameDuration; // 微秒
     struct timeval fLastFrameTime;
     bool           fHaveStartedReading;
+    // 展示时间 = 首包墙钟 + 包时间戳相对首包的偏移, live555 据此生成 RTP 时间戳
+    struct timeval fPacketTime;    // 当前包的展示时间, 分片共用
+    bool           fHaveTimeBase;
+    int64_t        fBaseWallUs;
+    int64_t        fBasePtsUs;
     
-    // 帧分片支持：处理大关键帧
+    // 一个编码包(一帧)按 NAL 逐个投递
     H264Packet     fCurrentPacket;
-    size_t         fPacketOffset;  // 当前包的发送偏移
+    size_t         fPacketOffset;  // 下一个 NAL 在包中的起点(起始码之后)
     bool           fHasPartialFrame;
+    bool           fNewAccessUnit; // 下一个 NAL 是该帧的第一个
 };
 
 Live555H264Source *Live555H264Source::createNew(
@@ -114,9 +149,11 @@ Live555H264Source *Live555H264Source::createNew(
     std::mutex              *queueMutex,
     std::condition_variable *queueCond,
     std::atomic<bool>       *running,
-    unsigned                 fps)
+    unsigned                 fps,
+    AclLiteCounter          *truncatedNum)
 {
-    return new Live555H264Source(env, queue, queueMutex, queueCond, running, fps);
+    return new Live555H264Source(env, queue, queueMutex, queueCond, running, fps,
+                                 truncatedNum);
 }
 
 Live555H264Source::Live555H264Source(
@@ -125,16 +162,22 @@ Live555H264Source::Live555H264Source(
     std::mutex              *queueMutex,
     std::condition_variable *queueCond,
     std::atomic<bool>       *running,
-    unsigned                 fps)
+    unsigned                 fps,
+    AclLiteCounter          *truncatedNum)
     : FramedSource(env),
       fQueue(queue),
       fQueueMutex(queueMutex),
       fQueueCond(queueCond),
       fRunning(running),
+      fTruncatedNum(truncatedNum),
       fFrameDuration(1000000 / fps),
       fHaveStartedReading(false),
+      fHaveTimeBase(false),
+      fBaseWallUs(0),
+      fBasePtsUs(0),
       fPacketOffset(0),
-      fHasPartialFrame(false)
+      fHasPartialFrame(false),
+      fNewAccessUnit(false)
 {
     gettimeofday(&fLastFrameTime, NULL);
     ACLLITE_LOG_INFO("Live555H264Source created, fps=%u, frameDuration=%uus", fps, fFrameDuration);
@@ -154,6 +197,27 @@ void Live555H264Source::doGetNextFrame()
 
 void Live555H264Source::deliverFrame0(void *clientData) { ((Live555H264Source *)clientData)->deliverFrame(); }
 
+void Live555H264Source::UpdatePacketTime()
+{
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    if (fCurrentPacket.ptsUs < 0)
+    {
+        // 没有时间戳的包按取出时刻
+        fPacketTime = now;
+        return;
+    }
+    if (!fHaveTimeBase)
+    {
+        fBaseWallUs = (int64_t)now.tv_sec * 1000000 + now.tv_usec;
+        fBasePtsUs = fCurrentPacket.ptsUs;
+        fHaveTimeBase = true;
+    }
+    int64_t us = fBaseWallUs + (fCurrentPacket.ptsUs - fBasePtsUs);
+    fPacketTime.tv_sec = us / 1000000;
+    fPacketTime.tv_usec = us % 1000000;
+}
+
 void Live555H264Source::deliverFrame()
 {
     if (!isCurrentlyAwaitingData())
@@ -170,8 +234,15 @@ void Live555H264Source::deliverFrame()
         {
             fCurrentPacket = std::move(fQueue->front());
             fQueue->pop();
-            fPacketOffset = 0;
+            size_t codeLen = 0;
+            fPacketOffset = FindStartCode(fCurrentPacket.data, 0, &codeLen) + codeLen;
+            if (fPacketOffset >= fCurrentPacket.data.size())
+            {
+                fPacketOffset = 0; // 没有起始码, 整包当作一个 NAL
+            }
             fHasPartialFrame = true;
+            fNewAccessUnit = true;
+            UpdatePacketTime();
             
             static int frameCount = 0;
             if (++frameCount % 100 == 0)
@@ -188,36 +259,39 @@ void Live555H264Source::deliverFrame()
         }
     }
 
-    // 计算本次可以发送的数据大小
-    size_t remainingSize = fCurrentPacket.data.size() - fPacketOffset;
-    size_t sendSize = (remainingSize > fMaxSize) ? fMaxSize : remainingSize;
-    
-    // 复制数据
+    // 取出下一个 NAL(不含起始码). discrete framer 不重新解析码流, 沿用这里
+    // 给出的展示时间, 同一帧的各 NAL 共用包的时间戳
+    size_t codeLen = 0;
+    size_t nalEnd = FindStartCode(fCurrentPacket.data, fPacketOffset, &codeLen);
+    size_t nalSize = nalEnd - fPacketOffset;
+    size_t sendSize = (nalSize > fMaxSize) ? fMaxSize : nalSize;
     memcpy(fTo, fCurrentPacket.data.data() + fPacketOffset, sendSize);
     fFrameSize = sendSize;
-    fNumTruncatedBytes = 0;
-    
-    fPacketOffset += sendSize;
-    
-    // 检查是否发送完成
+    fNumTruncatedBytes = nalSize - sendSize;
+    if (fNumTruncatedBytes > 0)
+    {
+        fTruncatedNum->Add();
+        ACLLITE_LOG_WARNING("NAL of %zu bytes truncated to %u bytes", nalSize, fMaxSize);
+    }
+    fPacketOffset = nalEnd + codeLen;
     if (fPacketOffset >= fCurrentPacket.data.size())
     {
         fHasPartialFrame = false;
         fPacketOffset = 0;
-        
-        // 如果是大帧且已完成，记录日志
-        if (fCurrentPacket.data.size() > fMaxSize && fCurrentPacket.isKeyFrame)
-        {
-            static int fragmentCount = 0;
-            if (++fragmentCount % 10 == 1)
-            {
-                ACLLITE_LOG_INFO("Large key frame sent in fragments: %zu bytes in %zu chunks",
-                    fCurrentPacket.data.size(), (fCurrentPacket.data.size() + fMaxSize - 1) / fMaxSize);
-            }
-        }
+    }
+    bool firstNal = fNewAccessUnit;
+    fNewAccessUnit = false;
+    // 同一帧的 NAL 连续发出, 帧间隔记在最后一个 NAL 上
+    unsigned duration = fHasPartialFrame ? 0 : fFrameDuration;
+    if (!firstNal)
+    {
+        fPresentationTime = fPacketTime;
+        fDurationInMicroseconds = duration;
+        afterGetting(this);
+        return;
     }
 
-    // 计算时间戳(使用固定帧间隔保证平滑播放)
+    // 投递按固定帧间隔节流保证平滑播放, 展示时间取自包的时间戳
     struct timeval now;
     gettimeofday(&now, NULL);
 
@@ -235,9 +309,10 @@ void Live555H264Source::deliverFrame()
             [](void *clientData)
             {
                 Live555H264Source *source = (Live555H264Source *)clientData;
-                source->fLastFrameTime = source->fPresentationTime;
-                gettimeofday(&source->fPresentationTime, NULL);
-                source->fDurationInMicroseconds = source->fFrameDuration;
+                gettimeofday(&source->fLastFrameTime, NULL);
+                source->fPresentationTime = source->fPacketTime;
+                source->fDurationInMicroseconds =
+                    source->fHasPartialFrame ? 0 : source->fFrameDuration;
                 FramedSource::afterGetting(source);
             },
             this);
@@ -245,8 +320,8 @@ void Live555H264Source::deliverFrame()
     }
 
     fLastFrameTime = now;
-    fPresentationTime = now;
-    fDurationInMicroseconds = fFrameDuration;
+    fPresentationTime = fPacketTime;
+    fDurationInMicroseconds = duration;
 
     // 通知 live555 数据已就绪
     afterGetting(this);
@@ -266,6 +341,9 @@ Live555Streamer::Live555Streamer()
       fQueueMutex(nullptr),
       fQueueCond(nullptr),
       fRunning(nullptr),
+      fDropNum(nullptr),
+      fQueueDepth(nullptr),
+      fTruncatedNum(nullptr),
       fInternalRunning(false),
       fUseInternalQueue(false),
       fEventLoopRunning(false),
@@ -299,6 +377,10 @@ bool Live555Streamer::Init(
     fRtspPort = rtspPort;
     fStreamName = streamName;
     fFps = fps;
+    std::string metricName = "live555." + fStreamName;
+    fDropNum = AclLiteMetrics::GetInstance().GetCounter(metricName + ".h264_drop");
+    fQueueDepth = AclLiteMetrics::GetInstance().GetGauge(metricName + ".h264_queue");
+    fTruncatedNum = AclLiteMetrics::GetInstance().GetCounter(metricName + ".nal_truncated");
 
     ACLLITE_LOG_INFO(
         "Initializing Live555 RTSP server: port=%d, stream=%s, fps=%u",
@@ -339,9 +421,11 @@ bool Live555Streamer::Init(
             std::mutex              *queueMutex,
             std::condition_variable *queueCond,
             std::atomic<bool>       *running,
-            unsigned                 fps)
+            unsigned                 fps,
+            AclLiteCounter          *truncatedNum)
         {
-            return new H264LiveServerMediaSubsession(env, queue, queueMutex, queueCond, running, fps);
+            return new H264LiveServerMediaSubsession(env, queue, queueMutex, queueCond, running, fps,
+                                                     truncatedNum);
         }
 
       protected:
@@ -351,13 +435,15 @@ bool Live555Streamer::Init(
             std::mutex              *queueMutex,
             std::condition_variable *queueCond,
             std::atomic<bool>       *running,
-            unsigned                 fps)
+            unsigned                 fps,
+            AclLiteCounter          *truncatedNum)
             : OnDemandServerMediaSubsession(env, True),
               fQueue(queue),
               fQueueMutex(queueMutex),
               fQueueCond(queueCond),
               fRunning(running),
-              fFps(fps)
+              fFps(fps),
+              fTruncatedNum(truncatedNum)
         {
         }
 
@@ -365,11 +451,12 @@ bool Live555Streamer::Init(
         {
             estBitrate = 4000; // kbps 估计（增加以适应高质量视频）
             Live555H264Source *source =
-                Live555H264Source::createNew(envir(), fQueue, fQueueMutex, fQueueCond, fRunning, fFps);
+                Live555H264Source::createNew(envir(), fQueue, fQueueMutex, fQueueCond, fRunning, fFps,
+                                             fTruncatedNum);
             
-            // 使用 framer 来正确解析 H.264 流
-            // 数据源已实现分片发送，可以处理大关键帧
-            return H264VideoStreamFramer::createNew(envir(), source);
+            // 数据源按 NAL 投递并带展示时间, discrete framer 保留这些时间,
+            // RTP 时间戳因此跟随源 pts(字节流 framer 会按帧率重新推算)
+            return H264VideoStreamDiscreteFramer::createNew(envir(), source);
         }
 
         virtual RTPSink *createNewRTPSink(
@@ -386,11 +473,13 @@ bool Live555Streamer::Init(
         std::condition_variable *fQueueCond;
         std::atomic<bool>       *fRunning;
         unsigned                 fFps;
+        AclLiteCounter          *fTruncatedNum;
     };
 
     // 6. 添加子会话
     fSms->addSubsession(
-        H264LiveServerMediaSubsession::createNew(*fEnv, fH264Queue, fQueueMutex, fQueueCond, fRunning, fFps));
+        H264LiveServerMediaSubsession::createNew(*fEnv, fH264Queue, fQueueMutex, fQueueCond, fRunning, fFps,
+                                                 fTruncatedNum));
 
     // 7. 注册会话到 RTSP 服务器
     fRtspServer->addServerMediaSession(fSms);
@@ -447,6 +536,7 @@ void Live555Streamer::Start()
 
 void Live555Streamer::EventLoopThread()
 {
+    ApplyHelperThreadSched("rtsp_push", "live555_" + fStreamName);
     ACLLITE_LOG_INFO("Live555 event loop thread started");
     fScheduler->doEventLoop(&fEventLoopStopFlag);
     fEventLoopRunning = false;
@@ -531,7 +621,9 @@ void Live555Streamer::Enqueue(const H264Packet &packet)
         while (fH264Queue->size() > MAX_Q)
         {
             fH264Queue->pop();
+            fDropNum->Add();
         }
+        fQueueDepth->Set(fH264Queue->size());
     }
     if (fQueueCond)
         fQueueCond->notify_one();
@@ -551,6 +643,9 @@ Live555Streamer::Live555Streamer()
       fQueueMutex(nullptr),
       fQueueCond(nullptr),
       fRunning(nullptr),
+      fDropNum(nullptr),
+      fQueueDepth(nullptr),
+      fTruncatedNum(nullptr),
       fEventLoopRunning(false),
       fInitialized(false)
 {
@@ -77,6 +77,11 @@ class Live555Streamer
     std::condition_variable *fQueueCond;
     std::atomic<bool>       *fRunning;
 
+    // 指标按 live555.<流名> 命名, 在 Init 中注册
+    AclLiteCounter          *fDropNum;
+    AclLiteGauge            *fQueueDepth;
+    AclLiteCounter          *fTruncatedNum;
+
     // 内部队列(当未提供外部队列时启用)
     std::queue<H264Packet>  fInternalQueue;
     std::mutex              fInternalMutex;
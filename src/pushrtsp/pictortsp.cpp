@@ -10,8 +10,10 @@ using namespace std;
 namespace
 {
 const string   g_avFormat = "rtsp";
+const uint32_t kDefaultFps = 25;
+const AVRational kUsTimeBase = {1, 1000000};
 } // namespace
-PicToRtsp::PicToRtsp()
+PicToRtsp::PicToRtsp() : g_streamClock(kDefaultFps)
 {
     this->g_bgrToRtspFlag = false;
     this->g_yuvToRtspFlag = false;
@@ -24,6 +26,8 @@ PicToRtsp::PicToRtsp()
     this->g_videoWriter = nullptr;
     this->g_frameSeq = 0;
     this->g_pushThreadRunning = false;
+    this->g_dropNum = nullptr;
+    this->g_queueDepth = nullptr;
     this->g_flushed = false;
 }
 
@@ -68,6 +72,10 @@ int PicToRtsp::AvInit(int picWidth, int picHeight, std::string g_outFile, aclrtC
     g_vencConfig.context = context;
     g_vencConfig.dataCallback = VencDataCallbackStatic;
     g_vencConfig.callbackUserData = this;
+    g_streamClock = StreamClock(g_vencConfig.outputFps);
+    string metricName = "rtsp_push" + to_string(g_vencConfig.channelId);
+    g_dropNum = AclLiteMetrics::GetInstance().GetCounter(metricName + ".h264_drop");
+    g_queueDepth = AclLiteMetrics::GetInstance().GetGauge(metricName + ".h264_queue");
 
     g_videoWriter = new ::VideoWriter(g_vencConfig, context);
     AclLiteError ret = g_videoWriter->Open();
@@ -177,17 +185,17 @@ int PicToRtsp::AvInit(int picWidth, int picHeight, std::string g_outFile, aclrtC
 
 // 静态回调函数，由VencHelper.cpp中的DvppVenc::SaveVencFile调用
 // NOTE: data指向编码后的H264数据
-void PicToRtsp::VencDataCallbackStatic(void* data, uint32_t size, void* userData)
+void PicToRtsp::VencDataCallbackStatic(void* data, uint32_t size, int64_t ptsUs, void* userData)
 {
     PicToRtsp* instance = static_cast<PicToRtsp*>(userData);
     if (instance)
     {
-        instance->VencDataCallbackImpl(data, size);
+        instance->VencDataCallbackImpl(data, size, ptsUs);
     }
 }
 
 // 实例回调函数，处理编码数据
-void PicToRtsp::VencDataCallbackImpl(void* data, uint32_t size)
+void PicToRtsp::VencDataCallbackImpl(void* data, uint32_t size, int64_t ptsUs)
 {
     if (data == nullptr || size == 0)
     {
@@ -199,6 +207,7 @@ void PicToRtsp::VencDataCallbackImpl(void* data, uint32_t size)
     packet.data.resize(size);
     memcpy(packet.data.data(), data, size);
     packet.pts = g_frameSeq++;
+    packet.ptsUs = ptsUs;
     
     // 检测是否为关键帧（I帧）：H264 NAL type 5 = IDR slice
     packet.isKeyFrame = false;
@@ -230,13 +239,15 @@ void PicToRtsp::VencDataCallbackImpl(void* data, uint32_t size)
         const size_t MAX_QUEUE_SIZE = 150;
         while (g_h264Queue.size() > MAX_QUEUE_SIZE)
         {
-            static size_t dropCnt = 0;
-            if (++dropCnt % 50 == 1) {
-                ACLLITE_LOG_WARNING("H264 queue overflow: size=%zu>%zu, dropped %zu frames",
-                                    g_h264Queue.size(), MAX_QUEUE_SIZE, dropCnt);
+            g_dropNum->Add();
+            if (g_dropNum->Get() % 50 == 1) {
+                ACLLITE_LOG_WARNING("H264 queue overflow: size=%zu>%zu, dropped %lu frames",
+                                    g_h264Queue.size(), MAX_QUEUE_SIZE,
+                                    (unsigned long)g_dropNum->Get());
             }
             g_h264Queue.pop();
         }
+        g_queueDepth->Set(g_h264Queue.size());
     }
     g_queueCond.notify_one();
 }
@@ -244,6 +255,8 @@ void PicToRtsp::VencDataCallbackImpl(void* data, uint32_t size)
 // 异步推流线程
 void PicToRtsp::PushThreadFunc()
 {
+    ApplyHelperThreadSched("rtsp_push",
+                           "rtsp_push" + to_string(g_vencConfig.channelId));
     ACLLITE_LOG_INFO("Push thread started");
     
     while (g_pushThreadRunning)
@@ -318,11 +331,15 @@ int PicToRtsp::PushH264Data(const H264Packet& packet)
     g_pkt->size = packet.data.size();
     g_pkt->stream_index = g_avStream->index;
     
-    // 正确计算时间戳：将帧序号转换为90000Hz时间基准
-    int64_t pts = packet.pts * (90000 / g_frameRate);
+    // 时间戳取自源帧映射到的推流时间轴, 转为流的时间基(RTSP 为 90kHz);
+    // 没有时间的包按帧序号和配置帧率推算
+    int64_t frameUs = g_streamClock.FrameIntervalUs();
+    int64_t ptsUs = (packet.ptsUs >= 0) ? packet.ptsUs
+                                        : (int64_t)packet.pts * frameUs;
+    int64_t pts = av_rescale_q(ptsUs, kUsTimeBase, g_avStream->time_base);
     g_pkt->pts = pts;
     g_pkt->dts = pts;
-    g_pkt->duration = 90000 / g_frameRate; // 每帧的持续时间
+    g_pkt->duration = av_rescale_q(frameUs, kUsTimeBase, g_avStream->time_base);
     g_pkt->pos = -1;
     
     // 检测并标记关键帧(I帧)
@@ -445,6 +462,7 @@ int PicToRtsp::YuvDataToRtsp(void *dataBuf, uint32_t size, uint32_t seq)
     imageData.size = size;
     // 直接使用传入的dataBuf，不拷贝
     imageData.data = std::shared_ptr<uint8_t>((uint8_t *)dataBuf, [](uint8_t *) {});
+    imageData.ptsUs = g_streamClock.Map(-1, 0, false);
 
     AclLiteError ret = g_videoWriter->Read(imageData);
     if (ret != ACLLITE_OK)
@@ -478,6 +496,9 @@ int PicToRtsp::ImageDataToRtsp(ImageData& imageData, uint32_t seq)
         ACLLITE_LOG_ERROR("Hardware encoder not initialized");
         return ACLLITE_ERROR;
     }
+    // 送编码的帧带推流时间轴上的时间戳, 由编码回调带给推流
+    int64_t streamUs = g_streamClock.Map(
+        imageData.ptsUs, imageData.captureUs, imageData.streamGap);
 
     // 如果 ImageData 大小与编码器期望大小不符,尝试做 resize (fallback)
     if (imageData.width != g_vencConfig.maxWidth || imageData.height != g_vencConfig.maxHeight) {
@@ -515,13 +536,16 @@ int PicToRtsp::ImageDataToRtsp(ImageData& imageData, uint32_t seq)
         tmp.height = dstH;
         tmp.size = dstSize;
         tmp.data = std::shared_ptr<uint8_t>(dstBuf, [](uint8_t *p) { av_free(p); });
+        tmp.ptsUs = streamUs;
         AclLiteError ret = g_videoWriter->Read(tmp);
         if (ret != ACLLITE_OK) {
             ACLLITE_LOG_ERROR("Hardware encode YUV(ImageData) failed after fallback resize");
             return ACLLITE_ERROR;
         }
     } else {
-        AclLiteError ret = g_videoWriter->Read(imageData);
+        ImageData frame = imageData;
+        frame.ptsUs = streamUs;
+        AclLiteError ret = g_videoWriter->Read(frame);
         if (ret != ACLLITE_OK) {
             ACLLITE_LOG_ERROR("Hardware encode YUV(ImageData) failed");
             return ACLLITE_ERROR;
@@ -662,6 +686,7 @@ int PicToRtsp::BgrDataToRtsp(void *dataBuf, uint32_t size, uint32_t srcW, uint32
     imageData.height = g_vencConfig.maxHeight;
     imageData.size = g_yuvSize;
     imageData.data = std::shared_ptr<uint8_t>(g_yuvBuf, [](uint8_t *) {});
+    imageData.ptsUs = g_streamClock.Map(-1, 0, false);
 
     AclLiteError ret = g_videoWriter->Read(imageData);
     if (ret != ACLLITE_OK)
@@ -2,6 +2,8 @@
 #include "common.h"
 // 注意：必须在common.h之后包含，因为common.h包含opencv，避免命名冲突
 #include "../../common/include/VideoWriter.h"
+#include "AclLiteMetrics.h"
+#include "StreamClock.h"
 #include <atomic>
 #include <condition_variable>
 #include <mutex>
@@ -13,10 +15,11 @@
 struct H264Packet
 {
     std::vector<uint8_t> data;
-    uint64_t             pts;
+    uint64_t             pts;        // 编码输出序号
+    int64_t              ptsUs;      // 输出流时间轴上的时间戳(微秒), -1 为未知
     bool                 isKeyFrame; // 是否为关键帧（I帧）
 
-    H264Packet() : pts(0), isKeyFrame(false) {}
+    H264Packet() : pts(0), ptsUs(-1), isKeyFrame(false) {}
 };
 
 class PicToRtsp
@@ -40,8 +43,11 @@ class PicToRtsp
     void PrintEncodeQueuesStatus();
 
   private:
-    static void VencDataCallbackStatic(void *data, uint32_t size, void *userData);
-    void        VencDataCallbackImpl(void *data, uint32_t size);
+    static void VencDataCallbackStatic(void    *data,
+                                       uint32_t size,
+                                       int64_t  ptsUs,
+                                       void    *userData);
+    void        VencDataCallbackImpl(void *data, uint32_t size, int64_t ptsUs);
     void        PushThreadFunc();
     int         PushH264Data(const H264Packet &packet);
 
@@ -60,8 +66,12 @@ class PicToRtsp
     std::condition_variable g_queueCond;
     std::thread             g_pushThread;
     std::atomic<bool>       g_pushThreadRunning;
+    AclLiteCounter         *g_dropNum;    // 队列满丢弃的 H264 包
+    AclLiteGauge           *g_queueDepth;
     uint64_t                g_frameSeq;
     bool                    g_flushed; // guard repeated flush/free
+    // 源帧时间映射到推流时间轴, 送编码前打上, 编码回调带回
+    StreamClock             g_streamClock;
 
     // 图像格式转换相关
     AVFrame           *g_rgbFrame;
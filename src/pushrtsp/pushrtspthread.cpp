@@ -10,6 +10,7 @@ uint32_t kBgrMultiplier = 3;
 } // namespace
 
 PushRtspThread::PushRtspThread(std::string rtspUrl, VencConfig vencConfig)
+    : g_captureLatency(nullptr), g_msgNum(nullptr)
 {
     g_rtspUrl = rtspUrl;
     g_vencConfig = vencConfig;
@@ -25,6 +26,10 @@ AclLiteError PushRtspThread::Init()
 {
     g_frameSeq = 0;
     XInitThreads();
+    g_captureLatency = AclLiteMetrics::GetInstance().GetHistogram(
+        SelfInstanceName() + ".capture_latency");
+    g_msgNum = AclLiteMetrics::GetInstance().GetCounter(
+        SelfInstanceName() + ".deliver_msgs");
     
     // 获取当前ACL context用于硬件编码器
     aclrtContext context = nullptr;
@@ -47,42 +52,34 @@ AclLiteError PushRtspThread::Init()
 
 AclLiteError PushRtspThread::Process(int msgId, std::shared_ptr<void> msgData)
 {
-    auto start = std::chrono::high_resolution_clock::now();
-    
     switch (msgId)
     {
     case MSG_RTSP_DISPLAY:
         DisplayMsgProcess(static_pointer_cast<DetectDataMsg>(msgData));
         break;
     case MSG_ENCODE_FINISH:
-        SendMessage(g_MainThreadId, MSG_APP_EXIT, nullptr);
+        SendMessage(g_MainThreadId, MSG_APP_EXIT, nullptr, ACLLITE_PRIO_HIGH);
         break;
     default:
         ACLLITE_LOG_INFO("Present agent display thread ignore msg %d", msgId);
         break;
     }
     
-    auto end = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
-    if (msgId == MSG_RTSP_DISPLAY) {
-        static int logCount = 0;
-        if (++logCount % 30 == 0) {
-            ACLLITE_LOG_INFO("[PushRtspThread] Process time: %ld ms", duration);
-        }
-    }
-    
     return ACLLITE_OK;
 }
 
 AclLiteError
 PushRtspThread::DisplayMsgProcess(std::shared_ptr<DetectDataMsg> detectDataMsg)
 {
-    static int frameCount = 0;
-    frameCount++;
+    AclLiteTraceScope span(detectDataMsg->trace, "rtsp_deliver");
+    g_msgNum->Add();
+    uint64_t msgNum = g_msgNum->Get();
     
-    if (frameCount == 1 || frameCount % 30 == 0) {
-        ACLLITE_LOG_INFO("Processing frame %d, frames in batch: %zu, isLastFrame: %d",
-                         frameCount, detectDataMsg->frame.size(), detectDataMsg->isLastFrame);
+    if (msgNum == 1 || msgNum % 30 == 0) {
+        ACLLITE_LOG_INFO("[%s] Processing frame %lu, frames in batch: %zu, isLastFrame: %d, pts: %ld ms",
+                         SelfInstanceName().c_str(), (unsigned long)msgNum,
+                         detectDataMsg->frame.size(), detectDataMsg->isLastFrame,
+                         (long)(detectDataMsg->ptsUs >= 0 ? detectDataMsg->ptsUs / 1000 : -1));
     }
     
     if (detectDataMsg->isLastFrame)
@@ -94,15 +91,17 @@ PushRtspThread::DisplayMsgProcess(std::shared_ptr<DetectDataMsg> detectDataMsg)
         for (int i = 0; i < detectDataMsg->frame.size(); i++)
         {
             // 数据已在DataOutput中resize,直接使用
-            cv::Mat &frame = detectDataMsg->frame[i];
+            const cv::Mat &frame = detectDataMsg->frame[i].Full();
             g_picToRtsp.BgrDataToRtsp(frame.data,
                                       frame.cols * frame.rows * kBgrMultiplier,
                                       frame.cols,
                                       frame.rows,
                                       g_frameSeq++);
         }
-        SendMessage(
-            detectDataMsg->rtspDisplayThreadId, MSG_ENCODE_FINISH, nullptr);
+        SendMessage(detectDataMsg->rtspDisplayThreadId,
+                    MSG_ENCODE_FINISH,
+                    nullptr,
+                    ACLLITE_PRIO_HIGH_FENCED);
         return ACLLITE_OK;
     }
     if (av_log_get_level() != AV_LOG_ERROR)
@@ -120,6 +119,10 @@ PushRtspThread::DisplayMsgProcess(std::shared_ptr<DetectDataMsg> detectDataMsg)
         //                           g_frameSeq++);
         ImageData imgData = detectDataMsg->decodedImg[i];
         g_picToRtsp.ImageDataToRtsp(imgData, g_frameSeq++);
+        if (imgData.captureUs > 0)
+        {
+            g_captureLatency->Record(AclLiteNowUs() - imgData.captureUs);
+        }
     }
     return ACLLITE_OK;
 }
\ No newline at end of file
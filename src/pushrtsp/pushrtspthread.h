@@ -1,4 +1,5 @@
 #pragma once
+#include "AclLiteMetrics.h"
 #include "AclLiteThread.h"
 #include "Params.h"
 #include "pictortsp.h"
@@ -15,8 +16,10 @@ class PushRtspThread : public AclLiteThread
     DisplayMsgProcess(std::shared_ptr<DetectDataMsg> detectDataMsg);
 
   private:
-    PicToRtsp   g_picToRtsp;
-    uint64_t    g_frameSeq;
-    std::string g_rtspUrl;
-    VencConfig  g_vencConfig;
+    PicToRtsp         g_picToRtsp;
+    uint64_t          g_frameSeq;
+    std::string       g_rtspUrl;
+    VencConfig        g_vencConfig;
+    AclLiteHistogram *g_captureLatency; // 输入收到帧到送编码的时延
+    AclLiteCounter   *g_msgNum;         // 已处理的显示消息数
 };
@@ -0,0 +1,143 @@
+// 解码前丢包判断测试: h265 子层非参考帧只有位于最高时域层时才可丢弃,
+// 低层的 _N 帧仍会被更高层引用; h264 按 nal_ref_idc 判断.
+//
+// 用法: ./test_disposable_packet, 全部通过时返回 0
+#include "DisposablePacket.h"
+#include <cstdio>
+#include <vector>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+}
+
+namespace
+{
+int kFailed = 0;
+
+#define EXPECT_TRUE(cond)                                                      \
+    do                                                                         \
+    {                                                                          \
+        if (!(cond))                                                           \
+        {                                                                      \
+            printf("FAILED %s:%d: %s\n", __FILE__, __LINE__, #cond);           \
+            kFailed++;                                                         \
+        }                                                                      \
+    } while (0)
+
+const int kTrailN = 0;
+const int kTrailR = 1;
+const int kTsaN = 2;
+const int kRaslN = 8;
+const int kIdrWRadl = 19;
+const int kSps = 33;
+const int kPps = 34;
+
+// 在 annexb 包后追加一个 h265 NAL: 两字节头加少量负载
+void AppendHevcNal(std::vector<uint8_t> &packet,
+                   int                   type,
+                   int                   temporalId,
+                   uint8_t               payload = 0x80)
+{
+    const uint8_t startCode[] = {0, 0, 0, 1};
+    packet.insert(packet.end(), startCode, startCode + sizeof(startCode));
+    packet.push_back((uint8_t)(type << 1));
+    packet.push_back((uint8_t)(temporalId + 1));
+    packet.push_back(payload);
+    packet.push_back(0xaa);
+}
+
+std::vector<uint8_t> HevcPicture(int type, int temporalId)
+{
+    std::vector<uint8_t> packet;
+    AppendHevcNal(packet, type, temporalId);
+    // 同一帧的第二个 slice
+    AppendHevcNal(packet, type, temporalId, 0x40);
+    return packet;
+}
+
+// IDR 前带 SPS, sps_max_sub_layers_minus1 = maxTemporalId
+std::vector<uint8_t> HevcIdr(int maxTemporalId)
+{
+    std::vector<uint8_t> packet;
+    AppendHevcNal(packet, kSps, 0, (uint8_t)((maxTemporalId << 1) | 1));
+    AppendHevcNal(packet, kPps, 0);
+    AppendHevcNal(packet, kIdrWRadl, 0);
+    return packet;
+}
+
+bool Disposable(DisposablePacketFilter     &filter,
+                const std::vector<uint8_t> &packet,
+                int                         videoType = AV_CODEC_ID_HEVC)
+{
+    return filter.IsDisposable(packet.data(), (int)packet.size(), videoType);
+}
+
+void TestHevcSingleLayer()
+{
+    DisposablePacketFilter filter;
+    EXPECT_TRUE(!Disposable(filter, HevcIdr(0)));
+    EXPECT_TRUE(!Disposable(filter, HevcPicture(kTrailR, 0)));
+    EXPECT_TRUE(Disposable(filter, HevcPicture(kTrailN, 0)));
+    EXPECT_TRUE(Disposable(filter, HevcPicture(kRaslN, 0)));
+}
+
+// 三个时域层的分层 GOP, 按解码顺序: 只有 TemporalId 2 的 _N 帧可丢
+void TestHevcMultiLayer()
+{
+    DisposablePacketFilter filter;
+    EXPECT_TRUE(!Disposable(filter, HevcIdr(2)));
+    EXPECT_TRUE(!Disposable(filter, HevcPicture(kTrailR, 0)));
+    EXPECT_TRUE(!Disposable(filter, HevcPicture(kTsaN, 1)));
+    EXPECT_TRUE(!Disposable(filter, HevcPicture(kTrailN, 1)));
+    EXPECT_TRUE(Disposable(filter, HevcPicture(kTsaN, 2)));
+    EXPECT_TRUE(Disposable(filter, HevcPicture(kTrailN, 2)));
+    EXPECT_TRUE(!Disposable(filter, HevcPicture(kTrailR, 2)));
+    // 层数变少的新 SPS 生效后, 第 1 层成为最高层
+    EXPECT_TRUE(!Disposable(filter, HevcIdr(1)));
+    EXPECT_TRUE(Disposable(filter, HevcPicture(kTrailN, 1)));
+    EXPECT_TRUE(!Disposable(filter, HevcPicture(kTrailN, 0)));
+}
+
+// 没有 SPS 时按已见到的最高 TemporalId 判断
+void TestHevcWithoutSps()
+{
+    DisposablePacketFilter filter;
+    EXPECT_TRUE(Disposable(filter, HevcPicture(kTrailN, 0)));
+    EXPECT_TRUE(!Disposable(filter, HevcPicture(kTrailR, 1)));
+    EXPECT_TRUE(!Disposable(filter, HevcPicture(kTrailN, 0)));
+    EXPECT_TRUE(Disposable(filter, HevcPicture(kTrailN, 1)));
+    filter.Reset();
+    EXPECT_TRUE(Disposable(filter, HevcPicture(kTrailN, 0)));
+}
+
+void TestH264()
+{
+    DisposablePacketFilter filter;
+    // SPS, PPS 后跟 nal_ref_idc 为 0 的非 IDR slice
+    const uint8_t nonRef[] = {0, 0, 0, 1, 0x67, 0x42, 0,    0,
+                              1, 0x68, 0xce, 0, 0,    1, 0x01, 0x88};
+    const uint8_t ref[] = {0, 0, 1, 0x41, 0x9a};
+    const uint8_t idr[] = {0, 0, 1, 0x65, 0x88};
+    EXPECT_TRUE(filter.IsDisposable(nonRef, sizeof(nonRef), AV_CODEC_ID_H264));
+    EXPECT_TRUE(!filter.IsDisposable(ref, sizeof(ref), AV_CODEC_ID_H264));
+    EXPECT_TRUE(!filter.IsDisposable(idr, sizeof(idr), AV_CODEC_ID_H264));
+    // 其他编码格式一律不丢
+    EXPECT_TRUE(!filter.IsDisposable(nonRef, sizeof(nonRef), 0));
+}
+} // namespace
+
+int main()
+{
+    TestHevcSingleLayer();
+    TestHevcMultiLayer();
+    TestHevcWithoutSps();
+    TestH264();
+    if (kFailed > 0)
+    {
+        printf("%d checks failed\n", kFailed);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,218 @@
+// 消息队列微基准: 对比 ThreadSafeQueue(mutex) 与 RingBufferQueue(无锁) 在
+// 1/4/16 路通道下的吞吐和单条消息交接延迟.
+//
+// 两种拓扑:
+//   fan-in  : N 个生产者 -> 1 个消费者 (类似多路 detectPre -> 共享 detectInfer)
+//   per-chan: N 组独立的 1 生产者 -> 1 消费者 (类似 pre->infer, output->rtsp)
+// 消费者使用 PopWait, 与 AclLiteThreadMgr::ThreadEntry 的取消息方式一致;
+// 生产者遇到队列满时 yield 重试, 与各阶段 SendMessage 的入队重试一致.
+//
+// 用法: ./test_msg_queue_bench [msgs_per_channel] [queue_size]
+#include "RingBufferQueue.h"
+#include "ThreadSafeQueue.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+const uint32_t kDefaultMsgsPerChannel = 200000;
+const uint32_t kDefaultQueueSize = 256;
+const uint32_t kPopWaitTimeout = 100000;
+const int      kChannelNums[] = {1, 4, 16};
+
+// 与 AclLiteMessage 同形, 避免依赖 acl 头文件
+struct BenchMessage
+{
+    int                   dest;
+    int                   msgId;
+    std::shared_ptr<void> data = nullptr;
+    int64_t               sendTimeNs = 0;
+};
+typedef std::shared_ptr<BenchMessage> MsgPtr;
+
+int64_t NowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+struct BenchResult
+{
+    double seconds = 0;
+    double msgsPerSec = 0;
+    double avgLatencyUs = 0;
+};
+
+template <typename Queue>
+void ProducerLoop(Queue &queue, int channelId, uint32_t msgNum)
+{
+    for (uint32_t i = 0; i < msgNum; i++)
+    {
+        MsgPtr msg = std::make_shared<BenchMessage>();
+        msg->dest = channelId;
+        msg->msgId = i;
+        msg->sendTimeNs = NowNs();
+        while (!queue.Push(msg))
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+template <typename Queue>
+void ConsumerLoop(Queue &queue, uint64_t expect, int64_t &latencySumNs)
+{
+    uint64_t received = 0;
+    int64_t  latencySum = 0;
+    while (received < expect)
+    {
+        MsgPtr msg = queue.PopWait(kPopWaitTimeout);
+        if (msg == nullptr)
+        {
+            continue;
+        }
+        latencySum += NowNs() - msg->sendTimeNs;
+        received++;
+    }
+    latencySumNs = latencySum;
+}
+
+template <typename Queue, typename MakeQueue>
+BenchResult RunFanIn(int channels, uint32_t msgNum, MakeQueue makeQueue)
+{
+    std::unique_ptr<Queue>   queue(makeQueue(channels > 1));
+    std::vector<std::thread> producers;
+    int64_t                  latencySumNs = 0;
+    uint64_t                 total = (uint64_t)channels * msgNum;
+
+    int64_t     start = NowNs();
+    std::thread consumer(
+        [&] { ConsumerLoop(*queue, total, latencySumNs); });
+    for (int c = 0; c < channels; c++)
+    {
+        producers.push_back(
+            std::thread([&, c] { ProducerLoop(*queue, c, msgNum); }));
+    }
+    for (auto &t : producers)
+    {
+        t.join();
+    }
+    consumer.join();
+    int64_t end = NowNs();
+
+    BenchResult result;
+    result.seconds = (end - start) / 1e9;
+    result.msgsPerSec = total / result.seconds;
+    result.avgLatencyUs = latencySumNs / 1e3 / total;
+    return result;
+}
+
+template <typename Queue, typename MakeQueue>
+BenchResult RunPerChannel(int channels, uint32_t msgNum, MakeQueue makeQueue)
+{
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<int64_t>                latencySumNs(channels, 0);
+    std::vector<std::thread>            threads;
+    uint64_t                            total = (uint64_t)channels * msgNum;
+
+    for (int c = 0; c < channels; c++)
+    {
+        queues.push_back(std::unique_ptr<Queue>(makeQueue(false)));
+    }
+
+    int64_t start = NowNs();
+    for (int c = 0; c < channels; c++)
+    {
+        threads.push_back(std::thread(
+            [&, c] { ConsumerLoop(*queues[c], msgNum, latencySumNs[c]); }));
+        threads.push_back(
+            std::thread([&, c] { ProducerLoop(*queues[c], c, msgNum); }));
+    }
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+    int64_t end = NowNs();
+
+    int64_t latencySum = 0;
+    for (int c = 0; c < channels; c++)
+    {
+        latencySum += latencySumNs[c];
+    }
+    BenchResult result;
+    result.seconds = (end - start) / 1e9;
+    result.msgsPerSec = total / result.seconds;
+    result.avgLatencyUs = latencySum / 1e3 / total;
+    return result;
+}
+
+void PrintResult(const char        *topo,
+                 const char        *queueName,
+                 int                channels,
+                 const BenchResult &result)
+{
+    printf("%-9s %-8s channels=%-3d time=%8.3fs  %12.0f msg/s  "
+           "avg latency=%9.2fus\n",
+           topo,
+           queueName,
+           channels,
+           result.seconds,
+           result.msgsPerSec,
+           result.avgLatencyUs);
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    uint32_t msgNum = kDefaultMsgsPerChannel;
+    uint32_t queueSize = kDefaultQueueSize;
+    if (argc > 1)
+    {
+        msgNum = (uint32_t)strtoul(argv[1], nullptr, 10);
+    }
+    if (argc > 2)
+    {
+        queueSize = (uint32_t)strtoul(argv[2], nullptr, 10);
+    }
+    printf("msgs per channel: %u, queue size: %u, hw threads: %u\n",
+           msgNum,
+           queueSize,
+           std::thread::hardware_concurrency());
+
+    typedef ThreadSafeQueue<MsgPtr> MutexQueue;
+    typedef RingBufferQueue<MsgPtr> RingQueue;
+    auto makeMutex = [queueSize](bool) { return new MutexQueue(queueSize); };
+    auto makeRing = [queueSize](bool multiProducer) {
+        return new RingQueue(queueSize, multiProducer);
+    };
+
+    for (int channels : kChannelNums)
+    {
+        PrintResult("fan-in",
+                    "mutex",
+                    channels,
+                    RunFanIn<MutexQueue>(channels, msgNum, makeMutex));
+        PrintResult("fan-in",
+                    channels > 1 ? "mpsc" : "spsc",
+                    channels,
+                    RunFanIn<RingQueue>(channels, msgNum, makeRing));
+    }
+    for (int channels : kChannelNums)
+    {
+        PrintResult("per-chan",
+                    "mutex",
+                    channels,
+                    RunPerChannel<MutexQueue>(channels, msgNum, makeMutex));
+        PrintResult("per-chan",
+                    "spsc",
+                    channels,
+                    RunPerChannel<RingQueue>(channels, msgNum, makeRing));
+    }
+    return 0;
+}
@@ -0,0 +1,164 @@
+// pic 输入读图基准: 对比原 ReadPic 的逐文件串行路径(ReadJpeg + JPEGD 解码,
+// 再 cv::imread 解码一次得到 BGR)与 PicDirReader 的多线程预读路径的吞吐.
+//
+// PicDirReader 每个文件只由 JPEGD 解码一次, BGR 由 host NV12 按需转换.
+// 分两列给出: nv12 为只取 NV12 (检测/跟踪搜索窗口的常见情况), bgr 为每帧
+// 再整帧转换 BGR (视频/图片输出的情况), 与串行路径的工作量相同.
+// 每种读法计时前先完整读一遍目录预热页缓存.
+//
+// 用法: ./test_pic_reader_bench <jpeg_dir> [max_workers] [prefetch_per_worker]
+#include "AclLiteImageProc.h"
+#include "AclLiteResource.h"
+#include "AclLiteUtils.h"
+#include "BgrFrameView.h"
+#include "PicDirReader.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+const uint32_t kDefaultMaxWorkers = 4;
+const uint32_t kDefaultPrefetchPerWorker = 4;
+
+double NowSec()
+{
+    return std::chrono::duration_cast<std::chrono::duration<double>>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+struct BenchResult
+{
+    size_t pics = 0;
+    double seconds = 0;
+};
+
+// 原 DataInputThread::ReadPic 的做法
+BenchResult RunSerial(const std::vector<std::string> &files,
+                      aclrtRunMode                    runMode)
+{
+    BenchResult      result;
+    AclLiteImageProc dvpp;
+    if (dvpp.Init("DVPP_CHNMODE_JPEGD") != ACLLITE_OK)
+    {
+        printf("jpegd init failed\n");
+        return result;
+    }
+    double start = NowSec();
+    for (const std::string &file : files)
+    {
+        ImageData jpgImg, dvppImg, decodedImg;
+        if ((ReadJpeg(jpgImg, file) != ACLLITE_OK) ||
+            (CopyImageToDevice(dvppImg, jpgImg, runMode, MEMORY_DVPP) !=
+             ACLLITE_OK) ||
+            (dvpp.JpegD(decodedImg, dvppImg) != ACLLITE_OK))
+        {
+            continue;
+        }
+        cv::Mat frame = cv::imread(file);
+        if (!frame.empty())
+        {
+            result.pics++;
+        }
+    }
+    result.seconds = NowSec() - start;
+    return result;
+}
+
+BenchResult RunReader(const std::vector<std::string> &files,
+                      aclrtRunMode                    runMode,
+                      uint32_t                        workers,
+                      uint32_t                        prefetch,
+                      bool                            toBgr)
+{
+    BenchResult  result;
+    PicDirReader reader("bench", files, workers, prefetch, runMode);
+    double       start = NowSec();
+    if (reader.Open() != ACLLITE_OK)
+    {
+        printf("pic reader open failed\n");
+        return result;
+    }
+    ImageData dvppImg, hostImg;
+    while (reader.Read(dvppImg, hostImg) == ACLLITE_OK)
+    {
+        if (toBgr)
+        {
+            BgrFrameView view(hostImg);
+            if (view.Full().empty())
+            {
+                continue;
+            }
+        }
+        result.pics++;
+    }
+    result.seconds = NowSec() - start;
+    return result;
+}
+
+void PrintResult(const char *name, uint32_t workers, const BenchResult &result)
+{
+    printf("%-12s workers=%-2u pics=%-6zu time=%8.3fs  %9.1f pic/s\n",
+           name,
+           workers,
+           result.pics,
+           result.seconds,
+           result.seconds > 0 ? result.pics / result.seconds : 0.0);
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        printf("usage: %s <jpeg_dir> [max_workers] [prefetch_per_worker]\n",
+               argv[0]);
+        return -1;
+    }
+    uint32_t maxWorkers = kDefaultMaxWorkers;
+    uint32_t prefetchPerWorker = kDefaultPrefetchPerWorker;
+    if (argc > 2)
+    {
+        maxWorkers = (uint32_t)strtoul(argv[2], nullptr, 10);
+    }
+    if (argc > 3)
+    {
+        prefetchPerWorker = (uint32_t)strtoul(argv[3], nullptr, 10);
+    }
+
+    AclLiteResource aclDev;
+    if (aclDev.Init() != ACLLITE_OK)
+    {
+        printf("acl init failed\n");
+        return -1;
+    }
+    aclrtRunMode             runMode = aclDev.GetRunMode();
+    std::vector<std::string> files;
+    GetAllFiles(argv[1], files);
+    if (files.empty())
+    {
+        printf("no file in %s\n", argv[1]);
+        return -1;
+    }
+    printf("files: %zu, prefetch per worker: %u\n",
+           files.size(),
+           prefetchPerWorker);
+
+    RunSerial(files, runMode); // 预热
+    PrintResult("serial", 1, RunSerial(files, runMode));
+    for (uint32_t workers = 1; workers <= maxWorkers; workers *= 2)
+    {
+        uint32_t prefetch = workers * prefetchPerWorker;
+        RunReader(files, runMode, workers, prefetch, false);
+        PrintResult("reader-nv12",
+                    workers,
+                    RunReader(files, runMode, workers, prefetch, false));
+        PrintResult("reader-bgr",
+                    workers,
+                    RunReader(files, runMode, workers, prefetch, true));
+    }
+    return 0;
+}
@@ -0,0 +1,348 @@
+// graph 配置解析测试: 畸形的 graph JSON、入边配置冲突和不支持的通道拓扑
+// 都必须被拒绝, 合法配置按边设置接收节点的队列参数.
+//
+// 用法: ./test_pipeline_graph, 全部通过时返回 0
+#include "AclLiteUtils.h"
+#include "pipelineGraph/graphChannel.h"
+#include "pipelineGraph/pipelineConfig.h"
+#include "pipelineGraph/pipelineGraph.h"
+#include <cstdio>
+#include <json/json.h>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace
+{
+int kFailed = 0;
+
+#define EXPECT_TRUE(cond)                                                      \
+    do                                                                         \
+    {                                                                          \
+        if (!(cond))                                                           \
+        {                                                                      \
+            printf("FAILED %s:%d: %s\n", __FILE__, __LINE__, #cond);           \
+            kFailed++;                                                         \
+        }                                                                      \
+    } while (0)
+
+Json::Value ParseJson(const std::string &text)
+{
+    Json::Reader reader;
+    Json::Value  value;
+    if (!reader.parse(text, value))
+    {
+        printf("bad test json: %s\n", text.c_str());
+        kFailed++;
+    }
+    return value;
+}
+
+bool ParseGraph(const std::string &text, PipelineGraph *graph)
+{
+    return graph->Parse(ParseJson(text)) == ACLLITE_OK;
+}
+
+// 合法的单通道图, 检测链路完整, 带跟踪和 rtsp 显示
+const char *kChannelNodes =
+    "{\"name\": \"in0\", \"type\": \"data_input\","
+    " \"params\": {\"channel_id\": 0}},"
+    "{\"name\": \"pre0\", \"type\": \"detect_pre\"},"
+    "{\"name\": \"infer\", \"type\": \"detect_infer\"},"
+    "{\"name\": \"post0\", \"type\": \"detect_post\"},"
+    "{\"name\": \"track0\", \"type\": \"track\"},"
+    "{\"name\": \"out0\", \"type\": \"data_output\"},"
+    "{\"name\": \"rtsp0\", \"type\": \"rtsp_display\"}";
+const char *kChannelEdges =
+    "{\"from\": \"in0\", \"to\": \"pre0\"},"
+    "{\"from\": \"pre0\", \"to\": \"infer\"},"
+    "{\"from\": \"infer\", \"to\": \"post0\"},"
+    "{\"from\": \"post0\", \"to\": \"track0\"},"
+    "{\"from\": \"in0\", \"to\": \"track0\"},"
+    "{\"from\": \"track0\", \"to\": \"out0\"},"
+    "{\"from\": \"in0\", \"to\": \"out0\"},"
+    "{\"from\": \"out0\", \"to\": \"rtsp0\"}";
+
+std::string ChannelGraph(const std::string &extraNodes,
+                         const std::string &edges)
+{
+    return std::string("{\"nodes\": [") + kChannelNodes + extraNodes +
+           "], \"edges\": [" + edges + "]}";
+}
+
+void TestMalformedGraph()
+{
+    const char *graphs[] = {
+        "[]",
+        "{}",
+        "{\"nodes\": []}",
+        "{\"nodes\": {\"name\": \"a\", \"type\": \"t\"}}",
+        "{\"nodes\": [1]}",
+        "{\"nodes\": [{\"type\": \"t\"}]}",
+        "{\"nodes\": [{\"name\": \"a\"}]}",
+        "{\"nodes\": [{\"name\": 1, \"type\": \"t\"}]}",
+        "{\"nodes\": [{\"name\": \"\", \"type\": \"t\"}]}",
+        "{\"nodes\": [{\"name\": \"a\", \"type\": \"t\"},"
+        " {\"name\": \"a\", \"type\": \"u\"}]}",
+        "{\"nodes\": [{\"name\": \"a\", \"type\": \"t\", \"device_id\": -1}]}",
+        "{\"nodes\": [{\"name\": \"a\", \"type\": \"t\", \"device_id\": \"0\"}]}",
+        "{\"nodes\": [{\"name\": \"a\", \"type\": \"t\", \"params\": [1]}]}",
+        "{\"nodes\": [{\"name\": \"a\", \"type\": \"t\"}], \"edges\": {}}",
+        "{\"nodes\": [{\"name\": \"a\", \"type\": \"t\"}], \"edges\": [1]}",
+        "{\"nodes\": [{\"name\": \"a\", \"type\": \"t\"}],"
+        " \"edges\": [{\"from\": \"a\"}]}",
+        "{\"nodes\": [{\"name\": \"a\", \"type\": \"t\"}],"
+        " \"edges\": [{\"from\": \"a\", \"to\": \"b\"}]}",
+        "{\"nodes\": [{\"name\": \"a\", \"type\": \"t\"}],"
+        " \"edges\": [{\"from\": \"a\", \"to\": \"a\"}]}",
+        "{\"nodes\": [{\"name\": \"a\", \"type\": \"t\"},"
+        " {\"name\": \"b\", \"type\": \"t\"}],"
+        " \"edges\": [{\"from\": \"a\", \"to\": \"b\"},"
+        " {\"from\": \"a\", \"to\": \"b\"}]}",
+        "{\"nodes\": [{\"name\": \"a\", \"type\": \"t\"},"
+        " {\"name\": \"b\", \"type\": \"t\"}],"
+        " \"edges\": [{\"from\": \"a\", \"to\": \"b\", \"queue_size\": 0}]}",
+        "{\"nodes\": [{\"name\": \"a\", \"type\": \"t\"},"
+        " {\"name\": \"b\", \"type\": \"t\"}],"
+        " \"edges\": [{\"from\": \"a\", \"to\": \"b\", \"queue_size\": \"8\"}]}",
+        "{\"nodes\": [{\"name\": \"a\", \"type\": \"t\"},"
+        " {\"name\": \"b\", \"type\": \"t\"}],"
+        " \"edges\": [{\"from\": \"a\", \"to\": \"b\", \"policy\": \"drop\"}]}",
+        "{\"nodes\": [{\"name\": \"a\", \"type\": \"t\"},"
+        " {\"name\": \"b\", \"type\": \"t\"}],"
+        " \"edges\": [{\"from\": \"a\", \"to\": \"b\", \"policy\": 1}]}",
+        "{\"nodes\": [{\"name\": \"a\", \"type\": \"t\"},"
+        " {\"name\": \"b\", \"type\": \"t\"}],"
+        " \"edges\": [{\"from\": \"a\", \"to\": \"b\", \"timeout_ms\": \"1\"}]}",
+    };
+    for (const char *text : graphs)
+    {
+        PipelineGraph graph;
+        if (ParseGraph(text, &graph))
+        {
+            printf("FAILED: graph accepted: %s\n", text);
+            kFailed++;
+        }
+    }
+
+    PipelineGraph graph;
+    EXPECT_TRUE(ParseGraph(ChannelGraph("", kChannelEdges), &graph));
+    EXPECT_TRUE(graph.Nodes().size() == 7);
+    EXPECT_TRUE(graph.InEdges("out0").size() == 2);
+    EXPECT_TRUE(graph.Successors("in0", "").size() == 3);
+    EXPECT_TRUE(graph.Predecessors("track0", "detect_post").size() == 1);
+}
+
+// 构建测试的节点工厂创建的空线程
+class NullThread : public AclLiteThread
+{
+  public:
+    int Process(int msgId, std::shared_ptr<void> msgData) { return ACLLITE_OK; }
+};
+
+PipelineGraphBuilder NullBuilder(const std::vector<std::string> &types)
+{
+    PipelineGraphBuilder builder;
+    for (const std::string &type : types)
+    {
+        GraphNodeType nodeType;
+        nodeType.factory = [](const PipelineGraph &graph,
+                              const GraphNode     &node,
+                              AclLiteThreadParam  *param) {
+            param->threadInst = new NullThread();
+            return ACLLITE_OK;
+        };
+        nodeType.queueSize = 3;
+        builder.RegisterType(type, nodeType);
+    }
+    return builder;
+}
+
+bool BuildGraph(const std::string &text, std::vector<AclLiteThreadParam> *tbl)
+{
+    PipelineGraph graph;
+    if (!ParseGraph(text, &graph))
+    {
+        printf("FAILED: graph rejected: %s\n", text.c_str());
+        kFailed++;
+        return false;
+    }
+    AclLiteError ret = NullBuilder({"src", "dst"}).Build(graph, *tbl);
+    return ret == ACLLITE_OK;
+}
+
+void FreeThreads(std::vector<AclLiteThreadParam> *tbl)
+{
+    for (AclLiteThreadParam &param : *tbl)
+    {
+        delete param.threadInst;
+    }
+    tbl->clear();
+}
+
+void TestBuildInEdges()
+{
+    const std::string nodes =
+        "{\"nodes\": [{\"name\": \"a\", \"type\": \"src\"},"
+        " {\"name\": \"b\", \"type\": \"src\"},"
+        " {\"name\": \"c\", \"type\": \"dst\"}], ";
+    std::vector<AclLiteThreadParam> tbl;
+
+    // 只有一条边配置时以它为准, 另一条边沿用
+    EXPECT_TRUE(BuildGraph(
+        nodes + "\"edges\": [{\"from\": \"a\", \"to\": \"c\", \"queue_size\": 8,"
+                " \"policy\": \"drop_oldest\"}, {\"from\": \"b\", \"to\": \"c\"}]}",
+        &tbl));
+    EXPECT_TRUE(tbl.size() == 3);
+    if (tbl.size() == 3)
+    {
+        EXPECT_TRUE(tbl[0].queueSize == 3);
+        EXPECT_TRUE(tbl[2].queueSize == 8);
+        EXPECT_TRUE(tbl[2].sendPolicy == ACLLITE_SEND_DROP_OLDEST);
+    }
+    FreeThreads(&tbl);
+
+    EXPECT_TRUE(BuildGraph(
+        nodes + "\"edges\": [{\"from\": \"a\", \"to\": \"c\", \"queue_size\": 8},"
+                " {\"from\": \"b\", \"to\": \"c\", \"queue_size\": 8,"
+                " \"policy\": \"block\", \"timeout_ms\": 40},"
+                " {\"from\": \"a\", \"to\": \"b\"}]}",
+        &tbl));
+    FreeThreads(&tbl);
+
+    EXPECT_TRUE(!BuildGraph(
+        nodes + "\"edges\": [{\"from\": \"a\", \"to\": \"c\", \"queue_size\": 8},"
+                " {\"from\": \"b\", \"to\": \"c\", \"queue_size\": 16}]}",
+        &tbl));
+    FreeThreads(&tbl);
+
+    EXPECT_TRUE(!BuildGraph(
+        nodes + "\"edges\": [{\"from\": \"a\", \"to\": \"c\", \"policy\": "
+                "\"drop_oldest\"}, {\"from\": \"b\", \"to\": \"c\", \"policy\": "
+                "\"drop_newest\"}]}",
+        &tbl));
+    FreeThreads(&tbl);
+
+    EXPECT_TRUE(!BuildGraph(
+        nodes + "\"edges\": [{\"from\": \"a\", \"to\": \"c\", \"timeout_ms\": 40},"
+                " {\"from\": \"b\", \"to\": \"c\", \"timeout_ms\": 80}]}",
+        &tbl));
+    FreeThreads(&tbl);
+
+    PipelineGraph graph;
+    EXPECT_TRUE(ParseGraph("{\"nodes\": [{\"name\": \"a\", \"type\": \"x\"}]}",
+                           &graph));
+    EXPECT_TRUE(NullBuilder({"src"}).Build(graph, tbl) != ACLLITE_OK);
+    FreeThreads(&tbl);
+}
+
+bool ResolveChannel(const std::string &text, GraphChannel *channel)
+{
+    PipelineGraph graph;
+    if (!ParseGraph(text, &graph))
+    {
+        printf("FAILED: graph rejected: %s\n", text.c_str());
+        kFailed++;
+        return false;
+    }
+    std::set<uint32_t> channelIds;
+    const GraphNode   *input = graph.FindNode("in0");
+    return CollectGraphChannels(graph, &channelIds) == ACLLITE_OK &&
+           input != nullptr &&
+           ResolveGraphChannel(graph, *input, channel) == ACLLITE_OK;
+}
+
+void TestResolveChannel()
+{
+    GraphChannel channel;
+    EXPECT_TRUE(ResolveChannel(ChannelGraph("", kChannelEdges), &channel));
+    EXPECT_TRUE(channel.posts.size() == 1 && channel.track != nullptr &&
+                channel.display != nullptr);
+
+    std::string edges = kChannelEdges;
+    const std::string badGraphs[] = {
+        // 缺少抽帧帧使用的 input -> output
+        ChannelGraph("", edges.substr(0, edges.find("{\"from\": \"in0\", "
+                                                    "\"to\": \"out0\"}")) +
+                             "{\"from\": \"out0\", \"to\": \"rtsp0\"}"),
+        // 两个显示节点
+        ChannelGraph(",{\"name\": \"hdmi0\", \"type\": \"hdmi_display\"}",
+                     edges + ",{\"from\": \"out0\", \"to\": \"hdmi0\"}"),
+        // 两个预处理节点
+        ChannelGraph(",{\"name\": \"pre1\", \"type\": \"detect_pre\"}",
+                     edges + ",{\"from\": \"in0\", \"to\": \"pre1\"},"
+                             "{\"from\": \"pre1\", \"to\": \"infer\"}"),
+        // 后处理不经过跟踪
+        ChannelGraph("",
+                     "{\"from\": \"in0\", \"to\": \"pre0\"},"
+                     "{\"from\": \"pre0\", \"to\": \"infer\"},"
+                     "{\"from\": \"infer\", \"to\": \"post0\"},"
+                     "{\"from\": \"post0\", \"to\": \"out0\"},"
+                     "{\"from\": \"in0\", \"to\": \"track0\"},"
+                     "{\"from\": \"track0\", \"to\": \"out0\"},"
+                     "{\"from\": \"in0\", \"to\": \"out0\"}"),
+    };
+    for (const std::string &text : badGraphs)
+    {
+        if (ResolveChannel(text, &channel))
+        {
+            printf("FAILED: channel accepted: %s\n", text.c_str());
+            kFailed++;
+        }
+    }
+
+    const char *badChannelIds[] = {
+        "{\"nodes\": [{\"name\": \"in0\", \"type\": \"data_input\"}]}",
+        "{\"nodes\": [{\"name\": \"in0\", \"type\": \"data_input\","
+        " \"params\": {\"channel_id\": -1}}]}",
+        "{\"nodes\": [{\"name\": \"in0\", \"type\": \"data_input\","
+        " \"params\": {\"channel_id\": \"0\"}}]}",
+        "{\"nodes\": [{\"name\": \"in0\", \"type\": \"data_input\","
+        " \"params\": {\"channel_id\": 0}},"
+        " {\"name\": \"in1\", \"type\": \"data_input\","
+        " \"params\": {\"channel_id\": 0}}]}",
+        "{\"nodes\": [{\"name\": \"pre0\", \"type\": \"detect_pre\"}]}",
+    };
+    for (const char *text : badChannelIds)
+    {
+        PipelineGraph      graph;
+        std::set<uint32_t> channelIds;
+        EXPECT_TRUE(ParseGraph(text, &graph));
+        EXPECT_TRUE(CollectGraphChannels(graph, &channelIds) != ACLLITE_OK);
+    }
+}
+
+void TestEdgePolicyConfig()
+{
+    std::map<std::string, EdgePolicy> policies = DefaultEdgePolicies();
+    ParseEdgePolicies(ParseJson("{\"track\": \"drop_newest\","
+                                " \"display\": {\"policy\": \"block\","
+                                " \"timeout_ms\": 0}, \"unknown\": \"block\"}"),
+                      "test",
+                      &policies);
+    EXPECT_TRUE(policies.count("unknown") == 0);
+    EXPECT_TRUE(policies[kEdgeTrack].policy == ACLLITE_SEND_DROP_NEWEST);
+    EXPECT_TRUE(policies[kEdgeDisplay].timeoutUs == ACLLITE_WAIT_FOREVER);
+    EXPECT_TRUE(policies[kEdgeDetectPre].policy == ACLLITE_SEND_BLOCK);
+    EXPECT_TRUE(StageQueueType(ACLLITE_QUEUE_SPSC, 2, "test") ==
+                ACLLITE_QUEUE_MPSC);
+    EXPECT_TRUE(StageQueueType(ACLLITE_QUEUE_SPSC, 1, "test") ==
+                ACLLITE_QUEUE_SPSC);
+}
+} // namespace
+
+int main()
+{
+    TestMalformedGraph();
+    TestBuildInEdges();
+    TestResolveChannel();
+    TestEdgePolicyConfig();
+    if (kFailed > 0)
+    {
+        printf("%d checks failed\n", kFailed);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
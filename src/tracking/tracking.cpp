@@ -21,7 +21,6 @@ constexpr const char *kDefaultNanotrackBackboneModel =
 constexpr const char *kDefaultNanotrackBackboneSearchModel =
     "model/nanotrack_backbone_search_bs1.om";
 
-const uint32_t kSleepTime = 500;
 } // namespace
 
 Tracking::Tracking(const std::string &model_path)
@@ -147,6 +146,8 @@ AclLiteError Tracking::Init()
     {
         return ACLLITE_ERROR; // model init failed
     }
+    track_time_ = AclLiteMetrics::GetInstance().GetHistogram(
+        SelfInstanceName() + ".track");
 
     return ACLLITE_OK;
 }
@@ -159,7 +160,7 @@ void Tracking::SendTrackingStateFeedback(std::shared_ptr<DetectDataMsg> detectDa
         return;
     }
 
-    std::shared_ptr<DetectDataMsg> feedbackMsg = std::make_shared<DetectDataMsg>();
+    std::shared_ptr<DetectDataMsg> feedbackMsg = feedback_pool_.Acquire();
     feedbackMsg->trackingActive = detectDataMsg->trackingActive;
     feedbackMsg->trackingConfidence = detectDataMsg->trackingConfidence;
     feedbackMsg->needRedetection = detectDataMsg->needRedetection;
@@ -173,7 +174,9 @@ void Tracking::SendTrackingStateFeedback(std::shared_ptr<DetectDataMsg> detectDa
     feedbackMsg->staticCenterThreshold = static_center_threshold_;
     feedbackMsg->staticSizeThreshold = static_size_threshold_;
     
-    AclLiteError ret = SendMessage(dataInputThreadId_, MSG_TRACK_STATE_CHANGE, feedbackMsg);
+    // 控制通道发送, 不排在已入队的读帧消息之后
+    AclLiteError ret = SendMessage(dataInputThreadId_, MSG_TRACK_STATE_CHANGE, feedbackMsg,
+                                   ACLLITE_PRIO_HIGH);
     if (ret != ACLLITE_OK)
     {
         ACLLITE_LOG_WARNING("[Tracking Ch%d] Failed to send track state change to DataInput, error %d",
@@ -181,6 +184,20 @@ void Tracking::SendTrackingStateFeedback(std::shared_ptr<DetectDataMsg> detectDa
     }
 }
 
+void Tracking::ResetForStreamGap(int channelId)
+{
+    if (tracking_initialized_)
+    {
+        ACLLITE_LOG_INFO("[Tracking Ch%d] Stream reconnected, drop tracking state",
+                         channelId);
+    }
+    tracking_initialized_ = false;
+    track_loss_count_ = 0;
+    static_frame_count_ = 0;
+    has_last_box_ = false;
+    tracking_validation_error_count_ = 0;
+}
+
 bool Tracking::IsBlockedDetection(const DetectionOBB &det) const
 {
     if (!has_blocked_target_)
@@ -251,6 +268,13 @@ void Tracking::FillStaticFilterState(std::shared_ptr<DetectDataMsg> &msg) const
 
 AclLiteError Tracking::Process(int msgId, std::shared_ptr<void> data)
 {
+    // 每帧只读一次快照, 配置重新加载后从本帧开始生效
+    std::shared_ptr<const TrackTuning> tuning = tuning_.Load();
+    if (tuning != applied_tuning_)
+    {
+        ApplyTuning(*tuning);
+        applied_tuning_ = tuning;
+    }
     switch (msgId)
     {
     case MSG_TRACK_DATA: // receive detection results from postprocess
@@ -266,11 +290,22 @@ AclLiteError Tracking::Process(int msgId, std::shared_ptr<void> data)
         {
             dataInputThreadId_ = detectDataMsg->dataInputThreadId;
         }
+        if (detectDataMsg->IsStale())
+        {
+            // 跟踪丢失前读入的帧, 不用其更新或初始化跟踪器, 仅透传到输出
+            detectDataMsg->trackingActive = false;
+            MsgSend(detectDataMsg);
+            return ACLLITE_OK;
+        }
+        if (detectDataMsg->streamGap)
+        {
+            ResetForStreamGap(detectDataMsg->channelId);
+        }
 
         // 单目标跟踪：首次检测初始化，后续调用 track 更新
         if (!detectDataMsg->frame.empty())
         {
-            cv::Mat &img = detectDataMsg->frame[0];
+            BgrFrameView &img = detectDataMsg->frame[0];
 
             if (!tracking_initialized_)
             {
@@ -306,7 +341,10 @@ AclLiteError Tracking::Process(int msgId, std::shared_ptr<void> data)
                         initBox.score = best.score;
                         initBox.initScore = best.score;
 
-                        if (this->init(img, initBox) == 0)
+                        int span = detectDataMsg->trace.Begin("track_init");
+                        int initRet = this->init(img, initBox);
+                        detectDataMsg->trace.End(span);
+                        if (initRet == 0)
                         {
                             tracking_initialized_ = true;
                             track_loss_count_ = 0;
@@ -346,7 +384,9 @@ AclLiteError Tracking::Process(int msgId, std::shared_ptr<void> data)
             else
             {
                 // 已初始化,执行跟踪更新
+                int          span = detectDataMsg->trace.Begin("track");
                 const DrOBB &tracked = this->track(img);
+                detectDataMsg->trace.End(span);
                 current_tracking_confidence_ = tracked.score;
                 
                 // Store tracking result in new structure
@@ -459,6 +499,17 @@ AclLiteError Tracking::Process(int msgId, std::shared_ptr<void> data)
         {
             dataInputThreadId_ = detectDataMsg->dataInputThreadId;
         }
+        if (detectDataMsg->IsStale())
+        {
+            // 过期帧不执行 track, 直接显示原图
+            detectDataMsg->trackingActive = false;
+            MsgSend(detectDataMsg);
+            return ACLLITE_OK;
+        }
+        if (detectDataMsg->streamGap)
+        {
+            ResetForStreamGap(detectDataMsg->channelId);
+        }
         
         if (!tracking_initialized_)
         {
@@ -492,8 +543,10 @@ AclLiteError Tracking::Process(int msgId, std::shared_ptr<void> data)
         // 执行跟踪
         if (!detectDataMsg->frame.empty())
         {
-            cv::Mat &img = detectDataMsg->frame[0];
+            BgrFrameView &img = detectDataMsg->frame[0];
+            int          span = detectDataMsg->trace.Begin("track");
             const DrOBB &tracked = this->track(img);
+            detectDataMsg->trace.End(span);
             
             // 更新置信度
             current_tracking_confidence_ = tracked.score;
@@ -590,49 +643,31 @@ AclLiteError Tracking::Process(int msgId, std::shared_ptr<void> data)
 
 AclLiteError Tracking::MsgSend(std::shared_ptr<DetectDataMsg> detectDataMsg)
 {
-    while (1)
+    AclLiteError ret =
+        detectDataMsg->isLastFrame
+            ? SendMessage(dataOutputThreadId_,
+                          MSG_OUTPUT_FRAME,
+                          detectDataMsg,
+                          ACLLITE_SEND_BLOCK)
+            : SendMessageByPolicy(dataOutputThreadId_, MSG_OUTPUT_FRAME, detectDataMsg);
+    if (ret != ACLLITE_OK && ret != ACLLITE_ERROR_MSG_DROPPED)
     {
-        AclLiteError ret = SendMessage(dataOutputThreadId_, MSG_OUTPUT_FRAME, detectDataMsg);
-        if (ret == ACLLITE_ERROR_ENQUEUE)
-        {
-            usleep(kSleepTime);
-            continue;
-        }
-        else if (ret == ACLLITE_OK)
-        {
-            break;
-        }
-        else
-        {
-            ACLLITE_LOG_ERROR("Tracking send output frame message failed, error %d", ret);
-            return ret;
-        }
+        ACLLITE_LOG_ERROR("Tracking send output frame message failed, error %d", ret);
+        return ret;
     }
 
     if (detectDataMsg->isLastFrame)
     {
-        while (1)
+        ret = SendMessage(dataOutputThreadId_,
+                          MSG_ENCODE_FINISH,
+                          detectDataMsg,
+                          ACLLITE_PRIO_HIGH_FENCED);
+        if (ret != ACLLITE_OK)
         {
-            AclLiteError ret = SendMessage(
-                dataOutputThreadId_,
-                MSG_ENCODE_FINISH,
-                detectDataMsg);
-            if (ret == ACLLITE_ERROR_ENQUEUE)
-            {
-                usleep(kSleepTime);
-                continue;
-            }
-            else if (ret == ACLLITE_OK)
-            {
-                break;
-            }
-            else
-            {
-                ACLLITE_LOG_ERROR(
-                    "Tracking send encode finish message failed, error %d",
-                    ret);
-                return ret;
-            }
+            ACLLITE_LOG_ERROR(
+                "Tracking send encode finish message failed, error %d",
+                ret);
+            return ret;
         }
     }
 
@@ -751,14 +786,55 @@ void Tracking::setStaticFrameThreshold(int frames)
     }
 }
 
+void Tracking::UpdateTuning(std::shared_ptr<const TrackTuning> tuning)
+{
+    tuning_.Store(tuning);
+}
+
+void Tracking::ApplyTuning(const TrackTuning &tuning)
+{
+    setConfidenceActiveThreshold(tuning.confidenceActiveThreshold);
+    setConfidenceRedetectThreshold(tuning.confidenceRedetectThreshold);
+    setMaxTrackLossFrames(tuning.maxTrackLossFrames);
+    setMaxScoreDecay(tuning.scoreDecayFactor);
+    setStaticTargetFilterEnabled(tuning.filterStaticTarget);
+    setStaticCenterThreshold(tuning.staticCenterThreshold);
+    setStaticSizeThreshold(tuning.staticSizeThreshold);
+    setStaticFrameThreshold(tuning.staticFrameThreshold);
+    setTrackingValidationEnabled(tuning.validationEnabled);
+    setTrackingValidationIouThreshold(tuning.validationIouThreshold);
+    setTrackingValidationMaxErrors(tuning.validationMaxErrors);
+    ACLLITE_LOG_INFO(
+        "[%s] tuning applied: active=%.2f redetect=%.2f max_loss=%d "
+        "decay=%.2f static_filter=%s(%.1f,%.1f,%d) validation=%s(%.2f,%d)",
+        SelfInstanceName().c_str(),
+        confidence_active_threshold_,
+        confidence_redetect_threshold_,
+        max_track_loss_frames_,
+        max_score_decay,
+        filter_static_target_ ? "on" : "off",
+        static_center_threshold_,
+        static_size_threshold_,
+        static_frame_threshold_,
+        tracking_validation_enabled_ ? "on" : "off",
+        tracking_validation_iou_threshold_,
+        tracking_validation_max_errors_);
+}
+
 int Tracking::init(const cv::Mat &img, DrOBB bbox)
+{
+    BgrFrameView view(img);
+    return init(view, bbox);
+}
+
+int Tracking::init(BgrFrameView &img, DrOBB bbox)
 {
     if (!model_initialized_)
     {
         ACLLITE_LOG_ERROR("Model not initialized, call InitModel() first");
         return -1;
     }
-    if (img.empty())
+    if (img.Empty())
     {
         ACLLITE_LOG_ERROR("Init image is empty");
         return -1;
@@ -781,7 +857,7 @@ int Tracking::init(const cv::Mat &img, DrOBB bbox)
         this->size_.y + this->cfg_.context_amount *
         (this->size_.x + this->size_.y);
     float s_z = std::sqrt(w_z * h_z);
-    this->channel_average_ = cv::mean(img);
+    this->channel_average_ = img.Mean();
 
     if (this->template_input_hw_.first > 0 &&
         this->template_input_hw_.first != this->cfg_.exemplar_size)
@@ -817,13 +893,20 @@ int Tracking::init(const cv::Mat &img, DrOBB bbox)
 
 const DrOBB &Tracking::track(const cv::Mat &img)
 {
+    BgrFrameView view(img);
+    return track(view);
+}
+
+const DrOBB &Tracking::track(BgrFrameView &img)
+{
+    AclLiteScopeTimer timer(track_time_);
     if (!model_initialized_)
     {
         ACLLITE_LOG_ERROR("Model not initialized");
         std::memset(&this->object_box, 0, sizeof(DrOBB));
         return this->object_box;
     }
-    if (img.empty() || this->zf_.empty())
+    if (img.Empty() || this->zf_.empty())
     {
         ACLLITE_LOG_WARNING("Tracking input empty");
         std::memset(&this->object_box, 0, sizeof(DrOBB));
@@ -937,7 +1020,7 @@ const DrOBB &Tracking::track(const cv::Mat &img)
         pred_bbox[3 * score.size() + best_idx] / scale_z * this->cfg_.lr;
 
     auto clipped =
-        BboxClip(bbox.x, bbox.y, width, height, img.rows, img.cols);
+        BboxClip(bbox.x, bbox.y, width, height, img.Height(), img.Width());
     this->center_pos_ = cv::Point2f(clipped[0], clipped[1]);
     this->size_ = cv::Point2f(clipped[2], clipped[3]);
 
@@ -1486,7 +1569,7 @@ std::vector<cv::Point2f> Tracking::BuildPoints(int stride, int size)
     return pts;
 }
 
-std::vector<float> Tracking::GetSubwindow(const cv::Mat &img,
+std::vector<float> Tracking::GetSubwindow(BgrFrameView &img,
                                           const cv::Point2f &pos,
                                           int model_sz,
                                           int original_sz,
@@ -1498,32 +1581,26 @@ std::vector<float> Tracking::GetSubwindow(const cv::Mat &img,
     int context_ymin = static_cast<int>(std::floor(pos.y - c + 0.5f));
     int context_ymax = context_ymin + original_sz - 1;
 
-    int left_pad = std::max(0, -context_xmin);
-    int top_pad = std::max(0, -context_ymin);
-    int right_pad = std::max(0, context_xmax - img.cols + 1);
-    int bottom_pad = std::max(0, context_ymax - img.rows + 1);
-
-    cv::Mat te_im;
-    if (left_pad || top_pad || right_pad || bottom_pad)
+    // 只取裁剪窗口内的 BGR, 超出图像的部分用均值填充
+    cv::Rect roi(context_xmin, context_ymin,
+                 context_xmax - context_xmin + 1,
+                 context_ymax - context_ymin + 1);
+    cv::Mat  inside = img.Roi(roi);
+    cv::Mat  im_patch;
+    if (inside.size() == roi.size())
     {
-        te_im = cv::Mat(img.rows + top_pad + bottom_pad,
-                        img.cols + left_pad + right_pad, img.type(), avg_chans);
-        img.copyTo(te_im(cv::Rect(left_pad, top_pad, img.cols, img.rows)));
+        im_patch = inside;
     }
     else
     {
-        te_im = img;
+        im_patch = cv::Mat(roi.height, roi.width, CV_8UC3, avg_chans);
+        cv::Rect area = roi & cv::Rect(0, 0, img.Width(), img.Height());
+        if (!inside.empty())
+        {
+            inside.copyTo(im_patch(cv::Rect(area.x - roi.x, area.y - roi.y,
+                                            area.width, area.height)));
+        }
     }
-
-    context_xmin += left_pad;
-    context_xmax += left_pad;
-    context_ymin += top_pad;
-    context_ymax += top_pad;
-
-    cv::Rect roi(context_xmin, context_ymin,
-                 context_xmax - context_xmin + 1,
-                 context_ymax - context_ymin + 1);
-    cv::Mat im_patch = te_im(roi).clone();
     if (model_sz != original_sz)
     {
         cv::resize(im_patch, im_patch, cv::Size(model_sz, model_sz));
@@ -1,8 +1,11 @@
 #ifndef TRACKING_H
 #define TRACKING_H
 
+#include "AclLiteMetrics.h"
 #include "AclLiteModel.h"
+#include "AclLiteSnapshot.h"
 #include "AclLiteThread.h"
+#include "ObjectPool.h"
 #include "Params.h"
 #include <array>
 #include <memory>
@@ -73,6 +76,14 @@ class Tracking : public AclLiteThread
      */
     int init(const cv::Mat &img, DrOBB bbox);
 
+    /**
+     * @brief 初始化跟踪器, 只转换模板区域的 BGR
+     * @param img 输入：帧的 BGR 视图
+     * @param bbox 输入：初始边界框
+     * @return 成功返回 0，失败返回非 0
+     */
+    int init(BgrFrameView &img, DrOBB bbox);
+
     /**
      * @brief 在当前帧跟踪对象
      * @param img 输入：当前帧图像
@@ -80,6 +91,13 @@ class Tracking : public AclLiteThread
      */
     const DrOBB &track(const cv::Mat &img);
 
+    /**
+     * @brief 在当前帧跟踪对象, 只转换搜索区域的 BGR
+     * @param img 输入：帧的 BGR 视图
+     * @return 跟踪结果边界框的常量引用
+     */
+    const DrOBB &track(BgrFrameView &img);
+
     /**
      * @brief 设置模板大小
      * @param size 输入：模板大小
@@ -182,6 +200,12 @@ class Tracking : public AclLiteThread
      */
     void setStaticFrameThreshold(int frames);
 
+    /**
+     * @brief 发布新的热更新参数, 可在任意线程调用, 跟踪线程处理下一帧时应用
+     * @param tuning 输入：参数快照
+     */
+    void UpdateTuning(std::shared_ptr<const TrackTuning> tuning);
+
     /**
      * @brief 发送跟踪状态反馈给DataInput线程
      * @param detectDataMsg 输入：检测数据消息
@@ -191,6 +215,12 @@ class Tracking : public AclLiteThread
     private:
     AclLiteError MsgSend(std::shared_ptr<DetectDataMsg> detectDataMsg);
 
+    /**
+     * @brief 通过各 set 接口应用热更新参数, 只在跟踪线程调用
+     * @param tuning 输入：参数快照
+     */
+    void ApplyTuning(const TrackTuning &tuning);
+
     /**
      * @brief 初始化 Nanotrack 模型路径
      * @param model_path 输入：配置中的模型路径字符串
@@ -262,14 +292,14 @@ class Tracking : public AclLiteThread
 
     /**
      * @brief 裁剪并缩放子图
-     * @param img 输入：原图
+     * @param img 输入：原图的 BGR 视图, 只取裁剪区域
      * @param pos 输入：中心位置
      * @param model_sz 输入：模型输入尺寸
      * @param original_sz 输入：裁剪尺寸
      * @param avg_chans 输入：均值
      * @return CHW 数据
      */
-    std::vector<float> GetSubwindow(const cv::Mat &img,
+    std::vector<float> GetSubwindow(BgrFrameView &img,
                                     const cv::Point2f &pos,
                                     int model_sz,
                                     int original_sz,
@@ -342,6 +372,11 @@ class Tracking : public AclLiteThread
      */
     float ComputeIou(const DetectionOBB &a, const DetectionOBB &b) const;
 
+    /**
+     * @brief 输入断流重连后丢弃跟踪状态, 下一帧检测结果重新初始化
+     */
+    void ResetForStreamGap(int channelId);
+
     bool IsBlockedDetection(const DetectionOBB &det) const;
     bool UpdateStaticTrackingState(const DrBBox &box);
     void FillStaticFilterState(std::shared_ptr<DetectDataMsg> &msg) const;
@@ -454,6 +489,18 @@ class Tracking : public AclLiteThread
     float  tracking_validation_iou_threshold_ = 0.3f; ///< IOU 阈值
     int    tracking_validation_max_errors_ = 3; ///< 最大错误次数
     int    tracking_validation_error_count_ = 0; ///< 当前错误次数
+
+    /// ============ 热更新参数 ============
+    AclLiteSnapshot<TrackTuning>       tuning_;         ///< 最新发布的参数
+    std::shared_ptr<const TrackTuning> applied_tuning_; ///< 最近一次应用的快照
+
+    /// 状态反馈消息对象池, DataInput 处理完后回收
+    static const uint32_t     kFeedbackPoolSize = 4;
+    ObjectPool<DetectDataMsg> feedback_pool_{
+        kFeedbackPoolSize, [](DetectDataMsg &msg) { msg.Reset(); }};
+
+    /// track() 耗时, Init 中注册
+    AclLiteHistogram *track_time_ = nullptr;
 };
 
 #endif // TRACKING_H